@@ -32,6 +32,7 @@ struct ircd::client
 	struct conf;
 	struct settings;
 	struct request;
+	struct session;
 
 	static log::log log;
 	static struct settings settings;
@@ -62,11 +63,16 @@ struct ircd::client
 	size_t head_length {0};
 	size_t content_consumed {0};
 	resource::request request;
+	std::shared_ptr<struct session> h2;   // HTTP/2 connection, if negotiated
+	uint32_t stream_id {0};              // HTTP/2 stream this client is serving
 
 	string_view loghead() const;
+	size_t write_headers(const vector_view<const http::header> &, const size_t &content_length);
 	size_t write_all(const net::const_buffers &);
 	size_t write_all(const const_buffer &);
+	size_t read_all(const mutable_buffer &);
 	void close(const net::close_opts &, net::close_callback);
+	void stream_timeout(const milliseconds &, std::function<void ()>);
 	ctx::future<void> close(const net::close_opts & = {});
 
 	void discard_unconsumed(const http::request::head &);
@@ -70,6 +70,13 @@ namespace ircd::db
 	uint64_t read(const columns &, const keys &, const bufs &, const gopts & = {});
 	uint64_t read(column &, const keys &, const bufs &, const gopts & = {});
 
+	// [GET] Parallel query presenting views of all the values to the closure
+	// at once in the order of the keys; a value not found is an empty view.
+	// The views are only valid for the duration of the closure. Returns
+	// bitset for existential report.
+	using views_closure = std::function<void (const vector_view<const string_view> &)>;
+	uint64_t read(const columns &, const keys &, const views_closure &, const gopts & = {});
+
 	// [SET] Write data to the db
 	void write(column &, const string_view &key, const const_buffer &value, const sopts & = {});
 
@@ -19,6 +19,7 @@ namespace ircd::db
 	extern conf::item<std::string> open_recover;
 	extern conf::item<bool> open_repair;
 	extern conf::item<bool> open_slave;
+	extern conf::item<std::string> open_slave_path;
 	extern conf::item<bool> auto_compact;
 	extern conf::item<bool> auto_deletion;
 
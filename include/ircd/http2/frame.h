@@ -21,10 +21,15 @@ struct ircd::http2::frame
 	struct header;
 	struct settings;
 	enum type :uint8_t;
+	enum flag :uint8_t;
+
+	static constexpr size_t HEADER_SIZE {9};
 
 	static string_view reflect(const type &);
 };
 
+/// Frame header. The wire format is big-endian; use the const_buffer
+/// constructor to read a header off the wire and make_header() to write one.
 struct ircd::http2::frame::header
 {
 	uint32_t len        : 24;
@@ -32,9 +37,18 @@ struct ircd::http2::frame::header
 	uint8_t flags;
 	uint32_t            : 1;
 	uint32_t stream_id  : 31;
+
+	explicit header(const const_buffer &);
+	header(const uint32_t &len, const enum type &, const uint8_t &flags, const uint32_t &stream_id);
+	header() = default;
 }
 __attribute__((packed));
 
+namespace ircd::http2
+{
+	const_buffer make_header(const mutable_buffer &, const frame::header &);
+}
+
 enum ircd::http2::frame::type
 :uint8_t
 {
@@ -49,3 +63,13 @@ enum ircd::http2::frame::type
 	WINDOW_UPDATE  = 0x8,
 	CONTINUATION   = 0x9,
 };
+
+enum ircd::http2::frame::flag
+:uint8_t
+{
+	END_STREAM     = 0x01,
+	ACK            = 0x01,
+	END_HEADERS    = 0x04,
+	PADDED         = 0x08,
+	PRIORITY_FLAG  = 0x20,   // PRIORITY; renamed for the type of the same name
+};
@@ -0,0 +1,68 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2019 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_HTTP2_HPACK_H
+
+/// RFC 7541 HPACK: Header Compression for HTTP/2
+namespace ircd::http2::hpack
+{
+	struct table;
+	struct decoder;
+	struct encoder;
+
+	using entry = std::pair<string_view, string_view>;
+	using closure = std::function<void (const string_view &name, const string_view &value)>;
+
+	// Size of an entry for the purpose of the table size (4.1)
+	constexpr size_t overhead {32};
+
+	extern const entry static_table[61];
+
+	size_t huffman_size(const string_view &);
+	string_view huffman_encode(const mutable_buffer &, const string_view &);
+	string_view huffman_decode(const mutable_buffer &, const const_buffer &);
+}
+
+/// Dynamic table. The index space begins after the static table; the most
+/// recently inserted entry has the lowest index.
+struct ircd::http2::hpack::table
+{
+	std::deque<std::pair<std::string, std::string>> entries;
+	size_t size {0};
+	size_t max {4096};
+
+	entry operator[](const size_t &index) const;
+	void insert(const string_view &name, const string_view &value);
+	void resize(const size_t &max);
+};
+
+/// Decodes header blocks received from the peer. The decoder must see every
+/// header block on the connection in order so its table stays synchronized
+/// with the peer's encoder. The views presented to the closure are only
+/// valid for that call.
+struct ircd::http2::hpack::decoder
+{
+	hpack::table table;
+	size_t max_size {4096};
+	std::string scratch;
+
+	void operator()(const const_buffer &block, const closure &);
+};
+
+/// Encodes header blocks for the peer. Only literal representations which
+/// do not enter the dynamic table are emitted, so no table state is kept and
+/// the peer's table size setting does not constrain us. Names are lowercased.
+struct ircd::http2::hpack::encoder
+{
+	static size_t size_max(const vector_view<const http::header> &);
+
+	const_buffer operator()(const mutable_buffer &, const vector_view<const http::header> &) const;
+};
@@ -0,0 +1,81 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2019 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_HTTP2_SESSION_H
+
+namespace ircd::http2
+{
+	struct session;
+}
+
+/// Connection state for either end of an HTTP/2 connection. This performs no
+/// I/O: the owner feeds the session bytes received from the peer, and the
+/// session handles the connection-level frames itself while the frames
+/// concerning streams are presented to the owner's handlers. Control frames
+/// generated in response (acknowledgements, window updates, resets) are
+/// appended to `out` which the owner must write to the peer.
+///
+/// Errors which concern the whole connection are thrown as http2::error; the
+/// owner should then send a GOAWAY with goaway() and close the connection.
+struct ircd::http2::session
+{
+	bool server {false};               // role; peer initiates odd streams
+	bool preface {false};              // connection preface was received
+	bool settings_acked {false};       // peer acknowledged our settings
+	http2::settings ours;              // our settings, as advertised
+	http2::settings theirs;            // peer's settings, as received
+	hpack::decoder decoder;
+	hpack::encoder encoder;
+	int64_t send_window {65535};       // connection-level send credit
+	int64_t recv_window {65535};       // connection-level receive credit
+	int64_t recv_window_max {65535};   // replenish target for recv_window
+	uint32_t last_id {0};              // highest stream initiated by the peer
+	uint32_t next_id {0};              // next stream we initiate
+	uint32_t goaway_id {0};            // last stream the peer will process
+	bool goaway_recv {false};
+
+	uint32_t block_id {0};             // stream of the incomplete header block
+	bool block_eos {false};            // END_STREAM of the incomplete block
+	std::string block;                 // HEADERS + CONTINUATION fragments
+
+	std::string out;                   // frames pending transmission
+
+	// Handlers for the owner.
+	virtual void handle_headers(const uint32_t &id, const vector_view<const http::header> &, const bool &eos) = 0;
+	virtual void handle_data(const uint32_t &id, const const_buffer &, const bool &eos) = 0;
+	virtual void handle_rst(const uint32_t &id, const enum error::code &) = 0;
+	virtual void handle_window(const uint32_t &id, const uint32_t &increment) = 0;
+	virtual void handle_settings(const int64_t &window_delta) = 0;
+	virtual void handle_goaway(const uint32_t &last_id, const enum error::code &) = 0;
+
+	void handle_frame(const frame::header &, const const_buffer &payload);
+	void handle_block(const uint32_t &id, const bool &eos);
+
+  public:
+	// Composition of frames into out.
+	void send_preface();
+	void send_window_update(const uint32_t &id, const uint32_t &increment);
+	void send_rst(const uint32_t &id, const enum error::code &);
+	void send_goaway(const enum error::code &, const string_view &debug = {});
+
+	// Composition of stream frames into the supplied buffers.
+	const_buffer make_headers(const mutable_buffer &, const uint32_t &id, const vector_view<const http::header> &, const bool &eos) const;
+	const_buffer make_data(const mutable_buffer &head, const uint32_t &id, const size_t &len, const bool &eos) const;
+	size_t frame_max() const;
+
+	// Consumes complete frames from the input; returns bytes consumed.
+	size_t operator()(const const_buffer &);
+
+	session(const bool &server, const http2::settings &ours);
+	session(session &&) = delete;
+	session(const session &) = delete;
+	virtual ~session() noexcept;
+};
@@ -62,5 +62,30 @@ struct ircd::http2::settings
 	using code = frame::settings::code;
 	using array_type = std::array<uint32_t, num_of<code>()>;
 
+	const uint32_t &operator[](const code &) const;
+	uint32_t &operator[](const code &);
+
+	void apply(const const_buffer &payload);
+
 	settings();
 };
+
+namespace ircd::http2
+{
+	const_buffer make_settings(const mutable_buffer &, const settings &);
+}
+
+inline uint32_t &
+ircd::http2::settings::operator[](const code &code)
+{
+	assert(code > 0 && code < code::_NUM_);
+	return array_type::operator[](code - 1);
+}
+
+inline const uint32_t &
+ircd::http2::settings::operator[](const code &code)
+const
+{
+	assert(code > 0 && code < code::_NUM_);
+	return array_type::operator[](code - 1);
+}
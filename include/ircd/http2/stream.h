@@ -16,12 +16,24 @@ namespace ircd::http2
 	struct stream;
 }
 
+/// Stream state. The windows are the flow-control credit remaining in each
+/// direction; the send window may become negative when the peer reduces its
+/// initial window size while data is in flight.
 struct ircd::http2::stream
 {
 	enum class state :uint8_t;
 
+	uint32_t id {0};
 	enum state state;
+	int64_t send_window {65535};
+	int64_t recv_window {65535};
 
+	bool local_closed() const;
+	bool remote_closed() const;
+	void close_local();
+	void close_remote();
+
+	stream(const uint32_t &id, const settings &ours, const settings &theirs);
 	stream();
 };
 
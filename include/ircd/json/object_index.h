@@ -0,0 +1,114 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_JSON_OBJECT_INDEX_H
+
+/// Member offset table for a json::object.
+///
+/// A json::object parses from the beginning for every lookup. When the same
+/// object is queried for several keys this device can be attached to it: the
+/// first lookup parses the object once, recording the hash of each key with
+/// the offset and length of its value in a fixed array held by this object.
+/// Later lookups scan that array rather than invoking the parser. Nothing is
+/// allocated. Members past the capacity of the array are not recorded and
+/// lookups which miss the array fall back to the parser for such objects.
+///
+/// As with json::object::find() the first of any duplicate keys is found.
+///
+struct ircd::json::object::index
+{
+	struct entry
+	{
+		name_hash_t hash;
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	static constexpr size_t MAX {32};
+
+	json::object object;
+	mutable std::array<entry, MAX> entries;
+	mutable uint8_t count {0};
+	mutable bool built {false};
+	mutable bool overflow {false};
+
+	void build() const;
+	string_view find(const name_hash_t &) const;
+
+  public:
+	explicit operator const json::object &() const;
+
+	bool has(const string_view &key) const;
+	string_view get(const string_view &key, const string_view &def = {}) const;
+	string_view operator[](const string_view &key) const;
+
+	template<class T> T get(const string_view &key, const T &def = T{}) const;
+	template<class T = string_view> T at(const string_view &key) const;
+
+	index(const json::object &);
+	index() = default;
+};
+
+inline
+ircd::json::object::index::operator
+const ircd::json::object &()
+const
+{
+	return object;
+}
+
+template<class T>
+inline T
+ircd::json::object::index::at(const string_view &key)
+const try
+{
+	const string_view &val
+	{
+		find(name_hash(key))
+	};
+
+	if(unlikely(val.empty()))
+		throw not_found
+		{
+			"'%s'", key
+		};
+
+	return lex_cast<T>(val);
+}
+catch(const bad_lex_cast &e)
+{
+	throw type_error
+	{
+		"'%s' must cast to type %s",
+		key,
+		typeid(T).name()
+	};
+}
+
+template<class T>
+inline T
+ircd::json::object::index::get(const string_view &key,
+                               const T &def)
+const try
+{
+	const string_view &val
+	{
+		find(name_hash(key))
+	};
+
+	return !val.empty()?
+		lex_cast<T>(val):
+		def;
+}
+catch(const bad_lex_cast &e)
+{
+	return def;
+}
@@ -53,12 +53,17 @@ namespace ircd::m::dbs::appendix
 #include "event_sender.h"           // sender | event_idx || hostpart | localpart, event_idx
 #include "event_type.h"             // type | event_idx
 #include "event_state.h"            // state_key, type, room_id, depth, event_idx
+#include "event_auth_chain.h"       // event_idx => chain, seq || chain | seq => event_idx
 #include "room_events.h"            // room_id | depth, event_idx
 #include "room_type.h"              // room_id | type, depth, event_idx
 #include "room_state.h"             // room_id | type, state_key => event_idx
 #include "room_state_space.h"       // room_id | type, state_key, depth, event_idx
+#include "room_state_point.h"       // room_id | point, type, state_key => depth, event_idx
 #include "room_joined.h"            // room_id | origin, member => event_idx
 #include "room_head.h"              // room_id | event_id => event_idx
+#include "room_terms.h"             // term | room_id, event_idx
+#include "user_mitsein.h"           // user_id | other_user_id, room_id
+#include "user_unread.h"            // user_id | room_id => notification, highlight, event_idx
 
 /// Options that affect the dbs::write() of an event to the transaction.
 struct ircd::m::dbs::write_opts
@@ -162,6 +167,11 @@ enum ircd::m::dbs::appendix::index
 	/// Involves the event_state column.
 	EVENT_STATE,
 
+	/// Involves the event_auth_chain and event_auth_cover columns. State
+	/// events are placed in the chain cover of the auth DAG when their whole
+	/// auth chain is already in the cover.
+	EVENT_AUTH_CHAIN,
+
 	/// Involves room_events table.
 	ROOM_EVENTS,
 
@@ -183,11 +193,30 @@ enum ircd::m::dbs::appendix::index
 	/// Involves room_space (all states) table.
 	ROOM_STATE_SPACE,
 
+	/// Involves room_state_point (state checkpoints) table. Any event at a
+	/// checkpoint depth makes the checkpoint; state events amend checkpoints
+	/// above them.
+	ROOM_STATE_POINT,
+
 	/// Involves room_joined table.
 	ROOM_JOINED,
 
+	/// Involves user_mitsein (co-membership) table. Only membership events
+	/// changing a user into or out of the joined state of the room have an
+	/// effect; the present members of the room are queried.
+	USER_MITSEIN,
+
+	/// Involves user_unread (notification counts) table. Only the push
+	/// notifications and the ircd.read receipts in a user's room have an
+	/// effect; a receipt queries the notifications which remain unread.
+	USER_UNREAD,
+
 	/// Take branch to handle room redaction events.
 	ROOM_REDACT,
+
+	/// Involves room_terms (full-text inverted index) table. Redactions
+	/// remove the terms of their target from the index.
+	ROOM_TERMS,
 };
 
 struct ircd::m::dbs::init
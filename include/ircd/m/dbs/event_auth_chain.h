@@ -0,0 +1,72 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_EVENT_AUTH_CHAIN_H
+
+namespace ircd::m::dbs
+{
+	// The position of an auth event: its chain and its sequence in the chain.
+	using event_auth_chain_pos = std::pair<uint64_t, uint64_t>;
+
+	constexpr size_t EVENT_AUTH_CHAIN_VAL_SIZE
+	{
+		sizeof(uint64_t) + sizeof(uint64_t)
+	};
+
+	constexpr size_t EVENT_AUTH_COVER_KEY_SIZE
+	{
+		sizeof(uint64_t) + sizeof(uint64_t)
+	};
+
+	constexpr size_t EVENT_AUTH_COVER_VAL_MAX_SIZE
+	{
+		sizeof(event::idx) + event::auth::MAX * EVENT_AUTH_CHAIN_VAL_SIZE
+	};
+
+	string_view event_auth_chain_val(const mutable_buffer &out, const event_auth_chain_pos &);
+	event_auth_chain_pos event_auth_chain_val(const string_view &);
+	bool find_event_auth_chain(event_auth_chain_pos &, const event::idx &, const write_opts &);
+
+	string_view event_auth_cover_key(const mutable_buffer &out, const uint64_t &chain, const uint64_t &seq = 0);
+	uint64_t event_auth_cover_key(const string_view &amalgam);
+
+	using event_auth_cover_links = vector_view<const event_auth_chain_pos>;
+	string_view event_auth_cover_val(const mutable_buffer &out, const event::idx &, const event_auth_cover_links &);
+	std::tuple<event::idx, size_t> event_auth_cover_val(event_auth_chain_pos (&)[event::auth::MAX], const string_view &);
+
+	void _index_event_auth_chain(db::txn &, const event &, const write_opts &);
+
+	// event_idx => chain, seq
+	extern db::column event_auth_chain;
+
+	// chain | seq => event_idx, (chain, seq)...
+	extern db::domain event_auth_cover;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> event_auth_chain__comp;
+	extern conf::item<size_t> event_auth_chain__block__size;
+	extern conf::item<size_t> event_auth_chain__meta_block__size;
+	extern conf::item<size_t> event_auth_chain__cache__size;
+	extern conf::item<size_t> event_auth_chain__cache_comp__size;
+	extern conf::item<size_t> event_auth_chain__bloom__bits;
+	extern const db::descriptor event_auth_chain;
+
+	extern conf::item<std::string> event_auth_cover__comp;
+	extern conf::item<size_t> event_auth_cover__block__size;
+	extern conf::item<size_t> event_auth_cover__meta_block__size;
+	extern conf::item<size_t> event_auth_cover__cache__size;
+	extern conf::item<size_t> event_auth_cover__cache_comp__size;
+	extern const db::prefix_transform event_auth_cover__pfx;
+	extern const db::comparator event_auth_cover__cmp;
+	extern const db::descriptor event_auth_cover;
+}
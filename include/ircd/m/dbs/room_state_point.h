@@ -0,0 +1,62 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_ROOM_STATE_POINT_H
+
+namespace ircd::m::dbs
+{
+	using room_state_point_key_parts = std::tuple<int64_t, string_view, string_view>;
+	using room_state_point_val_parts = std::tuple<int64_t, event::idx>;
+
+	constexpr size_t ROOM_STATE_POINT_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE +
+		1 +
+		sizeof(int64_t) +
+		event::TYPE_MAX_SIZE +
+		1 +
+		event::STATE_KEY_MAX_SIZE
+	};
+
+	constexpr size_t ROOM_STATE_POINT_VAL_SIZE
+	{
+		sizeof(int64_t) +
+		sizeof(event::idx)
+	};
+
+	int64_t room_state_point_base(const int64_t &point);
+	bool room_state_point_is(const int64_t &depth);
+
+	string_view room_state_point_val(const mutable_buffer &out, const int64_t &depth, const event::idx &);
+	room_state_point_val_parts room_state_point_val(const string_view &);
+
+	string_view room_state_point_key(const mutable_buffer &out, const id::room &, const int64_t &point, const string_view &type = {}, const string_view &state_key = {});
+	room_state_point_key_parts room_state_point_key(const string_view &amalgam);
+
+	void _index_room_state_point(db::txn &, const event &, const write_opts &);
+
+	// room_id | point, type, state_key => depth, event_idx
+	extern db::domain room_state_point;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> room_state_point__comp;
+	extern conf::item<size_t> room_state_point__block__size;
+	extern conf::item<size_t> room_state_point__meta_block__size;
+	extern conf::item<size_t> room_state_point__cache__size;
+	extern conf::item<size_t> room_state_point__cache_comp__size;
+	extern conf::item<size_t> room_state_point__interval;
+	extern conf::item<size_t> room_state_point__keyframe;
+	extern const db::prefix_transform room_state_point__pfx;
+	extern const db::comparator room_state_point__cmp;
+	extern const db::descriptor room_state_point;
+}
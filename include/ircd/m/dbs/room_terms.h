@@ -0,0 +1,87 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_ROOM_TERMS_H
+
+namespace ircd::m::dbs
+{
+	constexpr size_t ROOM_TERMS_TERM_MAX_SIZE
+	{
+		48
+	};
+
+	constexpr size_t ROOM_TERMS_KEY_MAX_SIZE
+	{
+		ROOM_TERMS_TERM_MAX_SIZE       // term
+		+ 1                            // \0
+		+ id::MAX_SIZE                 // room_id
+		+ 1                            // \0
+		+ 8                            // u64
+	};
+
+	/// Content keys in which a term of a posting was found, one bit for each
+	/// of body, name and topic.
+	using room_terms_mask = uint8_t;
+
+	constexpr room_terms_mask ROOM_TERMS_KEYS_ALL
+	{
+		0x07
+	};
+
+	constexpr size_t ROOM_TERMS_VAL_SIZE
+	{
+		sizeof(uint16_t)               // term frequency
+		+ sizeof(room_terms_mask)      // keys
+	};
+
+	using room_terms_tuple = std::tuple<string_view, event::idx>;
+	using room_terms_val_tuple = std::tuple<uint16_t, room_terms_mask>;
+	using room_terms_closure = std::function<bool (const string_view &)>;
+
+	bool room_terms_tokenize(const mutable_buffer &, const json::string &text, const room_terms_closure &);
+	room_terms_mask room_terms_key_mask(const string_view &key) noexcept;
+
+	room_terms_val_tuple
+	room_terms_val(const string_view &val) noexcept;
+
+	string_view
+	room_terms_val(const mutable_buffer &out,
+	               const uint16_t &tf,
+	               const room_terms_mask &keys);
+
+	room_terms_tuple
+	room_terms_key(const string_view &amalgam);
+
+	string_view
+	room_terms_key(const mutable_buffer &out,
+	               const string_view &term,
+	               const string_view &room_id  = {},
+	               const event::idx &          = -1);
+
+	void _index_room_terms(db::txn &, const event &, const write_opts &);
+
+	// term | room_id, event_idx => term frequency, keys
+	extern db::domain room_terms;
+}
+
+namespace ircd::m::dbs::desc
+{
+	// room terms postings
+	extern conf::item<std::string> room_terms__comp;
+	extern conf::item<size_t> room_terms__block__size;
+	extern conf::item<size_t> room_terms__meta_block__size;
+	extern conf::item<size_t> room_terms__cache__size;
+	extern conf::item<size_t> room_terms__cache_comp__size;
+	extern conf::item<size_t> room_terms__terms__max;
+	extern const db::prefix_transform room_terms__pfx;
+	extern const db::comparator room_terms__cmp;
+	extern const db::descriptor room_terms;
+}
@@ -0,0 +1,53 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_USER_MITSEIN_H
+
+namespace ircd::m::dbs
+{
+	constexpr size_t USER_MITSEIN_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE                   // user_id
+		+ 1                            // \0
+		+ id::MAX_SIZE                 // other user_id
+		+ 1                            // \0
+		+ id::MAX_SIZE                 // room_id
+	};
+
+	using user_mitsein_tuple = std::tuple<string_view, string_view>;
+
+	user_mitsein_tuple
+	user_mitsein_key(const string_view &amalgam);
+
+	string_view
+	user_mitsein_key(const mutable_buffer &out,
+	                 const id::user &user,
+	                 const id::user &other = {},
+	                 const id::room &room = {});
+
+	void _index_user_mitsein(db::txn &, const id::room &, const vector_view<const id::user> &, const db::op &);
+	void _index_user_mitsein(db::txn &, const event &, const write_opts &);
+
+	// user_id | other_user_id, room_id
+	extern db::domain user_mitsein;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> user_mitsein__comp;
+	extern conf::item<size_t> user_mitsein__block__size;
+	extern conf::item<size_t> user_mitsein__meta_block__size;
+	extern conf::item<size_t> user_mitsein__cache__size;
+	extern conf::item<size_t> user_mitsein__cache_comp__size;
+	extern conf::item<size_t> user_mitsein__bloom__bits;
+	extern const db::prefix_transform user_mitsein__pfx;
+	extern const db::descriptor user_mitsein;
+}
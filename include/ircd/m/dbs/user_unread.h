@@ -0,0 +1,56 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_USER_UNREAD_H
+
+namespace ircd::m::dbs
+{
+	constexpr size_t USER_UNREAD_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE                   // user_id
+		+ 1                            // \0
+		+ id::MAX_SIZE                 // room_id
+	};
+
+	constexpr size_t USER_UNREAD_VAL_SIZE
+	{
+		sizeof(uint64_t)               // notification count
+		+ sizeof(uint64_t)             // highlight count
+		+ sizeof(event::idx)           // last change
+	};
+
+	// notification count, highlight count, event_idx of the last change
+	using user_unread_tuple = std::tuple<uint64_t, uint64_t, event::idx>;
+
+	string_view user_unread_key(const string_view &amalgam);
+	string_view user_unread_key(const mutable_buffer &out, const id::user &, const id::room & = {});
+
+	user_unread_tuple user_unread_val(const string_view &);
+	string_view user_unread_val(const mutable_buffer &out, const user_unread_tuple &);
+
+	bool find_user_unread(user_unread_tuple &, const string_view &key, const write_opts &);
+	void _index_user_unread(db::txn &, const event &, const write_opts &);
+
+	// user_id | room_id => notification, highlight, event_idx
+	extern db::domain user_unread;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> user_unread__comp;
+	extern conf::item<size_t> user_unread__block__size;
+	extern conf::item<size_t> user_unread__meta_block__size;
+	extern conf::item<size_t> user_unread__cache__size;
+	extern conf::item<size_t> user_unread__cache_comp__size;
+	extern conf::item<size_t> user_unread__bloom__bits;
+	extern const db::prefix_transform user_unread__pfx;
+	extern const db::descriptor user_unread;
+}
@@ -34,6 +34,10 @@ namespace ircd::m
 /// instead. A default constructor can also be used; after construction the
 /// seek() ADL suite can be used to the above effect.
 ///
+/// Many events can be fetched at once with for_each(), which submits the
+/// queries for all of the indexes to the database together rather than
+/// waiting on each event in turn; the events are presented to a closure.
+///
 /// The data is populated by one of two query types to the database; this is
 /// determined automatically by default, but can be configured further with
 /// the options structure.
@@ -45,6 +49,7 @@ struct ircd::m::event::fetch
 
 	using keys = event::keys;
 	using view_closure = std::function<void (const string_view &)>;
+	using closure = std::function<bool (const idx &, const event &)>;
 
 	static const opts default_opts;
 
@@ -62,6 +67,8 @@ struct ircd::m::event::fetch
 	bool assign_from_json(const string_view &key);
 
   public:
+	static bool for_each(const vector_view<const idx> &, const closure &, const opts & = default_opts);
+
 	explicit fetch(std::nothrow_t, const idx &, const id &, const opts & = default_opts);
 	fetch(std::nothrow_t, const idx &, const opts & = default_opts);
 	fetch(std::nothrow_t, const id &, const opts & = default_opts);
@@ -17,7 +17,8 @@
 /// remote parties serially. It operates by querying servers in a room until
 /// one server can provide a satisfying response. The exact method for
 /// determining who to contact, when and how is encapsulated internally for
-/// further development, but it is primarily stochastic. All viable servers
+/// further development; servers are ranked by their past responsiveness with
+/// some stochastic exploration of the others. All viable servers
 /// in a room are exhausted before an error is the result. A hint may be
 /// provided in the options by the caller. If supplied, it will be attempted
 /// first.
@@ -200,6 +201,15 @@ struct ircd::m::fetch::request
 	/// Error pointer state for an attempt. This is cleared each attempt.
 	std::exception_ptr eptr;
 
+	/// State for a hedged attempt. When enabled, if the current attempt has
+	/// not responded after a delay the same request is made to the next best
+	/// server concurrently; whichever responds satisfactorily first is used.
+	/// The hedge has its own buffer since the request heads are written there.
+	std::unique_ptr<server::request> hedge;
+	unique_buffer<mutable_buffer> hedge_buf;
+	string_view hedge_origin;
+	system_point hedge_last;
+
 	/// Buffer backing for opts
 	m::event::id::buf event_id;
 	m::room::id::buf room_id;
@@ -71,6 +71,7 @@ namespace ircd
 #include "users.h"
 #include "rooms.h"
 #include "rooms_summary.h"
+#include "rooms_directory.h"
 #include "groups.h"
 #include "membership.h"
 #include "filter.h"
@@ -100,6 +101,7 @@ namespace ircd
 #include "acquire.h"
 #include "burst.h"
 #include "resource.h"
+#include "replica.h"
 #include "homeserver.h"
 
 struct ircd::m::matrix
@@ -23,6 +23,9 @@ namespace ircd::m::media::file
 	room::id room_id(room::id::buf &out, const mxc &);
 	room::id::buf room_id(const mxc &);
 
+	// Reads the byte range [first, second) of the file; the closure receives
+	// several blocks at a time.
+	size_t read(const room &, const std::pair<size_t, size_t> &range, const closure &);
 	size_t read(const room &, const closure &);
 	size_t write(const room &, const user::id &, const const_buffer &content, const string_view &content_type);
 
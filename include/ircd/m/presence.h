@@ -30,25 +30,60 @@ struct ircd::m::edu::m_presence
 	using super_type::operator=;
 };
 
+/// Presence is held in memory. Changes are not events; each change is
+/// announced at once to /sync and the federation through the
+/// presence.changed hook, and the changes are persisted together in
+/// periodic ircd.presence.snapshot events in the !presence room. The
+/// snapshots are loaded again when the server starts. The ircd.presence
+/// state of a user's room is read for users without a snapshot.
 struct ircd::m::presence
 :edu::m_presence
 {
+	struct state;
 	using closure = std::function<void (const json::object &)>;
 	using closure_event = std::function<void (const m::event &)>;
+	using closure_state = std::function<void (const state &)>;
+
+	static conf::item<seconds> snapshot_interval;
+	static conf::item<size_t> snapshot_users;
 
 	static bool valid_state(const string_view &state);
+	static room::id::buf room_id();
 
 	static bool prefetch(const user &);
 	static event::idx get(std::nothrow_t, const user &);
 	static event::idx get(const user &);
 
 	static bool get(std::nothrow_t, const user &, const closure_event &, const event::fetch::opts *const & = nullptr);
+	static bool get(std::nothrow_t, const user &, const closure_state &);
 	static bool get(std::nothrow_t, const user &, const closure &);
 	static void get(const user &, const closure &);
 
-	static event::id::buf set(const presence &);
-	static event::id::buf set(const user &, const string_view &, const string_view &status = {});
+	static json::object compose(const mutable_buffer &, const user::id &, const state &);
+
+	static uint64_t set(const presence &);
+	static uint64_t set(const user &, const string_view &, const string_view &status = {});
+
+	// Persists the changes since the last snapshot; returns the users.
+	static size_t snapshot();
+
+	/// Internal use only; do not call
+	static void init(), fini() noexcept;
 
 	using edu::m_presence::m_presence;
 	presence(const user &, const mutable_buffer &);
 };
+
+/// The presence of a user held in memory.
+struct ircd::m::presence::state
+{
+	std::string presence;
+	std::string status_msg;
+	time_t last_active {0};         // milliseconds since epoch
+	time_t updated {0};             // milliseconds since epoch
+	bool currently_active {false};
+	bool dirty {false};             // not yet in a snapshot
+
+	// The vm sequence number the state is synchronized at.
+	uint64_t version {0};
+};
@@ -70,6 +70,11 @@ struct ircd::m::push::match
 struct ircd::m::push::match::opts
 {
 	m::id::user user_id;
+
+	/// Optional member index over the content of the event. Evaluating many
+	/// rules against the same event looks up content keys repeatedly; the
+	/// index allows the content to be parsed once for all of them.
+	const json::object::index *content {nullptr};
 };
 
 /// 13.13.1 I'm your pusher, baby.
@@ -0,0 +1,51 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_REPLICA_H
+
+/// Read-only replicas.
+///
+/// A replica is another process of the same server opening the databases
+/// as slaves (RocksDB secondary instances) of the primary process. It serves
+/// the read-only client endpoints from its own copy of the indexes and
+/// proxies everything else to the primary.
+///
+/// The primary announces each retired sequence number with a datagram to
+/// the replicas which subscribed on its notification socket. The replica
+/// then catches up with the primary and replays the notification of the new
+/// events so its /sync longpollers and caches see them as they would on the
+/// primary. Replicas also catch up periodically in case of a lost datagram.
+///
+namespace ircd::m::replica
+{
+	extern log::log log;
+	extern conf::item<bool> enable;
+	extern conf::item<std::string> host;
+	extern conf::item<size_t> port;
+	extern conf::item<std::string> primary;
+	extern conf::item<milliseconds> interval;
+	extern conf::item<seconds> proxy_timeout;
+
+	// This process is a replica.
+	bool is() noexcept;
+
+	// Whether the method is served by a replica rather than the primary.
+	bool local(const resource::method &) noexcept;
+
+	// Forwards the request to the primary.
+	resource::response proxy(client &, const ircd::resource::request &);
+
+	// Catches up with the primary; returns the number of events notified.
+	size_t catchup();
+
+	/// Internal use only; do not call
+	void init(), fini() noexcept;
+}
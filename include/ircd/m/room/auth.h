@@ -67,12 +67,19 @@ struct ircd::m::room::auth::refs
 	{}
 };
 
+/// Interface to the auth chain of an event. When the auth chain is in the
+/// chain cover (see dbs/event_auth_chain.h) it is found by range scans of a
+/// few chains; otherwise the auth DAG is walked from the event.
 struct ircd::m::room::auth::chain
 {
 	using closure = event::closure_idx_bool;
+	using reach = std::map<uint64_t, uint64_t>;
 
 	event::idx idx;
 
+	bool cover(reach &) const;
+	bool for_each_walk(const closure &) const;
+
   public:
 	bool for_each(const closure &) const;
 	bool has(const string_view &type) const;
@@ -81,6 +88,12 @@ struct ircd::m::room::auth::chain
 	chain(const event::idx &idx)
 	:idx{idx}
 	{}
+
+	// Events in the auth chains of some but not all of the events.
+	static bool for_each_difference(const vector_view<const event::idx> &, const closure &);
+
+	// Places all state events in the chain cover; returns events added.
+	static size_t rebuild();
 };
 
 class ircd::m::room::auth::hookdata
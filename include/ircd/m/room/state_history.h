@@ -13,7 +13,8 @@
 
 /// Interface to the state of a room at some previous point in time. This is
 /// constructed out of the data obtained through the lower-level state::space
-/// interface.
+/// interface. Iterations over the whole state (or all of a type) start from
+/// the nearest checkpoint in dbs::room_state_point when one is available.
 ///
 struct ircd::m::room::state::history
 {
@@ -23,6 +24,9 @@ struct ircd::m::room::state::history
 	event::idx event_idx {0};
 	int64_t bound {-1};
 
+  private:
+	bool for_each_point(const string_view &type, const int64_t &point, const int64_t &base, const closure &) const;
+
   public:
 	bool for_each(const string_view &type, const string_view &state_key, const closure &) const;
 	bool for_each(const string_view &type, const closure &) const;
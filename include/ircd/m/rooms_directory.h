@@ -0,0 +1,72 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_ROOMS_DIRECTORY_H
+
+/// In-memory index of the public rooms directory.
+///
+/// The index is built from the ircd.rooms.summary state of the !public room
+/// when the server starts and is kept current as summaries are set and
+/// redacted. Rooms are ranked by their number of joined members. The words of
+/// their name, topic and aliases are indexed so a search term is answered
+/// without inspecting each summary.
+namespace ircd::m::rooms::directory
+{
+	struct opts;
+	struct entry;
+	using closure = std::function<bool (const entry &)>;
+
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> terms_max;
+
+	// The joined count, room_id and origin of a make_token() with the commas.
+	constexpr size_t TOKEN_MAX_SIZE
+	{
+		20 + 1 + m::id::MAX_SIZE + 1 + rfc3986::REMOTE_MAX + 1
+	};
+
+	// The index is built and in use.
+	bool ready() noexcept;
+
+	// Pagination token positioned at the entry.
+	string_view make_token(const mutable_buffer &, const entry &);
+	bool valid_token(const string_view &) noexcept;
+
+	bool for_each(const opts &, const closure &);
+	size_t count(const opts &);
+
+	/// Internal use only; do not call
+	void init(), fini() noexcept;
+}
+
+/// A room summary in the index.
+struct ircd::m::rooms::directory::entry
+{
+	std::string room_id;
+	std::string origin;
+	event::idx event_idx {0};
+	size_t joined {0};
+	std::vector<std::string> terms;
+};
+
+/// Arguments to directory::for_each() and count().
+struct ircd::m::rooms::directory::opts
+{
+	/// Token from make_token(); the iteration starts after that entry.
+	string_view since;
+
+	/// Localize to the summaries from one server.
+	string_view server;
+
+	/// Each word of the term must prefix a word of the name, topic or an
+	/// alias of the room. Case insensitive.
+	string_view search_term;
+};
@@ -16,6 +16,17 @@ namespace ircd::m::search
 	struct query;
 	struct result;
 	struct room_events;
+
+	using closure = std::function<bool (const event::idx &, const long &rank)>;
+
+	extern conf::item<size_t> rank_max;
+	extern conf::item<size_t> rank_df_max;
+
+	// Iterate events matching every term of the query within a room.
+	bool for_each(const query &, const room::id &, const closure &);
+
+	// Iterate events matching every term of the query in all rooms.
+	bool for_each(const query &, const closure &);
 }
 
 struct ircd::m::search::room_events
@@ -24,9 +35,9 @@ struct ircd::m::search::room_events
 	/// Required. The string to search events for
 	json::property<name::search_term, json::string>,
 
-	/// The keys to search. Defaults to all. One of: ["content.body",
+	/// The keys to search. Defaults to all. Any of: ["content.body",
 	/// "content.name", "content.topic"]
-	json::property<name::keys, json::string>,
+	json::property<name::keys, json::array>,
 
 	/// This takes a filter
 	json::property<name::filter, room_event_filter>,
@@ -21,8 +21,14 @@ namespace ircd::m::sync
 struct ircd::m::sync::stats
 {
 	static conf::item<bool> info;
+	static ircd::stats::item<uint64_t> longpoll_waiting;
+	static ircd::stats::item<uint64_t> longpoll_events;
+	static ircd::stats::item<uint64_t> longpoll_notified;
 
 	ircd::timer timer;
 	size_t flush_bytes {0};
 	size_t flush_count {0};
+	size_t longpoll_keys {0};
+	size_t longpoll_wakes {0};
+	size_t longpoll_misses {0};
 };
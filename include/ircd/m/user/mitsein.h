@@ -12,10 +12,18 @@
 #define HAVE_IRCD_M_USER_MITSEIN_H
 
 /// Interface to the other users visible to a user from common rooms.
+///
+/// The users joined to a common room with one of our users are indexed by
+/// the database (see dbs/user_mitsein.h), so for our users the joined
+/// queries are answered from the index. Other queries iterate the rooms of
+/// the user and their members.
 struct ircd::m::user::mitsein
 {
 	m::user user;
 
+	bool indexed(const m::user &other, const string_view &membership) const;
+	bool indexed(const string_view &membership) const;
+
   public:
 	// All common rooms with user
 	bool for_each(const m::user &, const string_view &membership, const rooms::closure_bool &) const;
@@ -35,4 +43,7 @@ struct ircd::m::user::mitsein
 	mitsein(const m::user &user)
 	:user{user}
 	{}
+
+	// Regenerates the index for all of our users; returns pairs indexed.
+	static size_t rebuild();
 };
@@ -16,11 +16,13 @@ struct ircd::m::user::notifications
 	struct opts;
 	using closure_meta = std::function<bool (const string_view &type, const event::idx &)>;
 	using closure = std::function<bool (const event::idx &, const json::object &)>;
+	using counts = std::tuple<size_t, size_t, event::idx>;
 
 	static const string_view type_prefix;
 
 	static string_view make_type(const mutable_buffer &, const opts &);
 	static opts unmake_type(const string_view &type);
+	static size_t rebuild();
 
 	m::user user;
 
@@ -30,6 +32,13 @@ struct ircd::m::user::notifications
 	size_t count(const opts &) const;
 	bool empty(const opts &) const;
 
+	// Notification and highlight counts for a room after an event_idx.
+	std::pair<size_t, size_t> tally(const room::id &, const event::idx &) const;
+
+	// Unread notification and highlight counts for a room, and the event_idx
+	// which last changed them; from the index.
+	counts unread(const room::id &) const;
+
 	notifications(const m::user &user) noexcept;
 };
 
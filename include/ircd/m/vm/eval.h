@@ -14,6 +14,7 @@
 namespace ircd::m::vm
 {
 	struct eval;
+	enum verified :uint8_t;
 
 	const event *find_pdu(const eval &, const event::id &) noexcept;
 	eval *find_parent(const eval &, const ctx::ctx & = ctx::cur()) noexcept;
@@ -24,8 +25,20 @@ namespace ircd::m::vm
 
 	size_t prefetch_refs(const eval &);
 	size_t fetch_keys(const eval &);
+	size_t verify_pdus(eval &);
+	uint8_t preverified(const eval &, const event &) noexcept;
 }
 
+/// Results of verification conducted in advance for a batch of pdus by
+/// verify_pdus(). Absent bits indicate the check must be conducted normally.
+enum ircd::m::vm::verified
+:uint8_t
+{
+	HASH_CHECKED      = 0x01,   ///< The content hash was computed.
+	HASH_VALID        = 0x02,   ///< The content hash matched the claim.
+	SIGNATURE_VALID   = 0x04,   ///< The origin's signature was valid.
+};
+
 /// Event Evaluation Device
 ///
 /// This object conducts the evaluation of an event or a tape of multiple
@@ -55,6 +68,8 @@ struct ircd::m::vm::eval
 	size_t faulted {0};
 
 	vector_view<const m::event> pdus;
+	std::vector<uint8_t> verified;
+	uint8_t preverified {0};
 	const json::iov *issue {nullptr};
 	const event *event_ {nullptr};
 	string_view room_id;
@@ -105,6 +105,20 @@ struct ircd::m::vm::opts
 	/// perform a parallel/mass fetch before proceeding with the evals.
 	bool mfetch_keys {true};
 
+	/// Whether to verify the signatures and content hashes of an input vector
+	/// of events as a batch on the offload threads before proceeding with
+	/// the evals. The results are consumed by the VERIFY and CONFORM phases;
+	/// failures are re-verified serially for accurate reporting.
+	bool mverify {true};
+
+	/// The number of rooms from an input vector of events which may be
+	/// evaluated concurrently. The events are partitioned by room and each
+	/// room is evaluated in order on a context from the vm::pool, so a room
+	/// waiting on a fetch, the database or the offload threads does not hold
+	/// up unrelated rooms. Sequencing and commitment are unaffected. The
+	/// default of 1 evaluates all events on the calling context.
+	size_t concurrency {1};
+
 	/// Whether to launch prefetches for all event_id's (found at standard
 	/// locations) from the input vector, in addition to some other related
 	/// local db prefetches. Disabled by default because it operates prior
@@ -204,6 +218,10 @@ struct ircd::m::vm::opts
 	/// Point this at a json::stack to transcribe output.
 	json::stack::object *out {nullptr};
 
+	/// Serializes transcription to `out` when it is shared by evaluations on
+	/// several contexts; set internally when concurrency is greater than 1.
+	ctx::mutex *out_mutex {nullptr};
+
 	opts() noexcept;
 };
 
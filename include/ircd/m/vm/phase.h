@@ -49,3 +49,10 @@ enum ircd::m::vm::phase
 	EFFECTS,               ///< Effects phase.
 	_NUM_
 };
+
+namespace ircd::m::vm
+{
+	// Distribution of microseconds spent in each phase. Phases nest, so the
+	// time of an outer phase (i.e. EXECUTE) includes those within it.
+	extern std::unique_ptr<stats::histogram> phase_duration[phase::_NUM_];
+}
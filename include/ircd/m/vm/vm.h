@@ -19,6 +19,7 @@ namespace ircd::m::vm
 
 	extern log::log log;
 	extern ctx::dock dock;
+	extern ctx::pool pool;
 	extern bool ready;
 }
 
@@ -49,6 +49,7 @@ struct ircd::net::acceptor
 	ip::tcp::endpoint ep;
 	ip::tcp::acceptor a;
 	size_t accepting {0};
+	iou::op *accept_op {nullptr};
 	sockets handshaking;
 	bool interrupting {false};
 	ctx::dock joining;
@@ -0,0 +1,69 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_NET_IOU_H
+
+/// io_uring transport for sockets.
+///
+/// When this is active, the asynchronous ciphertext reads and writes
+/// underneath the SSL stream of every socket, and the accepts of the
+/// listeners, are submitted to a ring rather than performed by the reactor.
+/// This covers the handshake and the yielding suites of the socket (read_few,
+/// read_all, write_few, write_all). The non-blocking suites (read_one,
+/// read_any, write_one, write_any) are still direct system calls: they run
+/// after a readiness wait, must complete without yielding, and a ring would
+/// only replace one recv(2) or send(2) by an io_uring_enter(2). The client
+/// and server request cycles use those suites; the readiness waits also stay
+/// on the reactor. Everything submitted during
+/// one pass of the event loop is flushed to the kernel with a single system
+/// call, and completions are reaped in batches whenever the ring's eventfd
+/// becomes readable.
+///
+/// Data is transferred through a pool of buffers owned by the ring; the
+/// kernel never references the memory of a socket which might be destroyed
+/// while its operation is still in flight. When available()
+/// is false the pool is exhausted and operations take the reactor path.
+///
+/// The ring is set up when the network subsystem initializes, if enabled by
+/// the configuration and supported by the kernel. This interface is available
+/// whether or not the platform supports io_uring; when it does not, there is
+/// never a system and none of these are called.
+namespace ircd::net::iou
+{
+	struct init;
+	struct system;
+	struct op;
+
+	/// Receives the result of an operation: the number of bytes transferred
+	/// or the accepted file descriptor; a negative errno on failure.
+	using callback = std::function<void (const int32_t &)>;
+
+	extern const bool support;
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> entries;
+	extern conf::item<size_t> buffers;
+	extern struct system *system;
+
+	bool available() noexcept;
+	op *accept(const int &fd, callback);
+	op *recv(const int &fd, const mutable_buffer &, callback);
+	op *send(const int &fd, const const_buffer &, callback);
+	bool cancel(op &) noexcept;
+	void detach(op &) noexcept;
+}
+
+/// Internal use; this is simply declared here for when internal headers are
+/// not available for this build so a weak no-op definition can be defined.
+struct ircd::net::iou::init
+{
+	init();
+	~init() noexcept;
+};
@@ -36,6 +36,7 @@ struct ircd::net::listener_udp
 	explicit operator json::object() const;
 	string_view name() const;
 
+	// Yields until the datagram is received; or sent when it has a remote.
 	datagram &operator()(datagram &);
 
 	listener_udp(const string_view &name,
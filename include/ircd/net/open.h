@@ -102,6 +102,11 @@ struct ircd::net::open_opts
 	/// been set. If true, it will be sent regardless.
 	bool send_sni { true };
 
+	/// Application protocols offered to the remote in the ClientHello in
+	/// order of preference. The protocol selected by the remote (if any) is
+	/// found in socket::alpn after the handshake. Nothing is offered if empty.
+	vector_view<const string_view> alpn;
+
 	/// Option to toggle whether to allow self-signed certificates. This
 	/// currently defaults to true to not break Matrix development but will
 	/// likely change later and require setting to true for specific conns.
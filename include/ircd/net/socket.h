@@ -18,12 +18,52 @@
 
 namespace ircd::net
 {
+	struct transport;
+
 	extern conf::item<std::string> ssl_curve_list;
 	extern conf::item<std::string> ssl_cipher_list;
 	extern conf::item<std::string> ssl_cipher_blacklist;
 	extern asio::ssl::context sslv23_client;
 }
 
+/// Transport layer underneath the SSL stream of a socket. The asynchronous
+/// ciphertext reads and writes are submitted to the net::iou ring when one is
+/// active; otherwise, or when the ring can't take them, they are passed
+/// through to the socket and its reactor. The synchronous read_some() and
+/// write_some() of the non-blocking suites are always passed through; see
+/// net/iou.h.
+struct ircd::net::transport
+{
+	using lowest_layer_type = ip::tcp::socket;
+	using executor_type = lowest_layer_type::executor_type;
+	using error_code = boost::system::error_code;
+	using handler = std::function<void (const error_code &, const size_t &)>;
+
+	ip::tcp::socket &sd;
+	iou::op *pending[2] {nullptr};               // read, write
+
+	static error_code make_error(const int32_t &res) noexcept;
+	void submit(const mutable_buffer &, handler &&);
+	void submit(const const_buffer &, handler &&);
+
+  public:
+	const lowest_layer_type &lowest_layer() const  { return sd;                    }
+	lowest_layer_type &lowest_layer()              { return sd;                    }
+	executor_type get_executor()                   { return sd.get_executor();     }
+
+	template<class buffers> size_t read_some(const buffers &, error_code &);
+	template<class buffers> size_t write_some(const buffers &, error_code &);
+	template<class buffers, class callback> void async_read_some(const buffers &, callback&&);
+	template<class buffers, class callback> void async_write_some(const buffers &, callback&&);
+
+	bool cancel() noexcept;
+
+	transport(ip::tcp::socket &sd) noexcept;
+	transport(transport &&) = delete;
+	transport(const transport &) = delete;
+	~transport() noexcept;
+};
+
 /// Internal socket interface
 ///
 struct ircd::net::socket
@@ -60,7 +100,8 @@ struct ircd::net::socket
 
 	uint64_t id {++count};
 	ip::tcp::socket sd;
-	asio::ssl::stream<ip::tcp::socket &> ssl;
+	net::transport stream;
+	asio::ssl::stream<net::transport &> ssl;
 	stat in, out;
 	deadline_timer timer;
 	uint64_t timer_sem[2] {0};                   // handler, sender
@@ -134,3 +175,89 @@ ircd::net::socket::operator()(args&&... a)
 {
 	return this->wait(std::forward<args>(a)...);
 }
+
+template<class buffers,
+         class callback>
+void
+ircd::net::transport::async_write_some(const buffers &bufs,
+                                       callback&& cb)
+{
+	const asio::const_buffer &ab
+	{
+		*asio::buffer_sequence_begin(bufs)
+	};
+
+	const const_buffer buf
+	{
+		static_cast<const char *>(ab.data()), ab.size()
+	};
+
+	if(!iou::available() || empty(buf) || pending[1])
+		return sd.async_write_some(bufs, std::forward<callback>(cb));
+
+	const auto ex
+	{
+		asio::get_associated_executor(cb, get_executor())
+	};
+
+	handler h{[ex, cb(std::move(cb))]
+	(const error_code &ec, const size_t &bytes) mutable
+	{
+		asio::dispatch(ex, asio::detail::bind_handler(std::move(cb), ec, bytes));
+	}};
+
+	submit(buf, std::move(h));
+}
+
+template<class buffers,
+         class callback>
+void
+ircd::net::transport::async_read_some(const buffers &bufs,
+                                      callback&& cb)
+{
+	const asio::mutable_buffer &ab
+	{
+		*asio::buffer_sequence_begin(bufs)
+	};
+
+	const mutable_buffer buf
+	{
+		static_cast<char *>(ab.data()), ab.size()
+	};
+
+	if(!iou::available() || empty(buf) || pending[0])
+		return sd.async_read_some(bufs, std::forward<callback>(cb));
+
+	const auto ex
+	{
+		asio::get_associated_executor(cb, get_executor())
+	};
+
+	handler h{[ex, cb(std::move(cb))]
+	(const error_code &ec, const size_t &bytes) mutable
+	{
+		asio::dispatch(ex, asio::detail::bind_handler(std::move(cb), ec, bytes));
+	}};
+
+	submit(buf, std::move(h));
+}
+
+/// Non-blocking; never submitted to the ring, which can't complete an
+/// operation without a yield.
+template<class buffers>
+size_t
+ircd::net::transport::write_some(const buffers &bufs,
+                                 error_code &ec)
+{
+	return sd.write_some(bufs, ec);
+}
+
+/// Non-blocking; never submitted to the ring, which can't complete an
+/// operation without a yield.
+template<class buffers>
+size_t
+ircd::net::transport::read_some(const buffers &bufs,
+                                error_code &ec)
+{
+	return sd.read_some(bufs, ec);
+}
@@ -142,6 +142,10 @@ namespace ircd::openssl
 	string_view server_name(const SSL &); // provided by client
 	void server_name(SSL &, const string_view &); // set by client
 
+	// ALPN suite
+	string_view alpn(const SSL &); // selected after handshake
+	void alpn(SSL &, const vector_view<const string_view> &); // set by client
+
 	// Header version; library version
 	extern const info::versions version_api, version_abi;
 	extern const info::versions libressl_version_api;
@@ -52,6 +52,7 @@ enum ircd::resource::method::flag
 	CONTENT_DISCRETION    = 0x08,
 	DELAYED_ACK           = 0x10,
 	DELAYED_RESPONSE      = 0x20,
+	READ_ONLY             = 0x40,   // may be served by a read-only instance
 };
 
 struct ircd::resource::method::opts
@@ -79,6 +80,7 @@ struct ircd::resource::method::stats
 	item timeouts;            ///< The method's timeout was exceeded.
 	item completions;         ///< The handler returned without throwing.
 	item internal_errors;     ///< The handler threw a very bad exception.
+	ircd::stats::histogram duration; ///< Microseconds spent in the method.
 
 	stats(method &);
 };
@@ -21,14 +21,19 @@ namespace ircd::server
 ///
 struct ircd::server::link
 {
+	struct session;
+
 	static conf::item<size_t> tag_max_default;
 	static conf::item<size_t> tag_commit_max_default;
+	static conf::item<bool> h2_enable;
+	static const string_view h2_alpn[2];
 	static uint64_t ids;
 
 	uint64_t id {++ids};                         ///< unique identifier of link.
 	server::peer *peer;                          ///< backreference to peer
 	std::shared_ptr<net::socket> socket;         ///< link's socket
 	std::list<tag> queue;                        ///< link's work queue
+	std::unique_ptr<struct session> h2;          ///< HTTP/2 state if negotiated
 	size_t tag_done {0L};                        ///< total tags processed
 	time_t synack_ts {0L};                       ///< time socket was estab
 	time_t read_ts {0L};                         ///< time of last read
@@ -50,6 +50,7 @@ struct ircd::server::peer
 	size_t write_bytes {0};
 	size_t read_bytes {0};
 	size_t tag_done {0};
+	std::unique_ptr<stats::histogram> tag_rtt;
 	bool op_resolve {false};
 	bool op_fini {false};
 
@@ -39,6 +39,8 @@ struct ircd::server::tag
 		size_t chunk_read {0};         // content read after last chunk head
 		size_t chunk_length {0};       // -1 for chunk header mode
 		http::code status {(http::code)0};
+		uint32_t stream_id {0};        // HTTP/2 stream carrying the request
+		steady_point started {now<steady_point>()}; // submission time
 	}
 	state;
 	ctx::promise<http::code> p;
@@ -72,6 +72,9 @@ namespace ircd::stats
 	template<> struct item<milliseconds>;
 	template<> struct item<seconds>;
 
+	// Distribution item
+	struct histogram;
+
 	extern const size_t NAME_MAX_LEN;
 	extern std::vector<item<void> *> items;
 
@@ -341,3 +344,84 @@ struct ircd::stats::item<ircd::seconds>
 	using int_item<seconds>::int_item;
 	using int_item<seconds>::operator=;
 };
+
+/// Distribution item
+///
+/// Samples are counted into log-linear buckets: every power of two is split
+/// into two sub-buckets so the width of any bucket is within half of its
+/// lower bound. The first bucket counts zero and the last bucket counts
+/// everything past the range. By convention samples of durations are recorded
+/// in microseconds, which gives the range a little over an hour.
+///
+/// Recording is a few integer operations without synchronization, just like
+/// the other items this is only updated from the main thread. Two histograms
+/// are merged by addition because their bucketing is fixed.
+struct ircd::stats::histogram
+:item<void>
+{
+	static constexpr const size_t BUCKETS {64};
+
+	std::array<uint64_t, BUCKETS> bucket {{0}};
+	uint64_t count {0};
+	uint64_t sum {0};
+
+  public:
+	static size_t index(const uint64_t &val) noexcept;
+	static uint64_t bound(const size_t &idx) noexcept;
+
+	bool operator!() const override;
+	uint64_t quantile(const double &) const noexcept;
+
+	histogram &operator+=(const uint64_t &val) noexcept;
+	histogram &operator+=(const microseconds &) noexcept;
+	histogram &operator+=(const histogram &) noexcept;
+
+	histogram(const json::members &feature);
+	histogram() = default;
+};
+
+/// The bucket counting the value. Bucket 1 + 2k + s counts the values with
+/// their highest bit at k and the next bit below it equal to s.
+inline size_t
+ircd::stats::histogram::index(const uint64_t &val)
+noexcept
+{
+	if(!val)
+		return 0;
+
+	const size_t k
+	{
+		63UL - __builtin_clzl(val)
+	};
+
+	const size_t s
+	{
+		k? (val >> (k - 1)) & 1UL: 0UL
+	};
+
+	return std::min(1 + 2 * k + s, BUCKETS - 1);
+}
+
+inline ircd::stats::histogram &
+ircd::stats::histogram::operator+=(const microseconds &val)
+noexcept
+{
+	return operator+=(uint64_t(std::max(val.count(), 0L)));
+}
+
+inline ircd::stats::histogram &
+ircd::stats::histogram::operator+=(const uint64_t &val)
+noexcept
+{
+	bucket[index(val)]++;
+	count++;
+	sum += val;
+	return *this;
+}
+
+inline bool
+ircd::stats::histogram::operator!()
+const
+{
+	return !count;
+}
@@ -337,6 +337,7 @@ namespace ircd
 
 	static void handle_client_requests(std::shared_ptr<client>);
 	static void handle_client_ready(std::shared_ptr<client>, const error_code &ec);
+	static void handle_client_stream(std::shared_ptr<client>);
 }
 
 /// This function is the basis for the client's request loop. We still use
@@ -619,6 +620,808 @@ ircd::handle_ec_default(client &client,
 	return false;
 }
 
+//
+// client::session
+//
+
+/// HTTP/2 connection state shared by the connection's client and the
+/// clients created for each of its streams. The connection's client reads
+/// frames off the socket in bursts from the request pool like any other
+/// client; streams are each given a client of their own which is dispatched
+/// to the pool once their request head (and possibly content) is complete.
+/// Writes to the socket from the streams are serialized by the mutex.
+struct ircd::client::session
+:http2::session
+,std::enable_shared_from_this<session>
+{
+	struct stream;
+
+	static ircd::conf::item<size_t> streams_max;
+	static ircd::conf::item<size_t> window_size;
+	static ircd::conf::item<size_t> buffer_max;
+	static ios::descriptor timeout_desc;
+
+	std::shared_ptr<net::socket> sock;
+	struct conf *conf {nullptr};
+	unique_buffer<mutable_buffer> rxbuf;
+	size_t rxlen {0};
+	uint32_t last_stream {0};
+	bool closed {false};
+	ctx::mutex mutex;
+	ctx::dock dock;
+	std::map<uint32_t, stream> streams;
+
+	static http2::settings make_settings();
+
+	void handle_headers(const uint32_t &, const vector_view<const http::header> &, const bool &) override;
+	void handle_data(const uint32_t &, const const_buffer &, const bool &) override;
+	void handle_rst(const uint32_t &, const enum http2::error::code &) override;
+	void handle_window(const uint32_t &, const uint32_t &) override;
+	void handle_settings(const int64_t &) override;
+	void handle_goaway(const uint32_t &, const enum http2::error::code &) override;
+
+	stream &get(const uint32_t &id);
+	void dispatch(stream &);
+	void transmit(const vector_view<const const_buffer> &);
+	void flush();
+	void reset(const uint32_t &id, const enum http2::error::code &);
+	void finish(const uint32_t &id);
+	void terminate();
+
+	size_t write_headers(const uint32_t &id, const vector_view<const http::header> &, const size_t &content_length);
+	size_t write(const uint32_t &id, const net::const_buffers &);
+	size_t read(const uint32_t &id, const mutable_buffer &);
+	size_t discard(const uint32_t &id);
+	bool main();
+
+	session(client &);
+};
+
+/// A stream opened by the peer. The request head is composed in HTTP/1.1
+/// form so it can be handled by the same request path as any other client.
+struct ircd::client::session::stream
+:http2::stream
+{
+	std::shared_ptr<ircd::client> client;
+	std::string head;                  // request head in HTTP/1.1 form
+	std::string content;               // received data not yet read
+	size_t content_length {-1UL};      // declared by the request, if at all
+	size_t remain {-1UL};              // response content yet to be sent
+	boost::asio::deadline_timer timer {ios::get()};
+	std::function<void ()> timeout;    // called if the timer expires
+	bool dispatched {false};
+	bool reset {false};
+
+	using http2::stream::stream;
+};
+
+decltype(ircd::client::session::timeout_desc)
+ircd::client::session::timeout_desc
+{
+	"ircd.client.http2.stream.timeout"
+};
+
+decltype(ircd::client::session::streams_max)
+ircd::client::session::streams_max
+{
+	{ "name",     "ircd.client.http2.streams.max" },
+	{ "default",  32L                             },
+};
+
+decltype(ircd::client::session::window_size)
+ircd::client::session::window_size
+{
+	{ "name",     "ircd.client.http2.window.size" },
+	{ "default",  long(256_KiB)                   },
+};
+
+/// Limits the request content buffered for a stream which has not declared
+/// its content-length, and so cannot be dispatched until it has all arrived.
+decltype(ircd::client::session::buffer_max)
+ircd::client::session::buffer_max
+{
+	{ "name",     "ircd.client.http2.buffer.max" },
+	{ "default",  long(1_MiB)                    },
+};
+
+ircd::http2::settings
+ircd::client::session::make_settings()
+{
+	using code = http2::settings::code;
+
+	http2::settings ret;
+	ret[code::ENABLE_PUSH] = 0;
+	ret[code::MAX_CONCURRENT_STREAMS] = size_t(streams_max);
+	ret[code::INITIAL_WINDOW_SIZE] = std::min(size_t(window_size), 0x7fffffffUL);
+	ret[code::MAX_HEADER_LIST_SIZE] = size_t(default_conf.header_max_size);
+	return ret;
+}
+
+ircd::client::session::session(client &client)
+:http2::session
+{
+	true, make_settings()
+}
+,sock
+{
+	client.sock
+}
+,conf
+{
+	client.conf
+}
+,rxbuf
+{
+	size(http2::connection_preface) +
+	http2::frame::HEADER_SIZE +
+	ours[http2::settings::code::MAX_FRAME_SIZE]
+}
+{
+	send_preface();
+}
+
+/// Reads and handles everything available on the socket. This is called
+/// from client::main() on a request context whenever the socket is ready;
+/// it returns to put the connection back into async mode, or false if the
+/// connection is to be closed.
+bool
+ircd::client::session::main()
+try
+{
+	if(closed)
+		return false;
+
+	size_t got
+	{
+		net::read_few(*sock, mutable_buffer{rxbuf} + rxlen)
+	};
+
+	do
+	{
+		rxlen += got;
+		const size_t consumed
+		{
+			(*this)(const_buffer{data(rxbuf), rxlen})
+		};
+
+		rxlen -= consumed;
+		memmove(data(rxbuf), data(rxbuf) + consumed, rxlen);
+		flush();
+	}
+	while((got = net::read_any(*sock, mutable_buffer{rxbuf} + rxlen)));
+
+	if(goaway_recv && streams.empty())
+	{
+		terminate();
+		return false;
+	}
+
+	return true;
+}
+catch(const http2::error &e)
+{
+	log::derror
+	{
+		log, "socket:%lu HTTP/2 connection error :%s",
+		net::id(*sock),
+		e.what(),
+	};
+
+	send_goaway(e.code, e.what());
+	terminate();
+	flush();
+	return false;
+}
+catch(...)
+{
+	terminate();
+	throw;
+}
+
+/// The connection will no longer be read; every stream still waiting on
+/// the connection is released.
+void
+ircd::client::session::terminate()
+{
+	closed = true;
+	for(auto it(begin(streams)); it != end(streams); )
+		if(!it->second.dispatched)
+			it = streams.erase(it);
+		else
+			++it;
+
+	dock.notify_all();
+}
+
+void
+ircd::client::session::handle_headers(const uint32_t &id,
+                                      const vector_view<const http::header> &headers,
+                                      const bool &eos)
+{
+	// Trailers; their fields are not considered.
+	const auto it(streams.find(id));
+	if(it != end(streams))
+	{
+		if(!eos)
+			return reset(id, http2::error::code::PROTOCOL_ERROR);
+
+		it->second.close_remote();
+		dispatch(it->second);
+		dock.notify_all();
+		return;
+	}
+
+	if(id <= last_stream)
+		return reset(id, http2::error::code::STREAM_CLOSED);
+
+	last_stream = id;
+	if(closed || goaway_recv)
+		return reset(id, http2::error::code::REFUSED_STREAM);
+
+	if(streams.size() >= size_t(streams_max))
+		return reset(id, http2::error::code::REFUSED_STREAM);
+
+	string_view method, path, authority;
+	size_t content_length(-1UL);
+	for(const auto &[name, value] : headers)
+	{
+		if(name == ":method")
+			method = value;
+		else if(name == ":path")
+			path = value;
+		else if(name == ":authority")
+			authority = value;
+		else if(name == "content-length")
+			content_length = lex_castable<size_t>(value)?
+				lex_cast<size_t>(value):
+				-2UL;
+
+		// Any line break would smuggle another header into the head.
+		if(has(name, '\r') || has(name, '\n') || has(value, '\r') || has(value, '\n'))
+			return reset(id, http2::error::code::PROTOCOL_ERROR);
+	}
+
+	if(!method || !path || content_length == -2UL)
+		return reset(id, http2::error::code::PROTOCOL_ERROR);
+
+	auto &stream
+	{
+		streams.emplace(std::piecewise_construct,
+		                std::forward_as_tuple(id),
+		                std::forward_as_tuple(id, ours, theirs)).first->second
+	};
+
+	stream.content_length = content_length;
+	stream.head.reserve(512);
+	stream.head.append(method);
+	stream.head.append(" ");
+	stream.head.append(path);
+	stream.head.append(" HTTP/1.1\r\n");
+	if(authority)
+	{
+		stream.head.append("Host: ");
+		stream.head.append(authority);
+		stream.head.append("\r\n");
+	}
+
+	for(const auto &[name, value] : headers)
+	{
+		if(startswith(name, ':') || name == "host")
+			continue;
+
+		stream.head.append(name);
+		stream.head.append(": ");
+		stream.head.append(value);
+		stream.head.append("\r\n");
+	}
+
+	if(eos)
+		stream.close_remote();
+
+	dispatch(stream);
+}
+
+/// Streams are dispatched once the content-length is known so the request
+/// path can consume the content as it arrives; a stream without one is
+/// buffered until it ends.
+void
+ircd::client::session::dispatch(stream &stream)
+{
+	if(stream.dispatched)
+		return;
+
+	if(stream.content_length == -1UL && !stream.remote_closed())
+		return;
+
+	if(stream.content_length == -1UL)
+	{
+		stream.head.append("Content-Length: ");
+		stream.head.append(lex_cast(stream.content.size()));
+		stream.head.append("\r\n");
+	}
+
+	stream.head.append("\r\n");
+	auto c
+	{
+		std::make_shared<ircd::client>(sock)
+	};
+
+	if(unlikely(size(stream.head) > size(c->head_buffer)))
+		return reset(stream.id, http2::error::code::REFUSED_STREAM);
+
+	c->h2 = shared_from_this();
+	c->stream_id = stream.id;
+	c->conf = conf;
+	c->head_length = copy(c->head_buffer, string_view{stream.head});
+	stream.client = c;
+	stream.dispatched = true;
+	stream.head.clear();
+	stream.head.shrink_to_fit();
+	client::pool(std::bind(ircd::handle_client_stream, std::move(c)));
+}
+
+void
+ircd::client::session::handle_data(const uint32_t &id,
+                                   const const_buffer &buf,
+                                   const bool &eos)
+{
+	const auto it(streams.find(id));
+	if(it == end(streams) || it->second.remote_closed())
+	{
+		if(id > last_stream)
+			throw http2::error
+			{
+				http2::error::code::PROTOCOL_ERROR, "DATA on idle stream %u",
+				id,
+			};
+
+		return reset(id, http2::error::code::STREAM_CLOSED);
+	}
+
+	auto &stream(it->second);
+	stream.recv_window -= size(buf);
+	if(stream.recv_window < 0)
+		return reset(id, http2::error::code::FLOW_CONTROL_ERROR);
+
+	if(stream.content.size() + size(buf) > size_t(buffer_max))
+		return reset(id, http2::error::code::ENHANCE_YOUR_CALM);
+
+	stream.content.append(data(buf), size(buf));
+	if(eos)
+		stream.close_remote();
+
+	// Content of a stream not yet dispatched is not read until it ends, so
+	// its window is replenished as it is received.
+	if(!stream.dispatched && !eos && size(buf))
+	{
+		send_window_update(id, size(buf));
+		stream.recv_window += size(buf);
+	}
+
+	dispatch(stream);
+	dock.notify_all();
+}
+
+void
+ircd::client::session::handle_rst(const uint32_t &id,
+                                  const enum http2::error::code &code)
+{
+	const auto it(streams.find(id));
+	if(it == end(streams))
+	{
+		if(id > last_stream)
+			throw http2::error
+			{
+				http2::error::code::PROTOCOL_ERROR, "RST_STREAM on idle stream %u",
+				id,
+			};
+
+		return;
+	}
+
+	auto &stream(it->second);
+	stream.reset = true;
+	stream.close_local();
+	stream.close_remote();
+	if(!stream.dispatched)
+		streams.erase(it);
+	else if(stream.client && stream.client->reqctx)
+		ctx::interrupt(*stream.client->reqctx);
+
+	dock.notify_all();
+}
+
+void
+ircd::client::session::handle_window(const uint32_t &id,
+                                     const uint32_t &increment)
+{
+	if(id)
+	{
+		const auto it(streams.find(id));
+		if(it == end(streams))
+			return;
+
+		auto &stream(it->second);
+		stream.send_window += increment;
+		if(stream.send_window > 0x7fffffffL)
+			return reset(id, http2::error::code::FLOW_CONTROL_ERROR);
+	}
+
+	dock.notify_all();
+}
+
+void
+ircd::client::session::handle_settings(const int64_t &delta)
+{
+	for(auto &[id, stream] : streams)
+	{
+		stream.send_window += delta;
+		if(stream.send_window > 0x7fffffffL)
+			throw http2::error
+			{
+				http2::error::code::FLOW_CONTROL_ERROR, "Stream %u window overflow.",
+				id,
+			};
+	}
+
+	dock.notify_all();
+}
+
+void
+ircd::client::session::handle_goaway(const uint32_t &last_id,
+                                     const enum http2::error::code &code)
+{
+	log::debug
+	{
+		log, "socket:%lu HTTP/2 GOAWAY last stream:%u :%s",
+		net::id(*sock),
+		last_id,
+		http2::reflect(code),
+	};
+
+	dock.notify_all();
+}
+
+void
+ircd::client::session::reset(const uint32_t &id,
+                             const enum http2::error::code &code)
+{
+	const auto it(streams.find(id));
+	if(it != end(streams))
+	{
+		if(it->second.reset)
+			return;
+
+		it->second.reset = true;
+		it->second.close_local();
+		it->second.close_remote();
+		if(!it->second.dispatched)
+			streams.erase(it);
+	}
+
+	send_rst(id, code);
+	dock.notify_all();
+	flush();
+}
+
+/// The stream's request context has finished with it. A response which was
+/// not completed is canceled; a request whose content was not entirely
+/// received is asked to stop (8.1).
+void
+ircd::client::session::finish(const uint32_t &id)
+{
+	const auto it(streams.find(id));
+	if(it == end(streams) || it->second.reset || closed)
+		return;
+
+	if(!it->second.local_closed())
+		send_rst(id, http2::error::code::CANCEL);
+	else if(!it->second.remote_closed())
+		send_rst(id, http2::error::code::NO_ERROR);
+
+	it->second.reset = true;
+	flush();
+}
+
+ircd::client::session::stream &
+ircd::client::session::get(const uint32_t &id)
+{
+	const auto it(streams.find(id));
+	if(unlikely(it == end(streams) || it->second.reset))
+		throw std::system_error
+		{
+			make_error_code(std::errc::connection_reset)
+		};
+
+	if(unlikely(closed || !sock || sock->fini))
+		throw std::system_error
+		{
+			make_error_code(std::errc::not_connected)
+		};
+
+	return it->second;
+}
+
+/// Writes the buffers after any pending control frames.
+void
+ircd::client::session::transmit(const vector_view<const const_buffer> &bufs)
+{
+	const std::lock_guard lock
+	{
+		mutex
+	};
+
+	std::string pending;
+	std::swap(pending, out);
+
+	const_buffer iov[4];
+	size_t num(0);
+	if(!pending.empty())
+		iov[num++] = const_buffer{pending.data(), pending.size()};
+
+	for(size_t i(0); i < bufs.size() && num < 4; ++i)
+		iov[num++] = bufs[i];
+
+	net::write_all(*sock, net::const_buffers(iov, num));
+}
+
+/// Transmits any pending control frames. Outside of a context this is only
+/// attempted without blocking; otherwise the next transmission carries them.
+void
+ircd::client::session::flush()
+{
+	if(out.empty() || !sock || sock->fini)
+		return;
+
+	if(ctx::current)
+	{
+		transmit({});
+		return;
+	}
+
+	if(mutex.locked())
+		return;
+
+	const size_t wrote
+	{
+		net::write_any(*sock, const_buffer{out.data(), out.size()})
+	};
+
+	out.erase(0, wrote);
+}
+
+size_t
+ircd::client::session::write_headers(const uint32_t &id,
+                                     const vector_view<const http::header> &headers,
+                                     const size_t &content_length)
+{
+	auto &stream(get(id));
+	const bool eos
+	{
+		content_length == 0
+	};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		http2::hpack::encoder::size_max(headers) + http2::frame::HEADER_SIZE * (1 + 8)
+	};
+
+	const const_buffer frames
+	{
+		make_headers(buf, id, headers, eos)
+	};
+
+	const const_buffer iov[]
+	{
+		frames
+	};
+
+	transmit(iov);
+	stream.remain = content_length;
+	if(eos)
+		stream.close_local();
+
+	return size(frames);
+}
+
+/// Sends the buffers in DATA frames within the flow control windows. The
+/// stream is ended with the last of the response content; when the length
+/// of the content was not declared an empty write ends the stream.
+size_t
+ircd::client::session::write(const uint32_t &id,
+                             const net::const_buffers &bufs)
+{
+	auto &stream(get(id));
+	if(unlikely(stream.local_closed()))
+		throw std::system_error
+		{
+			make_error_code(std::errc::broken_pipe)
+		};
+
+	const size_t total
+	{
+		buffers::size(bufs)
+	};
+
+	const bool ending
+	{
+		stream.remain == -1UL?
+			total == 0:
+			total >= stream.remain
+	};
+
+	size_t ret(0);
+	bool ended(false);
+	for(size_t i(0); i < bufs.size(); ++i)
+		for(size_t off(0); off < size(bufs[i]); )
+		{
+			const bool ready
+			{
+				dock.wait_for(seconds(conf->request_timeout), [this, &id, &stream]
+				{
+					return closed || stream.reset || (stream.send_window > 0 && send_window > 0);
+				})
+			};
+
+			if(unlikely(!ready))
+				throw std::system_error
+				{
+					make_error_code(std::errc::timed_out)
+				};
+
+			get(id);
+			const size_t len
+			{
+				std::min
+				({
+					size(bufs[i]) - off,
+					frame_max(),
+					size_t(stream.send_window),
+					size_t(send_window),
+				})
+			};
+
+			const bool eos
+			{
+				ending && ret + len == total
+			};
+
+			char head[http2::frame::HEADER_SIZE];
+			const const_buffer iov[]
+			{
+				make_data(head, id, len, eos),
+				const_buffer{data(bufs[i]) + off, len},
+			};
+
+			stream.send_window -= len;
+			send_window -= len;
+			transmit(iov);
+			off += len;
+			ret += len;
+			ended |= eos;
+		}
+
+	if(ending && !ended)
+	{
+		char head[http2::frame::HEADER_SIZE];
+		const const_buffer iov[]
+		{
+			make_data(head, id, 0, true)
+		};
+
+		transmit(iov);
+	}
+
+	if(stream.remain != -1UL)
+		stream.remain -= std::min(stream.remain, ret);
+
+	if(ending)
+		stream.close_local();
+
+	return ret;
+}
+
+/// Yields until the buffer is filled with content received on the stream.
+size_t
+ircd::client::session::read(const uint32_t &id,
+                            const mutable_buffer &buf)
+{
+	size_t ret(0);
+	while(ret < size(buf))
+	{
+		auto &stream(get(id));
+		const bool ready
+		{
+			dock.wait_for(seconds(conf->request_timeout), [this, &stream]
+			{
+				return closed || stream.reset || !stream.content.empty() || stream.remote_closed();
+			})
+		};
+
+		if(unlikely(!ready))
+			throw std::system_error
+			{
+				make_error_code(std::errc::timed_out)
+			};
+
+		get(id);
+		if(stream.content.empty())
+			throw std::system_error
+			{
+				net::eof
+			};
+
+		const size_t len
+		{
+			copy(mutable_buffer{data(buf) + ret, size(buf) - ret}, string_view{stream.content})
+		};
+
+		stream.content.erase(0, len);
+		ret += len;
+
+		// The peer is allowed to send as much as was just consumed.
+		if(!stream.remote_closed())
+		{
+			stream.recv_window += len;
+			send_window_update(id, len);
+			flush();
+		}
+	}
+
+	return ret;
+}
+
+size_t
+ircd::client::session::discard(const uint32_t &id)
+{
+	const auto it(streams.find(id));
+	if(it == end(streams))
+		return 0;
+
+	const size_t ret
+	{
+		it->second.content.size()
+	};
+
+	it->second.content.clear();
+	return ret;
+}
+
+/// A request on an HTTP/2 stream has been dispatched by the connection. The
+/// client exists only for this request; there is no async mode to return to.
+void
+ircd::handle_client_stream(std::shared_ptr<client> client)
+try
+{
+	assert(ctx::current);
+	assert(client->h2);
+	assert(client->stream_id);
+	assert(!client->reqctx);
+	client->reqctx = ctx::current;
+	client->ready_count++;
+	const unwind reset{[&client]
+	{
+		assert(bool(client));
+		assert(client->reqctx == ctx::current);
+		client->reqctx = nullptr;
+		client->h2->streams.erase(client->stream_id);
+		if(client::pool.avail() <= 1)
+			client::dock.notify_all();
+	}};
+
+	client->main();
+	client->h2->finish(client->stream_id);
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		client::log, "%s stream fault :%s",
+		client->loghead(),
+		e.what()
+	};
+}
+
 //
 // client
 //
@@ -691,6 +1494,23 @@ bool
 ircd::client::main()
 try
 {
+	// The request head of a stream was composed by the connection.
+	if(stream_id)
+	{
+		parse::buffer pb{const_buffer{data(head_buffer), head_length}};
+		parse::capstan pc{pb};
+		handle_request(pc);
+		return false;
+	}
+
+	if(h2 || string_view{sock->alpn} == "h2")
+	{
+		if(!h2)
+			h2 = std::make_shared<struct session>(*this);
+
+		return h2->main();
+	}
+
 	parse::buffer pb{head_buffer};
 	parse::capstan pc{pb, read_closure(*this)}; do
 	{
@@ -762,7 +1582,9 @@ try
 	// will block this request context below. The timeout limits that.
 	net::scope_timeout timeout
 	{
-		*sock, conf->request_timeout
+		!stream_id?
+			net::scope_timeout{*sock, conf->request_timeout}:
+			net::scope_timeout{}
 	};
 
 	// This is the first read off the wire. The headers are entirely read and
@@ -992,18 +1814,73 @@ ircd::client::discard_unconsumed(const http::request::head &head)
 		head.content_length
 	};
 
+	if(stream_id)
+	{
+		h2->discard(stream_id);
+		content_consumed = head.content_length;
+		return;
+	}
+
 	content_consumed += net::discard_all(*sock, unconsumed);
 	assert(content_consumed == head.content_length);
 }
 
+/// Closing the client of a stream resets the stream; the connection
+/// remains open.
 ircd::ctx::future<void>
 ircd::client::close(const net::close_opts &opts)
 {
+	if(stream_id && h2)
+	{
+		h2->reset(stream_id, http2::error::code::CANCEL);
+		return ctx::already;
+	}
+
 	return likely(sock) && !sock->fini?
 		net::close(*sock, opts):
 		ctx::already;
 }
 
+/// The socket of an HTTP/2 stream is shared by the connection, so the timer
+/// of the stream limits its request instead. The closure is called on the
+/// main stack if the timer expires; an empty closure cancels the timer.
+void
+ircd::client::stream_timeout(const milliseconds &timeout,
+                             std::function<void ()> closure)
+{
+	assert(h2 && stream_id);
+	const auto it(h2->streams.find(stream_id));
+	if(it == end(h2->streams))
+		return;
+
+	auto &stream(it->second);
+	stream.timeout = std::move(closure);
+	stream.timer.cancel();
+	if(!stream.timeout)
+		return;
+
+	const boost::posix_time::milliseconds pt
+	{
+		timeout.count()
+	};
+
+	stream.timer.expires_from_now(pt);
+	stream.timer.async_wait(ios::handle(session::timeout_desc, [h2(weak_from(*h2)), id(stream_id)]
+	(const error_code &ec)
+	{
+		const auto session(h2.lock());
+		if(!session || ec)
+			return;
+
+		const auto it(session->streams.find(id));
+		if(it == end(session->streams) || !it->second.timeout)
+			return;
+
+		const auto closure(std::move(it->second.timeout));
+		closure();
+	}));
+}
+
 void
 ircd::client::close(const net::close_opts &opts,
                     net::close_callback callback)
@@ -1011,6 +1888,12 @@ ircd::client::close(const net::close_opts &opts,
 	if(!sock)
 		return;
 
+	if(stream_id && h2)
+	{
+		h2->reset(stream_id, http2::error::code::CANCEL);
+		return callback({});
+	}
+
 	if(sock->fini)
 		return callback({});
 
@@ -1032,9 +1915,39 @@ ircd::client::write_all(const net::const_buffers &bufs)
 			make_error_code(std::errc::not_connected)
 		};
 
+	if(stream_id)
+		return h2->write(stream_id, bufs);
+
 	return net::write_all(*sock, bufs);
 }
 
+/// Sends the head of the response on an HTTP/2 stream. The content-length
+/// is -1 when the content will be ended by an empty write.
+size_t
+ircd::client::write_headers(const vector_view<const http::header> &headers,
+                            const size_t &content_length)
+{
+	assert(stream_id);
+	assert(h2);
+	return h2->write_headers(stream_id, headers, content_length);
+}
+
+/// Yields until the buffer is filled with the request content.
+size_t
+ircd::client::read_all(const mutable_buffer &buf)
+{
+	if(unlikely(!sock))
+		throw std::system_error
+		{
+			make_error_code(std::errc::bad_file_descriptor)
+		};
+
+	if(stream_id)
+		return h2->read(stream_id, buf);
+
+	return net::read_all(*sock, buf);
+}
+
 /// Returns a string_view to a static (tls) buffer containing common
 /// information used to prefix log calls for this client: i.e id, remote
 /// address, etc. This is meant to be used as the first argument to all log
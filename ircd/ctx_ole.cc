@@ -62,14 +62,15 @@ ircd::ctx::ole::offload::offload(const opts &opts,
                                  const function &func)
 {
 	assert(current);
-	assert(opts.concurrency == 1); // not yet implemented
+	assert(opts.concurrency >= 1);
 
 	// Prepare the offload package on our stack here. These objects will
 	// remain here for the duration of the offload.
-	latch latch{1};
+	latch latch(opts.concurrency);
 	std::exception_ptr eptr;
+	std::atomic_flag eptr_set = ATOMIC_FLAG_INIT;
 	auto *const context(current);
-	auto closure{[&func, &latch, &eptr, &context]
+	auto closure{[&func, &latch, &eptr, &eptr_set, &context]
 	() noexcept
 	{
 		try
@@ -79,8 +80,10 @@ ircd::ctx::ole::offload::offload(const opts &opts,
 		catch(...)
 		{
 			// Note that the write to eptr is taking place on a different
-			// thread from where we created the eptr.
-			eptr = std::current_exception();
+			// thread from where we created the eptr. When the function is
+			// running concurrently only the first exception is kept.
+			if(!eptr_set.test_and_set())
+				eptr = std::current_exception();
 		}
 
 		// The ctx::signal() is a special device which executes the closure
@@ -101,6 +104,11 @@ ircd::ctx::ole::offload::offload(const opts &opts,
 	// capable of throwing an interrupt that was received during this scope.
 	const uninterruptible uninterruptible;
 
+	// The same closure is queued once for each unit of concurrency; the
+	// latch is released after every one of them has returned.
+	for(size_t i(1); i < opts.concurrency; ++i)
+		ole::push(offload::function{closure});
+
 	ole::push(std::move(closure));       // scope address required for clang-7
 	latch.wait();
 
@@ -2929,6 +2929,55 @@ ircd::db::read(const columns &c,
 	return ret;
 }
 
+uint64_t
+ircd::db::read(const columns &c,
+               const keys &key,
+               const views_closure &closure,
+               const gopts &gopts)
+{
+	if(c.empty())
+		return 0UL;
+
+	const auto &num
+	{
+		key.size()
+	};
+
+	if(unlikely(!num || num > 64))
+		throw std::out_of_range
+		{
+			"db::read() :too many columns or vector size mismatch"
+		};
+
+	_read_op op[num];
+	for(size_t i(0); i < num; ++i)
+		op[i] =
+		{
+			c[std::min(c.size() - 1, i)], key[i]
+		};
+
+	// The values are pinned until _read() returns, so the user is called
+	// from within the last invocation of the closure.
+	string_view val[num];
+	uint64_t i(0), ret(0);
+	auto opts(make_opts(gopts));
+	_read({op, num}, opts, [&i, &ret, &val, &num, &closure]
+	(column &, const column::delta &d, const rocksdb::Status &s)
+	{
+		val[i] = s.ok()?
+			std::get<column::delta::VAL>(d):
+			string_view{};
+
+		ret |= (uint64_t(s.ok()) << i++);
+		if(i == num)
+			closure(vector_view<const string_view>(val, num));
+
+		return true;
+	});
+
+	return ret;
+}
+
 std::string
 ircd::db::read(column &column,
                const string_view &key,
@@ -4635,16 +4684,20 @@ ircd::db::_seek(database::column &c,
 
 	rocksdb::ColumnFamilyHandle *const &cf(c);
 	database &d(*c.d);
-
-	#ifdef RB_DEBUG_DB_SEEK
 	const ircd::timer timer;
-	#endif
-
 	const rocksdb::Status ret
 	{
 		d.d->Get(ropts, cf, slice(key), &s)
 	};
 
+	const auto elapsed
+	{
+		timer.at<microseconds>()
+	};
+
+	c.stats->get_latency += elapsed;
+	d.stats->get_latency += elapsed;
+
 	#ifdef RB_DEBUG_DB_SEEK
 	log::debug
 	{
@@ -4653,7 +4706,7 @@ ircd::db::_seek(database::column &c,
 		sequence(d),
 		sequence(ropts.snapshot),
 		ret.ToString(),
-		timer.at<microseconds>().count(),
+		elapsed.count(),
 		name(c)
 	};
 	#endif
@@ -4859,14 +4912,18 @@ ircd::db::_seek(database::column &c,
 try
 {
 	const ctx::uninterruptible ui;
-
-	#ifdef RB_DEBUG_DB_SEEK
 	database &d(*c.d);
 	const ircd::timer timer;
-	#endif
-
 	_seek_(it, p);
 
+	const auto elapsed
+	{
+		timer.at<microseconds>()
+	};
+
+	c.stats->seek_latency += elapsed;
+	d.stats->seek_latency += elapsed;
+
 	#ifdef RB_DEBUG_DB_SEEK
 	log::debug
 	{
@@ -4876,7 +4933,7 @@ try
 		sequence(opts.snapshot),
 		valid(it)? "VALID" : "INVALID",
 		it.status().ToString(),
-		timer.at<microseconds>().count(),
+		elapsed.count(),
 		name(c)
 	};
 	#endif
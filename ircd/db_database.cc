@@ -92,6 +92,17 @@ ircd::db::open_slave
 	{ "persist",  false                },
 };
 
+/// Conf item for the directory where slave instances keep their private
+/// state (info log and the like). Each database of each process gets its
+/// own subdirectory so any number of slaves can follow the same primary.
+decltype(ircd::db::open_slave_path)
+ircd::db::open_slave_path
+{
+	{ "name",     "ircd.db.open.slave.path" },
+	{ "default",  "/tmp/slave"              },
+	{ "persist",  false                     },
+};
+
 void
 ircd::db::sync(database &d)
 {
@@ -1148,11 +1159,24 @@ try
 
 	// Open DB into ptr
 	rocksdb::DB *ptr;
+	const std::string slave_path
+	{
+		slave?
+			fmt::snstringf
+			{
+				4096, "%s/%s.%d",
+				string_view{open_slave_path},
+				this->name,
+				getpid(),
+			}:
+			std::string{}
+	};
+
 	if(slave)
 		throw_on_error
 		{
 			#ifdef IRCD_DB_HAS_SECONDARY
-			rocksdb::DB::OpenAsSecondary(*opts, path, "/tmp/slave", columns, &handles, &ptr)
+			rocksdb::DB::OpenAsSecondary(*opts, path, slave_path, columns, &handles, &ptr)
 			#else
 			rocksdb::Status::NotSupported(slice("Slave mode not supported by this RocksDB"_sv))
 			#endif
@@ -2358,6 +2382,16 @@ ircd::db::database::stats::stats(database *const &d,
 	{ "name", make_name("multiget.referenced")                          },
 	{ "desc", "Number of DB::MultiGet() results adhering to zero-copy." },
 }
+,get_latency
+{
+	{ "name", make_name("get.latency")                                  },
+	{ "desc", "Distribution of DB::Get() durations in microseconds."    },
+}
+,seek_latency
+{
+	{ "name", make_name("seek.latency")                                 },
+	{ "desc", "Distribution of iterator seeks to a key in microseconds." },
+}
 {
 	assert(item.size() == ticker.size());
 	for(size_t i(0); i < item.size(); ++i)
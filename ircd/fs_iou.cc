@@ -212,6 +212,35 @@ noexcept
 // system::system
 //
 
+/// Maps the region of the ring at the IORING_OFF_* offset; also used for the
+/// ring of net::iou. The mapping is released with the pointer.
+ircd::custom_ptr<uint8_t>
+ircd::fs::iou::map_ring(const fd &fd,
+                        const size_t &len,
+                        const off_t &off)
+{
+	static const auto prot(PROT_READ | PROT_WRITE);
+	static const auto flags(MAP_SHARED | MAP_POPULATE);
+	void *const &map
+	{
+		::mmap(NULL, len, prot, flags, fd, off)
+	};
+
+	if(unlikely(map == MAP_FAILED))
+	{
+		throw_system_error(errno);
+		__builtin_unreachable();
+	}
+
+	return
+	{
+		reinterpret_cast<uint8_t *>(map), [len](uint8_t *const ptr)
+		{
+			syscall(::munmap, ptr, len);
+		}
+	};
+}
+
 ircd::fs::iou::system::system(const size_t &max_events,
                               const size_t &max_submit)
 try
@@ -237,75 +266,15 @@ try
 }
 ,sq_p
 {
-	[this]
-	{
-		static const auto prot(PROT_READ | PROT_WRITE);
-		static const auto flags(MAP_SHARED | MAP_POPULATE);
-		void *const &map
-		{
-			::mmap(NULL, sq_len, prot, flags, fd, IORING_OFF_SQ_RING)
-		};
-
-		if(unlikely(map == MAP_FAILED))
-		{
-			throw_system_error(errno);
-			__builtin_unreachable();
-		}
-
-		return reinterpret_cast<uint8_t *>(map);
-	}(),
-	[this](uint8_t *const ptr)
-	{
-		syscall(::munmap, ptr, sq_len);
-	}
+	map_ring(fd, sq_len, IORING_OFF_SQ_RING)
 }
 ,cq_p
 {
-	[this]
-	{
-		static const auto prot(PROT_READ | PROT_WRITE);
-		static const auto flags(MAP_SHARED | MAP_POPULATE);
-		void *const &map
-		{
-			::mmap(NULL, cq_len, prot, flags, fd, IORING_OFF_CQ_RING)
-		};
-
-		if(unlikely(map == MAP_FAILED))
-		{
-			throw_system_error(errno);
-			__builtin_unreachable();
-		}
-
-		return reinterpret_cast<uint8_t *>(map);
-	}(),
-	[this](uint8_t *const ptr)
-	{
-		syscall(::munmap, ptr, cq_len);
-	}
+	map_ring(fd, cq_len, IORING_OFF_CQ_RING)
 }
 ,sqe_p
 {
-	[this]
-	{
-		static const auto prot(PROT_READ | PROT_WRITE);
-		static const auto flags(MAP_SHARED | MAP_POPULATE);
-		void *const &map
-		{
-			::mmap(NULL, sqe_len, prot, flags, fd, IORING_OFF_SQES)
-		};
-
-		if(unlikely(map == MAP_FAILED))
-		{
-			throw_system_error(errno);
-			__builtin_unreachable();
-		}
-
-		return reinterpret_cast<uint8_t *>(map);
-	}(),
-	[this](uint8_t *const ptr)
-	{
-		syscall(::munmap, ptr, sqe_len);
-	}
+	map_ring(fd, sqe_len, IORING_OFF_SQES)
 }
 ,head
 {
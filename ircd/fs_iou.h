@@ -17,6 +17,7 @@ namespace ircd::fs::iou
 	struct system;
 	struct request;
 
+	custom_ptr<uint8_t> map_ring(const fd &, const size_t &len, const off_t &off);
 	size_t write(const fd &, const const_iovec_view &, const write_opts &);
 	size_t read(const fd &, const const_iovec_view &, const read_opts &);
 	void fsync(const fd &, const sync_opts &);
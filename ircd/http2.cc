@@ -8,12 +8,1230 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::http2
+{
+	static uint16_t get16(const char *);
+	static uint32_t get32(const char *);
+	static void put16(char *, const uint16_t &);
+	static void put32(char *, const uint32_t &);
+}
+
 decltype(ircd::http2::connection_preface)
 ircd::http2::connection_preface
 {
 	"PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
 };
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// session.h
+//
+
+ircd::http2::session::session(const bool &server,
+                              const http2::settings &ours)
+:server
+{
+	server
+}
+,preface
+{
+	!server
+}
+,ours
+{
+	ours
+}
+,recv_window_max
+{
+	std::max(int64_t(ours[settings::code::INITIAL_WINDOW_SIZE]), int64_t(65535))
+}
+,next_id
+{
+	server? 2U : 1U
+}
+{
+	decoder.max_size = ours[settings::code::HEADER_TABLE_SIZE];
+}
+
+ircd::http2::session::~session()
+noexcept
+{
+}
+
+size_t
+ircd::http2::session::operator()(const const_buffer &buf)
+{
+	size_t ret(0);
+	if(!preface)
+	{
+		const size_t cmp
+		{
+			std::min(size(buf), size(connection_preface))
+		};
+
+		if(string_view(data(buf), cmp) != connection_preface.substr(0, cmp))
+			throw error
+			{
+				error::code::PROTOCOL_ERROR, "Invalid connection preface."
+			};
+
+		if(cmp < size(connection_preface))
+			return ret;
+
+		ret += size(connection_preface);
+		preface = true;
+	}
+
+	while(size(buf) - ret >= frame::HEADER_SIZE)
+	{
+		const frame::header header
+		{
+			const_buffer{data(buf) + ret, size(buf) - ret}
+		};
+
+		if(header.len > ours[settings::code::MAX_FRAME_SIZE])
+			throw error
+			{
+				error::code::FRAME_SIZE_ERROR, "%s frame length %u exceeds %u",
+				frame::reflect(header.type),
+				uint32_t(header.len),
+				ours[settings::code::MAX_FRAME_SIZE],
+			};
+
+		if(size(buf) - ret < frame::HEADER_SIZE + header.len)
+			break;
+
+		const const_buffer payload
+		{
+			data(buf) + ret + frame::HEADER_SIZE, header.len
+		};
+
+		handle_frame(header, payload);
+		ret += frame::HEADER_SIZE + header.len;
+	}
+
+	return ret;
+}
+
+void
+ircd::http2::session::handle_frame(const frame::header &header,
+                                   const const_buffer &payload_)
+{
+	const_buffer payload{payload_};
+	const uint32_t id(header.stream_id);
+	const uint8_t flags(header.flags);
+
+	// A header block must be continued without any frame interleaved (4.3).
+	if(block_id && (header.type != frame::type::CONTINUATION || id != block_id))
+		throw error
+		{
+			error::code::PROTOCOL_ERROR, "Expected CONTINUATION of stream %u; got %s on %u",
+			block_id,
+			frame::reflect(header.type),
+			id,
+		};
+
+	const auto strip_padding{[&payload, &flags]
+	{
+		if(!(flags & frame::flag::PADDED))
+			return;
+
+		const uint8_t pad
+		{
+			!empty(payload)? uint8_t(payload[0]) : uint8_t(0)
+		};
+
+		if(empty(payload) || pad >= size(payload))
+			throw error
+			{
+				error::code::PROTOCOL_ERROR, "Invalid padding."
+			};
+
+		payload = const_buffer
+		{
+			data(payload) + 1, size(payload) - 1 - pad
+		};
+	}};
+
+	const auto require{[&header](const bool &connection, const ssize_t &len = -1)
+	{
+		if(connection != (header.stream_id == 0))
+			throw error
+			{
+				error::code::PROTOCOL_ERROR, "%s frame on stream %u",
+				frame::reflect(header.type),
+				uint32_t(header.stream_id),
+			};
+
+		if(len >= 0 && header.len != size_t(len))
+			throw error
+			{
+				error::code::FRAME_SIZE_ERROR, "%s frame length %u",
+				frame::reflect(header.type),
+				uint32_t(header.len),
+			};
+	}};
+
+	switch(header.type)
+	{
+		case frame::type::DATA:
+		{
+			require(false);
+
+			// The entire frame including padding counts against the window
+			recv_window -= header.len;
+			if(recv_window < 0)
+				throw error
+				{
+					error::code::FLOW_CONTROL_ERROR, "Connection receive window exceeded."
+				};
+
+			strip_padding();
+			handle_data(id, payload, flags & frame::flag::END_STREAM);
+
+			// Data is buffered by the streams under their own flow control so
+			// the connection window is replenished as soon as it is half spent.
+			if(recv_window < recv_window_max / 2)
+			{
+				send_window_update(0, recv_window_max - recv_window);
+				recv_window = recv_window_max;
+			}
+
+			return;
+		}
+
+		case frame::type::HEADERS:
+		{
+			require(false);
+			strip_padding();
+			if(flags & frame::flag::PRIORITY_FLAG)
+			{
+				if(size(payload) < 5)
+					throw error
+					{
+						error::code::FRAME_SIZE_ERROR, "HEADERS priority truncated."
+					};
+
+				consume(payload, 5);
+			}
+
+			block.assign(data(payload), size(payload));
+			block_eos = flags & frame::flag::END_STREAM;
+			if(flags & frame::flag::END_HEADERS)
+				handle_block(id, block_eos);
+			else
+				block_id = id;
+
+			return;
+		}
+
+		case frame::type::CONTINUATION:
+		{
+			if(!block_id)
+				throw error
+				{
+					error::code::PROTOCOL_ERROR, "Unexpected CONTINUATION on stream %u",
+					id,
+				};
+
+			const size_t max
+			{
+				ours[settings::code::MAX_HEADER_LIST_SIZE]?: 64_KiB
+			};
+
+			if(size(block) + size(payload) > max)
+				throw error
+				{
+					error::code::ENHANCE_YOUR_CALM, "Header block exceeds %zu bytes.",
+					max,
+				};
+
+			block.append(data(payload), size(payload));
+			if(flags & frame::flag::END_HEADERS)
+			{
+				block_id = 0;
+				handle_block(id, block_eos);
+			}
+
+			return;
+		}
+
+		case frame::type::PRIORITY:
+			require(false, 5);
+			return;
+
+		case frame::type::RST_STREAM:
+			require(false, 4);
+			handle_rst(id, (enum error::code)(get32(data(payload))));
+			return;
+
+		case frame::type::SETTINGS:
+		{
+			require(true);
+			if(flags & frame::flag::ACK)
+			{
+				require(true, 0);
+				settings_acked = true;
+				return;
+			}
+
+			const int64_t window
+			{
+				theirs[settings::code::INITIAL_WINDOW_SIZE]
+			};
+
+			theirs.apply(payload);
+
+			char buf[frame::HEADER_SIZE];
+			const auto ack
+			{
+				make_header(buf, {0, frame::type::SETTINGS, frame::flag::ACK, 0})
+			};
+
+			out.append(data(ack), size(ack));
+			handle_settings(int64_t(theirs[settings::code::INITIAL_WINDOW_SIZE]) - window);
+			return;
+		}
+
+		case frame::type::PUSH_PROMISE:
+			throw error
+			{
+				error::code::PROTOCOL_ERROR, "PUSH_PROMISE is not accepted."
+			};
+
+		case frame::type::PING:
+		{
+			require(true, 8);
+			if(flags & frame::flag::ACK)
+				return;
+
+			char buf[frame::HEADER_SIZE];
+			const auto head
+			{
+				make_header(buf, {8, frame::type::PING, frame::flag::ACK, 0})
+			};
+
+			out.append(data(head), size(head));
+			out.append(data(payload), size(payload));
+			return;
+		}
+
+		case frame::type::GOAWAY:
+		{
+			require(true);
+			if(size(payload) < 8)
+				throw error
+				{
+					error::code::FRAME_SIZE_ERROR, "GOAWAY frame length %zu",
+					size(payload),
+				};
+
+			goaway_id = get32(data(payload)) & 0x7fffffffU;
+			goaway_recv = true;
+			handle_goaway(goaway_id, (enum error::code)(get32(data(payload) + 4)));
+			return;
+		}
+
+		case frame::type::WINDOW_UPDATE:
+		{
+			if(header.len != 4)
+				throw error
+				{
+					error::code::FRAME_SIZE_ERROR, "WINDOW_UPDATE frame length %u",
+					uint32_t(header.len),
+				};
+
+			const uint32_t increment
+			{
+				get32(data(payload)) & 0x7fffffffU
+			};
+
+			if(!increment && id)
+			{
+				send_rst(id, error::code::PROTOCOL_ERROR);
+				handle_rst(id, error::code::PROTOCOL_ERROR);
+				return;
+			}
+
+			if(!increment)
+				throw error
+				{
+					error::code::PROTOCOL_ERROR, "WINDOW_UPDATE increment of zero."
+				};
+
+			if(!id)
+			{
+				send_window += increment;
+				if(send_window > 0x7fffffffL)
+					throw error
+					{
+						error::code::FLOW_CONTROL_ERROR, "Connection send window overflow."
+					};
+			}
+
+			handle_window(id, increment);
+			return;
+		}
+
+		// Frames of unknown type are ignored (4.1)
+		default:
+			return;
+	}
+}
+
+void
+ircd::http2::session::handle_block(const uint32_t &id,
+                                   const bool &eos)
+{
+	const bool initiated_by_peer
+	{
+		bool(id & 1) == server
+	};
+
+	if(!initiated_by_peer && id > next_id)
+		throw error
+		{
+			error::code::PROTOCOL_ERROR, "HEADERS on idle stream %u",
+			id,
+		};
+
+	if(initiated_by_peer && id > last_id)
+		last_id = id;
+
+	const size_t max
+	{
+		ours[settings::code::MAX_HEADER_LIST_SIZE]?: 64_KiB
+	};
+
+	// The fields are gathered into one buffer before any view is made so
+	// the views remain valid for the handler.
+	std::string buf;
+	std::vector<std::array<size_t, 3>> pos;
+	decoder(const_buffer{block.data(), block.size()}, [&buf, &pos, &max]
+	(const string_view &name, const string_view &value)
+	{
+		if(size(buf) + size(name) + size(value) + hpack::overhead > max)
+			throw error
+			{
+				error::code::ENHANCE_YOUR_CALM, "Header list exceeds %zu bytes.",
+				max,
+			};
+
+		pos.emplace_back(std::array<size_t, 3>
+		{
+			size(buf), size(name), size(value)
+		});
+
+		buf.append(name);
+		buf.append(value);
+	});
+
+	block.clear();
+	std::vector<http::header> headers(size(pos));
+	for(size_t i(0); i < size(pos); ++i)
+	{
+		const auto &[off, nlen, vlen] {pos[i]};
+		headers[i].first = string_view{buf.data() + off, nlen};
+		headers[i].second = string_view{buf.data() + off + nlen, vlen};
+	}
+
+	handle_headers(id, vector_view<const http::header>(headers), eos);
+}
+
+void
+ircd::http2::session::send_preface()
+{
+	if(!server)
+		out.append(connection_preface);
+
+	char buf[64];
+	const auto settings
+	{
+		make_settings(buf, ours)
+	};
+
+	out.append(data(settings), size(settings));
+	if(recv_window_max > recv_window)
+	{
+		send_window_update(0, recv_window_max - recv_window);
+		recv_window = recv_window_max;
+	}
+}
+
+void
+ircd::http2::session::send_window_update(const uint32_t &id,
+                                  const uint32_t &increment)
+{
+	char buf[frame::HEADER_SIZE + 4];
+	make_header(buf, {4, frame::type::WINDOW_UPDATE, 0, id});
+	put32(buf + frame::HEADER_SIZE, increment & 0x7fffffffU);
+	out.append(buf, sizeof(buf));
+}
+
+void
+ircd::http2::session::send_rst(const uint32_t &id,
+                               const enum error::code &code)
+{
+	char buf[frame::HEADER_SIZE + 4];
+	make_header(buf, {4, frame::type::RST_STREAM, 0, id});
+	put32(buf + frame::HEADER_SIZE, uint32_t(code));
+	out.append(buf, sizeof(buf));
+}
+
+void
+ircd::http2::session::send_goaway(const enum error::code &code,
+                                  const string_view &debug_)
+{
+	const string_view debug
+	{
+		trunc(debug_, 256)
+	};
+
+	char buf[frame::HEADER_SIZE + 8];
+	make_header(buf, {uint32_t(8 + size(debug)), frame::type::GOAWAY, 0, 0});
+	put32(buf + frame::HEADER_SIZE, last_id);
+	put32(buf + frame::HEADER_SIZE + 4, uint32_t(code));
+	out.append(buf, sizeof(buf));
+	out.append(debug);
+}
+
+/// Composes a HEADERS frame followed by as many CONTINUATION frames as the
+/// peer's maximum frame size requires. The block is encoded in place after
+/// the first frame header and then spread out to make room for the others.
+ircd::const_buffer
+ircd::http2::session::make_headers(const mutable_buffer &buf,
+                                   const uint32_t &id,
+                                   const vector_view<const http::header> &headers,
+                                   const bool &eos)
+const
+{
+	if(unlikely(size(buf) < frame::HEADER_SIZE))
+		throw error
+		{
+			"Insufficient buffer for HEADERS frame."
+		};
+
+	const size_t len
+	{
+		size(encoder(mutable_buffer{data(buf) + frame::HEADER_SIZE, size(buf) - frame::HEADER_SIZE}, headers))
+	};
+
+	const size_t max(frame_max());
+	const size_t frames
+	{
+		std::max((len + max - 1) / max, size_t(1))
+	};
+
+	const size_t total
+	{
+		len + frames * frame::HEADER_SIZE
+	};
+
+	if(unlikely(size(buf) < total))
+		throw error
+		{
+			"Insufficient buffer for %zu frames of headers.",
+			frames,
+		};
+
+	for(size_t i(frames - 1); i > 0; --i)
+	{
+		const size_t off(i * max);
+		const size_t flen(std::min(len - off, max));
+		char *const dst(data(buf) + frame::HEADER_SIZE * (i + 1) + off);
+		std::memmove(dst, data(buf) + frame::HEADER_SIZE + off, flen);
+		make_header(mutable_buffer{dst - frame::HEADER_SIZE, frame::HEADER_SIZE},
+		{
+			uint32_t(flen),
+			frame::type::CONTINUATION,
+			uint8_t(i == frames - 1? frame::flag::END_HEADERS : 0),
+			id,
+		});
+	}
+
+	const uint8_t flags
+	{
+		uint8_t
+		(
+			(frames == 1? frame::flag::END_HEADERS : 0) |
+			(eos? frame::flag::END_STREAM : 0)
+		)
+	};
+
+	make_header(buf, {uint32_t(std::min(len, max)), frame::type::HEADERS, flags, id});
+	return { data(buf), total };
+}
+
+ircd::const_buffer
+ircd::http2::session::make_data(const mutable_buffer &head,
+                                const uint32_t &id,
+                                const size_t &len,
+                                const bool &eos)
+const
+{
+	assert(len <= frame_max());
+	return make_header(head,
+	{
+		uint32_t(len),
+		frame::type::DATA,
+		uint8_t(eos? frame::flag::END_STREAM : 0),
+		id,
+	});
+}
+
+size_t
+ircd::http2::session::frame_max()
+const
+{
+	return theirs[settings::code::MAX_FRAME_SIZE];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// hpack.h
+//
+
+namespace ircd::http2::hpack
+{
+	struct huffman_code;
+
+	extern const huffman_code huffman_table[257];
+
+	static size_t decode_int(const uint8_t *&, const uint8_t *const &, const uint8_t &prefix);
+	static void encode_int(mutable_buffer &, size_t, const uint8_t &prefix, const uint8_t &mask);
+	static string_view decode_str(mutable_buffer &, const uint8_t *&, const uint8_t *const &);
+	static void encode_str(mutable_buffer &, const string_view &);
+	static entry lookup(const table &, const size_t &index);
+}
+
+struct ircd::http2::hpack::huffman_code
+{
+	uint32_t code;
+	uint8_t bits;
+};
+
+/// RFC 7541 Appendix A
+decltype(ircd::http2::hpack::static_table)
+ircd::http2::hpack::static_table
+{
+	{ ":authority",                   ""               },
+	{ ":method",                      "GET"            },
+	{ ":method",                      "POST"           },
+	{ ":path",                        "/"              },
+	{ ":path",                        "/index.html"    },
+	{ ":scheme",                      "http"           },
+	{ ":scheme",                      "https"          },
+	{ ":status",                      "200"            },
+	{ ":status",                      "204"            },
+	{ ":status",                      "206"            },
+	{ ":status",                      "304"            },
+	{ ":status",                      "400"            },
+	{ ":status",                      "404"            },
+	{ ":status",                      "500"            },
+	{ "accept-charset",               ""               },
+	{ "accept-encoding",              "gzip, deflate"  },
+	{ "accept-language",              ""               },
+	{ "accept-ranges",                ""               },
+	{ "accept",                       ""               },
+	{ "access-control-allow-origin",  ""               },
+	{ "age",                          ""               },
+	{ "allow",                        ""               },
+	{ "authorization",                ""               },
+	{ "cache-control",                ""               },
+	{ "content-disposition",          ""               },
+	{ "content-encoding",             ""               },
+	{ "content-language",             ""               },
+	{ "content-length",               ""               },
+	{ "content-location",             ""               },
+	{ "content-range",                ""               },
+	{ "content-type",                 ""               },
+	{ "cookie",                       ""               },
+	{ "date",                         ""               },
+	{ "etag",                         ""               },
+	{ "expect",                       ""               },
+	{ "expires",                      ""               },
+	{ "from",                         ""               },
+	{ "host",                         ""               },
+	{ "if-match",                     ""               },
+	{ "if-modified-since",            ""               },
+	{ "if-none-match",                ""               },
+	{ "if-range",                     ""               },
+	{ "if-unmodified-since",          ""               },
+	{ "last-modified",                ""               },
+	{ "link",                         ""               },
+	{ "location",                     ""               },
+	{ "max-forwards",                 ""               },
+	{ "proxy-authenticate",           ""               },
+	{ "proxy-authorization",          ""               },
+	{ "range",                        ""               },
+	{ "referer",                      ""               },
+	{ "refresh",                      ""               },
+	{ "retry-after",                  ""               },
+	{ "server",                       ""               },
+	{ "set-cookie",                   ""               },
+	{ "strict-transport-security",    ""               },
+	{ "transfer-encoding",            ""               },
+	{ "user-agent",                   ""               },
+	{ "vary",                         ""               },
+	{ "via",                          ""               },
+	{ "www-authenticate",             ""               },
+};
+
+/// RFC 7541 Appendix B; indexed by symbol with EOS at 256.
+decltype(ircd::http2::hpack::huffman_table)
+ircd::http2::hpack::huffman_table
+{
+	{ 0x00001ff8, 13 }, { 0x007fffd8, 23 }, { 0x0fffffe2, 28 }, { 0x0fffffe3, 28 },
+	{ 0x0fffffe4, 28 }, { 0x0fffffe5, 28 }, { 0x0fffffe6, 28 }, { 0x0fffffe7, 28 },
+	{ 0x0fffffe8, 28 }, { 0x00ffffea, 24 }, { 0x3ffffffc, 30 }, { 0x0fffffe9, 28 },
+	{ 0x0fffffea, 28 }, { 0x3ffffffd, 30 }, { 0x0fffffeb, 28 }, { 0x0fffffec, 28 },
+	{ 0x0fffffed, 28 }, { 0x0fffffee, 28 }, { 0x0fffffef, 28 }, { 0x0ffffff0, 28 },
+	{ 0x0ffffff1, 28 }, { 0x0ffffff2, 28 }, { 0x3ffffffe, 30 }, { 0x0ffffff3, 28 },
+	{ 0x0ffffff4, 28 }, { 0x0ffffff5, 28 }, { 0x0ffffff6, 28 }, { 0x0ffffff7, 28 },
+	{ 0x0ffffff8, 28 }, { 0x0ffffff9, 28 }, { 0x0ffffffa, 28 }, { 0x0ffffffb, 28 },
+	{ 0x00000014,  6 }, { 0x000003f8, 10 }, { 0x000003f9, 10 }, { 0x00000ffa, 12 },
+	{ 0x00001ff9, 13 }, { 0x00000015,  6 }, { 0x000000f8,  8 }, { 0x000007fa, 11 },
+	{ 0x000003fa, 10 }, { 0x000003fb, 10 }, { 0x000000f9,  8 }, { 0x000007fb, 11 },
+	{ 0x000000fa,  8 }, { 0x00000016,  6 }, { 0x00000017,  6 }, { 0x00000018,  6 },
+	{ 0x00000000,  5 }, { 0x00000001,  5 }, { 0x00000002,  5 }, { 0x00000019,  6 },
+	{ 0x0000001a,  6 }, { 0x0000001b,  6 }, { 0x0000001c,  6 }, { 0x0000001d,  6 },
+	{ 0x0000001e,  6 }, { 0x0000001f,  6 }, { 0x0000005c,  7 }, { 0x000000fb,  8 },
+	{ 0x00007ffc, 15 }, { 0x00000020,  6 }, { 0x00000ffb, 12 }, { 0x000003fc, 10 },
+	{ 0x00001ffa, 13 }, { 0x00000021,  6 }, { 0x0000005d,  7 }, { 0x0000005e,  7 },
+	{ 0x0000005f,  7 }, { 0x00000060,  7 }, { 0x00000061,  7 }, { 0x00000062,  7 },
+	{ 0x00000063,  7 }, { 0x00000064,  7 }, { 0x00000065,  7 }, { 0x00000066,  7 },
+	{ 0x00000067,  7 }, { 0x00000068,  7 }, { 0x00000069,  7 }, { 0x0000006a,  7 },
+	{ 0x0000006b,  7 }, { 0x0000006c,  7 }, { 0x0000006d,  7 }, { 0x0000006e,  7 },
+	{ 0x0000006f,  7 }, { 0x00000070,  7 }, { 0x00000071,  7 }, { 0x00000072,  7 },
+	{ 0x000000fc,  8 }, { 0x00000073,  7 }, { 0x000000fd,  8 }, { 0x00001ffb, 13 },
+	{ 0x0007fff0, 19 }, { 0x00001ffc, 13 }, { 0x00003ffc, 14 }, { 0x00000022,  6 },
+	{ 0x00007ffd, 15 }, { 0x00000003,  5 }, { 0x00000023,  6 }, { 0x00000004,  5 },
+	{ 0x00000024,  6 }, { 0x00000005,  5 }, { 0x00000025,  6 }, { 0x00000026,  6 },
+	{ 0x00000027,  6 }, { 0x00000006,  5 }, { 0x00000074,  7 }, { 0x00000075,  7 },
+	{ 0x00000028,  6 }, { 0x00000029,  6 }, { 0x0000002a,  6 }, { 0x00000007,  5 },
+	{ 0x0000002b,  6 }, { 0x00000076,  7 }, { 0x0000002c,  6 }, { 0x00000008,  5 },
+	{ 0x00000009,  5 }, { 0x0000002d,  6 }, { 0x00000077,  7 }, { 0x00000078,  7 },
+	{ 0x00000079,  7 }, { 0x0000007a,  7 }, { 0x0000007b,  7 }, { 0x00007ffe, 15 },
+	{ 0x000007fc, 11 }, { 0x00003ffd, 14 }, { 0x00001ffd, 13 }, { 0x0ffffffc, 28 },
+	{ 0x000fffe6, 20 }, { 0x003fffd2, 22 }, { 0x000fffe7, 20 }, { 0x000fffe8, 20 },
+	{ 0x003fffd3, 22 }, { 0x003fffd4, 22 }, { 0x003fffd5, 22 }, { 0x007fffd9, 23 },
+	{ 0x003fffd6, 22 }, { 0x007fffda, 23 }, { 0x007fffdb, 23 }, { 0x007fffdc, 23 },
+	{ 0x007fffdd, 23 }, { 0x007fffde, 23 }, { 0x00ffffeb, 24 }, { 0x007fffdf, 23 },
+	{ 0x00ffffec, 24 }, { 0x00ffffed, 24 }, { 0x003fffd7, 22 }, { 0x007fffe0, 23 },
+	{ 0x00ffffee, 24 }, { 0x007fffe1, 23 }, { 0x007fffe2, 23 }, { 0x007fffe3, 23 },
+	{ 0x007fffe4, 23 }, { 0x001fffdc, 21 }, { 0x003fffd8, 22 }, { 0x007fffe5, 23 },
+	{ 0x003fffd9, 22 }, { 0x007fffe6, 23 }, { 0x007fffe7, 23 }, { 0x00ffffef, 24 },
+	{ 0x003fffda, 22 }, { 0x001fffdd, 21 }, { 0x000fffe9, 20 }, { 0x003fffdb, 22 },
+	{ 0x003fffdc, 22 }, { 0x007fffe8, 23 }, { 0x007fffe9, 23 }, { 0x001fffde, 21 },
+	{ 0x007fffea, 23 }, { 0x003fffdd, 22 }, { 0x003fffde, 22 }, { 0x00fffff0, 24 },
+	{ 0x001fffdf, 21 }, { 0x003fffdf, 22 }, { 0x007fffeb, 23 }, { 0x007fffec, 23 },
+	{ 0x001fffe0, 21 }, { 0x001fffe1, 21 }, { 0x003fffe0, 22 }, { 0x001fffe2, 21 },
+	{ 0x007fffed, 23 }, { 0x003fffe1, 22 }, { 0x007fffee, 23 }, { 0x007fffef, 23 },
+	{ 0x000fffea, 20 }, { 0x003fffe2, 22 }, { 0x003fffe3, 22 }, { 0x003fffe4, 22 },
+	{ 0x007ffff0, 23 }, { 0x003fffe5, 22 }, { 0x003fffe6, 22 }, { 0x007ffff1, 23 },
+	{ 0x03ffffe0, 26 }, { 0x03ffffe1, 26 }, { 0x000fffeb, 20 }, { 0x0007fff1, 19 },
+	{ 0x003fffe7, 22 }, { 0x007ffff2, 23 }, { 0x003fffe8, 22 }, { 0x01ffffec, 25 },
+	{ 0x03ffffe2, 26 }, { 0x03ffffe3, 26 }, { 0x03ffffe4, 26 }, { 0x07ffffde, 27 },
+	{ 0x07ffffdf, 27 }, { 0x03ffffe5, 26 }, { 0x00fffff1, 24 }, { 0x01ffffed, 25 },
+	{ 0x0007fff2, 19 }, { 0x001fffe3, 21 }, { 0x03ffffe6, 26 }, { 0x07ffffe0, 27 },
+	{ 0x07ffffe1, 27 }, { 0x03ffffe7, 26 }, { 0x07ffffe2, 27 }, { 0x00fffff2, 24 },
+	{ 0x001fffe4, 21 }, { 0x001fffe5, 21 }, { 0x03ffffe8, 26 }, { 0x03ffffe9, 26 },
+	{ 0x0ffffffd, 28 }, { 0x07ffffe3, 27 }, { 0x07ffffe4, 27 }, { 0x07ffffe5, 27 },
+	{ 0x000fffec, 20 }, { 0x00fffff3, 24 }, { 0x000fffed, 20 }, { 0x001fffe6, 21 },
+	{ 0x003fffe9, 22 }, { 0x001fffe7, 21 }, { 0x001fffe8, 21 }, { 0x007ffff3, 23 },
+	{ 0x003fffea, 22 }, { 0x003fffeb, 22 }, { 0x01ffffee, 25 }, { 0x01ffffef, 25 },
+	{ 0x00fffff4, 24 }, { 0x00fffff5, 24 }, { 0x03ffffea, 26 }, { 0x007ffff4, 23 },
+	{ 0x03ffffeb, 26 }, { 0x07ffffe6, 27 }, { 0x03ffffec, 26 }, { 0x03ffffed, 26 },
+	{ 0x07ffffe7, 27 }, { 0x07ffffe8, 27 }, { 0x07ffffe9, 27 }, { 0x07ffffea, 27 },
+	{ 0x07ffffeb, 27 }, { 0x0ffffffe, 28 }, { 0x07ffffec, 27 }, { 0x07ffffed, 27 },
+	{ 0x07ffffee, 27 }, { 0x07ffffef, 27 }, { 0x07fffff0, 27 }, { 0x03ffffee, 26 },
+	{ 0x3fffffff, 30 },
+};
+
+//
+// decoder
+//
+
+void
+ircd::http2::hpack::decoder::operator()(const const_buffer &block,
+                                        const closure &closure)
+{
+	// Huffman coding is at best 5 bits per octet so a string decodes to no
+	// more than 8/5 of its encoded length.
+	scratch.resize(std::max(scratch.size(), size(block) * 8 / 5 + 16));
+
+	const auto *it(reinterpret_cast<const uint8_t *>(data(block)));
+	const auto *const end(it + size(block));
+	while(it != end)
+	{
+		mutable_buffer buf
+		{
+			scratch.data(), scratch.size()
+		};
+
+		const uint8_t lead(*it);
+
+		// 6.1 Indexed Header Field
+		if(lead & 0x80)
+		{
+			const auto &[name, value]
+			{
+				lookup(table, decode_int(it, end, 7))
+			};
+
+			closure(name, value);
+			continue;
+		}
+
+		// 6.3 Dynamic Table Size Update
+		if((lead & 0xe0) == 0x20)
+		{
+			const size_t max
+			{
+				decode_int(it, end, 5)
+			};
+
+			if(max > max_size)
+				throw error
+				{
+					error::code::COMPRESSION_ERROR, "Table size update %zu exceeds %zu",
+					max,
+					max_size,
+				};
+
+			table.resize(max);
+			continue;
+		}
+
+		// 6.2.1 Literal with Incremental Indexing, else 6.2.2/6.2.3 literals
+		// without indexing or never indexed.
+		const bool indexing
+		{
+			(lead & 0xc0) == 0x40
+		};
+
+		const size_t index
+		{
+			decode_int(it, end, indexing? 6 : 4)
+		};
+
+		const string_view name
+		{
+			index?
+				lookup(table, index).first:
+				decode_str(buf, it, end)
+		};
+
+		const string_view value
+		{
+			decode_str(buf, it, end)
+		};
+
+		closure(name, value);
+		if(indexing)
+			table.insert(name, value);
+	}
+}
+
+//
+// encoder
+//
+
+/// 6.2.2 Literal Header Field without Indexing; the name is referenced from
+/// the static table when possible. Values are Huffman coded when shorter.
+ircd::const_buffer
+ircd::http2::hpack::encoder::operator()(const mutable_buffer &buf_,
+                                        const vector_view<const http::header> &headers)
+const
+{
+	mutable_buffer buf{buf_};
+	for(const auto &[name, value] : headers)
+	{
+		const auto it
+		{
+			std::find_if(std::begin(static_table), std::end(static_table), [&name]
+			(const auto &entry)
+			{
+				return iequals(entry.first, name);
+			})
+		};
+
+		if(it != std::end(static_table))
+		{
+			const size_t index(std::distance(std::begin(static_table), it) + 1);
+			encode_int(buf, index, 4, 0x00);
+		}
+		else
+		{
+			if(unlikely(size(buf) < 1 + 5 + size(name)))
+				throw error
+				{
+					"Insufficient buffer for header name."
+				};
+
+			consume(buf, copy(buf, "\0"_sv));
+			encode_int(buf, size(name), 7, 0x00);
+			consume(buf, size(tolower(buf, name)));
+		}
+
+		encode_str(buf, value);
+	}
+
+	return { data(buf_), data(buf) };
+}
+
+size_t
+ircd::http2::hpack::encoder::size_max(const vector_view<const http::header> &headers)
+{
+	return std::accumulate(begin(headers), end(headers), size_t(0), []
+	(const size_t &ret, const auto &header)
+	{
+		return ret + 1 + 5 + size(header.first) + 5 + size(header.second);
+	});
+}
+
+//
+// table
+//
+
+ircd::http2::hpack::entry
+ircd::http2::hpack::table::operator[](const size_t &index)
+const
+{
+	if(unlikely(index >= entries.size()))
+		throw error
+		{
+			error::code::COMPRESSION_ERROR, "Invalid dynamic table index %zu",
+			index,
+		};
+
+	const auto &[name, value]
+	{
+		entries.at(index)
+	};
+
+	return { name, value };
+}
+
+/// 4.4 Entry eviction when adding new entries. The entry is copied before
+/// any eviction because the name may reference an entry being evicted.
+void
+ircd::http2::hpack::table::insert(const string_view &name,
+                                  const string_view &value)
+{
+	std::pair<std::string, std::string> entry
+	{
+		name, value
+	};
+
+	const size_t entry_size
+	{
+		name.size() + value.size() + overhead
+	};
+
+	while(!entries.empty() && size + entry_size > max)
+	{
+		size -= entries.back().first.size() + entries.back().second.size() + overhead;
+		entries.pop_back();
+	}
+
+	// An entry larger than the table empties it without being added.
+	if(entry_size > max)
+		return;
+
+	entries.emplace_front(std::move(entry));
+	size += entry_size;
+}
+
+void
+ircd::http2::hpack::table::resize(const size_t &max)
+{
+	this->max = max;
+	while(!entries.empty() && size > max)
+	{
+		size -= entries.back().first.size() + entries.back().second.size() + overhead;
+		entries.pop_back();
+	}
+}
+
+//
+// huffman
+//
+
+size_t
+ircd::http2::hpack::huffman_size(const string_view &str)
+{
+	const size_t bits
+	{
+		std::accumulate(begin(str), end(str), size_t(0), []
+		(const size_t &ret, const char &c)
+		{
+			return ret + huffman_table[uint8_t(c)].bits;
+		})
+	};
+
+	return (bits + 7) / 8;
+}
+
+ircd::string_view
+ircd::http2::hpack::huffman_encode(const mutable_buffer &buf,
+                                   const string_view &str)
+{
+	if(unlikely(size(buf) < huffman_size(str)))
+		throw error
+		{
+			"Insufficient buffer for huffman coding."
+		};
+
+	char *out(data(buf));
+	uint64_t acc(0);
+	uint32_t bits(0);
+	for(const char &c : str)
+	{
+		const auto &code(huffman_table[uint8_t(c)]);
+		acc = (acc << code.bits) | code.code;
+		bits += code.bits;
+		for(; bits >= 8; bits -= 8)
+			*out++ = char(acc >> (bits - 8));
+	}
+
+	// Padding is the most significant bits of EOS; all ones (5.2).
+	if(bits)
+		*out++ = char((acc << (8 - bits)) | (0xffU >> bits));
+
+	return { data(buf), out };
+}
+
+/// The code is canonical: within each length the codes are consecutive and
+/// ordered by symbol, so the codes of a length are found by the first code
+/// and the count of that length.
+ircd::string_view
+ircd::http2::hpack::huffman_decode(const mutable_buffer &buf,
+                                   const const_buffer &in)
+{
+	struct canon
+	{
+		uint32_t first[32] {0};
+		uint16_t count[32] {0};
+		uint16_t offset[32] {0};
+		uint16_t symbol[257] {0};
+	};
+
+	static const canon canon{[]
+	{
+		struct canon ret;
+		for(size_t i(0); i < 257; ++i)
+			++ret.count[huffman_table[i].bits];
+
+		for(size_t i(1), off(0); i < 32; off += ret.count[i++])
+			ret.offset[i] = off;
+
+		uint16_t pos[32];
+		std::copy(std::begin(ret.offset), std::end(ret.offset), pos);
+		for(size_t i(0); i < 257; ++i)
+		{
+			const auto &code(huffman_table[i]);
+			if(!ret.count[code.bits] || pos[code.bits] == ret.offset[code.bits])
+				ret.first[code.bits] = code.code;
+
+			ret.symbol[pos[code.bits]++] = i;
+		}
+
+		return ret;
+	}()};
+
+	char *out(data(buf));
+	uint32_t code(0), bits(0);
+	for(const char &c : in)
+		for(int b(7); b >= 0; --b)
+		{
+			code = (code << 1) | ((uint8_t(c) >> b) & 1);
+			++bits;
+
+			const uint32_t idx(code - canon.first[bits]);
+			if(canon.count[bits] && code >= canon.first[bits] && idx < canon.count[bits])
+			{
+				const auto &symbol(canon.symbol[canon.offset[bits] + idx]);
+				if(unlikely(symbol == 256))
+					throw error
+					{
+						error::code::COMPRESSION_ERROR, "EOS in huffman string."
+					};
+
+				if(unlikely(out >= data(buf) + size(buf)))
+					throw error
+					{
+						error::code::COMPRESSION_ERROR, "Huffman string too large."
+					};
+
+				*out++ = char(symbol);
+				code = 0;
+				bits = 0;
+				continue;
+			}
+
+			if(unlikely(bits >= 30))
+				throw error
+				{
+					error::code::COMPRESSION_ERROR, "Invalid huffman code."
+				};
+		}
+
+	// Remaining bits must be fewer than 8 and all ones (5.2).
+	if(unlikely(bits > 7 || code != (1U << bits) - 1))
+		throw error
+		{
+			error::code::COMPRESSION_ERROR, "Invalid huffman padding."
+		};
+
+	return { data(buf), out };
+}
+
+//
+// util
+//
+
+ircd::http2::hpack::entry
+ircd::http2::hpack::lookup(const table &table,
+                           const size_t &index)
+{
+	if(unlikely(!index))
+		throw error
+		{
+			error::code::COMPRESSION_ERROR, "Index of zero."
+		};
+
+	if(index <= std::size(static_table))
+		return static_table[index - 1];
+
+	return table[index - std::size(static_table) - 1];
+}
+
+/// 5.1 Integer Representation
+size_t
+ircd::http2::hpack::decode_int(const uint8_t *&it,
+                               const uint8_t *const &end,
+                               const uint8_t &prefix)
+{
+	assert(it != end);
+	const uint8_t max((1U << prefix) - 1);
+	size_t ret(*it++ & max);
+	if(ret < max)
+		return ret;
+
+	for(uint8_t m(0); it != end && m <= 28; m += 7)
+	{
+		const uint8_t b(*it++);
+		ret += size_t(b & 0x7f) << m;
+		if(!(b & 0x80))
+			return ret;
+	}
+
+	throw error
+	{
+		error::code::COMPRESSION_ERROR, "Invalid integer representation."
+	};
+}
+
+void
+ircd::http2::hpack::encode_int(mutable_buffer &buf,
+                               size_t val,
+                               const uint8_t &prefix,
+                               const uint8_t &mask)
+{
+	if(unlikely(size(buf) < 1 + 5))
+		throw error
+		{
+			"Insufficient buffer for integer."
+		};
+
+	const uint8_t max((1U << prefix) - 1);
+	auto *p(reinterpret_cast<uint8_t *>(data(buf)));
+	if(val < max)
+	{
+		*p++ = mask | uint8_t(val);
+		consume(buf, 1);
+		return;
+	}
+
+	*p++ = mask | max;
+	for(val -= max; val >= 0x80; val >>= 7)
+		*p++ = uint8_t(val & 0x7f) | 0x80;
+
+	*p++ = uint8_t(val);
+	consume(buf, p - reinterpret_cast<uint8_t *>(data(buf)));
+}
+
+/// 5.2 String Literal Representation. Huffman strings are decoded into the
+/// buffer, which is consumed; raw strings are a view of the input.
+ircd::string_view
+ircd::http2::hpack::decode_str(mutable_buffer &buf,
+                               const uint8_t *&it,
+                               const uint8_t *const &end)
+{
+	if(unlikely(it == end))
+		throw error
+		{
+			error::code::COMPRESSION_ERROR, "Truncated string."
+		};
+
+	const bool huffman(*it & 0x80);
+	const size_t len
+	{
+		decode_int(it, end, 7)
+	};
+
+	if(unlikely(size_t(end - it) < len))
+		throw error
+		{
+			error::code::COMPRESSION_ERROR, "Truncated string of %zu bytes.",
+			len,
+		};
+
+	const const_buffer str
+	{
+		reinterpret_cast<const char *>(it), len
+	};
+
+	it += len;
+	if(!huffman)
+		return string_view{str};
+
+	const string_view ret
+	{
+		huffman_decode(buf, str)
+	};
+
+	consume(buf, size(ret));
+	return ret;
+}
+
+void
+ircd::http2::hpack::encode_str(mutable_buffer &buf,
+                               const string_view &str)
+{
+	const size_t hlen
+	{
+		huffman_size(str)
+	};
+
+	const bool huffman
+	{
+		hlen < size(str)
+	};
+
+	encode_int(buf, huffman? hlen : size(str), 7, huffman? 0x80 : 0x00);
+	if(unlikely(size(buf) < (huffman? hlen : size(str))))
+		throw error
+		{
+			"Insufficient buffer for string."
+		};
+
+	consume(buf, huffman?
+		size(huffman_encode(buf, str)):
+		copy(buf, str));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // stream.h
@@ -27,6 +1245,60 @@ ircd::http2::stream::stream()
 {
 }
 
+/// Stream opened by HEADERS; the windows start at the initial window size
+/// advertised by each side.
+ircd::http2::stream::stream(const uint32_t &id,
+                            const settings &ours,
+                            const settings &theirs)
+:id
+{
+	id
+}
+,state
+{
+	state::OPEN
+}
+,send_window
+{
+	theirs[settings::code::INITIAL_WINDOW_SIZE]
+}
+,recv_window
+{
+	ours[settings::code::INITIAL_WINDOW_SIZE]
+}
+{
+}
+
+void
+ircd::http2::stream::close_local()
+{
+	state = remote_closed()?
+		state::CLOSED:
+		state::HALF_CLOSED_LOCAL;
+}
+
+void
+ircd::http2::stream::close_remote()
+{
+	state = local_closed()?
+		state::CLOSED:
+		state::HALF_CLOSED_REMOTE;
+}
+
+bool
+ircd::http2::stream::remote_closed()
+const
+{
+	return state == state::HALF_CLOSED_REMOTE || state == state::CLOSED;
+}
+
+bool
+ircd::http2::stream::local_closed()
+const
+{
+	return state == state::HALF_CLOSED_LOCAL || state == state::CLOSED;
+}
+
 ircd::string_view
 ircd::http2::reflect(const enum stream::state &state)
 {
@@ -64,6 +1336,113 @@ ircd::http2::settings::settings()
 {
 }
 
+/// Applies the parameters of a received SETTINGS frame payload. Unknown
+/// parameters are ignored as required (6.5.2).
+void
+ircd::http2::settings::apply(const const_buffer &payload)
+{
+	if(buffer::size(payload) % sizeof(struct frame::settings::param) != 0)
+		throw error
+		{
+			error::code::FRAME_SIZE_ERROR, "SETTINGS payload size %zu",
+			buffer::size(payload),
+		};
+
+	for(size_t i(0); i < buffer::size(payload); i += sizeof(struct frame::settings::param))
+	{
+		const auto *const p
+		{
+			buffer::data(payload) + i
+		};
+
+		const auto id(get16(p));
+		const auto value(get32(p + 2));
+		switch(id)
+		{
+			case code::ENABLE_PUSH:
+				if(value > 1)
+					throw error
+					{
+						error::code::PROTOCOL_ERROR, "ENABLE_PUSH value %u",
+						value,
+					};
+				break;
+
+			case code::INITIAL_WINDOW_SIZE:
+				if(value > 0x7fffffffU)
+					throw error
+					{
+						error::code::FLOW_CONTROL_ERROR, "INITIAL_WINDOW_SIZE value %u",
+						value,
+					};
+				break;
+
+			case code::MAX_FRAME_SIZE:
+				if(value < 16384 || value > 0xffffffU)
+					throw error
+					{
+						error::code::PROTOCOL_ERROR, "MAX_FRAME_SIZE value %u",
+						value,
+					};
+				break;
+
+			case code::HEADER_TABLE_SIZE:
+			case code::MAX_CONCURRENT_STREAMS:
+			case code::MAX_HEADER_LIST_SIZE:
+				break;
+
+			default:
+				continue;
+		}
+
+		(*this)[code(id)] = value;
+	}
+}
+
+/// Composes a SETTINGS frame advertising the parameters which differ from
+/// the protocol defaults.
+ircd::const_buffer
+ircd::http2::make_settings(const mutable_buffer &buf,
+                           const settings &settings)
+{
+	static const http2::settings defaults;
+
+	static const size_t max
+	{
+		frame::HEADER_SIZE + sizeof(struct frame::settings::param) * (num_of<http2::settings::code>() - 1)
+	};
+
+	if(unlikely(size(buf) < max))
+		throw error
+		{
+			"Insufficient buffer for SETTINGS frame."
+		};
+
+	char *p
+	{
+		data(buf) + frame::HEADER_SIZE
+	};
+
+	for(uint16_t i(1); i < num_of<http2::settings::code>(); ++i)
+	{
+		const auto code{http2::settings::code(i)};
+		if(settings[code] == defaults[code])
+			continue;
+
+		put16(p, i);
+		put32(p + 2, settings[code]);
+		p += sizeof(struct frame::settings::param);
+	}
+
+	const uint32_t len
+	{
+		uint32_t(p - data(buf) - frame::HEADER_SIZE)
+	};
+
+	make_header(buf, {len, frame::type::SETTINGS, 0, 0});
+	return { data(buf), p };
+}
+
 ircd::string_view
 ircd::http2::reflect(const frame::settings::code &code)
 {
@@ -91,6 +1470,82 @@ static_assert
     sizeof(ircd::http2::frame::header) == 9
 );
 
+ircd::http2::frame::header::header(const const_buffer &buf)
+{
+	if(unlikely(size(buf) < HEADER_SIZE))
+		throw error
+		{
+			error::code::FRAME_SIZE_ERROR, "Incomplete frame header"
+		};
+
+	const auto *const p
+	{
+		reinterpret_cast<const uint8_t *>(data(buf))
+	};
+
+	this->len = (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | uint32_t(p[2]);
+	this->type = (enum type)p[3];
+	this->flags = p[4];
+	this->stream_id = get32(data(buf) + 5) & 0x7fffffffU;
+}
+
+ircd::http2::frame::header::header(const uint32_t &len,
+                                   const enum type &type,
+                                   const uint8_t &flags,
+                                   const uint32_t &stream_id)
+:len{len}
+,type{type}
+,flags{flags}
+,stream_id{stream_id}
+{
+	assert(len <= 0xffffffU);
+	assert(stream_id <= 0x7fffffffU);
+}
+
+ircd::const_buffer
+ircd::http2::make_header(const mutable_buffer &buf,
+                         const frame::header &header)
+{
+	if(unlikely(size(buf) < frame::HEADER_SIZE))
+		throw error
+		{
+			"Insufficient buffer for frame header."
+		};
+
+	auto *const p
+	{
+		reinterpret_cast<uint8_t *>(data(buf))
+	};
+
+	p[0] = uint8_t(header.len >> 16);
+	p[1] = uint8_t(header.len >> 8);
+	p[2] = uint8_t(header.len);
+	p[3] = uint8_t(header.type);
+	p[4] = header.flags;
+	put32(data(buf) + 5, header.stream_id & 0x7fffffffU);
+	return { data(buf), frame::HEADER_SIZE };
+}
+
+ircd::string_view
+ircd::http2::frame::reflect(const type &type)
+{
+	switch(type)
+	{
+		case type::DATA:                 return "DATA";
+		case type::HEADERS:              return "HEADERS";
+		case type::PRIORITY:             return "PRIORITY";
+		case type::RST_STREAM:           return "RST_STREAM";
+		case type::SETTINGS:             return "SETTINGS";
+		case type::PUSH_PROMISE:         return "PUSH_PROMISE";
+		case type::PING:                 return "PING";
+		case type::GOAWAY:               return "GOAWAY";
+		case type::WINDOW_UPDATE:        return "WINDOW_UPDATE";
+		case type::CONTINUATION:         return "CONTINUATION";
+	}
+
+	return "??????";
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -167,3 +1622,40 @@ ircd::http2::reflect(const enum error::code &code)
 
 	return "??????";
 }
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// (internal)
+//
+
+uint16_t
+ircd::http2::get16(const char *const p)
+{
+	uint16_t ret;
+	memcpy(&ret, p, sizeof(ret));
+	return ntohs(ret);
+}
+
+uint32_t
+ircd::http2::get32(const char *const p)
+{
+	uint32_t ret;
+	memcpy(&ret, p, sizeof(ret));
+	return ntohl(ret);
+}
+
+void
+ircd::http2::put16(char *const p,
+                   const uint16_t &val)
+{
+	const uint16_t v(htons(val));
+	memcpy(p, &v, sizeof(v));
+}
+
+void
+ircd::http2::put32(char *const p,
+                   const uint32_t &val)
+{
+	const uint32_t v(htonl(val));
+	memcpy(p, &v, sizeof(v));
+}
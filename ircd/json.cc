@@ -2841,6 +2841,94 @@ ircd::json::object::const_iterator::operator++()
 	return *this;
 }
 
+//
+// object::index
+//
+
+ircd::json::object::index::index(const json::object &object)
+:object
+{
+	object
+}
+{
+}
+
+ircd::string_view
+ircd::json::object::index::operator[](const string_view &key)
+const
+{
+	return find(name_hash(key));
+}
+
+ircd::string_view
+ircd::json::object::index::get(const string_view &key,
+                               const string_view &def)
+const
+{
+	return get<string_view>(key, def);
+}
+
+bool
+ircd::json::object::index::has(const string_view &key)
+const
+{
+	return !find(name_hash(key)).empty();
+}
+
+ircd::string_view
+ircd::json::object::index::find(const name_hash_t &key)
+const
+{
+	if(!built)
+		build();
+
+	for(size_t i(0); i < count; ++i)
+		if(entries[i].hash == key)
+			return string_view
+			{
+				object.data() + entries[i].offset, entries[i].length
+			};
+
+	if(likely(!overflow))
+		return {};
+
+	const auto it
+	{
+		object.find(key)
+	};
+
+	return it != object.end()?
+		it->second:
+		string_view{};
+}
+
+void
+ircd::json::object::index::build()
+const
+{
+	assert(!built);
+	built = true;
+	if(object.empty())
+		return;
+
+	for(const auto &[key, val] : object)
+	{
+		if(unlikely(count >= entries.size()))
+		{
+			overflow = true;
+			break;
+		}
+
+		assert(val.data() >= object.data());
+		entries[count++] =
+		{
+			name_hash(key),
+			uint32_t(val.data() - object.data()),
+			uint32_t(val.size()),
+		};
+	}
+}
+
 //
 // object::member
 //
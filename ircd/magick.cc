@@ -29,14 +29,20 @@ namespace ircd::magick
 	template<class R, class F, class... A> static R call(F&&, A&&...);
 	template<class R, class F, class... A> static R callex(F&&, A&&...);
 	template<class F, class... A> static void callpf(F&&, A&&...);
+	static void offload(const std::function<void ()> &);
 
 	extern bool call_ready;
+	extern size_t offload_running;
+	extern size_t offload_waiting;
 	extern ctx::dock call_dock;
 	extern ctx::mutex call_mutex;
 	extern conf::item<uint64_t> limit_ticks;
 	extern conf::item<uint64_t> limit_cycles;
 	extern conf::item<uint64_t> yield_threshold;
 	extern conf::item<uint64_t> yield_interval;
+	extern conf::item<bool> offload_enable;
+	extern conf::item<size_t> offload_concurrency;
+	extern conf::item<size_t> offload_queue_max;
 	extern log::log log;
 }
 
@@ -89,6 +95,40 @@ ircd::magick::yield_interval
 	{ "default", 768L                         },
 };
 
+/// Run the decoding, transformation and encoding of jobs on the ctx::ole
+/// worker threads. The calling context waits and the result is presented
+/// to it as usual; the main thread is not blocked by large images.
+decltype(ircd::magick::offload_enable)
+ircd::magick::offload_enable
+{
+	{ "name",    "ircd.magick.offload.enable" },
+	{ "default", true                         },
+};
+
+/// The number of jobs offloaded at the same time. Note the number of worker
+/// threads is also bounded by ircd.ctx.ole.thread.max.
+decltype(ircd::magick::offload_concurrency)
+ircd::magick::offload_concurrency
+{
+	{ "name",    "ircd.magick.offload.concurrency" },
+	{ "default", 2L                                },
+};
+
+/// The number of jobs waiting for an offload slot before further jobs are
+/// rejected.
+decltype(ircd::magick::offload_queue_max)
+ircd::magick::offload_queue_max
+{
+	{ "name",    "ircd.magick.offload.queue.max" },
+	{ "default", 64L                             },
+};
+
+decltype(ircd::magick::offload_running)
+ircd::magick::offload_running;
+
+decltype(ircd::magick::offload_waiting)
+ircd::magick::offload_waiting;
+
 // It is likely that we can't have two contexts enter libmagick
 // simultaneously. This race is possible if the progress callback yields
 // and another context starts an operation. It is highly unlikely the lib
@@ -259,7 +299,7 @@ noexcept
 	call_ready = false;
 	call_dock.wait([]
 	{
-		return !call_mutex.locked();
+		return !call_mutex.locked() && !offload_running;
 	});
 
 	DestroyMagick();
@@ -437,34 +477,47 @@ ircd::magick::transform::transform(const const_buffer &input,
                                    const output &output,
                                    const transformer &transformer)
 {
-	const custom_ptr<ImageInfo> input_info
+	size_t output_size(0);
+	void *output_data(nullptr);
+	const auto encode{[&input, &transformer, &output_size, &output_data]
 	{
-		CloneImageInfo(nullptr),
-		DestroyImageInfo
-	};
+		const custom_ptr<ImageInfo> input_info
+		{
+			CloneImageInfo(nullptr),
+			DestroyImageInfo
+		};
 
-	const custom_ptr<ImageInfo> output_info
-	{
-		CloneImageInfo(nullptr),
-		DestroyImageInfo
-	};
+		const custom_ptr<ImageInfo> output_info
+		{
+			CloneImageInfo(nullptr),
+			DestroyImageInfo
+		};
 
-	const custom_ptr<Image> input_image
-	{
-		callex<Image *>(BlobToImage, input_info.get(), data(input), size(input)),
-		DestroyImage // pollock
-	};
+		const custom_ptr<Image> input_image
+		{
+			callex<Image *>(BlobToImage, input_info.get(), data(input), size(input)),
+			DestroyImage // pollock
+		};
 
-	const custom_ptr<Image> output_image
-	{
-		transformer({*input_info, input_image.get()}),
-		DestroyImage
-	};
+		const custom_ptr<Image> output_image
+		{
+			transformer({*input_info, input_image.get()}),
+			DestroyImage
+		};
 
-	size_t output_size(0);
-	const auto output_data
+		output_data = callex<void *>(ImageToBlob, output_info.get(), output_image.get(), &output_size);
+	}};
+
+	// The output closure is always called on this context; only the work
+	// of the library is offloaded.
+	if(offload_enable && ctx::current)
+		offload(encode);
+	else
+		encode();
+
+	const custom_ptr<void> output_blob
 	{
-		callex<void *>(ImageToBlob, output_info.get(), output_image.get(), &output_size)
+		output_data, MagickFree
 	};
 
 	const const_buffer result
@@ -509,6 +562,48 @@ ircd::magick::display::display(const ImageInfo &info,
 // util (internal)
 //
 
+/// Waits for one of the offload slots and then executes the function on
+/// a worker thread while this context waits.
+void
+ircd::magick::offload(const std::function<void ()> &func)
+{
+	if(unlikely(offload_waiting >= size_t(offload_queue_max)))
+		throw error
+		{
+			"Too many graphics jobs queued (%zu running; %zu waiting).",
+			offload_running,
+			offload_waiting,
+		};
+
+	++offload_waiting;
+	const unwind unwait{[]
+	{
+		--offload_waiting;
+	}};
+
+	call_dock.wait([]
+	{
+		return offload_running < std::max(size_t(offload_concurrency), 1UL);
+	});
+
+	++offload_running;
+	const unwind unrun{[]
+	{
+		--offload_running;
+		call_dock.notify_all();
+	}};
+
+	const ctx::ole::opts opts
+	{
+		"magick"
+	};
+
+	ctx::offload
+	{
+		opts, func
+	};
+}
+
 template<class return_t,
          class function,
          class... args>
@@ -522,11 +617,16 @@ ircd::magick::callex(function&& f,
 			"Graphics library not ready."
 		};
 
-	const std::lock_guard lock
+	// Offloaded jobs run on their own thread and can't take the ctx::mutex
+	// (nor yield while within the library).
+	std::unique_lock lock
 	{
-		call_mutex
+		call_mutex, std::defer_lock
 	};
 
+	if(ctx::current)
+		lock.lock();
+
 	ExceptionInfo ei;
 	GetExceptionInfo(&ei); // initializer
 	const unwind destroy{[&ei]
@@ -579,11 +679,14 @@ ircd::magick::call(function&& f,
 			"Graphics library not ready."
 		};
 
-	const std::lock_guard lock
+	std::unique_lock lock
 	{
-		call_mutex
+		call_mutex, std::defer_lock
 	};
 
+	if(ctx::current)
+		lock.lock();
+
 	assert(call_ready);
 	return f(std::forward<args>(a)...);
 }
@@ -628,7 +731,9 @@ noexcept try
 	// and monotonically increases across jobs as well.
 	const auto cycles_sample
 	{
-		ctx::this_ctx::cycles()
+		ctx::current?
+			ctx::this_ctx::cycles():
+			prof::cycles()
 	};
 
 	// Detect if this is a new job. Tick is usually zero for a new job, but for
@@ -748,6 +853,10 @@ ircd::magick::check_yield(job &job)
 	if(likely(job.ticks < yield_threshold))
 		return false;
 
+	// This job is running on a worker thread; there's nothing to yield.
+	if(!ctx::current)
+		return false;
+
 	const uint64_t &yield_interval
 	{
 		magick::yield_interval
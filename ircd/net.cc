@@ -12,6 +12,7 @@ namespace ircd::net
 {
 	ctx::dock dock;
 	std::optional<dns::init> _dns_;
+	std::optional<iou::init> _iou_;
 
 	static void init_ipv6();
 	static void wait_close_sockets();
@@ -72,6 +73,7 @@ ircd::net::init::init()
 	sslv23_client.set_verify_mode(asio::ssl::verify_peer);
 	sslv23_client.set_default_verify_paths();
 	_dns_.emplace();
+	_iou_.emplace();
 }
 
 /// Network subsystem shutdown
@@ -80,6 +82,7 @@ noexcept
 {
 	_dns_.reset();
 	wait_close_sockets();
+	_iou_.reset();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1298,9 +1301,13 @@ ircd::net::socket::socket(asio::ssl::context &ssl)
 {
 	ios::get()
 }
+,stream
+{
+	this->sd
+}
 ,ssl
 {
-	this->sd, ssl
+	this->stream, ssl
 }
 ,timer
 {
@@ -1407,6 +1414,9 @@ ircd::net::socket::handshake(const open_opts &opts,
 	if(opts.send_sni && server_name(opts))
 		openssl::server_name(*this, server_name(opts));
 
+	if(!empty(opts.alpn))
+		openssl::alpn(*this, opts.alpn);
+
 	ssl.set_verify_callback(std::move(verify_handler));
 	ssl.async_handshake(handshake_type::client, ios::handle(desc_handshake, std::move(handshake_handler)));
 }
@@ -1500,6 +1510,7 @@ ircd::net::socket::cancel()
 noexcept
 {
 	cancel_timeout();
+	stream.cancel();
 
 	boost::system::error_code ec;
 	sd.cancel(ec);
@@ -1803,7 +1814,8 @@ catch(const boost::system::system_error &e)
 	throw_system_error(e);
 }
 
-/// Non-blocking; as much as possible without blocking
+/// Non-blocking; as much as possible without blocking. Always a direct system
+/// call, even with the net::iou ring active.
 template<class iov>
 size_t
 ircd::net::socket::read_any(iov&& bufs)
@@ -1836,7 +1848,8 @@ ircd::net::socket::read_any(iov&& bufs)
 	__builtin_unreachable();
 }
 
-/// Non-blocking; One system call only; never throws eof;
+/// Non-blocking; One system call only; never throws eof; Always a direct
+/// system call, even with the net::iou ring active.
 template<class iov>
 size_t
 ircd::net::socket::read_one(iov&& bufs)
@@ -1937,7 +1950,8 @@ catch(const boost::system::system_error &e)
 	throw_system_error(e);
 }
 
-/// Non-blocking; writes as much as possible without blocking
+/// Non-blocking; writes as much as possible without blocking. Always a direct
+/// system call, even with the net::iou ring active.
 template<class iov>
 size_t
 ircd::net::socket::write_any(iov&& bufs)
@@ -1966,7 +1980,8 @@ catch(const boost::system::system_error &e)
 	throw_system_error(e);
 }
 
-/// Non-blocking; Writes one "unit" of data or less; never more.
+/// Non-blocking; Writes one "unit" of data or less; never more. Always a
+/// direct system call, even with the net::iou ring active.
 template<class iov>
 size_t
 ircd::net::socket::write_one(iov&& bufs)
@@ -2330,6 +2345,10 @@ noexcept try
 	if(!ec)
 		blocking(*this, false);
 
+	// Record the application protocol if one was negotiated.
+	if(!ec)
+		strlcpy(alpn, openssl::alpn(*this));
+
 	// This is the end of the asynchronous call chain; the user is called
 	// back with or without error here.
 	call_user(callback, ec);
@@ -2652,6 +2671,204 @@ const
 	return *ssl.native_handle();
 }
 
+//
+// transport
+//
+
+ircd::net::transport::transport(ip::tcp::socket &sd)
+noexcept
+:sd{sd}
+{
+}
+
+/// Operations still in flight are detached; their results are discarded
+/// and the kernel only ever references buffers owned by the ring.
+ircd::net::transport::~transport()
+noexcept
+{
+	for(auto &op : pending)
+		if(op)
+			iou::detach(*std::exchange(op, nullptr));
+}
+
+bool
+ircd::net::transport::cancel()
+noexcept
+{
+	bool ret(false);
+	for(auto *const &op : pending)
+		if(op)
+			ret |= iou::cancel(*op);
+
+	return ret;
+}
+
+void
+ircd::net::transport::submit(const mutable_buffer &buf,
+                             handler &&h)
+{
+	assert(!pending[0]);
+	pending[0] = iou::recv(sd.native_handle(), buf, [this, h(std::move(h))]
+	(const int32_t &res)
+	{
+		pending[0] = nullptr;
+		if(unlikely(res == 0))
+			return h(asio::error::eof, 0UL);
+
+		h(make_error(res), std::max(res, 0));
+	});
+}
+
+void
+ircd::net::transport::submit(const const_buffer &buf,
+                             handler &&h)
+{
+	assert(!pending[1]);
+	pending[1] = iou::send(sd.native_handle(), buf, [this, h(std::move(h))]
+	(const int32_t &res)
+	{
+		pending[1] = nullptr;
+		h(make_error(res), std::max(res, 0));
+	});
+}
+
+boost::system::error_code
+ircd::net::transport::make_error(const int32_t &res)
+noexcept
+{
+	return res < 0?
+		error_code{-res, asio::error::get_system_category()}:
+		error_code{};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// net/iou.h
+//
+
+/// True if io_uring support was compiled; whether or not the kernel is able.
+decltype(ircd::net::iou::support)
+ircd::net::iou::support
+{
+	#if defined(IRCD_USE_IOU)
+		true
+	#else
+		false
+	#endif
+};
+
+/// Conf item to enable the ring for sockets. This takes effect when the
+/// network subsystem initializes, so it is not persisted; set it from the
+/// environment or command line.
+decltype(ircd::net::iou::enable)
+ircd::net::iou::enable
+{
+	{ "name",     "ircd.net.iou.enable"  },
+	{ "default",  false                  },
+	{ "persist",  false                  },
+};
+
+/// Number of entries of the submission queue.
+decltype(ircd::net::iou::entries)
+ircd::net::iou::entries
+{
+	{ "name",     "ircd.net.iou.entries"  },
+	{ "default",  1024L                   },
+	{ "persist",  false                   },
+};
+
+/// Number of buffers in the pool; this bounds the number of reads and
+/// writes in flight on the ring at any time.
+decltype(ircd::net::iou::buffers)
+ircd::net::iou::buffers
+{
+	{ "name",     "ircd.net.iou.buffers"  },
+	{ "default",  256L                    },
+	{ "persist",  false                   },
+};
+
+/// Non-null when the ring is active for sockets.
+decltype(ircd::net::iou::system)
+ircd::net::iou::system;
+
+#ifndef IRCD_USE_IOU
+[[gnu::weak]]
+ircd::net::iou::init::init()
+{
+	assert(!system);
+}
+#endif
+
+#ifndef IRCD_USE_IOU
+[[gnu::weak]]
+ircd::net::iou::init::~init()
+noexcept
+{
+	assert(!system);
+}
+#endif
+
+#ifndef IRCD_USE_IOU
+[[gnu::weak]]
+bool
+ircd::net::iou::available()
+noexcept
+{
+	return false;
+}
+#endif
+
+#ifndef IRCD_USE_IOU
+[[gnu::weak]]
+ircd::net::iou::op *
+ircd::net::iou::accept(const int &fd,
+                       callback callback)
+{
+	throw ircd::not_implemented{};
+}
+#endif
+
+#ifndef IRCD_USE_IOU
+[[gnu::weak]]
+ircd::net::iou::op *
+ircd::net::iou::recv(const int &fd,
+                     const mutable_buffer &buf,
+                     callback callback)
+{
+	throw ircd::not_implemented{};
+}
+#endif
+
+#ifndef IRCD_USE_IOU
+[[gnu::weak]]
+ircd::net::iou::op *
+ircd::net::iou::send(const int &fd,
+                     const const_buffer &buf,
+                     callback callback)
+{
+	throw ircd::not_implemented{};
+}
+#endif
+
+#ifndef IRCD_USE_IOU
+[[gnu::weak]]
+bool
+ircd::net::iou::cancel(op &op)
+noexcept
+{
+	return false;
+}
+#endif
+
+#ifndef IRCD_USE_IOU
+[[gnu::weak]]
+void
+ircd::net::iou::detach(op &op)
+noexcept
+{
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // net/ipport.h
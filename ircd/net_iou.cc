@@ -0,0 +1,796 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include "fs_iou.h"
+#include "net_iou.h"
+
+/// Each buffer in the pool holds one TLS record, which is the largest unit
+/// the SSL stream reads or writes on the transport.
+decltype(ircd::net::iou::system::BUFFER_SIZE)
+ircd::net::iou::system::BUFFER_SIZE
+{
+	17_KiB
+};
+
+//
+// init
+//
+
+ircd::net::iou::init::init()
+{
+	assert(!system);
+	if(!iou::enable)
+		return;
+
+	try
+	{
+		system = new struct iou::system
+		(
+			size_t(entries),
+			size_t(buffers)
+		);
+	}
+	catch(const std::exception &e)
+	{
+		log::warning
+		{
+			log, "io_uring is not available for sockets :%s",
+			e.what(),
+		};
+	}
+}
+
+ircd::net::iou::init::~init()
+noexcept
+{
+	delete system;
+	system = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// net/iou.h
+//
+// The contents of this section override weak symbols in ircd/net.cc when this
+// unit is conditionally compiled and linked on IOU-supporting platforms.
+
+bool
+ircd::net::iou::available()
+noexcept
+{
+	if(likely(!system))
+		return false;
+
+	if(unlikely(system->interrupting))
+		return false;
+
+	if(unlikely(system->pool_free.empty()))
+	{
+		++system->stats_exhausted;
+		return false;
+	}
+
+	return true;
+}
+
+ircd::net::iou::op *
+ircd::net::iou::accept(const int &fd,
+                       callback callback)
+{
+	assert(system);
+	auto op
+	{
+		std::make_unique<iou::op>()
+	};
+
+	op->callback = std::move(callback);
+	op->opcode = IORING_OP_ACCEPT;
+
+	auto &sqe(system->get_sqe());
+	sqe.opcode = op->opcode;
+	sqe.fd = fd;
+	sqe.accept_flags = SOCK_CLOEXEC;
+	return system->submit(sqe, std::move(op));
+}
+
+/// The data is read into a buffer of the pool and copied to the user's
+/// buffer upon completion; at most one buffer's worth is read. The socket is
+/// non-blocking; IORING_OP_RECV waits for it to become readable, where a
+/// plain read would complete with -EAGAIN.
+ircd::net::iou::op *
+ircd::net::iou::recv(const int &fd,
+                     const mutable_buffer &buf,
+                     callback callback)
+{
+	assert(system);
+	auto op
+	{
+		std::make_unique<iou::op>()
+	};
+
+	op->callback = std::move(callback);
+	op->dst = buf;
+	op->buf = system->buffer_get();
+	op->fd = fd;
+	op->opcode = IORING_OP_RECV;
+	if(unlikely(op->buf < 0))
+		throw error
+		{
+			"No buffers available for io_uring recv."
+		};
+
+	const mutable_buffer pbuf
+	{
+		system->buffer(op->buf)
+	};
+
+	op->len = std::min(size(buf), size(pbuf));
+	auto &sqe(system->get_sqe());
+	sqe.opcode = op->opcode;
+	sqe.fd = fd;
+	sqe.addr = uintptr_t(data(pbuf));
+	sqe.len = op->len;
+	return system->submit(sqe, std::move(op));
+}
+
+/// The data is copied into a buffer of the pool at submission; at most one
+/// buffer's worth is written, like any short write. As with recv(), the
+/// IORING_OP_SEND waits for the non-blocking socket to become writable.
+ircd::net::iou::op *
+ircd::net::iou::send(const int &fd,
+                     const const_buffer &buf,
+                     callback callback)
+{
+	assert(system);
+	auto op
+	{
+		std::make_unique<iou::op>()
+	};
+
+	op->callback = std::move(callback);
+	op->buf = system->buffer_get();
+	op->fd = fd;
+	op->opcode = IORING_OP_SEND;
+	if(unlikely(op->buf < 0))
+		throw error
+		{
+			"No buffers available for io_uring send."
+		};
+
+	const const_buffer pbuf
+	{
+		data(system->buffer(op->buf)), copy(system->buffer(op->buf), buf)
+	};
+
+	op->len = size(pbuf);
+	auto &sqe(system->get_sqe());
+	sqe.opcode = op->opcode;
+	sqe.fd = fd;
+	sqe.addr = uintptr_t(data(pbuf));
+	sqe.len = op->len;
+	return system->submit(sqe, std::move(op));
+}
+
+/// The operation completes with -ECANCELED unless it already finished; the
+/// callback is invoked either way.
+bool
+ircd::net::iou::cancel(op &op)
+noexcept try
+{
+	assert(system);
+	if(op.canceled)
+		return false;
+
+	op.canceled = true;
+	auto &sqe(system->get_sqe());
+	sqe.opcode = IORING_OP_ASYNC_CANCEL;
+	sqe.fd = -1;
+	sqe.addr = uintptr_t(&op);
+	system->submit(sqe, nullptr);
+	return true;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "io_uring cancel op:%p :%s",
+		(const void *)&op,
+		e.what(),
+	};
+
+	return false;
+}
+
+/// The owner of the operation is going away. The callback is released now
+/// and never invoked; the operation is canceled and its result discarded.
+void
+ircd::net::iou::detach(op &op)
+noexcept
+{
+	op.detached = true;
+	op.callback = {};
+	cancel(op);
+}
+
+//
+// system::system
+//
+
+decltype(ircd::net::iou::system::handle_descriptor)
+ircd::net::iou::system::handle_descriptor
+{
+	"ircd.net.iou.eventfd"
+};
+
+decltype(ircd::net::iou::system::flush_descriptor)
+ircd::net::iou::system::flush_descriptor
+{
+	"ircd.net.iou.flush"
+};
+
+ircd::net::iou::system::system(const size_t &entries,
+                               const size_t &buffers)
+:p
+{
+	0
+}
+,fd
+{
+	int(syscall<__NR_io_uring_setup>(entries, &p))
+}
+,sq_len
+{
+	p.sq_off.array + p.sq_entries * sizeof(uint32_t)
+}
+,cq_len
+{
+	p.cq_off.cqes + p.cq_entries * sizeof(::io_uring_cqe)
+}
+,sqe_len
+{
+	p.sq_entries * sizeof(::io_uring_sqe)
+}
+,sq_p
+{
+	fs::iou::map_ring(fd, sq_len, IORING_OFF_SQ_RING)
+}
+,cq_p
+{
+	fs::iou::map_ring(fd, cq_len, IORING_OFF_CQ_RING)
+}
+,sqe_p
+{
+	fs::iou::map_ring(fd, sqe_len, IORING_OFF_SQES)
+}
+,sq_head
+{
+	reinterpret_cast<uint32_t *>(sq_p.get() + p.sq_off.head)
+}
+,sq_tail
+{
+	reinterpret_cast<uint32_t *>(sq_p.get() + p.sq_off.tail)
+}
+,sq_mask
+{
+	reinterpret_cast<uint32_t *>(sq_p.get() + p.sq_off.ring_mask)
+}
+,sq_flags
+{
+	reinterpret_cast<uint32_t *>(sq_p.get() + p.sq_off.flags)
+}
+,sq_array
+{
+	reinterpret_cast<uint32_t *>(sq_p.get() + p.sq_off.array)
+}
+,cq_head
+{
+	reinterpret_cast<uint32_t *>(cq_p.get() + p.cq_off.head)
+}
+,cq_tail
+{
+	reinterpret_cast<uint32_t *>(cq_p.get() + p.cq_off.tail)
+}
+,cq_mask
+{
+	reinterpret_cast<uint32_t *>(cq_p.get() + p.cq_off.ring_mask)
+}
+,sqe
+{
+	reinterpret_cast<::io_uring_sqe *>(sqe_p.get())
+}
+,cqe
+{
+	reinterpret_cast<::io_uring_cqe *>(cq_p.get() + p.cq_off.cqes)
+}
+,pool
+{
+	std::max(buffers, 1UL) * BUFFER_SIZE, 4_KiB
+}
+,ev_fd
+{
+	ios::get(), int(syscall(::eventfd, 0, EFD_CLOEXEC | EFD_NONBLOCK))
+}
+,stats_enter
+{
+	{ "name", "ircd.net.iou.enter"                                       },
+	{ "desc", "Number of io_uring_enter(2) calls made for sockets."       },
+}
+,stats_submit
+{
+	{ "name", "ircd.net.iou.submit"                                      },
+	{ "desc", "Number of socket operations submitted to the ring."        },
+}
+,stats_complete
+{
+	{ "name", "ircd.net.iou.complete"                                    },
+	{ "desc", "Number of socket operations completed by the ring."        },
+}
+,stats_exhausted
+{
+	{ "name", "ircd.net.iou.exhausted"                                   },
+	{ "desc", "Number of operations sent to the reactor for lack of buffers." },
+}
+{
+	const size_t count
+	{
+		size(pool) / BUFFER_SIZE
+	};
+
+	// The pool isn't registered with the ring: IORING_OP_RECV and
+	// IORING_OP_SEND have no fixed-buffer form.
+	pool_free.reserve(count);
+	for(size_t i(0); i < count; ++i)
+		pool_free.emplace_back(count - i - 1);
+
+	int efd(ev_fd.native_handle());
+	syscall<__NR_io_uring_register>(int(fd), IORING_REGISTER_EVENTFD, &efd, 1);
+	set_handle();
+
+	log::info
+	{
+		log, "io_uring for sockets sq_entries:%u cq_entries:%u features:%08x buffers:%zu (%s)%s",
+		p.sq_entries,
+		p.cq_entries,
+		p.features,
+		count,
+		pretty(iec(size(pool))),
+		p.features & IORING_FEAT_FAST_POLL? " fast_poll"_sv: ""_sv,
+	};
+}
+
+ircd::net::iou::system::~system()
+noexcept try
+{
+	const ctx::uninterruptible::nothrow ui;
+
+	interrupt();
+	wait();
+
+	boost::system::error_code ec;
+	ev_fd.close(ec);
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Error shutting down io_uring for sockets :%s",
+		e.what()
+	};
+}
+
+bool
+ircd::net::iou::system::interrupt()
+noexcept
+{
+	if(interrupting)
+		return false;
+
+	interrupting = true;
+	flush();
+	return true;
+}
+
+/// Wait for the operations still in flight, then for the eventfd handler.
+bool
+ircd::net::iou::system::wait()
+{
+	if(!ev_fd.is_open())
+		return false;
+
+	if(!ctx::current)
+		return false;
+
+	log::debug
+	{
+		log, "Waiting for %zu io_uring socket operations", inflight
+	};
+
+	dock.wait_for(seconds(10), [this]
+	{
+		return !inflight;
+	});
+
+	if(handle_set)
+		ev_fd.cancel();
+
+	dock.wait([this]
+	{
+		return !handle_set;
+	});
+
+	return true;
+}
+
+//
+// submission
+//
+
+::io_uring_sqe &
+ircd::net::iou::system::get_sqe()
+{
+	const uint32_t tail
+	{
+		*sq_tail
+	};
+
+	// When the submission queue is full the entries are flushed to the
+	// kernel right now to make room.
+	if(tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= p.sq_entries)
+		enter();
+
+	const uint32_t idx
+	{
+		tail & *sq_mask
+	};
+
+	sq_array[idx] = idx;
+	::io_uring_sqe &ret(sqe[idx]);
+	memset(&ret, 0x0, sizeof(ret));
+	return ret;
+}
+
+/// The entry is made visible to the kernel with the next flush, which is
+/// deferred until the end of this pass through the event loop so that
+/// everything submitted meanwhile shares one system call.
+ircd::net::iou::op *
+ircd::net::iou::system::submit(::io_uring_sqe &sqe,
+                               std::unique_ptr<op> op)
+{
+	sqe.user_data = uintptr_t(op.get());
+	__atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+	++sq_queued;
+	inflight += bool(op);
+	set_flush();
+	return op.release();
+}
+
+void
+ircd::net::iou::system::set_flush()
+{
+	if(flush_set)
+		return;
+
+	flush_set = true;
+	ircd::dispatch
+	{
+		flush_descriptor, ios::defer, []
+		{
+			if(likely(iou::system))
+				iou::system->flush();
+		}
+	};
+}
+
+void
+ircd::net::iou::system::flush()
+noexcept try
+{
+	flush_set = false;
+	if(sq_queued)
+		enter();
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "io_uring flush of %u entries :%s",
+		sq_queued,
+		e.what(),
+	};
+}
+
+void
+ircd::net::iou::system::enter(const uint32_t &min_complete)
+{
+	const uint32_t flags
+	{
+		min_complete || *sq_flags & IORING_SQ_CQ_OVERFLOW?
+			IORING_ENTER_GETEVENTS:
+			0U
+	};
+
+	long ret; do
+	{
+		ret = sys::call<sys::call::NOTHROW>
+		(
+			::syscall, __NR_io_uring_enter, int(fd), sq_queued, min_complete, flags, nullptr, 0
+		);
+
+		++stats_enter;
+
+		// The completion queue is full; make room and try again.
+		if(ret < 0 && errno == EBUSY && reap())
+			continue;
+	}
+	while(ret < 0 && errno == EINTR);
+
+	if(unlikely(ret < 0))
+		throw_system_error(errno);
+
+	assert(uint32_t(ret) <= sq_queued);
+	sq_queued -= ret;
+	stats_submit += ret;
+}
+
+//
+// completion
+//
+
+void
+ircd::net::iou::system::set_handle()
+{
+	assert(!handle_set);
+	handle_set = true;
+
+	const asio::mutable_buffers_1 bufs
+	{
+		&ev_count, sizeof(ev_count)
+	};
+
+	auto handler
+	{
+		std::bind(&system::handle, this, ph::_1, ph::_2)
+	};
+
+	ev_fd.async_read_some(bufs, ios::handle(handle_descriptor, std::move(handler)));
+}
+
+/// The eventfd is signaled by the kernel when completions are posted.
+void
+ircd::net::iou::system::handle(const boost::system::error_code &ec,
+                               const size_t bytes)
+noexcept try
+{
+	namespace errc = boost::system::errc;
+
+	assert(handle_set);
+	handle_set = false;
+	switch(ec.value())
+	{
+		case errc::success:
+			reap();
+			break;
+
+		case errc::interrupted:
+			break;
+
+		case errc::operation_canceled:
+			dock.notify_all();
+			return;
+
+		default:
+			throw_system_error(ec);
+			__builtin_unreachable();
+	}
+
+	set_handle();
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "io_uring eventfd handler :%s",
+		e.what(),
+	};
+
+	dock.notify_all();
+}
+
+size_t
+ircd::net::iou::system::reap()
+noexcept
+{
+	assert(!ctx::current);
+
+	size_t ret(0);
+	uint32_t head(*cq_head), tail; do
+	{
+		tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+		for(; head != tail; ++head, ++ret)
+		{
+			const ::io_uring_cqe &cqe
+			{
+				this->cqe[head & *cq_mask]
+			};
+
+			const auto op
+			{
+				reinterpret_cast<iou::op *>(cqe.user_data)
+			};
+
+			const int32_t res(cqe.res);
+			const uint32_t flags(cqe.flags);
+
+			// The entry is released before the callback which might submit.
+			__atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+			if(op)
+				complete(*op, res, flags);
+		}
+	}
+	while(head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE));
+
+	if(!inflight)
+		dock.notify_all();
+
+	return ret;
+}
+
+void
+ircd::net::iou::system::complete(op &op_,
+                                 const int32_t &res_,
+                                 const uint32_t &flags)
+noexcept try
+{
+	assert(inflight > 0);
+	--inflight;
+	++stats_complete;
+
+	int32_t res(res_);
+	if(rearm(op_, res))
+		return;
+
+	const std::unique_ptr<iou::op> op
+	{
+		&op_
+	};
+
+	const bool is_read
+	{
+		op->opcode == IORING_OP_RECV
+	};
+
+	if(is_read && res > 0 && !op->detached)
+	{
+		assert(size_t(res) <= size(op->dst));
+		res = copy(op->dst, const_buffer{data(buffer(op->buf)), size_t(res)});
+	}
+
+	if(op->opcode == IORING_OP_ACCEPT && res >= 0 && op->detached)
+		syscall(::close, res);
+
+	if(op->buf >= 0)
+		buffer_put(op->buf);
+
+	if(!op->detached && op->callback)
+		op->callback(res);
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "io_uring completion op:%p res:%d :%s",
+		(const void *)&op_,
+		res_,
+		e.what(),
+	};
+}
+
+/// Kernels without IORING_FEAT_FAST_POLL complete a recv or send on a socket
+/// which isn't ready with -EAGAIN. The socket is then polled on the ring and
+/// the operation resubmitted when it's ready. True when the operation was
+/// submitted again; otherwise res is the result for the owner.
+bool
+ircd::net::iou::system::rearm(op &op,
+                              int32_t &res)
+noexcept try
+{
+	const bool transfer
+	{
+		op.opcode == IORING_OP_RECV || op.opcode == IORING_OP_SEND
+	};
+
+	if(!transfer)
+		return false;
+
+	if(op.polling)
+	{
+		op.polling = false;
+		if(res < 0)
+			return false;
+
+		// The poll's result is a mask of events, not a length.
+		if(op.canceled || op.detached)
+		{
+			res = -ECANCELED;
+			return false;
+		}
+
+		res = -EAGAIN;
+		auto &sqe(get_sqe());
+		sqe.opcode = op.opcode;
+		sqe.fd = op.fd;
+		sqe.addr = uintptr_t(data(buffer(op.buf)));
+		sqe.len = op.len;
+		submit(sqe, std::unique_ptr<iou::op>(&op));
+		return true;
+	}
+
+	if(res != -EAGAIN || op.canceled || op.detached)
+		return false;
+
+	auto &sqe(get_sqe());
+	sqe.opcode = IORING_OP_POLL_ADD;
+	sqe.fd = op.fd;
+	sqe.poll_events = op.opcode == IORING_OP_RECV? POLLIN: POLLOUT;
+	op.polling = true;
+	submit(sqe, std::unique_ptr<iou::op>(&op));
+	return true;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "io_uring rearm op:%p :%s",
+		(const void *)&op,
+		e.what(),
+	};
+
+	op.polling = false;
+	return false;
+}
+
+//
+// buffer pool
+//
+
+int32_t
+ircd::net::iou::system::buffer_get()
+noexcept
+{
+	if(unlikely(pool_free.empty()))
+		return -1;
+
+	const auto ret(pool_free.back());
+	pool_free.pop_back();
+	return ret;
+}
+
+void
+ircd::net::iou::system::buffer_put(const int32_t &idx)
+noexcept
+{
+	assert(idx >= 0);
+	assert(size_t(idx) < size(pool) / BUFFER_SIZE);
+	pool_free.emplace_back(idx);
+}
+
+ircd::mutable_buffer
+ircd::net::iou::system::buffer(const int32_t &idx)
+const
+{
+	assert(idx >= 0);
+	return mutable_buffer
+	{
+		data(pool) + idx * BUFFER_SIZE, BUFFER_SIZE
+	};
+}
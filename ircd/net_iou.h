@@ -0,0 +1,85 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_NET_IOU_H
+#include <linux/io_uring.h>
+
+/// An operation in flight on the ring. The address of this object is the
+/// user_data of its submission.
+struct ircd::net::iou::op
+{
+	iou::callback callback;
+	mutable_buffer dst;            // recv: the user's buffer for the data
+	int32_t buf {-1};              // index of the pool buffer or -1
+	int32_t fd {-1};               // recv/send: resubmitted after a poll
+	uint32_t len {0};              // recv/send: length in the pool buffer
+	uint8_t opcode {IORING_OP_NOP};
+	bool polling {false};          // recv/send: waiting for readiness
+	bool canceled {false};
+	bool detached {false};         // owner is gone; result is discarded
+};
+
+struct ircd::net::iou::system
+{
+	static const size_t BUFFER_SIZE;
+	static ios::descriptor handle_descriptor;
+	static ios::descriptor flush_descriptor;
+
+	::io_uring_params p;
+	fs::fd fd;
+	size_t sq_len, cq_len, sqe_len;
+	custom_ptr<uint8_t> sq_p, cq_p, sqe_p;
+	uint32_t *sq_head, *sq_tail, *sq_mask, *sq_flags, *sq_array;
+	uint32_t *cq_head, *cq_tail, *cq_mask;
+	::io_uring_sqe *sqe;
+	::io_uring_cqe *cqe;
+	uint32_t sq_queued {0};        // entries not yet seen by the kernel
+	bool flush_set {false};
+
+	unique_buffer<mutable_buffer> pool;
+	std::vector<uint32_t> pool_free;
+
+	uint64_t ev_count {0};
+	asio::posix::stream_descriptor ev_fd;
+	bool handle_set {false};
+	bool interrupting {false};
+	size_t inflight {0};
+	ctx::dock dock;
+
+	stats::item<uint64_t> stats_enter;
+	stats::item<uint64_t> stats_submit;
+	stats::item<uint64_t> stats_complete;
+	stats::item<uint64_t> stats_exhausted;
+
+	mutable_buffer buffer(const int32_t &idx) const;
+	int32_t buffer_get() noexcept;
+	void buffer_put(const int32_t &idx) noexcept;
+
+	bool rearm(op &, int32_t &res) noexcept;
+	void complete(op &, const int32_t &res, const uint32_t &flags) noexcept;
+	size_t reap() noexcept;
+	void enter(const uint32_t &min_complete = 0);
+	void flush() noexcept;
+	void set_flush();
+	::io_uring_sqe &get_sqe();
+	op *submit(::io_uring_sqe &, std::unique_ptr<op>);
+
+	void handle(const boost::system::error_code &ec, const size_t bytes) noexcept;
+	void set_handle();
+
+	bool interrupt() noexcept;
+	bool wait();
+
+	system(const size_t &entries,
+	       const size_t &buffers);
+
+	~system() noexcept;
+};
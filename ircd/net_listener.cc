@@ -354,6 +354,9 @@ catch(const boost::system::system_error &e)
 ircd::net::acceptor::~acceptor()
 noexcept
 {
+	if(accept_op)
+		iou::detach(*std::exchange(accept_op, nullptr));
+
 	if(accepting || !handshaking.empty())
 		log::critical
 		{
@@ -379,10 +382,20 @@ ircd::net::acceptor::open()
 		true
 	};
 
+	// Each process listening with this option on the same address is given
+	// a share of the incoming connections by the kernel.
+	static const asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port
+	{
+		true
+	};
+
 	assert(!interrupting);
 	interrupting = false;
 	a.open(ep.protocol());
 	a.set_option(reuse_address);
+	if(json::object(opts).get<bool>("reuseport", false))
+		a.set_option(reuse_port);
+
 	a.non_blocking(true);
 	log::debug
 	{
@@ -465,6 +478,9 @@ noexcept try
 		return false;
 
 	interrupting = true;
+	if(accept_op)
+		iou::cancel(*accept_op);
+
 	a.cancel();
 	return true;
 }
@@ -493,6 +509,33 @@ try
 		std::make_shared<ircd::socket>(ssl)
 	};
 
+	// When the ring is active the accept is submitted there and the result
+	// is assigned to the socket on completion.
+	if(iou::system)
+	{
+		assert(!accept_op);
+		accept_op = iou::accept(a.native_handle(), [this, sock]
+		(const int32_t &res)
+		{
+			accept_op = nullptr;
+			error_code ec
+			{
+				transport::make_error(res)
+			};
+
+			if(likely(res >= 0))
+				sock->sd.assign(ep.protocol(), res, ec);
+
+			if(unlikely(res >= 0 && ec))
+				syscall(::close, res);
+
+			accept(ec, sock);
+		});
+
+		++accepting;
+		return true;
+	}
+
 	auto handler
 	{
 		std::bind(&acceptor::accept, this, ph::_1, sock)
@@ -853,7 +896,19 @@ ircd::net::acceptor::handle_alpn(socket &socket,
 	}
 	#endif IRCD_NET_ACCEPTOR_DEBUG_ALPN
 
-	//NOTE: proto == "h2" condition goes here
+	// HTTP/2 is preferred when the listener enables it with "h2": true.
+	const bool h2
+	{
+		json::object(opts).get<bool>("h2", false)
+	};
+
+	for(const auto &proto : in)
+		if(h2 && proto == "h2")
+		{
+			strlcpy(socket.alpn, proto);
+			return proto;
+		}
+
 	for(const auto &proto : in)
 		if(proto == "http/1.1")
 		{
@@ -204,6 +204,27 @@ ircd::net::acceptor_udp::operator()(datagram &datagram)
 		this->waiting
 	};
 
+	// A datagram addressed to a remote is sent to it.
+	if(datagram.remote)
+	{
+		const auto ep
+		{
+			make_endpoint_udp(datagram.remote)
+		};
+
+		size_t wlen; continuation
+		{
+			continuation::asio_predicate, interruption, [this, &wlen, &datagram, &ep, &flags]
+			(auto &yield)
+			{
+				wlen = a.async_send_to(datagram.cbufs, ep, flags, yield);
+			}
+		};
+
+		datagram.cbuf = {data(datagram.cbuf), wlen};
+		return datagram;
+	}
+
 	ip::udp::endpoint ep;
 	size_t rlen; continuation
 	{
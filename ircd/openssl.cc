@@ -96,6 +96,45 @@ ircd::openssl::server_name(const SSL &ssl)
 	return ::SSL_get_servername(&ssl, type);
 }
 
+//
+// ALPN suite
+//
+
+void
+ircd::openssl::alpn(SSL &ssl,
+                    const vector_view<const string_view> &protos)
+{
+	// Protocols are sent in the wire format: each is prefixed by its length.
+	uint8_t buf[256];
+	size_t len(0);
+	for(const auto &proto : protos)
+	{
+		if(unlikely(empty(proto) || size(proto) > 255 || len + 1 + size(proto) > sizeof(buf)))
+			throw error
+			{
+				"Invalid ALPN protocol '%s'", proto
+			};
+
+		buf[len++] = size(proto);
+		len += copy(mutable_buffer(reinterpret_cast<char *>(buf + len), size(proto)), proto);
+	}
+
+	// Note this function returns zero on success, unlike most others.
+	call<error, 1>(::SSL_set_alpn_protos, &ssl, buf, len);
+}
+
+ircd::string_view
+ircd::openssl::alpn(const SSL &ssl)
+{
+	const uint8_t *data {nullptr};
+	uint len {0};
+	::SSL_get0_alpn_selected(&ssl, &data, &len);
+	return string_view
+	{
+		reinterpret_cast<const char *>(data), len
+	};
+}
+
 //
 // Cipher suite
 //
@@ -380,6 +380,10 @@ ircd::resource::method::stats::stats(method &m)
 {
 	{ "name", method_stats_name(m, "internal_errors") }
 }
+,duration
+{
+	{ "name", method_stats_name(m, "duration") }
+}
 {
 }
 
@@ -493,6 +497,12 @@ try
 	}};
 
 	++stats->requests;
+	const ircd::timer timer;
+	const unwind duration{[this, &timer]
+	{
+		stats->duration += timer.at<microseconds>();
+	}};
+
 	const scope_count pending
 	{
 		static_cast<uint64_t &>(stats->pending)
@@ -523,14 +533,33 @@ try
 			seconds(default_timeout)
 	};
 
+	// The socket of an HTTP/2 stream is shared by the connection; the
+	// timeout is applied to the stream instead.
+	if(client.stream_id)
+		client.stream_timeout(method_timeout, [this, &client]
+		{
+			this->handle_timeout(client);
+		});
+
+	const unwind stream_timeout{[&client]
+	{
+		if(client.stream_id)
+			client.stream_timeout(0ms, {});
+	}};
+
 	const net::scope_timeout timeout
 	{
-		*client.sock, method_timeout, [this, &client]
-		(const bool &timed_out)
-		{
-			if(timed_out)
-				this->handle_timeout(client);
-		}
+		!client.stream_id?
+			net::scope_timeout
+			{
+				*client.sock, method_timeout, [this, &client]
+				(const bool &timed_out)
+				{
+					if(timed_out)
+						this->handle_timeout(client);
+				}
+			}:
+			net::scope_timeout{}
 	};
 
 	// Content that hasn't yet arrived is remaining
@@ -559,7 +588,7 @@ try
 	// in the subsequent reads for content below (or in the handler). We don't
 	// QUICKACK when we've received all content since we might be able to make
 	// an actual response all in one shot.
-	if(content_remain && ~opts->flags & DELAYED_ACK)
+	if(content_remain && ~opts->flags & DELAYED_ACK && !client.stream_id)
 		net::quickack(*client.sock, true);
 
 	// Branch taken to receive any remaining content in the common case where
@@ -577,7 +606,7 @@ try
 		};
 
 		// Read the remaining content off the socket.
-		client.content_consumed += read_all(*client.sock, content_remain_buffer);
+		client.content_consumed += client.read_all(content_remain_buffer);
 		assert(client.content_consumed == head.content_length);
 		content = string_view
 		{
@@ -618,8 +647,9 @@ try
 	// This branch flips TCP_NODELAY to force transmission here. This is a
 	// good place because the request has finished writing everything; the
 	// socket doesn't know that, but we do, and this is the place. The action
-	// can be disabled by using the flag in the method's options.
-	if(likely(~opts->flags & DELAYED_RESPONSE))
+	// can be disabled by using the flag in the method's options. A stream
+	// shares the socket of the connection, whose writes are its own.
+	if(likely(~opts->flags & DELAYED_RESPONSE) && !client.stream_id)
 	{
 		assert(client.sock);
 		net::flush(*client.sock);
@@ -970,30 +1000,37 @@ try
 	if(empty(chunk) && ignore_empty)
 		return 0UL;
 
-	char headbuf[32];
-	const const_buffer iov[]
-	{
-		// head
-		http::writechunk(headbuf, size(chunk)),
-
-		// body
-		chunk,
-
-		// terminator,
-		http::response::chunk::terminator,
-	};
-
 	const size_t wrote
 	{
 		this->wrote
 	};
 
-	this->wrote += c->write_all(iov);
+	// HTTP/2 has no chunk framing; the empty chunk ends the stream.
+	if(c->stream_id)
+		this->wrote += c->write_all(chunk);
+	else
+	{
+		char headbuf[32];
+		const const_buffer iov[]
+		{
+			// head
+			http::writechunk(headbuf, size(chunk)),
+
+			// body
+			chunk,
+
+			// terminator,
+			http::response::chunk::terminator,
+		};
+
+		this->wrote += c->write_all(iov);
+	}
+
 	finished |= empty(chunk);
 	count++;
 
 	assert(this->wrote >= wrote);
-	assert(this->wrote >= 2 || !finished);
+	assert(this->wrote >= 2 || !finished || c->stream_id);
 	return this->wrote - wrote;
 }
 catch(...)
@@ -1261,15 +1298,16 @@ ircd::resource::response::response(client &client,
 
 	char head_buf[HEAD_BUF_SZ];
 	window_buffer head{head_buf};
-	http::response
-	{
-		head,
-		code,
-		content_length,
-		content_type,
-		headers,
-		headers_addl,
-	};
+	if(!client.stream_id)
+		http::response
+		{
+			head,
+			code,
+			content_length,
+			content_type,
+			headers,
+			headers_addl,
+		};
 
 	// Maximum size is realistically ok but ideally a small
 	// maximum; this exception should hit the developer in testing.
@@ -1282,7 +1320,9 @@ ircd::resource::response::response(client &client,
 	size_t wrote_head {0};
 	std::exception_ptr eptr; try
 	{
-		wrote_head += client.write_all(head.completed());
+		wrote_head += client.stream_id?
+			write_head_h2(client, code, content_type, content_length, headers, headers_addl):
+			client.write_all(head.completed());
 	}
 	catch(...)
 	{
@@ -1319,7 +1359,73 @@ ircd::resource::response::response(client &client,
 	if(unlikely(eptr))
 		std::rethrow_exception(eptr);
 
-	assert(wrote_head == size(head.completed()));
+	assert(wrote_head == size(head.completed()) || client.stream_id);
+}
+
+/// The head of a response on an HTTP/2 stream. The additional headers were
+/// composed for HTTP/1.1 so they are parsed back out; those specific to the
+/// connection are not allowed on a stream (RFC 7540 8.1.2.2).
+size_t
+ircd::resource::response::write_head_h2(client &client,
+                                        const http::code &code,
+                                        const string_view &content_type,
+                                        const size_t &content_length,
+                                        const string_view &headers,
+                                        const vector_view<const http::header> &headers_addl)
+{
+	static const string_view connection_specific[]
+	{
+		"connection",
+		"keep-alive",
+		"proxy-connection",
+		"transfer-encoding",
+		"upgrade",
+	};
+
+	static const size_t HEADERS_MAX
+	{
+		64
+	};
+
+	char status_buf[8], length_buf[24];
+	http::header header[HEADERS_MAX];
+	size_t num(0);
+	header[num++] =
+	{
+		":status", fmt::sprintf{status_buf, "%u", uint(code)}
+	};
+
+	if(content_type)
+		header[num++] = { "content-type", content_type };
+
+	if(content_length != size_t(-1))
+		header[num++] =
+		{
+			"content-length", fmt::sprintf{length_buf, "%zu", content_length}
+		};
+
+	http::headers{headers}.for_each([&header, &num, &headers_addl]
+	(const http::header &h)
+	{
+		const bool specific
+		{
+			std::any_of(begin(connection_specific), end(connection_specific), [&h]
+			(const string_view &name)
+			{
+				return iequals(h.first, name);
+			})
+		};
+
+		if(!specific)
+			header[num++] = h;
+
+		return num < HEADERS_MAX - size(headers_addl);
+	});
+
+	for(const auto &h : headers_addl)
+		header[num++] = h;
+
+	return client.write_headers(vector_view<const http::header>(header, num), content_length);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -14,6 +14,8 @@ namespace ircd::server
 	extern log::log log;
 	extern ctx::dock dock;
 	extern conf::item<seconds> close_all_timeout;
+	extern conf::item<bool> peer_rtt;
+	extern stats::histogram rtt;
 
 	// Internal util
 	template<class F> static size_t accumulate_peers(F&&);
@@ -51,6 +53,26 @@ ircd::server::close_all_timeout
 	{ "default",  2L                              },
 };
 
+decltype(ircd::server::peer_rtt)
+ircd::server::peer_rtt
+{
+	{ "name",     "ircd.server.peer.rtt" },
+	{ "default",  false                  },
+	{ "description",
+
+	R"(
+	Register a request round-trip histogram for each peer in addition to the
+	aggregate. Each peer contacted adds a stats item for the life of the peer.
+	)"},
+};
+
+decltype(ircd::server::rtt)
+ircd::server::rtt
+{
+	{ "name", "ircd.server.rtt"                                     },
+	{ "desc", "Microseconds from submit to completion of requests." },
+};
+
 //
 // init
 //
@@ -862,6 +884,42 @@ ircd::server::peer::peer(const net::hostport &hostport,
 
 	// Cert verify this name.
 	this->open_opts.common_name = host(canon);
+
+	// Offer HTTP/2 so requests can be multiplexed on each link.
+	if(link::h2_enable)
+		this->open_opts.alpn = link::h2_alpn;
+
+	// Distribution of the time from submitting a request to its completion
+	// for this peer alone; only when configured (see server::rtt). The name
+	// is truncated to the limit; registering a duplicate name is not
+	// allowed, so a peer colliding after truncation goes without.
+	if(!peer_rtt)
+		return;
+
+	char buf[128];
+	const string_view name
+	{
+		fmt::sprintf
+		{
+			buf, "ircd.server.peer.%s.rtt", this->hostcanon
+		}
+	};
+
+	const bool exists
+	{
+		std::any_of(begin(stats::items), end(stats::items), [&name]
+		(const auto *const &item)
+		{
+			return item->name == name;
+		})
+	};
+
+	if(likely(!exists))
+		tag_rtt = std::make_unique<stats::histogram>(json::members
+		{
+			{ "name", name                                                  },
+			{ "desc", "Microseconds from submit to completion of requests." },
+		});
 }
 
 ircd::server::peer::~peer()
@@ -1289,6 +1347,18 @@ noexcept try
 	{
 		assert(link.peer);
 		++tag_done;
+		if(likely(tag.state.status))
+		{
+			const auto elapsed
+			{
+				duration_cast<microseconds>(now<steady_point>() - tag.state.started)
+			};
+
+			server::rtt += elapsed;
+			if(tag_rtt)
+				*tag_rtt += elapsed;
+		}
+
 		log::logf
 		{
 			request::log, uint(tag.state.status) >= 300? log::DERROR: log::DEBUG,
@@ -2135,6 +2205,770 @@ ircd::server::loghead(const mutable_buffer &buf,
 	};
 }
 
+//
+// link::session
+//
+
+/// HTTP/2 state of a link which negotiated it with ALPN. Each committed tag
+/// is carried on a stream of its own so responses are received in any order
+/// and a slow response does not hold up the others on the link. The tags
+/// themselves are unaware: their request head is translated into HEADERS and
+/// the response is presented to them in HTTP/1.1 form, so the same parser
+/// and buffer management serve both protocols.
+struct ircd::server::link::session
+:http2::session
+{
+	struct stream;
+
+	static conf::item<size_t> streams_max;
+	static conf::item<size_t> window_size;
+
+	server::link *link;
+	unique_buffer<mutable_buffer> rxbuf;
+	size_t rxlen {0};
+	std::map<uint32_t, stream> streams;
+
+	static http2::settings make_settings();
+
+	void handle_headers(const uint32_t &, const vector_view<const http::header> &, const bool &) override;
+	void handle_data(const uint32_t &, const const_buffer &, const bool &) override;
+	void handle_rst(const uint32_t &, const enum http2::error::code &) override;
+	void handle_window(const uint32_t &, const uint32_t &) override;
+	void handle_settings(const int64_t &) override;
+	void handle_goaway(const uint32_t &, const enum http2::error::code &) override;
+
+	std::list<tag>::iterator find(const uint32_t &id);
+	bool feed(tag &, const const_buffer &);
+	void finish(std::list<tag>::iterator);
+	void fail(std::list<tag>::iterator, std::exception_ptr);
+	void reset(const uint32_t &id, const enum http2::error::code &);
+	void cancel(std::list<tag>::iterator);
+	void open(tag &);
+	void write(tag &);
+	bool flush();
+
+  public:
+	size_t tag_commit_max() const;
+	void cleanup_canceled();
+	void handle_writable();
+	void handle_readable();
+
+	session(server::link &);
+};
+
+struct ircd::server::link::session::stream
+:http2::stream
+{
+	bool chunked {false};              // response content is being re-chunked
+
+	using http2::stream::stream;
+};
+
+decltype(ircd::server::link::h2_enable)
+ircd::server::link::h2_enable
+{
+	{ "name",     "ircd.server.link.http2.enable" },
+	{ "default",  false                           },
+};
+
+decltype(ircd::server::link::h2_alpn)
+ircd::server::link::h2_alpn
+{
+	"h2",
+	"http/1.1",
+};
+
+/// Limits the number of requests in flight on an HTTP/2 link, in addition
+/// to the limit advertised by the remote.
+decltype(ircd::server::link::session::streams_max)
+ircd::server::link::session::streams_max
+{
+	{ "name",     "ircd.server.link.http2.streams_max" },
+	{ "default",  64L                                  },
+};
+
+decltype(ircd::server::link::session::window_size)
+ircd::server::link::session::window_size
+{
+	{ "name",     "ircd.server.link.http2.window_size" },
+	{ "default",  long(1_MiB)                          },
+};
+
+ircd::http2::settings
+ircd::server::link::session::make_settings()
+{
+	using code = http2::settings::code;
+
+	http2::settings ret;
+	ret[code::ENABLE_PUSH] = 0;
+	ret[code::INITIAL_WINDOW_SIZE] = std::min(size_t(window_size), 0x7fffffffUL);
+	ret[code::MAX_HEADER_LIST_SIZE] = 64_KiB;
+	return ret;
+}
+
+ircd::server::link::session::session(server::link &link)
+:http2::session
+{
+	false, make_settings()
+}
+,link
+{
+	&link
+}
+,rxbuf
+{
+	http2::frame::HEADER_SIZE +
+	ours[http2::settings::code::MAX_FRAME_SIZE]
+}
+{
+	send_preface();
+}
+
+size_t
+ircd::server::link::session::tag_commit_max()
+const
+{
+	const size_t theirs_max
+	{
+		theirs[http2::settings::code::MAX_CONCURRENT_STREAMS]?: -1UL
+	};
+
+	return std::max(std::min(size_t(streams_max), theirs_max), 1UL);
+}
+
+/// Commits the tags in the queue to streams and sends their content as the
+/// flow control windows allow. A tag waiting on its window does not hold up
+/// the tags behind it.
+void
+ircd::server::link::session::handle_writable()
+{
+	auto &queue(link->queue);
+	auto it(begin(queue));
+	while(it != end(queue))
+	{
+		auto &tag{*it};
+		if((tag.abandoned() || tag.canceled()) && !tag.committed())
+		{
+			it = queue.erase(it);
+			continue;
+		}
+
+		if(tag.canceled())
+		{
+			cancel(it++);
+			continue;
+		}
+
+		if(!tag.committed() && (goaway_recv || link->tag_committed() >= tag_commit_max()))
+			break;
+
+		write(tag);
+		++it;
+	}
+
+	// Unlike the pipeline, the remote may send control frames at any time.
+	link->wait_readable();
+	if(!flush())
+		link->wait_writable();
+}
+
+void
+ircd::server::link::session::write(tag &tag)
+{
+	if(!tag.committed())
+		open(tag);
+
+	const auto it
+	{
+		streams.find(tag.state.stream_id)
+	};
+
+	assert(it != end(streams));
+	auto &stream(it->second);
+	while(tag.write_remaining() && stream.send_window > 0 && send_window > 0)
+	{
+		// Large content is not all copied out at once; the remainder waits
+		// for the socket to drain.
+		if(out.size() >= frame_max() * 4 && !flush())
+			return;
+
+		const const_buffer buf
+		{
+			tag.make_write_buffer()
+		};
+
+		const size_t len
+		{
+			std::min
+			({
+				size(buf),
+				frame_max(),
+				size_t(stream.send_window),
+				size_t(send_window),
+			})
+		};
+
+		const bool eos
+		{
+			len == tag.write_remaining()
+		};
+
+		char head[http2::frame::HEADER_SIZE];
+		const const_buffer frame
+		{
+			make_data(head, stream.id, len, eos)
+		};
+
+		out.append(data(frame), size(frame));
+		out.append(data(buf), len);
+		stream.send_window -= len;
+		send_window -= len;
+		tag.wrote_buffer(const_buffer{data(buf), len});
+		if(eos)
+			stream.close_local();
+	}
+}
+
+/// Opens a stream for the tag with its request head translated into
+/// HEADERS; the head is considered entirely written from here.
+void
+ircd::server::link::session::open(tag &tag)
+{
+	assert(tag.request);
+	assert(!tag.committed());
+	const auto &req{*tag.request};
+
+	thread_local http::header header[64];
+	size_t num(4);
+	parse::buffer pb{req.out.head};
+	parse::capstan pc{pb, [](char *&read, char *stop)
+	{
+		read = stop;
+	}};
+
+	pc.read += size(req.out.head);
+	const http::request::head head
+	{
+		pc, [&num](const auto &h)
+		{
+			static const string_view connection_specific[]
+			{
+				"host",
+				"connection",
+				"keep-alive",
+				"proxy-connection",
+				"transfer-encoding",
+				"upgrade",
+				"te",
+			};
+
+			const auto specific
+			{
+				std::any_of(begin(connection_specific), end(connection_specific), [&h]
+				(const string_view &name)
+				{
+					return iequals(h.first, name);
+				})
+			};
+
+			if(!specific && num < 64)
+				header[num++] = h;
+		}
+	};
+
+	header[0] = { ":method",     head.method             };
+	header[1] = { ":scheme",     "https"                 };
+	header[2] = { ":authority",  head.host               };
+	header[3] = { ":path",       head.uri?: head.path    };
+
+	const vector_view<const http::header> headers
+	{
+		header, num
+	};
+
+	const size_t block_max
+	{
+		http2::hpack::encoder::size_max(headers)
+	};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		block_max + http2::frame::HEADER_SIZE * (1 + block_max / frame_max())
+	};
+
+	const uint32_t id(next_id);
+	const bool eos(empty(req.out.content));
+	const const_buffer frames
+	{
+		make_headers(buf, id, headers, eos)
+	};
+
+	auto &stream
+	{
+		streams.emplace(std::piecewise_construct,
+		                std::forward_as_tuple(id),
+		                std::forward_as_tuple(id, ours, theirs)).first->second
+	};
+
+	next_id += 2;
+	out.append(data(frames), size(frames));
+	tag.state.stream_id = id;
+	tag.wrote_buffer(req.out.head);
+	if(eos)
+		stream.close_local();
+}
+
+/// Writes as much of the pending frames as the socket will take without
+/// blocking; true when nothing remains.
+bool
+ircd::server::link::session::flush()
+{
+	if(out.empty())
+		return true;
+
+	const const_buffer written
+	{
+		link->process_write_next(const_buffer{out.data(), out.size()})
+	};
+
+	out.erase(0, size(written));
+	return out.empty();
+}
+
+/// Reads and handles everything available on the socket.
+void
+ircd::server::link::session::handle_readable()
+try
+{
+	size_t got; do
+	{
+		got = size(link->read(mutable_buffer{rxbuf} + rxlen));
+		rxlen += got;
+		const size_t consumed
+		{
+			(*this)(const_buffer{data(rxbuf), rxlen})
+		};
+
+		rxlen -= consumed;
+		memmove(data(rxbuf), data(rxbuf) + consumed, rxlen);
+	}
+	while(got && !link->op_fini);
+
+	if(link->op_fini)
+		return;
+
+	if(!flush())
+		link->wait_writable();
+
+	// After GOAWAY nothing more is started; the link is closed once the
+	// streams the remote will finish have finished.
+	if(goaway_recv && !link->tag_committed())
+	{
+		link->close();
+		return;
+	}
+
+	if(!link->tag_count())
+	{
+		assert(link->peer);
+		link->peer->handle_link_done(*link);
+		return;
+	}
+
+	link->wait_readable();
+	if(link->tag_uncommitted() || link->write_remaining())
+		link->wait_writable();
+}
+catch(const http2::error &e)
+{
+	send_goaway(e.code, e.what());
+	flush();
+	throw;
+}
+
+void
+ircd::server::link::session::handle_headers(const uint32_t &id,
+                                            const vector_view<const http::header> &headers,
+                                            const bool &eos)
+try
+{
+	const auto it(find(id));
+	if(it == end(link->queue))
+		return;
+
+	auto &tag(*it);
+	auto &stream(streams.at(id));
+
+	// Trailers; their fields are not considered.
+	if(tag.state.status != http::code(0))
+	{
+		if(!eos)
+			return reset(id, http2::error::code::PROTOCOL_ERROR);
+
+		return handle_data(id, {}, eos);
+	}
+
+	string_view status;
+	bool content_length(false);
+	for(const auto &[name, value] : headers)
+	{
+		if(name == ":status")
+			status = value;
+		else if(name == "content-length")
+			content_length = true;
+
+		// Any line break would smuggle another header into the head.
+		if(has(name, '\r') || has(name, '\n') || has(value, '\r') || has(value, '\n'))
+			return reset(id, http2::error::code::PROTOCOL_ERROR);
+	}
+
+	if(size(status) != 3)
+		return reset(id, http2::error::code::PROTOCOL_ERROR);
+
+	// Interim responses are not presented to the tag.
+	if(status[0] == '1')
+		return;
+
+	std::string head;
+	head.reserve(512);
+	head.append("HTTP/1.1 ");
+	head.append(status);
+	head.append("\r\n");
+	for(const auto &[name, value] : headers)
+	{
+		if(startswith(name, ':') || name == "transfer-encoding" || name == "connection")
+			continue;
+
+		head.append(name);
+		head.append(": ");
+		head.append(value);
+		head.append("\r\n");
+	}
+
+	// Content without a declared length is delimited by the end of the
+	// stream, which has no equivalent here but chunked encoding.
+	if(!content_length && eos)
+		head.append("Content-Length: 0\r\n");
+	else if(!content_length)
+		head.append("Transfer-Encoding: chunked\r\n");
+
+	head.append("\r\n");
+	stream.chunked = !content_length && !eos;
+	if(eos)
+		stream.close_remote();
+
+	if(feed(tag, string_view{head}))
+		return finish(it);
+
+	if(eos)
+		throw error
+		{
+			"Stream %u ended before the response content.", id
+		};
+}
+catch(const std::exception &)
+{
+	const auto it(find(id));
+	if(it != end(link->queue))
+		fail(it, std::current_exception());
+}
+
+void
+ircd::server::link::session::handle_data(const uint32_t &id,
+                                         const const_buffer &buf,
+                                         const bool &eos)
+try
+{
+	const auto sit(streams.find(id));
+	if(sit == end(streams))
+		return;
+
+	auto &stream(sit->second);
+	stream.recv_window -= size(buf);
+	if(stream.recv_window < 0)
+		return reset(id, http2::error::code::FLOW_CONTROL_ERROR);
+
+	if(eos)
+		stream.close_remote();
+
+	const auto it(find(id));
+	if(it == end(link->queue))
+		return;
+
+	auto &tag(*it);
+	if(tag.state.status == http::code(0))
+		return reset(id, http2::error::code::PROTOCOL_ERROR);
+
+	// Content is copied into the tag's buffers as it arrives so the window
+	// is replenished right away.
+	if(size(buf) && !eos)
+	{
+		send_window_update(id, size(buf));
+		stream.recv_window += size(buf);
+	}
+
+	bool done(false);
+	if(stream.chunked && size(buf))
+	{
+		char chunk_head[24];
+		const string_view chunk
+		{
+			fmt::sprintf
+			{
+				chunk_head, "%zx\r\n", size(buf)
+			}
+		};
+
+		done |= feed(tag, chunk);
+
+		done |= !done && feed(tag, buf);
+		done |= !done && feed(tag, "\r\n"_sv);
+	}
+	else if(size(buf))
+		done |= feed(tag, buf);
+
+	if(!done && stream.chunked && eos)
+		done |= feed(tag, "0\r\n\r\n"_sv);
+
+	if(done)
+		return finish(it);
+
+	if(eos)
+		throw error
+		{
+			"Stream %u ended before the response content was complete.", id
+		};
+}
+catch(const std::exception &)
+{
+	const auto it(find(id));
+	if(it != end(link->queue))
+		fail(it, std::current_exception());
+}
+
+void
+ircd::server::link::session::handle_rst(const uint32_t &id,
+                                        const enum http2::error::code &code)
+{
+	streams.erase(id);
+	const auto it(find(id));
+	if(it == end(link->queue))
+		return;
+
+	fail(it, make_exception_ptr<error>
+	(
+		"Stream %u reset by remote :%s", id, http2::reflect(code)
+	));
+}
+
+void
+ircd::server::link::session::handle_window(const uint32_t &id,
+                                           const uint32_t &increment)
+{
+	if(id)
+	{
+		const auto it(streams.find(id));
+		if(it == end(streams))
+			return;
+
+		auto &stream(it->second);
+		stream.send_window += increment;
+		if(stream.send_window > 0x7fffffffL)
+			return reset(id, http2::error::code::FLOW_CONTROL_ERROR);
+	}
+
+	if(link->ready())
+		link->wait_writable();
+}
+
+void
+ircd::server::link::session::handle_settings(const int64_t &delta)
+{
+	for(auto &[id, stream] : streams)
+	{
+		stream.send_window += delta;
+		if(stream.send_window > 0x7fffffffL)
+			throw http2::error
+			{
+				http2::error::code::FLOW_CONTROL_ERROR, "Stream %u window overflow.",
+				id,
+			};
+	}
+
+	if(link->ready())
+		link->wait_writable();
+}
+
+/// Requests on streams the remote did not get to were not processed, so
+/// they are returned to the uncommitted state to be retried on another link.
+void
+ircd::server::link::session::handle_goaway(const uint32_t &last_id,
+                                           const enum http2::error::code &code)
+{
+	log::debug
+	{
+		log, "%s HTTP/2 GOAWAY last stream:%u :%s",
+		loghead(*link),
+		last_id,
+		http2::reflect(code),
+	};
+
+	link->exclude = true;
+	auto &queue(link->queue);
+	for(auto it(begin(queue)); it != end(queue); )
+	{
+		auto &tag{*it};
+		if(!tag.committed() || tag.state.stream_id <= last_id)
+		{
+			++it;
+			continue;
+		}
+
+		streams.erase(tag.state.stream_id);
+		if(tag.canceled())
+		{
+			it = queue.erase(it);
+			continue;
+		}
+
+		tag.state.stream_id = 0;
+		tag.state.written = 0;
+		++it;
+	}
+}
+
+/// Presents the bytes to the tag as if they were received off the socket;
+/// true when the tag has received its entire response.
+bool
+ircd::server::link::session::feed(tag &tag,
+                                  const const_buffer &buf_)
+{
+	const_buffer buf{buf_};
+	bool done{false};
+	while(!empty(buf) && !done)
+	{
+		const mutable_buffer dst
+		{
+			tag.make_read_buffer()
+		};
+
+		if(unlikely(empty(dst)))
+			throw buffer_overrun
+			{
+				"Buffer of %zu bytes is insufficient to receive the HTTP response.",
+				size(tag.request->in.head),
+			};
+
+		const size_t copied
+		{
+			copy(dst, buf)
+		};
+
+		tag.read_buffer(const_buffer{data(dst), copied}, done, *link);
+		consume(buf, copied);
+	}
+
+	return done;
+}
+
+void
+ircd::server::link::session::finish(std::list<tag>::iterator it)
+{
+	auto &tag(*it);
+	const uint32_t id(tag.state.stream_id);
+
+	// Anything more the remote sends on the stream is not wanted.
+	const auto sit(streams.find(id));
+	if(sit != end(streams) && !sit->second.remote_closed())
+		send_rst(id, http2::error::code::CANCEL);
+
+	streams.erase(id);
+	assert(link->peer);
+	link->peer->handle_tag_done(*link, tag);
+	link->queue.erase(it);
+	++link->tag_done;
+}
+
+/// The failure of one stream concerns only its own tag.
+void
+ircd::server::link::session::fail(std::list<tag>::iterator it,
+                                  std::exception_ptr eptr)
+{
+	auto &tag(*it);
+	const uint32_t id(tag.state.stream_id);
+	log::derror
+	{
+		log, "%s stream:%u tag:%lu :%s",
+		loghead(*link),
+		id,
+		tag.state.id,
+		what(eptr),
+	};
+
+	if(streams.count(id))
+		reset(id, http2::error::code::CANCEL);
+
+	tag.set_exception(std::move(eptr));
+	link->queue.erase(it);
+}
+
+void
+ircd::server::link::session::reset(const uint32_t &id,
+                                   const enum http2::error::code &code)
+{
+	streams.erase(id);
+	send_rst(id, code);
+	const auto it(find(id));
+	if(it != end(link->queue))
+		fail(it, make_exception_ptr<error>
+		(
+			"Stream %u reset :%s", id, http2::reflect(code)
+		));
+}
+
+/// A canceled request only has its own stream reset rather than the link
+/// closed as in the HTTP/1.1 pipeline.
+void
+ircd::server::link::session::cancel(std::list<tag>::iterator it)
+{
+	auto &tag(*it);
+	assert(tag.canceled());
+	assert(tag.committed());
+	if(streams.erase(tag.state.stream_id))
+		send_rst(tag.state.stream_id, http2::error::code::CANCEL);
+
+	link->queue.erase(it);
+}
+
+void
+ircd::server::link::session::cleanup_canceled()
+{
+	auto &queue(link->queue);
+	for(auto it(begin(queue)); it != end(queue); )
+	{
+		const auto &tag{*it};
+		if(tag.committed() && tag.canceled())
+			cancel(it++);
+		else if(!tag.committed() && !tag.request)
+			it = queue.erase(it);
+		else
+			++it;
+	}
+
+	if(link->ready() && !out.empty())
+		link->wait_writable();
+}
+
+std::list<ircd::server::tag>::iterator
+ircd::server::link::session::find(const uint32_t &id)
+{
+	return std::find_if(begin(link->queue), end(link->queue), [&id]
+	(const auto &tag)
+	{
+		return tag.committed() && tag.state.stream_id == id;
+	});
+}
+
 //
 // link::link
 //
@@ -2224,6 +3058,9 @@ ircd::server::link::cancel_uncommitted(std::exception_ptr eptr)
 void
 ircd::server::link::cleanup_canceled()
 {
+	if(h2)
+		return h2->cleanup_canceled();
+
 	size_t dead(0);
 	for(auto it(begin(queue)); it != end(queue); )
 	{
@@ -2305,6 +3142,9 @@ ircd::server::link::handle_open(std::exception_ptr eptr)
 	op_init = false;
 	synack_ts = time<seconds>();
 
+	if(!eptr && !op_fini && string_view{socket->alpn} == "h2")
+		h2 = std::make_unique<session>(*this);
+
 	if(!eptr && !op_fini)
 		wait_writable();
 
@@ -2421,6 +3261,9 @@ void
 ircd::server::link::handle_writable_success()
 {
 	assert(socket);
+	if(h2)
+		return h2->handle_writable();
+
 	auto it(begin(queue));
 	while(it != end(queue))
 	{
@@ -2609,6 +3452,9 @@ void
 ircd::server::link::handle_readable_success()
 {
 	assert(socket);
+	if(h2)
+		return h2->handle_readable();
+
 	if(!tag_committed())
 	{
 		discard_read();
@@ -2969,6 +3815,9 @@ size_t
 ircd::server::link::tag_commit_max()
 const
 {
+	if(h2)
+		return h2->tag_commit_max();
+
 	return tag_commit_max_default;
 }
 
@@ -161,6 +161,22 @@ ircd::stats::string(const mutable_buffer &buf,
 			buf, "%d", *item.val
 		};
 	}
+	else if(item_.type == typeid(histogram))
+	{
+		const auto &item
+		{
+			dynamic_cast<const stats::histogram &>(item_)
+		};
+
+		return fmt::sprintf
+		{
+			buf, "%lu %lu %lu %lu",
+			item.count,
+			item.sum,
+			item.quantile(0.50),
+			item.quantile(0.99),
+		};
+	}
 	else throw invalid
 	{
 		"Unsupported value type '%s'",
@@ -257,3 +273,72 @@ const noexcept
 
 	return feature[key];
 }
+
+//
+// histogram
+//
+
+ircd::stats::histogram::histogram(const json::members &feature)
+:item<void>
+{
+	typeid(histogram), feature
+}
+{
+}
+
+ircd::stats::histogram &
+ircd::stats::histogram::operator+=(const histogram &other)
+noexcept
+{
+	for(size_t i(0); i < BUCKETS; ++i)
+		bucket[i] += other.bucket[i];
+
+	count += other.count;
+	sum += other.sum;
+	return *this;
+}
+
+/// The upper bound of the bucket containing the quantile. The estimate is
+/// therefore at most one bucket width above the true value.
+uint64_t
+ircd::stats::histogram::quantile(const double &q)
+const noexcept
+{
+	const uint64_t rank
+	{
+		uint64_t(std::ceil(std::clamp(q, 0.0, 1.0) * count))
+	};
+
+	uint64_t seen(0);
+	for(size_t i(0); i < BUCKETS; ++i)
+		if((seen += bucket[i]) >= rank && seen)
+			return bound(i);
+
+	return 0;
+}
+
+/// The greatest value counted by the bucket (inclusive).
+uint64_t
+ircd::stats::histogram::bound(const size_t &idx)
+noexcept
+{
+	if(idx == 0)
+		return 0;
+
+	if(idx >= BUCKETS - 1)
+		return std::numeric_limits<uint64_t>::max();
+
+	const size_t k
+	{
+		(idx - 1) / 2
+	};
+
+	const size_t s
+	{
+		(idx - 1) % 2
+	};
+
+	return k?
+		(1UL << k) + ((s + 1) << (k - 1)) - 1:
+		1UL;
+}
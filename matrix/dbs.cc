@@ -133,12 +133,18 @@ ircd::m::dbs::init::init(const string_view &servername,
 	event_sender = db::domain{*events, desc::event_sender.name};
 	event_type = db::domain{*events, desc::event_type.name};
 	event_state = db::domain{*events, desc::event_state.name};
+	event_auth_chain = db::column{*events, desc::event_auth_chain.name};
+	event_auth_cover = db::domain{*events, desc::event_auth_cover.name};
 	room_head = db::domain{*events, desc::room_head.name};
 	room_events = db::domain{*events, desc::room_events.name};
 	room_type = db::domain{*events, desc::room_type.name};
 	room_joined = db::domain{*events, desc::room_joined.name};
 	room_state = db::domain{*events, desc::room_state.name};
 	room_state_space = db::domain{*events, desc::room_state_space.name};
+	room_state_point = db::domain{*events, desc::room_state_point.name};
+	room_terms = db::domain{*events, desc::room_terms.name};
+	user_mitsein = db::domain{*events, desc::user_mitsein.name};
+	user_unread = db::domain{*events, desc::user_unread.name};
 }
 
 /// Shuts down the m::dbs subsystem; closes the events database. The extern
@@ -349,6 +355,9 @@ ircd::m::dbs::_index_event(db::txn &txn,
 	if(opts.appendix.test(appendix::EVENT_STATE))
 		_index_event_state(txn, event, opts);
 
+	if(opts.appendix.test(appendix::EVENT_AUTH_CHAIN) && defined(json::get<"state_key"_>(event)))
+		_index_event_auth_chain(txn, event, opts);
+
 	if(opts.appendix.test(appendix::EVENT_REFS) && opts.event_refs.any())
 		_index_event_refs(txn, event, opts);
 
@@ -379,6 +388,9 @@ ircd::m::dbs::_prefetch_event(const event &event,
 	if(opts.appendix.test(appendix::EVENT_STATE))
 		;//ret += _prefetch_event_state(txn, event, opts);
 
+	if(opts.appendix.test(appendix::EVENT_AUTH_CHAIN) && defined(json::get<"state_key"_>(event)))
+		;//ret += _prefetch_event_auth_chain(txn, event, opts);
+
 	if(opts.appendix.test(appendix::EVENT_REFS) && opts.event_refs.any())
 		ret += _prefetch_event_refs(event, opts);
 
@@ -417,10 +429,22 @@ ircd::m::dbs::_index_room(db::txn &txn,
 
 		if(opts.appendix.test(appendix::ROOM_JOINED) && at<"type"_>(event) == "m.room.member")
 			_index_room_joined(txn, event, opts);
+
+		if(opts.appendix.test(appendix::USER_MITSEIN) && at<"type"_>(event) == "m.room.member")
+			_index_user_mitsein(txn, event, opts);
 	}
 
+	if(opts.appendix.test(appendix::ROOM_STATE_POINT))
+		_index_room_state_point(txn, event, opts);
+
+	if(opts.appendix.test(appendix::USER_UNREAD) && startswith(json::get<"type"_>(event), "ircd."))
+		_index_user_unread(txn, event, opts);
+
 	if(opts.appendix.test(appendix::ROOM_REDACT) && json::get<"type"_>(event) == "m.room.redaction")
 		_index_room_redact(txn, event, opts);
+
+	if(opts.appendix.test(appendix::ROOM_TERMS))
+		_index_room_terms(txn, event, opts);
 }
 
 size_t
@@ -452,8 +476,17 @@ ircd::m::dbs::_prefetch_room(const event &event,
 
 		if(opts.appendix.test(appendix::ROOM_JOINED) && at<"type"_>(event) == "m.room.member")
 			;//ret += _prefetch_room_joined(event, opts);
+
+		if(opts.appendix.test(appendix::USER_MITSEIN) && at<"type"_>(event) == "m.room.member")
+			;//ret += _prefetch_user_mitsein(event, opts);
 	}
 
+	if(opts.appendix.test(appendix::ROOM_STATE_POINT))
+		;//ret += _prefetch_room_state_point(event, opts);
+
+	if(opts.appendix.test(appendix::USER_UNREAD) && startswith(json::get<"type"_>(event), "ircd."))
+		;//ret += _prefetch_user_unread(event, opts);
+
 	if(opts.appendix.test(appendix::ROOM_REDACT) && json::get<"type"_>(event) == "m.room.redaction")
 		ret += _prefetch_room_redact(event, opts);
 
@@ -505,6 +505,14 @@ ircd::m::dbs::desc::events
 	// Mapping of event states, indexed for application features.
 	event_state,
 
+	// event_idx => (chain, seq)
+	// Position of state events in the chain cover of the auth DAG.
+	event_auth_chain,
+
+	// (chain, seq) => (event_idx, (chain, seq)...)
+	// Chain cover of the auth DAG with the links between chains.
+	event_auth_cover,
+
 	// (room_id, (depth, event_idx))
 	// Sequence of all events for a room, ever.
 	room_events,
@@ -525,10 +533,26 @@ ircd::m::dbs::desc::events
 	// Sequence of all states of the room.
 	room_state_space,
 
+	// (room_id, (point, type, state_key)) => (depth, event_idx)
+	// Periodic checkpoints of the state of the room.
+	room_state_point,
+
 	// (room_id, event_id) => (event_idx)
 	// Mapping of all current head events for a room.
 	room_head,
 
+	// (term, (room_id, event_idx)) => (term frequency)
+	// Inverted index of the content terms of events in rooms.
+	room_terms,
+
+	// (user_id, (other_user_id, room_id))
+	// Pairs of users PRESENTLY JOINED to a common room.
+	user_mitsein,
+
+	// (user_id, room_id) => (notification, highlight, event_idx)
+	// Unread notification counts of a user in a room.
+	user_unread,
+
 	//
 	// These columns are legacy; they have been dropped from the schema.
 	//
@@ -0,0 +1,684 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static bool event_auth_chain_extends(const event &, const event::idx &, const write_opts &);
+	static bool event_auth_cover_has(const event_auth_chain_pos &, const write_opts &);
+	static bool event_auth_cover__cmp_less(const string_view &a, const string_view &b);
+}
+
+decltype(ircd::m::dbs::event_auth_chain)
+ircd::m::dbs::event_auth_chain;
+
+decltype(ircd::m::dbs::event_auth_cover)
+ircd::m::dbs::event_auth_cover;
+
+//
+// event_auth_chain
+//
+
+decltype(ircd::m::dbs::desc::event_auth_chain__comp)
+ircd::m::dbs::desc::event_auth_chain__comp
+{
+	{ "name",     "ircd.m.dbs._event_auth_chain.comp" },
+	{ "default",  "default"                           },
+};
+
+decltype(ircd::m::dbs::desc::event_auth_chain__block__size)
+ircd::m::dbs::desc::event_auth_chain__block__size
+{
+	{ "name",     "ircd.m.dbs._event_auth_chain.block.size" },
+	{ "default",  512L                                      },
+};
+
+decltype(ircd::m::dbs::desc::event_auth_chain__meta_block__size)
+ircd::m::dbs::desc::event_auth_chain__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._event_auth_chain.meta_block.size" },
+	{ "default",  4096L                                          },
+};
+
+decltype(ircd::m::dbs::desc::event_auth_chain__cache__size)
+ircd::m::dbs::desc::event_auth_chain__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._event_auth_chain.cache.size" },
+		{ "default",  long(16_MiB)                              },
+	}, []
+	{
+		const size_t &value{event_auth_chain__cache__size};
+		db::capacity(db::cache(dbs::event_auth_chain), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::event_auth_chain__cache_comp__size)
+ircd::m::dbs::desc::event_auth_chain__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._event_auth_chain.cache_comp.size" },
+		{ "default",  long(0_MiB)                                    },
+	}, []
+	{
+		const size_t &value{event_auth_chain__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::event_auth_chain), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::event_auth_chain__bloom__bits)
+ircd::m::dbs::desc::event_auth_chain__bloom__bits
+{
+	{ "name",     "ircd.m.dbs._event_auth_chain.bloom.bits" },
+	{ "default",  10L                                       },
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::event_auth_chain
+{
+	// name
+	"_event_auth_chain",
+
+	// explanation
+	R"(Position of state events in the auth chain cover.
+
+	event_idx => chain, seq
+
+	A state event is only present here when every event in its auth chain
+	is also present, so the cover answers for its whole auth chain.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(uint64_t), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	size_t(event_auth_chain__bloom__bits),
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(event_auth_chain__block__size),
+
+	// meta_block size
+	size_t(event_auth_chain__meta_block__size),
+
+	// compression
+	string_view{event_auth_chain__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+// event_auth_cover
+//
+
+decltype(ircd::m::dbs::desc::event_auth_cover__comp)
+ircd::m::dbs::desc::event_auth_cover__comp
+{
+	{ "name",     "ircd.m.dbs._event_auth_cover.comp" },
+	{ "default",  "default"                           },
+};
+
+decltype(ircd::m::dbs::desc::event_auth_cover__block__size)
+ircd::m::dbs::desc::event_auth_cover__block__size
+{
+	{ "name",     "ircd.m.dbs._event_auth_cover.block.size" },
+	{ "default",  512L                                      },
+};
+
+decltype(ircd::m::dbs::desc::event_auth_cover__meta_block__size)
+ircd::m::dbs::desc::event_auth_cover__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._event_auth_cover.meta_block.size" },
+	{ "default",  4096L                                          },
+};
+
+decltype(ircd::m::dbs::desc::event_auth_cover__cache__size)
+ircd::m::dbs::desc::event_auth_cover__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._event_auth_cover.cache.size" },
+		{ "default",  long(16_MiB)                              },
+	}, []
+	{
+		const size_t &value{event_auth_cover__cache__size};
+		db::capacity(db::cache(dbs::event_auth_cover), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::event_auth_cover__cache_comp__size)
+ircd::m::dbs::desc::event_auth_cover__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._event_auth_cover.cache_comp.size" },
+		{ "default",  long(0_MiB)                                    },
+	}, []
+	{
+		const size_t &value{event_auth_cover__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::event_auth_cover), value);
+	}
+};
+
+/// Prefix transform for the event_auth_cover. The prefix is the chain id and
+/// the suffix is the sequence number in the chain.
+///
+const ircd::db::prefix_transform
+ircd::m::dbs::desc::event_auth_cover__pfx
+{
+	"_event_auth_cover",
+	[](const string_view &key)
+	{
+		return size(key) >= sizeof(uint64_t);
+	},
+
+	[](const string_view &key)
+	{
+		assert(size(key) >= sizeof(uint64_t));
+		return string_view
+		{
+			data(key), sizeof(uint64_t)
+		};
+	}
+};
+
+const ircd::db::comparator
+ircd::m::dbs::desc::event_auth_cover__cmp
+{
+	"_event_auth_cover",
+	event_auth_cover__cmp_less,
+	db::cmp_string_view::equal,
+};
+
+/// This column is a chain cover of the auth DAG. Every state event is placed
+/// at the end of the chain of one of its auth events, or starts a new chain
+/// when none of its auth events ends a chain. A chain id is the event_idx of
+/// the event which started the chain. Consider the following:
+///
+/// [chain | seq] => event_idx, (chain, seq)...
+///
+/// The value lists the positions of the auth events of the event in other
+/// chains. An event at seq reaches every event in its chain at a lower seq,
+/// so the auth chain of an event is the union of ranges of a few chains,
+/// found by following the links of the events in those ranges.
+///
+/// A deleted event leaves its position with an event_idx of zero and its
+/// links intact; positions are never reused.
+///
+const ircd::db::descriptor
+ircd::m::dbs::desc::event_auth_cover
+{
+	// name
+	"_event_auth_cover",
+
+	// explanation
+	R"(Chain cover of the auth DAG.
+
+	chain | seq => event_idx, (chain, seq)...
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	event_auth_cover__cmp,
+
+	// prefix transform
+	event_auth_cover__pfx,
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(event_auth_cover__block__size),
+
+	// meta_block size
+	size_t(event_auth_cover__meta_block__size),
+
+	// compression
+	string_view{event_auth_cover__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+// indexer
+//
+
+/// Places a state event in the chain cover. Nothing is written when any
+/// event in its auth chain is missing from the cover; queries then fall back
+/// to walking the auth DAG for that event.
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_event_auth_chain(db::txn &txn,
+                                      const event &event,
+                                      const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::EVENT_AUTH_CHAIN));
+	assert(defined(json::get<"state_key"_>(event)));
+
+	char keybuf[EVENT_AUTH_COVER_KEY_SIZE];
+	char valbuf[EVENT_AUTH_COVER_VAL_MAX_SIZE];
+	const string_view idx_key
+	{
+		byte_view<string_view>(opts.event_idx)
+	};
+
+	if(opts.op == db::op::DELETE)
+	{
+		event_auth_chain_pos pos;
+		if(!find_event_auth_chain(pos, opts.event_idx, opts))
+			return;
+
+		db::txn::append
+		{
+			txn, event_auth_chain,
+			{
+				db::op::DELETE,
+				idx_key,
+			}
+		};
+
+		// The slot is left with a tombstone rather than freed; a later event
+		// would otherwise take the position and appear to reach the events
+		// below it. The links are kept for the events above it in the chain,
+		// which still reach the auth chain of the deleted event.
+		const string_view &key
+		{
+			event_auth_cover_key(keybuf, pos.first, pos.second)
+		};
+
+		size_t links_count(0);
+		event_auth_chain_pos links[event::auth::MAX];
+		const auto get_links{[&links, &links_count]
+		(const string_view &val)
+		{
+			std::tie(std::ignore, links_count) = event_auth_cover_val(links, val);
+		}};
+
+		const string_view &val
+		{
+			opts.interpose?
+				opts.interpose->val(db::op::SET, "_event_auth_cover", key):
+				string_view{}
+		};
+
+		if(val)
+			get_links(val);
+		else if(opts.allow_queries)
+			event_auth_cover(key, std::nothrow, get_links);
+
+		db::txn::append
+		{
+			txn, event_auth_cover,
+			{
+				db::op::SET,
+				key,
+				event_auth_cover_val(valbuf, 0UL, {links, links_count}),
+			}
+		};
+
+		return;
+	}
+
+	if(opts.op != db::op::SET)
+		return;
+
+	const event::auth auth
+	{
+		event
+	};
+
+	event::id auth_id[event::auth::MAX];
+	const auto &ids
+	{
+		auth.ids(auth_id)
+	};
+
+	event::idx auth_idx[event::auth::MAX] {0};
+	const vector_view<const event::id> id_view
+	{
+		ids.data(), ids.size()
+	};
+
+	const auto found
+	{
+		find_event_idx(vector_view<event::idx>(auth_idx, ids.size()), id_view, opts)
+	};
+
+	if(found < ids.size())
+		return;
+
+	event_auth_chain_pos auth_pos[event::auth::MAX];
+	for(size_t i(0); i < ids.size(); ++i)
+		if(!find_event_auth_chain(auth_pos[i], auth_idx[i], opts))
+			return;
+
+	// Extend the chain of an auth event of the same type and state_key when
+	// it ends its chain; otherwise this event starts a new chain.
+	event_auth_chain_pos pos
+	{
+		opts.event_idx, 1UL
+	};
+
+	for(size_t i(0); i < ids.size(); ++i)
+	{
+		const event_auth_chain_pos next
+		{
+			auth_pos[i].first, auth_pos[i].second + 1
+		};
+
+		if(!event_auth_chain_extends(event, auth_idx[i], opts))
+			continue;
+
+		if(event_auth_cover_has(next, opts))
+			continue;
+
+		pos = next;
+		break;
+	}
+
+	// Link to the auth events in other chains; one link per chain with the
+	// highest seq is sufficient.
+	size_t links_count(0);
+	event_auth_chain_pos links[event::auth::MAX];
+	for(size_t i(0); i < ids.size(); ++i)
+	{
+		if(auth_pos[i].first == pos.first)
+			continue;
+
+		auto *const it
+		{
+			std::find_if(links, links + links_count, [&auth_pos, &i]
+			(const auto &link)
+			{
+				return link.first == auth_pos[i].first;
+			})
+		};
+
+		if(it != links + links_count)
+			it->second = std::max(it->second, auth_pos[i].second);
+		else
+			links[links_count++] = auth_pos[i];
+	}
+
+	char posbuf[EVENT_AUTH_CHAIN_VAL_SIZE];
+	db::txn::append
+	{
+		txn, event_auth_chain,
+		{
+			db::op::SET,
+			idx_key,
+			event_auth_chain_val(posbuf, pos),
+		}
+	};
+
+	db::txn::append
+	{
+		txn, event_auth_cover,
+		{
+			db::op::SET,
+			event_auth_cover_key(keybuf, pos.first, pos.second),
+			event_auth_cover_val(valbuf, opts.event_idx, {links, links_count}),
+		}
+	};
+}
+
+// NOTE: QUERY
+bool
+ircd::m::dbs::event_auth_chain_extends(const event &event,
+                                       const event::idx &auth_idx,
+                                       const write_opts &opts)
+{
+	if(!opts.allow_queries)
+		return false;
+
+	bool ret(false);
+	m::get(std::nothrow, auth_idx, "type", [&event, &ret]
+	(const string_view &type)
+	{
+		ret = type == json::get<"type"_>(event);
+	});
+
+	if(!ret)
+		return false;
+
+	m::get(std::nothrow, auth_idx, "state_key", [&event, &ret]
+	(const string_view &state_key)
+	{
+		ret = state_key == json::get<"state_key"_>(event);
+	});
+
+	return ret;
+}
+
+// NOTE: QUERY
+bool
+ircd::m::dbs::event_auth_cover_has(const event_auth_chain_pos &pos,
+                                   const write_opts &opts)
+{
+	char buf[EVENT_AUTH_COVER_KEY_SIZE];
+	const string_view &key
+	{
+		event_auth_cover_key(buf, pos.first, pos.second)
+	};
+
+	if(opts.interpose)
+		if(opts.interpose->has(db::op::SET, "_event_auth_cover", key))
+			return true;
+
+	// Without queries a chain can't be known to end here.
+	if(!opts.allow_queries)
+		return true;
+
+	return db::has(event_auth_cover, key);
+}
+
+// NOTE: QUERY
+bool
+ircd::m::dbs::find_event_auth_chain(event_auth_chain_pos &pos,
+                                    const event::idx &event_idx,
+                                    const write_opts &opts)
+{
+	const string_view key
+	{
+		byte_view<string_view>(event_idx)
+	};
+
+	if(opts.interpose)
+	{
+		const string_view &val
+		{
+			opts.interpose->val(db::op::SET, "_event_auth_chain", key)
+		};
+
+		if(size(val) >= EVENT_AUTH_CHAIN_VAL_SIZE)
+		{
+			pos = event_auth_chain_val(val);
+			return true;
+		}
+	}
+
+	if(!opts.allow_queries)
+		return false;
+
+	return event_auth_chain(key, std::nothrow, [&pos]
+	(const string_view &val)
+	{
+		pos = event_auth_chain_val(val);
+	});
+}
+
+//
+// cmp
+//
+
+bool
+ircd::m::dbs::event_auth_cover__cmp_less(const string_view &a,
+                                         const string_view &b)
+{
+	static const size_t half(sizeof(uint64_t));
+
+	assert(size(a) >= half);
+	assert(size(b) >= half);
+	const uint64_t *const key[2]
+	{
+		reinterpret_cast<const uint64_t *>(data(a)),
+		reinterpret_cast<const uint64_t *>(data(b)),
+	};
+
+	return
+		key[0][0] < key[1][0]?   true:
+		key[0][0] > key[1][0]?   false:
+		size(a) < size(b)?       true:
+		size(a) > size(b)?       false:
+		size(a) == half?         false:
+		key[0][1] < key[1][1]?   true:
+		                         false;
+}
+
+//
+// key
+//
+
+uint64_t
+ircd::m::dbs::event_auth_cover_key(const string_view &amalgam)
+{
+	assert(size(amalgam) >= sizeof(uint64_t));
+	return byte_view<uint64_t>
+	{
+		amalgam.substr(size(amalgam) - sizeof(uint64_t))
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::event_auth_cover_key(const mutable_buffer &out_,
+                                   const uint64_t &chain,
+                                   const uint64_t &seq)
+{
+	assert(size(out_) >= EVENT_AUTH_COVER_KEY_SIZE);
+	mutable_buffer out{out_};
+	consume(out, copy(out, byte_view<string_view>(chain)));
+	consume(out, copy(out, byte_view<string_view>(seq)));
+	return { data(out_), data(out) };
+}
+
+//
+// val
+//
+
+std::tuple<ircd::m::event::idx, size_t>
+ircd::m::dbs::event_auth_cover_val(event_auth_chain_pos (&links)[event::auth::MAX],
+                                   const string_view &val)
+{
+	assert(size(val) >= sizeof(event::idx));
+	const event::idx event_idx
+	{
+		byte_view<event::idx>(val.substr(0, sizeof(event::idx)))
+	};
+
+	size_t i(0);
+	string_view link(val.substr(sizeof(event::idx)));
+	for(; i < event::auth::MAX && size(link) >= EVENT_AUTH_CHAIN_VAL_SIZE; ++i)
+	{
+		links[i] = event_auth_chain_val(link);
+		link = link.substr(EVENT_AUTH_CHAIN_VAL_SIZE);
+	}
+
+	return
+	{
+		event_idx, i
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::event_auth_cover_val(const mutable_buffer &out_,
+                                   const event::idx &event_idx,
+                                   const event_auth_cover_links &links)
+{
+	assert(links.size() <= event::auth::MAX);
+	mutable_buffer out{out_};
+	consume(out, copy(out, byte_view<string_view>(event_idx)));
+	for(const auto &link : links)
+	{
+		consume(out, copy(out, byte_view<string_view>(link.first)));
+		consume(out, copy(out, byte_view<string_view>(link.second)));
+	}
+
+	return { data(out_), data(out) };
+}
+
+ircd::m::dbs::event_auth_chain_pos
+ircd::m::dbs::event_auth_chain_val(const string_view &val)
+{
+	assert(size(val) >= EVENT_AUTH_CHAIN_VAL_SIZE);
+	return
+	{
+		byte_view<uint64_t>(val.substr(0, sizeof(uint64_t))),
+		byte_view<uint64_t>(val.substr(sizeof(uint64_t), sizeof(uint64_t))),
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::event_auth_chain_val(const mutable_buffer &out_,
+                                   const event_auth_chain_pos &pos)
+{
+	assert(size(out_) >= EVENT_AUTH_CHAIN_VAL_SIZE);
+	mutable_buffer out{out_};
+	consume(out, copy(out, byte_view<string_view>(pos.first)));
+	consume(out, copy(out, byte_view<string_view>(pos.second)));
+	return { data(out_), data(out) };
+}
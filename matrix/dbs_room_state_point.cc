@@ -0,0 +1,532 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static bool _room_state_point_find(const string_view &room_id, const int64_t &point, const string_view &type, const string_view &state_key, int64_t &depth, event::idx &);
+	static void _index_room_state_point_make(db::txn &, const string_view &room_id, const int64_t &point);
+	static void _index_room_state_point_patch(db::txn &, const event &, const write_opts &);
+	static bool room_state_point__cmp_lt(const string_view &, const string_view &);
+}
+
+decltype(ircd::m::dbs::room_state_point)
+ircd::m::dbs::room_state_point;
+
+decltype(ircd::m::dbs::desc::room_state_point__comp)
+ircd::m::dbs::desc::room_state_point__comp
+{
+	{ "name",     "ircd.m.dbs._room_state_point.comp" },
+	{ "default",  "default"                           },
+};
+
+decltype(ircd::m::dbs::desc::room_state_point__block__size)
+ircd::m::dbs::desc::room_state_point__block__size
+{
+	{ "name",     "ircd.m.dbs._room_state_point.block.size" },
+	{ "default",  512L                                      },
+};
+
+decltype(ircd::m::dbs::desc::room_state_point__meta_block__size)
+ircd::m::dbs::desc::room_state_point__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._room_state_point.meta_block.size" },
+	{ "default",  long(8_KiB)                                    },
+};
+
+decltype(ircd::m::dbs::desc::room_state_point__cache__size)
+ircd::m::dbs::desc::room_state_point__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_state_point.cache.size"  },
+		{ "default",  long(16_MiB)                               },
+	}, []
+	{
+		const size_t &value{room_state_point__cache__size};
+		db::capacity(db::cache(dbs::room_state_point), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::room_state_point__cache_comp__size)
+ircd::m::dbs::desc::room_state_point__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_state_point.cache_comp.size"  },
+		{ "default",  long(0_MiB)                                     },
+	}, []
+	{
+		const size_t &value{room_state_point__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::room_state_point), value);
+	}
+};
+
+/// The distance in depth between the checkpoints of a room. A historical
+/// state query replays at most this many room events past the nearest
+/// checkpoint. Zero disables making new checkpoints.
+decltype(ircd::m::dbs::desc::room_state_point__interval)
+ircd::m::dbs::desc::room_state_point__interval
+{
+	{ "name",     "ircd.m.dbs._room_state_point.interval" },
+	{ "default",  1024L                                   },
+};
+
+/// The number of checkpoints spanned by each keyframe. A keyframe is a full
+/// copy of the room state; the checkpoints between keyframes only store the
+/// entries which changed since their keyframe.
+decltype(ircd::m::dbs::desc::room_state_point__keyframe)
+ircd::m::dbs::desc::room_state_point__keyframe
+{
+	{ "name",     "ircd.m.dbs._room_state_point.keyframe" },
+	{ "default",  16L                                     },
+};
+
+const ircd::db::comparator
+ircd::m::dbs::desc::room_state_point__cmp
+{
+	"_room_state_point",
+	room_state_point__cmp_lt,
+	db::cmp_string_view::equal,
+};
+
+const ircd::db::prefix_transform
+ircd::m::dbs::desc::room_state_point__pfx
+{
+	"_room_state_point",
+
+	[](const string_view &key)
+	{
+		return has(key, "\0"_sv);
+	},
+
+	[](const string_view &key)
+	{
+		return split(key, '\0').first;
+	}
+};
+
+/// This column stores periodic checkpoints of the state of each room so a
+/// historical state query does not have to scan all states of the room in
+/// room_state_space. Consider the following:
+///
+/// [room_id | point, type, state_key] => depth, event_idx
+///
+const ircd::db::descriptor
+ircd::m::dbs::desc::room_state_point
+{
+	// name
+	"_room_state_point",
+
+	// explanation
+	R"(Checkpoints of the state of the room.
+
+	[room_id | point, type, state_key] => depth, event_idx
+
+	The point is a depth at a fixed interval; the entries of a point are the
+	state of the room from all events with a depth less than the point. The
+	first entry of each point is a header with an empty type and state_key
+	whose value holds the point of its keyframe. A keyframe contains all of
+	the state; other points only contain the entries which changed since
+	their keyframe. Points are sorted from the highest depth to the lowest.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	room_state_point__cmp,
+
+	// prefix transform
+	room_state_point__pfx,
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0, // no bloom filter because of possible comparator issues
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(room_state_point__block__size),
+
+	// meta_block size
+	size_t(room_state_point__meta_block__size),
+
+	// compression
+	string_view{room_state_point__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+// indexer
+//
+
+/// Makes the checkpoint when the event is at a checkpoint depth, and amends
+/// any checkpoints above a state event which arrived out of order.
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_room_state_point(db::txn &txn,
+                                      const event &event,
+                                      const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::ROOM_STATE_POINT));
+
+	if(opts.op != db::op::SET || !opts.allow_queries)
+		return;
+
+	if(defined(json::get<"state_key"_>(event)))
+		_index_room_state_point_patch(txn, event, opts);
+
+	const int64_t &depth
+	{
+		json::get<"depth"_>(event)
+	};
+
+	if(room_state_point_is(depth))
+		_index_room_state_point_make(txn, at<"room_id"_>(event), depth);
+}
+
+/// The state at the point is obtained through room::state::history, which
+/// itself starts from the previous checkpoint. When the keyframe for the
+/// point is not available the point is made into a keyframe.
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_room_state_point_make(db::txn &txn,
+                                           const string_view &room_id,
+                                           const int64_t &point)
+{
+	char buf[ROOM_STATE_POINT_KEY_MAX_SIZE], val[ROOM_STATE_POINT_VAL_SIZE];
+	if(db::has(room_state_point, room_state_point_key(buf, room_id, point)))
+		return;
+
+	const int64_t keyframe
+	{
+		room_state_point_base(point)
+	};
+
+	const int64_t base
+	{
+		keyframe != point && db::has(room_state_point, room_state_point_key(buf, room_id, keyframe))?
+			keyframe:
+			point
+	};
+
+	db::txn::append
+	{
+		txn, room_state_point,
+		{
+			db::op::SET,
+			room_state_point_key(buf, room_id, point),
+			room_state_point_val(val, base, 0UL),
+		}
+	};
+
+	const m::room room
+	{
+		m::room::id{room_id}
+	};
+
+	const m::room::state::history history
+	{
+		room, point
+	};
+
+	history.for_each([&txn, &room_id, &point, &base, &buf, &val]
+	(const string_view &type, const string_view &state_key, const int64_t &depth, const event::idx &event_idx)
+	{
+		if(base != point && depth < base)
+			return true;
+
+		db::txn::append
+		{
+			txn, room_state_point,
+			{
+				db::op::SET,
+				room_state_point_key(buf, room_id, point, type, state_key),
+				room_state_point_val(val, depth, event_idx),
+			}
+		};
+
+		return true;
+	});
+}
+
+/// Every checkpoint above the depth of this state event must reflect it
+/// unless the checkpoint already has a more recent event for the same
+/// (type, state_key).
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_room_state_point_patch(db::txn &txn,
+                                            const event &event,
+                                            const write_opts &opts)
+{
+	const auto &room_id(at<"room_id"_>(event));
+	const auto &type(at<"type"_>(event));
+	const auto &state_key(at<"state_key"_>(event));
+	const int64_t &depth(at<"depth"_>(event));
+
+	char buf[ROOM_STATE_POINT_KEY_MAX_SIZE], val[ROOM_STATE_POINT_VAL_SIZE];
+	int64_t point(std::numeric_limits<int64_t>::max());
+	while(point > depth)
+	{
+		const auto it
+		{
+			room_state_point.begin(room_state_point_key(buf, room_id, point))
+		};
+
+		if(!it)
+			break;
+
+		const auto &[_point, _type, _state_key]
+		{
+			room_state_point_key(it->first)
+		};
+
+		assert(!_type && !_state_key);
+		if(_point <= depth)
+			break;
+
+		const auto &[base, _]
+		{
+			room_state_point_val(it->second)
+		};
+
+		int64_t prior_depth(-1);
+		event::idx prior_idx(0);
+		const bool found
+		{
+			_room_state_point_find(room_id, _point, type, state_key, prior_depth, prior_idx) ||
+			(base != _point && _room_state_point_find(room_id, base, type, state_key, prior_depth, prior_idx))
+		};
+
+		const bool behind
+		{
+			!found ||
+			prior_depth < depth ||
+			(prior_depth == depth && prior_idx < opts.event_idx)
+		};
+
+		if(behind)
+			db::txn::append
+			{
+				txn, room_state_point,
+				{
+					db::op::SET,
+					room_state_point_key(buf, room_id, _point, type, state_key),
+					room_state_point_val(val, depth, opts.event_idx),
+				}
+			};
+
+		point = _point - 1;
+	}
+}
+
+bool
+ircd::m::dbs::_room_state_point_find(const string_view &room_id,
+                                     const int64_t &point,
+                                     const string_view &type,
+                                     const string_view &state_key,
+                                     int64_t &depth,
+                                     event::idx &event_idx)
+{
+	char buf[ROOM_STATE_POINT_KEY_MAX_SIZE];
+	return room_state_point(room_state_point_key(buf, room_id, point, type, state_key), std::nothrow, [&depth, &event_idx]
+	(const string_view &value)
+	{
+		std::tie(depth, event_idx) = room_state_point_val(value);
+	});
+}
+
+//
+// cmp
+//
+
+bool
+ircd::m::dbs::room_state_point__cmp_lt(const string_view &a,
+                                       const string_view &b)
+{
+	static const auto &pt
+	{
+		desc::room_state_point__pfx
+	};
+
+	const string_view pre[2]
+	{
+		pt.get(a),
+		pt.get(b),
+	};
+
+	if(size(pre[0]) != size(pre[1]))
+		return size(pre[0]) < size(pre[1]);
+
+	if(pre[0] != pre[1])
+		return pre[0] < pre[1];
+
+	const string_view post[2]
+	{
+		a.substr(size(pre[0])),
+		b.substr(size(pre[1])),
+	};
+
+	// These conditions are matched on some queries when the user only
+	// supplies a room_id.
+	if(size(post[1]) < 1 + 8)
+		return false;
+
+	if(size(post[0]) < 1 + 8)
+		return true;
+
+	const auto &[point_a, type_a, state_key_a]
+	{
+		room_state_point_key(post[0])
+	};
+
+	const auto &[point_b, type_b, state_key_b]
+	{
+		room_state_point_key(post[1])
+	};
+
+	// point (ORDER IS DESCENDING!)
+	if(point_a > point_b)
+		return true;
+	else if(point_a < point_b)
+		return false;
+
+	// type
+	if(type_a < type_b)
+		return true;
+	else if(type_a > type_b)
+		return false;
+
+	// state_key
+	if(state_key_a < state_key_b)
+		return true;
+	else if(state_key_a > state_key_b)
+		return false;
+
+	return false;
+}
+
+//
+// key
+//
+
+ircd::m::dbs::room_state_point_key_parts
+ircd::m::dbs::room_state_point_key(const string_view &amalgam)
+{
+	assert(size(amalgam) >= 1 + 8);
+	assert(amalgam.front() == '\0');
+
+	const int64_t &point
+	{
+		int64_t(byte_view<int64_t>(amalgam.substr(1, 8)))
+	};
+
+	const auto &[type, state_key]
+	{
+		split(amalgam.substr(1 + 8), '\0')
+	};
+
+	return
+	{
+		point, type, state_key
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::room_state_point_key(const mutable_buffer &out_,
+                                   const id::room &room_id,
+                                   const int64_t &point,
+                                   const string_view &type,
+                                   const string_view &state_key)
+{
+	mutable_buffer out{out_};
+	consume(out, copy(out, room_id));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, byte_view<string_view>(point)));
+	consume(out, copy(out, trunc(type, event::TYPE_MAX_SIZE)));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, trunc(state_key, event::STATE_KEY_MAX_SIZE)));
+	return { data(out_), data(out) };
+}
+
+//
+// val
+//
+
+ircd::m::dbs::room_state_point_val_parts
+ircd::m::dbs::room_state_point_val(const string_view &val)
+{
+	assert(size(val) >= ROOM_STATE_POINT_VAL_SIZE);
+	return
+	{
+		int64_t(byte_view<int64_t>(val.substr(0, 8))),
+		event::idx(byte_view<event::idx>(val.substr(8, 8))),
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::room_state_point_val(const mutable_buffer &out_,
+                                   const int64_t &depth,
+                                   const event::idx &event_idx)
+{
+	mutable_buffer out{out_};
+	consume(out, copy(out, byte_view<string_view>(depth)));
+	consume(out, copy(out, byte_view<string_view>(event_idx)));
+	return { data(out_), data(out) };
+}
+
+//
+// util
+//
+
+bool
+ircd::m::dbs::room_state_point_is(const int64_t &depth)
+{
+	const int64_t &interval
+	{
+		int64_t(desc::room_state_point__interval)
+	};
+
+	return interval > 0 && depth > 0 && depth % interval == 0;
+}
+
+/// The point of the keyframe for any point. This is zero for points before
+/// the first keyframe; there is never a point at zero.
+int64_t
+ircd::m::dbs::room_state_point_base(const int64_t &point)
+{
+	const int64_t span
+	{
+		int64_t(desc::room_state_point__interval) *
+		std::max(int64_t(desc::room_state_point__keyframe), 1L)
+	};
+
+	return span > 0?
+		point - point % span:
+		point;
+}
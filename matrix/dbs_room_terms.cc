@@ -0,0 +1,564 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static void _index_room_terms_content(db::txn &, const db::op &, const string_view &room_id, const event::idx &, const json::object &content);
+	static void _index_room_terms_redact(db::txn &, const event &, const write_opts &);
+	static bool room_terms__cmp_lt(const string_view &, const string_view &);
+
+	extern const string_view room_terms_keys[3];
+}
+
+decltype(ircd::m::dbs::room_terms)
+ircd::m::dbs::room_terms;
+
+/// The content properties which are tokenized into the index. These are the
+/// keys offered by the client-server search API.
+decltype(ircd::m::dbs::room_terms_keys)
+ircd::m::dbs::room_terms_keys
+{
+	"body",
+	"name",
+	"topic",
+};
+
+decltype(ircd::m::dbs::desc::room_terms__comp)
+ircd::m::dbs::desc::room_terms__comp
+{
+	{ "name",     "ircd.m.dbs._room_terms.comp" },
+	{ "default",  "default"                     },
+};
+
+decltype(ircd::m::dbs::desc::room_terms__block__size)
+ircd::m::dbs::desc::room_terms__block__size
+{
+	{ "name",     "ircd.m.dbs._room_terms.block.size" },
+	{ "default",  512L                                },
+};
+
+decltype(ircd::m::dbs::desc::room_terms__meta_block__size)
+ircd::m::dbs::desc::room_terms__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._room_terms.meta_block.size" },
+	{ "default",  8192L                                    },
+};
+
+decltype(ircd::m::dbs::desc::room_terms__cache__size)
+ircd::m::dbs::desc::room_terms__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_terms.cache.size" },
+		{ "default",  long(16_MiB)                        },
+	}, []
+	{
+		const size_t &value{room_terms__cache__size};
+		db::capacity(db::cache(dbs::room_terms), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::room_terms__cache_comp__size)
+ircd::m::dbs::desc::room_terms__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_terms.cache_comp.size" },
+		{ "default",  long(0_MiB)                              },
+	}, []
+	{
+		const size_t &value{room_terms__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::room_terms), value);
+	}
+};
+
+/// Limits the number of distinct terms indexed for a single event. Terms
+/// past this limit are not indexed, bounding the size of the transaction
+/// for pathological messages.
+decltype(ircd::m::dbs::desc::room_terms__terms__max)
+ircd::m::dbs::desc::room_terms__terms__max
+{
+	{ "name",     "ircd.m.dbs._room_terms.terms.max" },
+	{ "default",  256L                               },
+};
+
+/// Prefix transform for the room_terms. The prefix here is a term and the
+/// suffix is the room_id+event_idx concatenation.
+///
+const ircd::db::prefix_transform
+ircd::m::dbs::desc::room_terms__pfx
+{
+	"_room_terms",
+
+	[](const string_view &key)
+	{
+		return has(key, "\0"_sv);
+	},
+
+	[](const string_view &key)
+	{
+		return split(key, '\0').first;
+	}
+};
+
+/// Comparator for the room_terms. Within each term the postings are sorted
+/// by room_id and then by event_idx from highest to lowest, so the most
+/// recent posting in a room is hit first when it is sought.
+///
+const ircd::db::comparator
+ircd::m::dbs::desc::room_terms__cmp
+{
+	"_room_terms",
+	room_terms__cmp_lt,
+	db::cmp_string_view::equal,
+};
+
+/// This column is an inverted index of the words found in the content of
+/// events. Consider the following:
+///
+/// [term | room_id, event_idx] => term frequency, keys
+///
+const ircd::db::descriptor
+ircd::m::dbs::desc::room_terms
+{
+	// name
+	"_room_terms",
+
+	// explanation
+	R"(Inverted index of terms found in the content of events in rooms.
+
+	[term | room_id, event_idx] => term frequency, keys
+
+	The content.body, content.name and content.topic of events are tokenized
+	into lowercase terms. Each term forms the prefix domain and the postings
+	are ordered by room and then by descending event_idx. The value is the
+	number of times the term appeared in the event as a 16-bit integer,
+	followed by a byte with a bit for each key the term appeared in.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	room_terms__cmp,
+
+	// prefix transform
+	room_terms__pfx,
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0, // no bloom filter because of possible comparator issues
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(room_terms__block__size),
+
+	// meta_block size
+	size_t(room_terms__meta_block__size),
+
+	// compression
+	string_view{room_terms__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+// indexer
+//
+
+/// Adds the postings of the event's content terms into the txn. Redactions
+/// remove the postings of their target instead.
+void
+ircd::m::dbs::_index_room_terms(db::txn &txn,
+                                const event &event,
+                                const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::ROOM_TERMS));
+
+	if(json::get<"type"_>(event) == "m.room.redaction")
+		return _index_room_terms_redact(txn, event, opts);
+
+	const json::object &content
+	{
+		json::get<"content"_>(event)
+	};
+
+	if(empty(content))
+		return;
+
+	_index_room_terms_content(txn, opts.op, at<"room_id"_>(event), opts.event_idx, content);
+}
+
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_room_terms_redact(db::txn &txn,
+                                       const event &event,
+                                       const write_opts &opts)
+{
+	assert(json::get<"type"_>(event) == "m.room.redaction");
+
+	if(opts.op != db::op::SET || !opts.allow_queries)
+		return;
+
+	const auto &target_id
+	{
+		json::get<"redacts"_>(event)
+	};
+
+	if(!valid(m::id::EVENT, target_id))
+		return;
+
+	const m::event::idx target_idx
+	{
+		find_event_idx(target_id, opts)
+	};
+
+	if(!target_idx)
+		return;
+
+	m::get(std::nothrow, target_idx, "content", [&txn, &event, &target_idx]
+	(const json::object &content)
+	{
+		_index_room_terms_content(txn, db::op::DELETE, at<"room_id"_>(event), target_idx, content);
+	});
+}
+
+void
+ircd::m::dbs::_index_room_terms_content(db::txn &txn,
+                                        const db::op &op,
+                                        const string_view &room_id,
+                                        const event::idx &event_idx,
+                                        const json::object &content)
+{
+	thread_local char buf[event::MAX_SIZE], kbuf[ROOM_TERMS_KEY_MAX_SIZE];
+	const ctx::critical_assertion ca;
+
+	// Terms are views into buf; each property is tokenized into the space
+	// remaining after the previous one so all of the views remain valid.
+	std::map<string_view, room_terms_val_tuple> terms;
+	mutable_buffer scratch{buf};
+	for(size_t i(0); i < std::size(room_terms_keys); ++i)
+	{
+		const json::string text
+		{
+			content[room_terms_keys[i]]
+		};
+
+		if(!text)
+			continue;
+
+		room_terms_tokenize(scratch, text, [&terms, &i]
+		(const string_view &term)
+		{
+			if(terms.size() >= size_t(desc::room_terms__terms__max) && !terms.count(term))
+				return true;
+
+			auto &[tf, keys](terms[term]);
+			tf += tf < std::numeric_limits<uint16_t>::max();
+			keys |= room_terms_mask(1U << i);
+			return true;
+		});
+
+		consume(scratch, std::min(size(text), size(scratch)));
+	}
+
+	char vbuf[ROOM_TERMS_VAL_SIZE];
+	for(const auto &[term, val] : terms)
+	{
+		const auto &[tf, keys]
+		{
+			val
+		};
+
+		const string_view &key
+		{
+			room_terms_key(kbuf, term, room_id, event_idx)
+		};
+
+		db::txn::append
+		{
+			txn, room_terms,
+			{
+				op,
+				key,
+				op == db::op::SET?
+					room_terms_val(vbuf, tf, keys):
+					string_view{}
+			}
+		};
+	}
+}
+
+/// Bit of the content key in the keys of a posting; the key is given as in
+/// the client-server search API (i.e. "content.body") or bare. Zero if the
+/// key is not indexed.
+ircd::m::dbs::room_terms_mask
+ircd::m::dbs::room_terms_key_mask(const string_view &key)
+noexcept
+{
+	const string_view &name
+	{
+		startswith(key, "content.")?
+			key.substr(strlen("content.")):
+			key
+	};
+
+	for(size_t i(0); i < std::size(room_terms_keys); ++i)
+		if(room_terms_keys[i] == name)
+			return room_terms_mask(1U << i);
+
+	return 0;
+}
+
+//
+// val
+//
+
+/// Postings written before the keys were recorded have only the frequency
+/// and are considered found in every key.
+ircd::m::dbs::room_terms_val_tuple
+ircd::m::dbs::room_terms_val(const string_view &val)
+noexcept
+{
+	const uint16_t tf
+	{
+		size(val) >= sizeof(uint16_t)?
+			uint16_t(byte_view<uint16_t>(val.substr(0, sizeof(uint16_t)))):
+			uint16_t(1)
+	};
+
+	const room_terms_mask keys
+	{
+		size(val) >= ROOM_TERMS_VAL_SIZE?
+			room_terms_mask(val[sizeof(uint16_t)]):
+			ROOM_TERMS_KEYS_ALL
+	};
+
+	return
+	{
+		tf, keys
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::room_terms_val(const mutable_buffer &out_,
+                             const uint16_t &tf,
+                             const room_terms_mask &keys)
+{
+	assert(size(out_) >= ROOM_TERMS_VAL_SIZE);
+	mutable_buffer out{out_};
+	consume(out, copy(out, byte_view<string_view>(tf)));
+	consume(out, copy(out, byte_view<string_view>(keys)));
+	return { data(out_), data(out) };
+}
+
+//
+// tokenizer
+//
+
+/// Breaks the text into lowercase terms. The text is unescaped and folded
+/// into the buffer; the terms presented to the closure are views into the
+/// buffer. Multibyte UTF-8 sequences are treated as part of a term, while
+/// ASCII punctuation and whitespace separate terms. Single-byte terms are
+/// not considered. Terms are truncated to ROOM_TERMS_TERM_MAX_SIZE.
+bool
+ircd::m::dbs::room_terms_tokenize(const mutable_buffer &buf,
+                                  const json::string &text,
+                                  const room_terms_closure &closure)
+{
+	const string_view unescaped
+	{
+		json::unescape(buf, text)
+	};
+
+	const string_view lower
+	{
+		tolower(buf, unescaped)
+	};
+
+	static const auto is_term_char{[]
+	(const char &c) noexcept
+	{
+		return (c & 0x80) || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z');
+	}};
+
+	const char *it(begin(lower));
+	while(it != end(lower))
+	{
+		const auto start
+		{
+			std::find_if(it, end(lower), is_term_char)
+		};
+
+		const auto stop
+		{
+			std::find_if_not(start, end(lower), is_term_char)
+		};
+
+		const string_view term
+		{
+			start, stop
+		};
+
+		it = stop;
+		if(size(term) < 2)
+			continue;
+
+		if(!closure(trunc(term, ROOM_TERMS_TERM_MAX_SIZE)))
+			return false;
+	}
+
+	return true;
+}
+
+//
+// cmp
+//
+
+bool
+ircd::m::dbs::room_terms__cmp_lt(const string_view &a,
+                                 const string_view &b)
+{
+	static const auto &pt
+	{
+		desc::room_terms__pfx
+	};
+
+	// Extract the prefix from the keys
+	const string_view pre[2]
+	{
+		pt.get(a),
+		pt.get(b),
+	};
+
+	// Prefix size comparison has highest priority for rocksdb
+	if(size(pre[0]) < size(pre[1]))
+		return true;
+
+	// Prefix size comparison has highest priority for rocksdb
+	if(size(pre[0]) > size(pre[1]))
+		return false;
+
+	// Prefix lexical comparison sorts prefixes of the same size
+	if(pre[0] < pre[1])
+		return true;
+
+	// Prefix lexical comparison sorts prefixes of the same size
+	if(pre[0] > pre[1])
+		return false;
+
+	// After the prefix is the \0,room_id,\0,event_idx
+	const string_view post[2]
+	{
+		a.substr(size(pre[0])),
+		b.substr(size(pre[1])),
+	};
+
+	// These conditions are matched on some queries when the user only
+	// supplies a term; nothing sorts before the bare prefix.
+	if(size(post[1]) < 1 + 1 + 8)
+		return false;
+
+	if(size(post[0]) < 1 + 1 + 8)
+		return true;
+
+	const auto &[room_id_a, event_idx_a]
+	{
+		room_terms_key(post[0])
+	};
+
+	const auto &[room_id_b, event_idx_b]
+	{
+		room_terms_key(post[1])
+	};
+
+	if(room_id_a < room_id_b)
+		return true;
+
+	if(room_id_a > room_id_b)
+		return false;
+
+	// reverse event_idx to start from highest first like room_events
+	if(event_idx_a < event_idx_b)
+		return false;
+
+	if(event_idx_a > event_idx_b)
+		return true;
+
+	// equal is not less; so false
+	return false;
+}
+
+//
+// key
+//
+
+ircd::m::dbs::room_terms_tuple
+ircd::m::dbs::room_terms_key(const string_view &amalgam)
+{
+	assert(size(amalgam) >= 1 + 1 + 8);
+	assert(amalgam.front() == '\0');
+
+	// The event_idx is fixed-width at the end and may contain any byte, so
+	// the room_id is taken from between the separators.
+	const string_view room_id
+	{
+		amalgam.substr(1, size(amalgam) - 1 - 1 - 8)
+	};
+
+	const string_view trail
+	{
+		amalgam.substr(size(amalgam) - 8)
+	};
+
+	return room_terms_tuple
+	{
+		room_id,
+		event::idx(byte_view<uint64_t>(trail)),
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::room_terms_key(const mutable_buffer &out_,
+                             const string_view &term,
+                             const string_view &room_id,
+                             const event::idx &event_idx)
+{
+	assert(term);
+	mutable_buffer out{out_};
+	consume(out, copy(out, trunc(term, ROOM_TERMS_TERM_MAX_SIZE)));
+	consume(out, copy(out, '\0'));
+
+	if(!room_id)
+		return { data(out_), data(out) };
+
+	consume(out, copy(out, room_id));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, byte_view<string_view>(event_idx)));
+	return { data(out_), data(out) };
+}
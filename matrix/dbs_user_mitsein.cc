@@ -0,0 +1,316 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static void _index_user_mitsein_pair(db::txn &, const db::op &, const id::room &, const id::user &, const id::user &);
+}
+
+decltype(ircd::m::dbs::user_mitsein)
+ircd::m::dbs::user_mitsein;
+
+decltype(ircd::m::dbs::desc::user_mitsein__comp)
+ircd::m::dbs::desc::user_mitsein__comp
+{
+	{ "name",     "ircd.m.dbs._user_mitsein.comp" },
+	{ "default",  "default"                       },
+};
+
+decltype(ircd::m::dbs::desc::user_mitsein__block__size)
+ircd::m::dbs::desc::user_mitsein__block__size
+{
+	{ "name",     "ircd.m.dbs._user_mitsein.block.size" },
+	{ "default",  512L                                  },
+};
+
+decltype(ircd::m::dbs::desc::user_mitsein__meta_block__size)
+ircd::m::dbs::desc::user_mitsein__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._user_mitsein.meta_block.size" },
+	{ "default",  long(8_KiB)                                },
+};
+
+decltype(ircd::m::dbs::desc::user_mitsein__cache__size)
+ircd::m::dbs::desc::user_mitsein__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._user_mitsein.cache.size" },
+		{ "default",  long(16_MiB)                          },
+	}, []
+	{
+		const size_t &value{user_mitsein__cache__size};
+		db::capacity(db::cache(dbs::user_mitsein), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::user_mitsein__cache_comp__size)
+ircd::m::dbs::desc::user_mitsein__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._user_mitsein.cache_comp.size" },
+		{ "default",  long(0_MiB)                                },
+	}, []
+	{
+		const size_t &value{user_mitsein__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::user_mitsein), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::user_mitsein__bloom__bits)
+ircd::m::dbs::desc::user_mitsein__bloom__bits
+{
+	{ "name",     "ircd.m.dbs._user_mitsein.bloom.bits" },
+	{ "default",  0L                                    },
+};
+
+/// Prefix transform for the user_mitsein. The prefix is the user_id and the
+/// suffix is the other user_id and the room_id.
+///
+const ircd::db::prefix_transform
+ircd::m::dbs::desc::user_mitsein__pfx
+{
+	"_user_mitsein",
+
+	[](const string_view &key)
+	{
+		return has(key, "\0"_sv);
+	},
+
+	[](const string_view &key)
+	{
+		return split(key, '\0').first;
+	}
+};
+
+/// This column indexes the users sharing a joined room with each of our
+/// users. Consider the following:
+///
+/// [@user:mydomain | @other:theirdomain, !room:somewhere]
+///
+/// There is one key for every room the pair has in common, so the keys under
+/// a pair reference count the rooms keeping them together; the pair is
+/// visible while any remain. Only our own users form a prefix domain; a pair
+/// of two of our users is written in both directions.
+///
+const ircd::db::descriptor
+ircd::m::dbs::desc::user_mitsein
+{
+	// name
+	"_user_mitsein",
+
+	// explanation
+	R"(Index of the users sharing a presently joined room with a local user.
+
+	[user_id | other_user_id, room_id]
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	user_mitsein__pfx,
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	size_t(user_mitsein__bloom__bits),
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(user_mitsein__block__size),
+
+	// meta_block size
+	size_t(user_mitsein__meta_block__size),
+
+	// compression
+	string_view{user_mitsein__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+// indexer
+//
+
+/// Adds the pairs formed or broken by a membership event into the txn. Only
+/// a transition into or out of the joined state has any effect; the pairs
+/// are made with the present joined members of the room.
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_user_mitsein(db::txn &txn,
+                                  const event &event,
+                                  const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::USER_MITSEIN));
+	assert(at<"type"_>(event) == "m.room.member");
+
+	const m::room room
+	{
+		at<"room_id"_>(event)
+	};
+
+	const m::user::id &user_id
+	{
+		at<"state_key"_>(event)
+	};
+
+	const bool joins
+	{
+		opts.op == db::op::SET && m::membership(event) == "join"
+	};
+
+	const bool joined
+	{
+		m::membership(room, user_id, "join")
+	};
+
+	// Only transitions matter; a join with a changed displayname or a leave
+	// after a leave has nothing to contribute.
+	if(joins == joined)
+		return;
+
+	const db::op op
+	{
+		joins? db::op::SET: db::op::DELETE
+	};
+
+	// When the user is not ours, the only pairs are with our own members.
+	const string_view &host
+	{
+		my(user_id)?
+			string_view{}:
+			my_host()
+	};
+
+	const m::room::members members
+	{
+		room
+	};
+
+	members.for_each("join", host, [&txn, &op, &room, &user_id]
+	(const id::user &member)
+	{
+		if(member != user_id)
+			_index_user_mitsein_pair(txn, op, room.room_id, user_id, member);
+
+		return true;
+	});
+}
+
+/// Adds all pairs among the members into the txn. This is for bulk callers
+/// which already know the joined members of the room, such as rebuilds.
+void
+ircd::m::dbs::_index_user_mitsein(db::txn &txn,
+                                  const id::room &room_id,
+                                  const vector_view<const id::user> &members,
+                                  const db::op &op)
+{
+	for(size_t i(0); i < members.size(); ++i)
+	{
+		if(!my(members[i]))
+			continue;
+
+		for(size_t j(0); j < members.size(); ++j)
+			if(i != j && members[i] != members[j])
+				_index_user_mitsein_pair(txn, op, room_id, members[i], members[j]);
+	}
+}
+
+void
+ircd::m::dbs::_index_user_mitsein_pair(db::txn &txn,
+                                       const db::op &op,
+                                       const id::room &room_id,
+                                       const id::user &a,
+                                       const id::user &b)
+{
+	char buf[USER_MITSEIN_KEY_MAX_SIZE];
+	if(my(a))
+		db::txn::append
+		{
+			txn, user_mitsein,
+			{
+				op,
+				user_mitsein_key(buf, a, b, room_id),
+			}
+		};
+
+	if(my(b))
+		db::txn::append
+		{
+			txn, user_mitsein,
+			{
+				op,
+				user_mitsein_key(buf, b, a, room_id),
+			}
+		};
+}
+
+//
+// key
+//
+
+ircd::m::dbs::user_mitsein_tuple
+ircd::m::dbs::user_mitsein_key(const string_view &amalgam)
+{
+	assert(size(amalgam) >= 1);
+	assert(amalgam.front() == '\0');
+
+	const auto &[other, room_id]
+	{
+		split(amalgam.substr(1), '\0')
+	};
+
+	return user_mitsein_tuple
+	{
+		other, room_id
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::user_mitsein_key(const mutable_buffer &out_,
+                               const id::user &user,
+                               const id::user &other,
+                               const id::room &room_id)
+{
+	assert(user);
+	mutable_buffer out{out_};
+	consume(out, copy(out, user));
+	consume(out, copy(out, '\0'));
+
+	if(!other)
+		return { data(out_), data(out) };
+
+	consume(out, copy(out, other));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, room_id));
+	return { data(out_), data(out) };
+}
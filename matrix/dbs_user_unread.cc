@@ -0,0 +1,412 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static void _index_user_unread_note(db::txn &, const event &, const write_opts &);
+	static void _index_user_unread_read(db::txn &, const event &, const write_opts &);
+}
+
+decltype(ircd::m::dbs::user_unread)
+ircd::m::dbs::user_unread;
+
+decltype(ircd::m::dbs::desc::user_unread__comp)
+ircd::m::dbs::desc::user_unread__comp
+{
+	{ "name",     "ircd.m.dbs._user_unread.comp" },
+	{ "default",  "default"                       },
+};
+
+decltype(ircd::m::dbs::desc::user_unread__block__size)
+ircd::m::dbs::desc::user_unread__block__size
+{
+	{ "name",     "ircd.m.dbs._user_unread.block.size" },
+	{ "default",  512L                                  },
+};
+
+decltype(ircd::m::dbs::desc::user_unread__meta_block__size)
+ircd::m::dbs::desc::user_unread__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._user_unread.meta_block.size" },
+	{ "default",  long(8_KiB)                                },
+};
+
+decltype(ircd::m::dbs::desc::user_unread__cache__size)
+ircd::m::dbs::desc::user_unread__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._user_unread.cache.size" },
+		{ "default",  long(16_MiB)                          },
+	}, []
+	{
+		const size_t &value{user_unread__cache__size};
+		db::capacity(db::cache(dbs::user_unread), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::user_unread__cache_comp__size)
+ircd::m::dbs::desc::user_unread__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._user_unread.cache_comp.size" },
+		{ "default",  long(0_MiB)                                },
+	}, []
+	{
+		const size_t &value{user_unread__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::user_unread), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::user_unread__bloom__bits)
+ircd::m::dbs::desc::user_unread__bloom__bits
+{
+	{ "name",     "ircd.m.dbs._user_unread.bloom.bits" },
+	{ "default",  0L                                    },
+};
+
+/// Prefix transform for the user_unread. The prefix is the user_id and the
+/// suffix is the room_id.
+///
+const ircd::db::prefix_transform
+ircd::m::dbs::desc::user_unread__pfx
+{
+	"_user_unread",
+
+	[](const string_view &key)
+	{
+		return has(key, "\0"_sv);
+	},
+
+	[](const string_view &key)
+	{
+		return split(key, '\0').first;
+	}
+};
+
+/// This column holds the unread notification counts of our users for each
+/// room. Consider the following:
+///
+/// [@user:mydomain | !room:somewhere] => (3, 1, 5678)
+///
+/// The user has three unread notifications in the room, one of which is a
+/// highlight; event_idx 5678 last changed the counts. The counts are derived
+/// from the user's room: each push notification (ircd.push.note) increments
+/// them and each read receipt (ircd.read) recounts the notifications after
+/// the event it marks, so a reader needs only this single value.
+///
+const ircd::db::descriptor
+ircd::m::dbs::desc::user_unread
+{
+	// name
+	"_user_unread",
+
+	// explanation
+	R"(Unread notification counts of a local user in a room.
+
+	[user_id | room_id] => notification_count, highlight_count, event_idx
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	user_unread__pfx,
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	size_t(user_unread__bloom__bits),
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(user_unread__block__size),
+
+	// meta_block size
+	size_t(user_unread__meta_block__size),
+
+	// compression
+	string_view{user_unread__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+
+//
+// indexer
+//
+
+void
+ircd::m::dbs::_index_user_unread(db::txn &txn,
+                                 const event &event,
+                                 const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::USER_UNREAD));
+
+	if(opts.op != db::op::SET)
+		return;
+
+	const auto &type
+	{
+		at<"type"_>(event)
+	};
+
+	if(type == "ircd.read")
+		_index_user_unread_read(txn, event, opts);
+
+	else if(startswith(type, user::notifications::type_prefix))
+		_index_user_unread_note(txn, event, opts);
+}
+
+/// Counts a push notification. The notification is found in the user's room
+/// with the target room_id and the highlight tweak in its type.
+void
+ircd::m::dbs::_index_user_unread_note(db::txn &txn,
+                                      const event &event,
+                                      const write_opts &opts)
+{
+	const auto &type
+	{
+		at<"type"_>(event)
+	};
+
+	// Notifications without a room have nothing to count against.
+	if(!has(type, '!'))
+		return;
+
+	const json::string &target
+	{
+		json::get<"content"_>(event).get("user_id")
+	};
+
+	if(!valid(id::USER, target))
+		return;
+
+	const m::user::id &user_id
+	{
+		target
+	};
+
+	if(!my(user_id))
+		return;
+
+	// Ignore anybody that creates a notification in some other room.
+	if(!user::room::is(at<"room_id"_>(event), user_id))
+		return;
+
+	const auto note
+	{
+		user::notifications::unmake_type(type)
+	};
+
+	char keybuf[USER_UNREAD_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		user_unread_key(keybuf, user_id, note.room_id)
+	};
+
+	user_unread_tuple counts {0, 0, 0};
+	find_user_unread(counts, key, opts);
+
+	auto &[notification, highlight, event_idx] {counts};
+	notification += 1;
+	highlight += note.only == "highlight";
+	event_idx = opts.event_idx;
+
+	char valbuf[USER_UNREAD_VAL_SIZE];
+	db::txn::append
+	{
+		txn, user_unread,
+		{
+			db::op::SET,
+			key,
+			user_unread_val(valbuf, counts),
+		}
+	};
+}
+
+/// Resets the counts of the room marked by a read receipt. The receipt may
+/// mark an event older than the latest notifications, so those which came
+/// after it remain counted.
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_user_unread_read(db::txn &txn,
+                                      const event &event,
+                                      const write_opts &opts)
+{
+	// The state_key of an ircd.read event is the target room_id
+	if(!valid(id::ROOM, json::get<"state_key"_>(event)))
+		return;
+
+	const m::room::id &room_id
+	{
+		at<"state_key"_>(event)
+	};
+
+	const m::user::id &user_id
+	{
+		at<"sender"_>(event)
+	};
+
+	if(!my(user_id))
+		return;
+
+	// Ignore anybody that creates an ircd.read event in some other room.
+	if(!user::room::is(at<"room_id"_>(event), user_id))
+		return;
+
+	if(!opts.allow_queries)
+		return;
+
+	const json::string &event_id
+	{
+		json::get<"content"_>(event).get("event_id")
+	};
+
+	const auto read_idx
+	{
+		valid(id::EVENT, event_id)?
+			m::index(std::nothrow, m::event::id(event_id)):
+			0UL
+	};
+
+	const m::user::notifications notifications
+	{
+		user_id
+	};
+
+	const auto &[notification, highlight]
+	{
+		notifications.tally(room_id, read_idx)
+	};
+
+	const user_unread_tuple counts
+	{
+		notification, highlight, opts.event_idx
+	};
+
+	char keybuf[USER_UNREAD_KEY_MAX_SIZE];
+	char valbuf[USER_UNREAD_VAL_SIZE];
+	db::txn::append
+	{
+		txn, user_unread,
+		{
+			db::op::SET,
+			user_unread_key(keybuf, user_id, room_id),
+			user_unread_val(valbuf, counts),
+		}
+	};
+}
+
+// NOTE: QUERY
+bool
+ircd::m::dbs::find_user_unread(user_unread_tuple &counts,
+                               const string_view &key,
+                               const write_opts &opts)
+{
+	if(opts.interpose)
+	{
+		const string_view &val
+		{
+			opts.interpose->val(db::op::SET, "_user_unread", key)
+		};
+
+		if(size(val) >= USER_UNREAD_VAL_SIZE)
+		{
+			counts = user_unread_val(val);
+			return true;
+		}
+	}
+
+	if(!opts.allow_queries)
+		return false;
+
+	db::column &column(user_unread);
+	return column(key, std::nothrow, [&counts]
+	(const string_view &val)
+	{
+		counts = user_unread_val(val);
+	});
+}
+
+//
+// key
+//
+
+ircd::string_view
+ircd::m::dbs::user_unread_key(const string_view &amalgam)
+{
+	assert(size(amalgam) >= 1);
+	assert(amalgam.front() == '\0');
+	return amalgam.substr(1);
+}
+
+ircd::string_view
+ircd::m::dbs::user_unread_key(const mutable_buffer &out_,
+                              const id::user &user,
+                              const id::room &room_id)
+{
+	assert(user);
+	mutable_buffer out{out_};
+	consume(out, copy(out, user));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, room_id));
+	return { data(out_), data(out) };
+}
+
+//
+// val
+//
+
+ircd::m::dbs::user_unread_tuple
+ircd::m::dbs::user_unread_val(const string_view &val)
+{
+	assert(size(val) >= USER_UNREAD_VAL_SIZE);
+	return
+	{
+		byte_view<uint64_t>(val.substr(0, sizeof(uint64_t))),
+		byte_view<uint64_t>(val.substr(sizeof(uint64_t), sizeof(uint64_t))),
+		byte_view<uint64_t>(val.substr(sizeof(uint64_t) * 2, sizeof(uint64_t))),
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::user_unread_val(const mutable_buffer &out_,
+                              const user_unread_tuple &counts)
+{
+	assert(size(out_) >= USER_UNREAD_VAL_SIZE);
+	mutable_buffer out{out_};
+	consume(out, copy(out, byte_view<string_view>(std::get<0>(counts))));
+	consume(out, copy(out, byte_view<string_view>(std::get<1>(counts))));
+	consume(out, copy(out, byte_view<string_view>(std::get<2>(counts))));
+	return { data(out_), data(out) };
+}
@@ -138,12 +138,27 @@ ircd::m::vm::conform_report
 		if(eval.room_internal)
 			non_conform.set(event::conforms::MISMATCH_ORIGIN_SENDER);
 
+		// When the content hash was already computed by the batch verification
+		// the computation is skipped here and that result is applied instead.
+		const bool prehashed
+		{
+			bool(eval.preverified & vm::verified::HASH_CHECKED)
+		};
+
+		auto skip(non_conform);
+		if(prehashed)
+			skip.set(event::conforms::MISMATCH_HASHES);
+
 		// Generate the report here.
 		eval.report = event::conforms
 		{
-			event, non_conform.report
+			event, skip.report
 		};
 
+		if(prehashed && !(eval.preverified & vm::verified::HASH_VALID))
+			if(!non_conform.has(event::conforms::MISMATCH_HASHES))
+				eval.report.set(event::conforms::MISMATCH_HASHES);
+
 		// When opts.conforming is false a bad report is not an error.
 		if(!opts.conforming)
 			return;
@@ -268,14 +283,16 @@ ircd::m::event::conforms::reflect(const string_view &name)
 	return code(std::distance(begin(event_conforms_reflects), it));
 }
 
-ircd::m::event::conforms::conforms(const event &e,
-                                   const uint64_t &skip)
-:conforms{e}
+ircd::m::event::conforms::conforms(const event &e)
+:conforms{e, 0UL}
 {
-	report &= ~skip;
 }
 
-ircd::m::event::conforms::conforms(const event &e)
+/// Checks masked by skip are never reported. The content hash computation is
+/// also elided when MISMATCH_HASHES is masked; this allows the caller to apply
+/// its own result obtained elsewhere.
+ircd::m::event::conforms::conforms(const event &e,
+                                   const uint64_t &skip)
 try
 :report{0}
 {
@@ -293,7 +310,7 @@ try
 	if(empty(json::get<"hashes"_>(e)))
 		set(MISSING_HASHES);
 
-	if(!has(MISMATCH_HASHES) && !has(MISSING_HASHES))
+	if(!has(MISSING_HASHES) && !(skip & (1UL << MISMATCH_HASHES)))
 		if(!m::verify_hash(e))
 			set(MISMATCH_HASHES);
 
@@ -416,6 +433,8 @@ try
 				if(event_id == prev.prev_event(j))
 					set(DUP_PREV_EVENT);
 	}
+
+	report &= ~skip;
 }
 catch(const std::exception &_e)
 {
@@ -105,6 +105,144 @@ decltype(ircd::m::event::fetch::default_opts)
 ircd::m::event::fetch::default_opts
 {};
 
+/// Fetches the events for all of the indexes with parallel queries to the
+/// database. The closure is presented with each event found in the order of
+/// the indexes; indexes not found are skipped. The event is a zero-copy
+/// reference into the database which is only valid for the duration of the
+/// closure. Returns false if the closure broke the iteration.
+bool
+ircd::m::event::fetch::for_each(const vector_view<const idx> &event_idx,
+                                const closure &closure,
+                                const opts &opts)
+{
+	static const auto event_id_pos
+	{
+		json::indexof<m::event, "event_id"_>()
+	};
+
+	// The columns queried for each event. A JSON query also queries the
+	// event_id column because the event_id is absent from the JSON of
+	// events in newer room versions.
+	db::column column[event::size()];
+	size_t cols(0);
+	if(!should_seek_json(opts))
+		for(size_t i(0); i < opts.keys.size(); ++i)
+			if(opts.keys.test(i) && dbs::event_column.at(i))
+				column[cols++] = dbs::event_column.at(i);
+
+	const bool json_query
+	{
+		!cols
+	};
+
+	if(json_query)
+	{
+		column[cols++] = dbs::event_json;
+		column[cols++] = dbs::event_column.at(event_id_pos);
+	}
+
+	static const size_t query_max
+	{
+		64
+	};
+
+	const size_t batch_max
+	{
+		std::max(query_max / cols, 1UL)
+	};
+
+	bool ret(true);
+	for(size_t off(0); off < event_idx.size() && ret; off += batch_max)
+	{
+		const size_t num
+		{
+			std::min(event_idx.size() - off, batch_max)
+		};
+
+		string_view key[query_max];
+		db::column col[query_max];
+		for(size_t i(0); i < num; ++i)
+			for(size_t j(0); j < cols; ++j)
+			{
+				key[i * cols + j] = fetch::key(&event_idx[off + i]);
+				col[i * cols + j] = column[j];
+			}
+
+		const db::columns columns
+		{
+			col, num * cols
+		};
+
+		const db::keys keys
+		{
+			key, num * cols
+		};
+
+		db::read(columns, keys, [&](const vector_view<const string_view> &val)
+		{
+			for(size_t i(0); i < num && ret; ++i)
+			{
+				const auto *const v
+				{
+					val.data() + i * cols
+				};
+
+				m::event event;
+				if(json_query) try
+				{
+					if(!v[0])
+						continue;
+
+					event =
+					{
+						json::object{v[0]}, event::id{v[1]}, event::keys{opts.keys}
+					};
+				}
+				catch(const json::parse_error &e)
+				{
+					log::critical
+					{
+						m::log, "Fetching event:%lu JSON from local database :%s",
+						event_idx[off + i],
+						e.what(),
+					};
+
+					continue;
+				}
+				else
+				{
+					if(std::none_of(v, v + cols, [](const auto &val) { return bool(val); }))
+						continue;
+
+					for(size_t j(0); j < cols; ++j)
+					{
+						const bool is_string
+						{
+							describe(column[j]).type.second == typeid(string_view)
+						};
+
+						if(!v[j])
+							continue;
+						else if(is_string)
+							json::set(event, db::name(column[j]), v[j]);
+						else
+							json::set(event, db::name(column[j]), byte_view<string_view>{v[j]});
+					}
+
+					event.event_id = !empty(json::get<"event_id"_>(event))?
+						event::id{json::get<"event_id"_>(event)}:
+						event::id{};
+				}
+
+				ret = closure(event_idx[off + i], event);
+			}
+		},
+		opts.gopts);
+	}
+
+	return ret;
+}
+
 //
 // event::fetch::fetch
 //
@@ -274,16 +412,23 @@ try
 		_json.val()
 	};
 
+	// The source is only searched for an event_id when one is not already
+	// known; the member index parses it once for both the test and the value.
 	assert(!empty(source));
+	const json::object::index source_index
+	{
+		source
+	};
+
 	const bool source_event_id
 	{
-		!event_id_buf && source.has("event_id")
+		!event_id_buf && source_index.has("event_id")
 	};
 
 	const auto event_id
 	{
 		source_event_id?
-			id(json::string(source.at("event_id"))):
+			id(json::string(source_index.at("event_id"))):
 		event_id_buf?
 			id(event_id_buf):
 			m::event_id(std::nothrow, event_idx, event_id_buf)
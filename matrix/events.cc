@@ -11,6 +11,7 @@
 namespace ircd::m::events
 {
 	extern conf::item<size_t> dump_buffer_size;
+	extern conf::item<size_t> rebuild_txn_size;
 }
 
 decltype(ircd::m::events::dump_buffer_size)
@@ -20,12 +21,19 @@ ircd::m::events::dump_buffer_size
 	{ "default",  int64_t(512_KiB)                 },
 };
 
+decltype(ircd::m::events::rebuild_txn_size)
+ircd::m::events::rebuild_txn_size
+{
+	{ "name",     "ircd.m.events.rebuild.txn_size" },
+	{ "default",  int64_t(64_MiB)                  },
+};
+
 void
 ircd::m::events::rebuild()
 {
 	static const event::fetch::opts fopts
 	{
-		event::keys::include {"type", "sender"}
+		event::keys::include {"type", "sender", "room_id", "content", "redacts"}
 	};
 
 	static const m::events::range range
@@ -42,45 +50,55 @@ ircd::m::events::rebuild()
 	wopts.appendix.reset();
 	wopts.appendix.set(dbs::appendix::EVENT_TYPE);
 	wopts.appendix.set(dbs::appendix::EVENT_SENDER);
+	wopts.appendix.set(dbs::appendix::ROOM_TERMS);
 
-	size_t ret(0);
-	for_each(range, [&txn, &wopts, &ret]
+	size_t ret(0), commits(0);
+	for_each(range, [&txn, &wopts, &ret, &commits]
 	(const event::idx &event_idx, const m::event &event)
 	{
 		wopts.event_idx = event_idx;
 		dbs::write(txn, event, wopts);
 		++ret;
 
-		if(ret % 8192UL == 0UL)
-			log::info
-			{
-				log, "Events type/sender table rebuild events %zu of %zu num:%zu txn:%zu %s",
-				event_idx,
-				vm::sequence::retired,
-				ret,
-				txn.size(),
-				pretty(iec(txn.bytes())),
-			};
+		if(ret % 8192UL != 0UL)
+			return true;
+
+		log::info
+		{
+			log, "Events type/sender/terms table rebuild events %zu of %zu num:%zu txn:%zu %s",
+			event_idx,
+			vm::sequence::retired,
+			ret,
+			txn.size(),
+			pretty(iec(txn.bytes())),
+		};
+
+		// The terms index makes the transaction far too large to hold for
+		// the whole database; it is committed in segments instead.
+		if(txn.bytes() >= size_t(rebuild_txn_size))
+		{
+			txn();
+			txn.clear();
+			++commits;
+		}
 
 		return true;
 	});
 
 	log::info
 	{
-		log, "Events type/sender table rebuild events:%zu txn:%zu %s commit...",
+		log, "Events type/sender/terms table rebuild events:%zu txn:%zu %s commits:%zu commit...",
 		ret,
 		txn.size(),
 		pretty(iec(txn.bytes())),
+		commits,
 	};
 
 	txn();
 
 	log::notice
 	{
-		log, "Events type/sender table rebuild complete.",
-		ret,
-		txn.size(),
-		pretty(iec(txn.bytes())),
+		log, "Events type/sender/terms table rebuild complete.",
 	};
 }
 
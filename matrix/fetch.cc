@@ -10,6 +10,8 @@
 
 namespace ircd::m::fetch
 {
+	struct score;
+
 	static bool operator==(const opts &a, const opts &b) noexcept;
 	static bool operator==(const request &a, const opts &b) noexcept;
 	static bool operator==(const opts &a, const request &b) noexcept;
@@ -27,14 +29,28 @@ namespace ircd::m::fetch
 	extern conf::item<size_t> requests_max;
 	extern conf::item<seconds> timeout;
 	extern conf::item<bool> enable;
+	extern conf::item<size_t> scores_max;
+	extern conf::item<double> score_alpha;
+	extern conf::item<size_t> select_explore;
+	extern conf::item<bool> hedge_enable;
+	extern conf::item<milliseconds> hedge_delay;
+	extern std::map<std::string, score, std::less<>> scores;
 	extern log::log log;
 
+	static double cost(const score &, const string_view &room_id);
+	static void score_result(const request &, const bool &success);
 	static bool timedout(const request &, const system_point &now);
 	static void _check_event(const request &, const m::event &);
 	static void check_response(const request &, const json::object &);
 	static bool proffer_remote(request &, const string_view &);
 	static bool select_remote(request &, const string_view &);
 	static bool select_random_remote(request &);
+	static bool select_best_remote(request &);
+	static bool hedge_due(const request &, const system_point &now);
+	static void hedge_swap(request &);
+	static void hedge_cancel(request &);
+	static bool hedge_start(request &);
+	static bool hedge_handle(request &);
 	static void finish(request &);
 	static void retry(request &);
 	static bool start(request &, const string_view &remote);
@@ -42,12 +58,34 @@ namespace ircd::m::fetch
 	static void handle_result(request &);
 	static bool handle(request &);
 
-	static bool request_handle(const decltype(requests)::iterator &);
+	static bool request_handle(const decltype(requests)::iterator &, const bool &hedge);
 	static void request_handle();
 	static size_t request_cleanup();
 	static void request_worker();
 }
 
+/// Results of previous attempts to a remote. The averages are exponentially
+/// weighted so recent behavior dominates.
+struct ircd::m::fetch::score
+{
+	static constexpr size_t ROOMS_MAX {16};
+
+	/// Response time of successful attempts in milliseconds.
+	double latency {0.0};
+
+	/// Rate of unsatisfactory attempts (errors and timeouts) from 0 to 1.
+	double errors {0.0};
+
+	/// Number of results.
+	size_t samples {0};
+
+	/// Time of the last result.
+	system_point last;
+
+	/// Time of the last success by room; only the most recent are kept.
+	std::map<std::string, system_point, std::less<>> rooms;
+};
+
 decltype(ircd::m::fetch::log)
 ircd::m::fetch::log
 {
@@ -82,6 +120,53 @@ ircd::m::fetch::backfill_limit_default
 	{ "default",  96L                                   },
 };
 
+/// The number of remote servers whose responsiveness is remembered for
+/// ranking the servers in a room.
+decltype(ircd::m::fetch::scores_max)
+ircd::m::fetch::scores_max
+{
+	{ "name",     "ircd.m.fetch.scores.max" },
+	{ "default",  512L                      },
+};
+
+/// Weight of each new result in the moving averages of a server's response
+/// time and failure rate.
+decltype(ircd::m::fetch::score_alpha)
+ircd::m::fetch::score_alpha
+{
+	{ "name",     "ircd.m.fetch.score.alpha" },
+	{ "default",  0.25                       },
+};
+
+/// Percentage of selections made at random rather than by rank, so servers
+/// we have no results for yet are discovered.
+decltype(ircd::m::fetch::select_explore)
+ircd::m::fetch::select_explore
+{
+	{ "name",     "ircd.m.fetch.select.explore" },
+	{ "default",  10L                           },
+};
+
+decltype(ircd::m::fetch::hedge_enable)
+ircd::m::fetch::hedge_enable
+{
+	{ "name",     "ircd.m.fetch.hedge.enable" },
+	{ "default",  false                       },
+};
+
+/// Time an attempt may go without a response before the same request is
+/// also made to the next best server.
+decltype(ircd::m::fetch::hedge_delay)
+ircd::m::fetch::hedge_delay
+{
+	{ "name",     "ircd.m.fetch.hedge.delay" },
+	{ "default",  1500L                      },
+};
+
+/// Results of previous attempts by remote; see fetch::score.
+decltype(ircd::m::fetch::scores)
+ircd::m::fetch::scores;
+
 decltype(ircd::m::fetch::dock)
 ircd::m::fetch::dock;
 
@@ -273,22 +358,38 @@ ircd::m::fetch::request_handle()
 		fetch::dock
 	};
 
+	// Both the current attempt and any hedged attempt of each request are
+	// awaited together; the second member tells which one responded.
+	using future_ref = std::pair<decltype(requests)::iterator, server::request *>;
+	std::vector<future_ref> futures;
+	futures.reserve(requests.size() * 2);
+	for(auto it(begin(requests)); it != end(requests); ++it)
+	{
+		if(it->future)
+			futures.emplace_back(it, it->future.get());
+
+		if(it->hedge)
+			futures.emplace_back(it, it->hedge.get());
+	}
+
 	static const auto dereferencer{[]
 	(auto &it) -> server::request &
 	{
-		// If the request doesn't have a server::request future attached
-		// during this pass we reference this default constructed static
-		// instance which when_any() will treat as a no-op.
-		static server::request request_skip;
-		auto &request(mutable_cast(*it));
-		return request.future?
-			*request.future:
-			request_skip;
+		return *it->second;
 	}};
 
 	auto next
 	{
-		ctx::when_any(requests.begin(), requests.end(), dereferencer)
+		ctx::when_any(futures.begin(), futures.end(), dereferencer)
+	};
+
+	// When hedging the worker wakes at least as often as the hedge delay
+	// to start hedged attempts.
+	const milliseconds wait_max
+	{
+		hedge_enable?
+			std::min(milliseconds(seconds(timeout)), milliseconds(hedge_delay)):
+			milliseconds(seconds(timeout))
 	};
 
 	bool timedout{true};
@@ -298,7 +399,7 @@ ircd::m::fetch::request_handle()
 			lock
 		};
 
-		timedout = !next.wait(seconds(timeout), std::nothrow);
+		timedout = !next.wait(wait_max, std::nothrow);
 	};
 
 	if(likely(!timedout))
@@ -308,16 +409,24 @@ ircd::m::fetch::request_handle()
 			next.get()
 		};
 
-		if(it != end(requests))
-			if(!request_handle(it))
+		if(it != end(futures))
+		{
+			const bool hedge
+			{
+				it->second == it->first->hedge.get()
+			};
+
+			if(!request_handle(it->first, hedge))
 				return;
+		}
 	}
 
 	request_cleanup();
 }
 
 bool
-ircd::m::fetch::request_handle(const decltype(requests)::iterator &it)
+ircd::m::fetch::request_handle(const decltype(requests)::iterator &it,
+                               const bool &hedge)
 {
 	auto &request
 	{
@@ -325,7 +434,7 @@ ircd::m::fetch::request_handle(const decltype(requests)::iterator &it)
 	};
 
 	if(!request.finished)
-		if(!handle(request))
+		if(!(hedge? hedge_handle(request): handle(request)))
 			return false;
 
 	requests.erase(it);
@@ -352,7 +461,13 @@ try
 			start(request);
 
 		else if(!request.finished && timedout(request, now))
+		{
+			score_result(request, false);
 			retry(request);
+		}
+
+		else if(!request.finished && hedge_due(request, now))
+			hedge_start(request);
 	}
 
 	auto it(begin(requests)); while(it != end(requests))
@@ -401,10 +516,10 @@ try
 
 	if(!!request.started)
 		if(!request.opts.attempt_limit || request.attempted.size() < request.opts.attempt_limit)
-			select_random_remote(request);
+			select_best_remote(request);
 
 	if(!request.started && !request.origin)
-		select_random_remote(request);
+		select_best_remote(request);
 
 	if(!request.started)
 		request.started = ircd::now<system_point>();
@@ -418,7 +533,7 @@ try
 			if(request.attempted.size() >= request.opts.attempt_limit)
 				break;
 
-		select_random_remote(request);
+		select_best_remote(request);
 	}
 
 	throw m::NOT_FOUND
@@ -569,6 +684,67 @@ catch(const std::exception &e)
 	return false;
 }
 
+/// Selects the server in the room with the least expected cost based on the
+/// results of previous attempts. Some selections are made at random instead
+/// to explore the other servers, and random selection is the fallback when
+/// no server with results is viable.
+bool
+ircd::m::fetch::select_best_remote(request &request)
+{
+	// Limits the number of candidates tested for being in the room.
+	static const size_t candidates_max
+	{
+		64
+	};
+
+	const bool explore
+	{
+		rand::integer(0, 99) < size_t(select_explore)
+	};
+
+	if(explore || scores.empty())
+		return select_random_remote(request);
+
+	// Names are copied because the room query below may yield.
+	std::vector<std::pair<double, std::string>> ranked;
+	ranked.reserve(scores.size());
+	for(const auto &[remote, score] : scores)
+	{
+		// Servers failing more often than not are left to random selection.
+		if(score.errors >= 0.5)
+			continue;
+
+		if(proffer_remote(request, remote))
+			ranked.emplace_back(cost(score, request.opts.room_id), remote);
+	}
+
+	std::sort(begin(ranked), end(ranked), []
+	(const auto &a, const auto &b)
+	{
+		return a.first < b.first;
+	});
+
+	const m::room::origins origins
+	{
+		request.opts.room_id
+	};
+
+	size_t candidates(0);
+	for(const auto &[cost, remote] : ranked)
+	{
+		if(candidates++ >= candidates_max)
+			break;
+
+		if(!origins.has(remote))
+			continue;
+
+		if(select_remote(request, remote))
+			return true;
+	}
+
+	return select_random_remote(request);
+}
+
 bool
 ircd::m::fetch::select_random_remote(request &request)
 {
@@ -682,6 +858,7 @@ try
 	};
 
 	check_response(request, content);
+	score_result(request, true);
 
 	char pbuf[48];
 	log::debug
@@ -699,6 +876,7 @@ try
 catch(...)
 {
 	request.eptr = std::current_exception();
+	score_result(request, false);
 
 	log::derror
 	{
@@ -726,6 +904,15 @@ try
 
 	request.eptr = std::exception_ptr{};
 	request.origin = {};
+
+	// The hedged attempt still in flight becomes the current attempt.
+	if(request.hedge)
+	{
+		hedge_swap(request);
+		hedge_cancel(request);
+		return;
+	}
+
 	start(request);
 }
 catch(...)
@@ -734,10 +921,233 @@ catch(...)
 	finish(request);
 }
 
+//
+// score
+//
+
+/// The expected time to a result from the remote. A failure costs the full
+/// timeout before the next server is tried. Servers which recently answered
+/// for the same room are preferred.
+double
+ircd::m::fetch::cost(const score &score,
+                     const string_view &room_id)
+{
+	const double timeout_ms
+	(
+		milliseconds(seconds(timeout)).count()
+	);
+
+	const double expected
+	{
+		(1.0 - score.errors) * score.latency + score.errors * timeout_ms
+	};
+
+	const bool room_success
+	{
+		score.rooms.count(room_id) > 0
+	};
+
+	return room_success?
+		expected / 2.0:
+		expected;
+}
+
+void
+ircd::m::fetch::score_result(const request &request,
+                             const bool &success)
+{
+	if(!request.origin || !size_t(scores_max))
+		return;
+
+	const auto now
+	{
+		ircd::now<system_point>()
+	};
+
+	// Make room for a new remote by forgetting the one heard from least
+	// recently.
+	if(!scores.count(request.origin) && scores.size() >= size_t(scores_max))
+		scores.erase(std::min_element(begin(scores), end(scores), []
+		(const auto &a, const auto &b)
+		{
+			return a.second.last < b.second.last;
+		}));
+
+	auto it
+	{
+		scores.lower_bound(request.origin)
+	};
+
+	if(it == end(scores) || it->first != request.origin)
+		it = scores.emplace_hint(it, std::string{request.origin}, score{});
+
+	auto &score(it->second);
+	const double alpha
+	{
+		score.samples?
+			std::clamp(double(score_alpha), 0.0, 1.0):
+			1.0
+	};
+
+	const double elapsed
+	(
+		duration_cast<milliseconds>(now - request.last).count()
+	);
+
+	if(success)
+		score.latency = score.samples && score.latency?
+			alpha * elapsed + (1.0 - alpha) * score.latency:
+			elapsed;
+
+	score.errors = alpha * !success + (1.0 - alpha) * score.errors;
+	score.last = now;
+	++score.samples;
+
+	if(!success || !request.opts.room_id)
+		return;
+
+	if(!score.rooms.count(request.opts.room_id) && score.rooms.size() >= score.ROOMS_MAX)
+		score.rooms.erase(std::min_element(begin(score.rooms), end(score.rooms), []
+		(const auto &a, const auto &b)
+		{
+			return a.second < b.second;
+		}));
+
+	auto rit
+	{
+		score.rooms.lower_bound(request.opts.room_id)
+	};
+
+	if(rit == end(score.rooms) || rit->first != request.opts.room_id)
+		rit = score.rooms.emplace_hint(rit, std::string{request.opts.room_id}, now);
+
+	rit->second = now;
+}
+
+//
+// hedge
+//
+
+bool
+ircd::m::fetch::hedge_due(const request &request,
+                          const system_point &now)
+{
+	if(!hedge_enable)
+		return false;
+
+	if(!request.future || request.hedge)
+		return false;
+
+	if(request.opts.attempt_limit)
+		if(request.attempted.size() >= request.opts.attempt_limit)
+			return false;
+
+	return request.last + milliseconds(hedge_delay) < now;
+}
+
+/// Makes the same request to the next best server while the current
+/// attempt remains in flight.
+bool
+ircd::m::fetch::hedge_start(request &request)
+try
+{
+	assert(request.future && !request.hedge);
+
+	// The current attempt is set aside so start() operates on the hedge.
+	hedge_swap(request);
+	const unwind swap_back{[&request]
+	{
+		hedge_swap(request);
+		if(!request.hedge)
+			request.hedge_origin = {};
+	}};
+
+	if(!data(request.buf))
+		request.buf = unique_buffer<mutable_buffer>
+		{
+			size(request.hedge_buf)
+		};
+
+	if(!select_best_remote(request))
+		return false;
+
+	log::debug
+	{
+		log, "Hedging %s request for %s in %s to '%s' after %s",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		request.origin,
+		request.hedge_origin,
+	};
+
+	return start(request, request.origin);
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "Hedging %s request for %s in %s :%s",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		e.what(),
+	};
+
+	return false;
+}
+
+/// The hedged attempt responded first. If its response is satisfactory the
+/// request is finished with it; otherwise it is discarded and the current
+/// attempt continues. Returns true if finished.
+bool
+ircd::m::fetch::hedge_handle(request &request)
+{
+	assert(request.hedge);
+	hedge_swap(request);
+	handle_result(request);
+	if(!request.eptr)
+	{
+		finish(request);
+		return true;
+	}
+
+	request.eptr = std::exception_ptr{};
+	hedge_swap(request);
+	hedge_cancel(request);
+	return false;
+}
+
+void
+ircd::m::fetch::hedge_cancel(request &request)
+{
+	if(request.hedge)
+	{
+		server::cancel(*request.hedge);
+		request.hedge.reset(nullptr);
+	}
+
+	request.hedge_origin = {};
+}
+
+void
+ircd::m::fetch::hedge_swap(request &request)
+{
+	std::swap(request.future, request.hedge);
+	std::swap(request.buf, request.hedge_buf);
+	std::swap(request.origin, request.hedge_origin);
+	std::swap(request.last, request.hedge_last);
+}
+
 void
 ircd::m::fetch::finish(request &request)
 {
 	request.finished = ircd::now<system_point>();
+	hedge_cancel(request);
 
 	#if 0
 	log::logf
@@ -1130,5 +1540,6 @@ ircd::m::fetch::request::~request()
 noexcept
 {
 	//TODO: bad things unless this first here
+	hedge.reset(nullptr);
 	future.reset(nullptr);
 }
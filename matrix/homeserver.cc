@@ -282,6 +282,26 @@ try
 	if(opts->autoapps)
 		m::app::init();
 
+	m::replica::init();
+
+	// The co-membership index is generated when first added to a database.
+	db::column &user_mitsein(dbs::user_mitsein);
+	if(!ircd::write_avoid && !m::replica::is() && !bool(user_mitsein.begin()))
+		m::user::mitsein::rebuild();
+
+	// The unread notification counts are generated when first added to a database.
+	db::column &user_unread(dbs::user_unread);
+	if(!ircd::write_avoid && !m::replica::is() && !bool(user_unread.begin()))
+		m::user::notifications::rebuild();
+
+	// The auth chain cover is generated when first added to a database.
+	db::column &event_auth_chain(dbs::event_auth_chain);
+	if(!ircd::write_avoid && !m::replica::is() && !bool(event_auth_chain.begin()))
+		m::room::auth::chain::rebuild();
+
+	m::rooms::directory::init();
+	m::presence::init();
+
 	if(!ircd::maintenance)
 		signon(*this);
 
@@ -309,6 +329,8 @@ noexcept try
 	server::init::close();
 	client::close_all();
 	m::init::backfill::fini();
+	m::replica::fini();
+	m::rooms::directory::fini();
 	client::wait_all();
 	server::init::wait();
 	m::sync::pool.join();
@@ -316,6 +338,9 @@ noexcept try
 	if(!ircd::maintenance && _vm)
 		signoff(*this);
 
+	// After signoff so our own offline presence makes the last snapshot.
+	m::presence::fini();
+
 	///TODO: XXX primary
 	mods::imports.erase("net_dns_cache"s);
 	_fetch.reset(nullptr);
@@ -10,7 +10,18 @@
 
 namespace ircd::m
 {
+	static void presence_apply(const json::object &users, const event::idx &, const time_t &ts);
+	static size_t presence_load();
+	static void presence_worker();
+	static void handle_presence_snapshot(const event &, vm::eval &);
+
 	extern const string_view presence_valid_states[];
+	extern std::map<std::string, presence::state, std::less<>> presence_table;
+	extern std::set<std::string, std::less<>> presence_dirty;
+	extern ctx::dock presence_dock;
+	extern std::unique_ptr<context> presence_context;
+	extern hookfn<vm::eval &> presence_snapshot_hook;
+	extern hook::site<> presence_changed_hook;
 }
 
 decltype(ircd::m::presence_valid_states)
@@ -21,6 +32,327 @@ ircd::m::presence_valid_states
 	"unavailable",
 };
 
+decltype(ircd::m::presence::snapshot_interval)
+ircd::m::presence::snapshot_interval
+{
+	{ "name",     "ircd.m.presence.snapshot.interval" },
+	{ "default",  10L                                 },
+	{ "help",     "Seconds changes are collected for before they are persisted together." },
+};
+
+decltype(ircd::m::presence::snapshot_users)
+ircd::m::presence::snapshot_users
+{
+	{ "name",     "ircd.m.presence.snapshot.users" },
+	{ "default",  64L                              },
+	{ "help",     "Maximum users in one snapshot event." },
+};
+
+decltype(ircd::m::presence_table)
+ircd::m::presence_table;
+
+decltype(ircd::m::presence_dirty)
+ircd::m::presence_dirty;
+
+decltype(ircd::m::presence_dock)
+ircd::m::presence_dock;
+
+decltype(ircd::m::presence_context)
+ircd::m::presence_context;
+
+/// Called by set() with an m.presence of the user for each change; this is
+/// how /sync and the federation learn of changes without waiting for them
+/// to be persisted.
+decltype(ircd::m::presence_changed_hook)
+ircd::m::presence_changed_hook
+{
+	{ "name",        "presence.changed"  },
+	{ "exceptions",  false               },
+};
+
+/// Snapshots from the primary update the table of a replica; snapshots
+/// composed here are skipped since the table is already as new.
+decltype(ircd::m::presence_snapshot_hook)
+ircd::m::presence_snapshot_hook
+{
+	handle_presence_snapshot,
+	{
+		{ "_site",    "vm.notify"               },
+		{ "room_id",  "!presence"               },
+		{ "type",     "ircd.presence.snapshot"  },
+	}
+};
+
+void
+ircd::m::presence::init()
+{
+	if(!ircd::write_avoid && !exists(room_id()))
+		create(room_id(), me());
+
+	presence_context = std::make_unique<context>
+	(
+		"m.presence",
+		512_KiB,
+		&presence_worker,
+		context::POST
+	);
+}
+
+void
+ircd::m::presence::fini()
+noexcept
+{
+	if(presence_context)
+		presence_context->interrupt();
+
+	presence_context.reset();
+	if(!ircd::write_avoid && !presence_dirty.empty()) try
+	{
+		snapshot();
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			log, "Discarding %zu presence changes not yet in a snapshot :%s",
+			presence_dirty.size(),
+			e.what(),
+		};
+	}
+
+	presence_dirty.clear();
+	presence_table.clear();
+}
+
+void
+ircd::m::presence_worker()
+try
+{
+	const size_t loaded
+	{
+		presence_load()
+	};
+
+	log::info
+	{
+		log, "Loaded the presence of %zu users from snapshots.",
+		loaded,
+	};
+
+	// A replica's table follows the snapshots of the primary.
+	if(ircd::write_avoid)
+		return;
+
+	while(1) try
+	{
+		presence_dock.wait([]
+		{
+			return !presence_dirty.empty();
+		});
+
+		// Changes in the interval are coalesced into the snapshot.
+		ctx::sleep(seconds(presence::snapshot_interval));
+		presence::snapshot();
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		// The users of the failed snapshot are dirty again; they are retried
+		// after the next interval.
+		log::error
+		{
+			log, "Presence snapshot of %zu users :%s",
+			presence_dirty.size(),
+			e.what(),
+		};
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Presence snapshot worker :%s",
+		e.what(),
+	};
+}
+
+size_t
+ircd::m::presence_load()
+{
+	const m::room room
+	{
+		presence::room_id()
+	};
+
+	if(!exists(room))
+		return 0;
+
+	static const event::fetch::opts fopts
+	{
+		event::keys::include {"content", "origin_server_ts", "type"}
+	};
+
+	m::room::events it
+	{
+		room, &fopts
+	};
+
+	// From the latest snapshot; the first state seen for a user is theirs.
+	// The whole room is read since a user's last snapshot may be very old.
+	for(; it; --it)
+	{
+		const m::event &event(*it);
+		if(json::get<"type"_>(event) != "ircd.presence.snapshot")
+			continue;
+
+		const json::object &users
+		{
+			json::get<"content"_>(event).get("users")
+		};
+
+		presence_apply(users, it.event_idx(), json::get<"origin_server_ts"_>(event));
+	}
+
+	return presence_table.size();
+}
+
+void
+ircd::m::handle_presence_snapshot(const m::event &event,
+                                  vm::eval &eval)
+{
+	const json::object &users
+	{
+		json::get<"content"_>(event).get("users")
+	};
+
+	presence_apply(users, eval.sequence, json::get<"origin_server_ts"_>(event));
+}
+
+/// Sets the state of the users which is older than the snapshot.
+void
+ircd::m::presence_apply(const json::object &users,
+                        const event::idx &event_idx,
+                        const time_t &ts)
+{
+	for(const auto &[user_id, object] : users)
+	{
+		const json::object content
+		{
+			object
+		};
+
+		auto it
+		{
+			presence_table.lower_bound(user_id)
+		};
+
+		if(it == end(presence_table) || it->first != user_id)
+			it = presence_table.emplace_hint(it, std::string(user_id), presence::state{});
+
+		auto &state(it->second);
+		if(state.dirty || state.version >= event_idx)
+			continue;
+
+		state.presence = json::string(content.get("presence"));
+		state.status_msg = json::string(content.get("status_msg"));
+		state.last_active = ts - content.get<time_t>("last_active_ago", 0L);
+		state.currently_active = content.get<bool>("currently_active", false);
+		state.updated = ts;
+		state.version = event_idx;
+	}
+}
+
+size_t
+ircd::m::presence::snapshot()
+{
+	const m::room room
+	{
+		room_id()
+	};
+
+	const unique_mutable_buffer buf
+	{
+		48_KiB
+	};
+
+	size_t ret(0);
+	std::vector<std::string> batch;
+	while(!presence_dirty.empty())
+	{
+		batch.clear();
+		json::stack out{buf};
+		{
+			json::stack::object top{out};
+			json::stack::object users
+			{
+				top, "users"
+			};
+
+			while(!presence_dirty.empty() && batch.size() < size_t(snapshot_users) && out.remaining() > 2_KiB)
+			{
+				auto node
+				{
+					presence_dirty.extract(begin(presence_dirty))
+				};
+
+				const auto it
+				{
+					presence_table.find(node.value())
+				};
+
+				if(it == end(presence_table))
+					continue;
+
+				char tmp[1_KiB];
+				auto &state(it->second);
+				state.dirty = false;
+				json::stack::member
+				{
+					users, it->first, compose(tmp, it->first, state)
+				};
+
+				batch.emplace_back(std::move(node.value()));
+			}
+		}
+
+		if(batch.empty())
+			continue;
+
+		try
+		{
+			send(room, me(), "ircd.presence.snapshot", json::object
+			{
+				out.completed()
+			});
+		}
+		catch(...)
+		{
+			// Users changed again during the send are already dirty.
+			for(auto &user_id : batch)
+			{
+				const auto it(presence_table.find(user_id));
+				if(it != end(presence_table))
+					it->second.dirty = true;
+
+				presence_dirty.emplace(std::move(user_id));
+			}
+
+			throw;
+		}
+
+		ret += batch.size();
+	}
+
+	return ret;
+}
+
 ircd::m::presence::presence(const user &user,
                             const mutable_buffer &buf)
 :edu::m_presence{[&user, &buf]
@@ -40,7 +372,7 @@ ircd::m::presence::presence(const user &user,
 {
 }
 
-ircd::m::event::id::buf
+uint64_t
 ircd::m::presence::set(const user &user,
                        const string_view &presence,
                        const string_view &status_msg)
@@ -70,18 +402,103 @@ ircd::m::presence::get(std::nothrow_t,
                        const user &user,
                        const closure &closure)
 {
-	static const m::event::fetch::opts fopts
+	return get(std::nothrow, user, closure_state{[&user, &closure]
+	(const state &state)
 	{
-		m::event::keys::include {"content"}
+		char buf[1_KiB];
+		closure(compose(buf, user.user_id, state));
+	}});
+}
+
+bool
+ircd::m::presence::get(std::nothrow_t,
+                       const user &user,
+                       const closure_state &closure)
+{
+	auto it
+	{
+		presence_table.find(user.user_id)
 	};
 
-	const auto reclosure{[&closure]
-	(const m::event &event)
+	// Users not in a snapshot have their presence read from their room once.
+	if(it == end(presence_table))
 	{
-		closure(json::get<"content"_>(event));
-	}};
+		const event::idx event_idx
+		{
+			get(std::nothrow, user)
+		};
 
-	return get(std::nothrow, user, reclosure, &fopts);
+		presence::state state;
+		state.version = event_idx;
+		state.updated = m::get(std::nothrow, event_idx, "origin_server_ts", 0L);
+		m::get(std::nothrow, event_idx, "content", [&state]
+		(const json::object &content)
+		{
+			state.presence = json::string(content.get("presence"));
+			state.status_msg = trunc(json::string(content.get("status_msg")), 390);
+			state.last_active = state.updated - content.get<time_t>("last_active_ago", 0L);
+			state.currently_active = content.get<bool>("currently_active", false);
+		});
+
+		// Another context may have set the user during the queries.
+		it = presence_table.emplace(std::string(user.user_id), std::move(state)).first;
+	}
+
+	if(it->second.presence.empty())
+		return false;
+
+	// The closure may yield while the table changes.
+	const presence::state state
+	{
+		it->second
+	};
+
+	closure(state);
+	return true;
+}
+
+ircd::json::object
+ircd::m::presence::compose(const mutable_buffer &buf,
+                           const user::id &user_id,
+                           const state &state)
+{
+	json::stack out{buf};
+	{
+		json::stack::object top{out};
+		json::stack::member
+		{
+			top, "user_id", user_id
+		};
+
+		json::stack::member
+		{
+			top, "presence", string_view{state.presence}
+		};
+
+		if(!state.status_msg.empty())
+			json::stack::member
+			{
+				top, "status_msg", string_view{state.status_msg}
+			};
+
+		json::stack::member
+		{
+			top, "last_active_ago", json::value
+			{
+				std::max(ircd::time<milliseconds>() - state.last_active, 0L)
+			}
+		};
+
+		json::stack::member
+		{
+			top, "currently_active", json::value
+			{
+				state.currently_active
+			}
+		};
+	}
+
+	return out.completed();
 }
 
 ircd::m::event::idx
@@ -164,30 +581,64 @@ ircd::m::presence::prefetch(const m::user &user)
 	return state.prefetch("ircd.presence", "");
 }
 
-ircd::m::event::id::buf
+/// Sets the presence in the table; it is persisted with the next snapshot.
+/// Returns the sequence number the change is synchronized at.
+uint64_t
 ircd::m::presence::set(const m::presence &content)
 {
-	const m::user user
+	const m::user::id &user_id
 	{
 		json::at<"user_id"_>(content)
 	};
 
-	//TODO: ABA
-	if(!exists(user))
-		create(user.user_id);
+	const auto now
+	{
+		ircd::time<milliseconds>()
+	};
 
-	m::vm::copts copts;
-	const m::user::room user_room
+	auto it
 	{
-		user, &copts
+		presence_table.lower_bound(user_id)
 	};
 
-	const json::strung _content
+	if(it == end(presence_table) || it->first != user_id)
+		it = presence_table.emplace_hint(it, std::string(user_id), state{});
+
+	auto &state(it->second);
+	state.presence = json::get<"presence"_>(content);
+	state.status_msg = trunc(json::get<"status_msg"_>(content), 390);
+	state.last_active = now - json::get<"last_active_ago"_>(content);
+	state.currently_active = json::get<"currently_active"_>(content);
+	state.updated = now;
+	state.version = vm::sequence::retired + 1;
+	state.dirty = true;
+
+	presence_dirty.emplace(user_id);
+	presence_dock.notify_all();
+
+	const auto version
 	{
-		content
+		state.version
 	};
 
-	return send(user_room, user.user_id, "ircd.presence", "", json::object(_content));
+	// Clients and the federation are told now; the change is persisted with
+	// the next snapshot. The state is composed before any hook can yield.
+	char buf[1_KiB];
+	m::event event;
+	json::get<"type"_>(event) = "m.presence";
+	json::get<"sender"_>(event) = user_id;
+	json::get<"content"_>(event) = compose(buf, user_id, state);
+	presence_changed_hook(event);
+	return version;
+}
+
+ircd::m::room::id::buf
+ircd::m::presence::room_id()
+{
+	return
+	{
+		"presence", my_host()
+	};
 }
 
 bool
@@ -78,6 +78,7 @@ namespace ircd::m::push
 	static bool contains_user_mxid(const event &, const cond &, const match::opts &);
 	static bool room_member_count(const event &, const cond &, const match::opts &);
 	static bool event_match(const event &, const cond &, const match::opts &);
+	static string_view content(const event &, const match::opts &, const string_view &key);
 }
 
 decltype(ircd::m::push::match::cond_kind)
@@ -164,6 +165,22 @@ ircd::m::push::match::match(const event &event,
 // push::match condition functors (internal)
 //
 
+ircd::string_view
+ircd::m::push::content(const event &event,
+                       const match::opts &opts,
+                       const string_view &key)
+{
+	if(opts.content)
+		return (*opts.content)[key];
+
+	const json::object &content
+	{
+		json::get<"content"_>(event)
+	};
+
+	return content[key];
+}
+
 bool
 ircd::m::push::event_match(const event &event,
                            const cond &cond,
@@ -177,18 +194,30 @@ try
 		split(json::get<"key"_>(cond), '.')
 	};
 
+	// The first key of a path into the content is resolved through the
+	// member index when the caller supplied one.
+	const bool indexed
+	{
+		opts.content && top == "content"
+	};
+
 	string_view value
 	{
-		json::get(event, top, json::object{})
+		indexed?
+			string_view{json::object(*opts.content)}:
+			string_view{json::get(event, top, json::object{})}
 	};
 
-	tokens(path, ".", [&value]
+	size_t i(0);
+	tokens(path, ".", [&event, &opts, &value, &indexed, &i]
 	(const string_view &key)
 	{
 		if(!json::type(value, json::OBJECT))
 			return false;
 
-		value = json::object(value)[key];
+		value = indexed && i++ == 0?
+			content(event, opts, key):
+			json::object(value)[key];
 		if(likely(!json::type(value, json::STRING)))
 			return true;
 
@@ -232,14 +261,9 @@ try
 	if(unlikely(!opts.user_id))
 		return false;
 
-	const json::object &content
-	{
-		json::get<"content"_>(event)
-	};
-
 	const json::string &body
 	{
-		content["body"]
+		content(event, opts, "body")
 	};
 
 	if(has(body, opts.user_id))
@@ -247,7 +271,7 @@ try
 
 	const json::string &formatted_body
 	{
-		content["formatted_body"]
+		content(event, opts, "formatted_body")
 	};
 
 	if(has(formatted_body, opts.user_id))
@@ -311,14 +335,9 @@ try
 {
 	assert(json::get<"kind"_>(cond) == "contains_display_name");
 
-	const json::object &content
-	{
-		json::get<"content"_>(event)
-	};
-
 	const json::string &body
 	{
-		content["body"]
+		content(event, opts, "body")
 	};
 
 	if(!body)
@@ -0,0 +1,688 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::vm
+{
+	extern hook::site<eval &> notify_hook;
+	extern hook::site<eval &> effect_hook;
+}
+
+namespace ircd::m::replica
+{
+	using subscribers_map = std::map<net::ipport, system_point, net::ipport::cmp>;
+
+	static bool replay(const event::idx &);
+	static void publish(const uint64_t &);
+	static void subscribe();
+	static void handle_subscribe();
+	static void handle_notify();
+	static void primary_worker();
+	static void replica_worker();
+
+	extern std::unique_ptr<net::listener_udp> listener;
+	extern std::unique_ptr<context> receiver_context;
+	extern std::unique_ptr<context> worker_context;
+	extern subscribers_map subscribers;
+	extern uint64_t notified;
+	extern ctx::dock dock;
+}
+
+decltype(ircd::m::replica::log)
+ircd::m::replica::log
+{
+	"m.replica"
+};
+
+/// Conf item to enable replication. On the primary this opens the socket
+/// for the replicas to subscribe to; a process opening the databases as
+/// slaves (ircd.db.open.slave) with this enabled becomes a replica.
+decltype(ircd::m::replica::enable)
+ircd::m::replica::enable
+{
+	{ "name",     "ircd.m.replica.enable" },
+	{ "default",  false                   },
+	{ "persist",  false                   },
+};
+
+/// The address of the primary's notification socket. Replicas bind to an
+/// ephemeral port on this address.
+decltype(ircd::m::replica::host)
+ircd::m::replica::host
+{
+	{ "name",     "ircd.m.replica.host" },
+	{ "default",  "127.0.0.1"           },
+	{ "persist",  false                 },
+};
+
+decltype(ircd::m::replica::port)
+ircd::m::replica::port
+{
+	{ "name",     "ircd.m.replica.port" },
+	{ "default",  8449L                 },
+	{ "persist",  false                 },
+};
+
+/// The host:port of the primary's client listener. Requests which can't be
+/// served by a replica are forwarded there; when empty they are refused.
+decltype(ircd::m::replica::primary)
+ircd::m::replica::primary
+{
+	{ "name",     "ircd.m.replica.primary" },
+	{ "default",  string_view{}            },
+	{ "persist",  false                    },
+};
+
+/// A replica catches up with the primary at least this often. It also
+/// renews its subscription at this interval; the primary forgets replicas
+/// which haven't renewed for four intervals.
+decltype(ircd::m::replica::interval)
+ircd::m::replica::interval
+{
+	{ "name",     "ircd.m.replica.interval" },
+	{ "default",  1000L                     },
+};
+
+decltype(ircd::m::replica::proxy_timeout)
+ircd::m::replica::proxy_timeout
+{
+	{ "name",     "ircd.m.replica.proxy.timeout" },
+	{ "default",  30L                            },
+};
+
+decltype(ircd::m::replica::listener)
+ircd::m::replica::listener;
+
+decltype(ircd::m::replica::receiver_context)
+ircd::m::replica::receiver_context;
+
+decltype(ircd::m::replica::worker_context)
+ircd::m::replica::worker_context;
+
+decltype(ircd::m::replica::subscribers)
+ircd::m::replica::subscribers;
+
+decltype(ircd::m::replica::notified)
+ircd::m::replica::notified;
+
+decltype(ircd::m::replica::dock)
+ircd::m::replica::dock;
+
+//
+// init
+//
+
+void
+ircd::m::replica::init()
+{
+	if(!enable)
+		return;
+
+	if(!is() && ircd::read_only)
+		return;
+
+	// The primary listens on the configured port; replicas take any port
+	// and make themselves known to the primary from it.
+	const json::strung opts
+	{
+		json::members
+		{
+			{ "host",  string_view{host}        },
+			{ "port",  is()? 0L: long(port)     },
+		}
+	};
+
+	listener = std::make_unique<net::listener_udp>("m.replica", opts);
+	receiver_context = std::make_unique<context>
+	(
+		"m.replica.recv",
+		256_KiB,
+		is()? &handle_notify: &handle_subscribe,
+		context::POST
+	);
+
+	worker_context = std::make_unique<context>
+	(
+		"m.replica",
+		512_KiB,
+		is()? &replica_worker: &primary_worker,
+		context::POST
+	);
+
+	log::notice
+	{
+		log, "%s of %s:%zu; %s",
+		is()? "Replica"_sv: "Primary"_sv,
+		string_view{host},
+		size_t(port),
+		is() && primary?
+			string_view{primary}:
+		is()?
+			"no primary configured for writes"_sv:
+			"accepting replicas"_sv,
+	};
+}
+
+void
+ircd::m::replica::fini()
+noexcept
+{
+	if(receiver_context)
+		receiver_context->interrupt();
+
+	if(worker_context)
+		worker_context->interrupt();
+
+	dock.notify_all();
+	receiver_context.reset();
+	worker_context.reset();
+	listener.reset();
+	subscribers.clear();
+}
+
+//
+// replica
+//
+
+bool
+ircd::m::replica::is()
+noexcept
+{
+	return enable && db::open_slave;
+}
+
+bool
+ircd::m::replica::local(const resource::method &method)
+noexcept
+{
+	assert(method.opts);
+	return method.opts->flags & method.READ_ONLY;
+}
+
+/// The request is replayed to the primary with its credentials and the
+/// primary's response is relayed to the client as is, with its end-to-end
+/// headers. Content which has
+/// not been received in full (discretionary methods) can't be forwarded.
+ircd::resource::response
+ircd::m::replica::proxy(client &client,
+                        const ircd::resource::request &request)
+{
+	const auto &head
+	{
+		request.head
+	};
+
+	if(!primary)
+		throw m::error
+		{
+			http::SERVICE_UNAVAILABLE, "M_READ_ONLY",
+			"This server is a read-only replica.",
+		};
+
+	if(unlikely(size(request.content) < head.content_length))
+		throw m::error
+		{
+			http::SERVICE_UNAVAILABLE, "M_READ_ONLY",
+			"This request must be made to the primary server.",
+		};
+
+	const net::hostport target
+	{
+		string_view{primary}
+	};
+
+	char ipbuf[64];
+	const string_view forwarded_for
+	{
+		head.forwarded_for?:
+			net::string(ipbuf, net::ipaddr(remote(client)))
+	};
+
+	size_t headers_num(0);
+	http::header headers[2];
+	headers[headers_num++] = { "X-Forwarded-For", forwarded_for };
+	if(head.authorization)
+		headers[headers_num++] = { "Authorization", head.authorization };
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		16_KiB
+	};
+
+	window_buffer wb{buf};
+	http::request
+	{
+		wb,
+		net::host(target),
+		head.method,
+		head.uri,
+		size(request.content),
+		head.content_type,
+		vector_view<const http::header>{headers, headers_num},
+	};
+
+	server::out out;
+	out.head = wb.completed();
+	out.content = request.content;
+
+	server::in in;
+	in.head = wb.remains();
+	in.content = {};
+
+	static server::request::opts sopts;
+	sopts.http_exceptions = false;
+
+	server::request req
+	{
+		target, std::move(out), std::move(in), &sopts
+	};
+
+	if(!req.wait(seconds(proxy_timeout), std::nothrow))
+	{
+		server::cancel(req);
+		throw m::error
+		{
+			http::GATEWAY_TIMEOUT, "M_REQUEST_TIMEOUT",
+			"The primary server did not respond in time.",
+		};
+	}
+
+	const http::code &code
+	{
+		req.get()
+	};
+
+	parse::buffer pb{req.in.head};
+	parse::capstan pc{pb};
+	pc.read += size(req.in.head);
+	const http::response::head response_head
+	{
+		pc
+	};
+
+	log::debug
+	{
+		log, "%s %s `%s' proxied to %s :%u",
+		client.loghead(),
+		head.method,
+		head.path,
+		string_view{primary},
+		uint(code),
+	};
+
+	// The primary's headers are relayed except those of the connection to
+	// the primary and those which the response composes itself.
+	static const string_view excluded[]
+	{
+		"Connection", "Keep-Alive", "Proxy-Authenticate", "Proxy-Authorization",
+		"TE", "Trailer", "Transfer-Encoding", "Upgrade",
+		"Content-Type", "Content-Length", "Server", "Date",
+		"X-IRCd-Request-Timer", "Access-Control-Allow-Origin",
+	};
+
+	size_t relay_num(0);
+	http::header relay[32];
+	http::headers{response_head.headers}.for_each([&relay, &relay_num]
+	(const http::header &header)
+	{
+		const bool skip
+		{
+			std::any_of(std::begin(excluded), std::end(excluded), [&header]
+			(const string_view &key)
+			{
+				return iequals(header.first, key);
+			})
+		};
+
+		if(!skip)
+			relay[relay_num++] = header;
+
+		return relay_num < std::size(relay);
+	});
+
+	return resource::response
+	{
+		client,
+		string_view{req.in.content},
+		response_head.content_type?: "application/json; charset=utf-8"_sv,
+		code,
+		vector_view<const http::header>{relay, relay_num},
+	};
+}
+
+/// Brings the slave databases up to date with the primary, then notifies
+/// each new event in order as if it had been evaluated here. The retired
+/// sequence is advanced ahead of each notification like on the primary.
+size_t
+ircd::m::replica::catchup()
+{
+	for(auto *const &database : db::database::list)
+		if(database->slave)
+			db::refresh(*database);
+
+	event::id::buf event_id;
+	const uint64_t head
+	{
+		vm::sequence::get(event_id)
+	};
+
+	size_t ret(0);
+	while(vm::sequence::retired < head)
+	{
+		const event::idx event_idx
+		{
+			vm::sequence::retired + 1
+		};
+
+		vm::sequence::uncommitted = event_idx;
+		vm::sequence::committed = event_idx;
+		vm::sequence::retired = event_idx;
+		vm::sequence::dock.notify_all();
+		ret += replay(event_idx);
+	}
+
+	if(ret)
+		log::debug
+		{
+			log, "Caught up to %lu notifying %zu events",
+			head,
+			ret,
+		};
+
+	return ret;
+}
+
+bool
+ircd::m::replica::replay(const event::idx &event_idx)
+{
+	static const vm::opts opts{[]
+	{
+		vm::opts ret;
+		ret.notify_servers = false;
+		ret.phase.reset(vm::phase::EFFECTS);
+		return ret;
+	}()};
+
+	const event::fetch event
+	{
+		std::nothrow, event_idx
+	};
+
+	// Sequence numbers are skipped by evaluations which failed.
+	if(!event.valid)
+		return false;
+
+	const auto &room_id
+	{
+		json::get<"room_id"_>(event)
+	};
+
+	vm::eval eval
+	{
+		opts
+	};
+
+	eval.sequence = event_idx;
+	eval.event_ = &event;
+	eval.event_id = event.event_id;
+	eval.phase = vm::phase::NOTIFY;
+	eval.room_internal = room_id && my(room::id(room_id))?
+		m::internal(room_id):
+		false;
+
+	// Only the notification is replayed here; the EFFECTS phase is masked
+	// from the opts because the primary already carried out the effects.
+	if(likely(opts.phase[vm::phase::NOTIFY]))
+		vm::notify_hook(event, eval);
+
+	if(opts.phase[vm::phase::EFFECTS])
+		vm::effect_hook(event, eval);
+
+	return true;
+}
+
+//
+// replica side
+//
+
+void
+ircd::m::replica::replica_worker()
+try
+{
+	run::barrier<ctx::interrupted>{};
+	for(;;) try
+	{
+		subscribe();
+		dock.wait_for(milliseconds(interval), []
+		{
+			return notified > vm::sequence::retired;
+		});
+
+		catchup();
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			log, "Catching up with the primary :%s",
+			e.what(),
+		};
+
+		ctx::sleep(milliseconds(interval));
+	}
+}
+catch(const ctx::interrupted &)
+{
+	log::debug
+	{
+		log, "Replica worker interrupted; retired:%lu",
+		vm::sequence::retired,
+	};
+}
+
+/// The subscription carries the replica's retired sequence for the
+/// primary's information; any datagram from the replica renews it.
+void
+ircd::m::replica::subscribe()
+{
+	assert(listener);
+	const net::ipport remote
+	{
+		string_view{host}, uint16_t(port)
+	};
+
+	const auto &retired
+	{
+		vm::sequence::retired
+	};
+
+	net::listener_udp::datagram datagram
+	{
+		byte_view<string_view>(retired), remote
+	};
+
+	(*listener)(datagram);
+}
+
+void
+ircd::m::replica::handle_notify()
+try
+{
+	char buf[16];
+	for(;;)
+	{
+		net::listener_udp::datagram datagram
+		{
+			mutable_buffer{buf}
+		};
+
+		(*listener)(datagram);
+		if(unlikely(size(datagram.mbuf) != sizeof(uint64_t)))
+			continue;
+
+		const uint64_t sequence
+		{
+			byte_view<uint64_t>(string_view(datagram.mbuf))
+		};
+
+		if(sequence <= notified)
+			continue;
+
+		notified = sequence;
+		dock.notify_all();
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Notification receiver :%s",
+		e.what(),
+	};
+}
+
+//
+// primary side
+//
+
+/// Each change of the retired sequence is announced to the replicas; any
+/// changes made while announcing are coalesced into the next one.
+void
+ircd::m::replica::primary_worker()
+try
+{
+	uint64_t sent
+	{
+		vm::sequence::retired
+	};
+
+	for(;;)
+	{
+		vm::sequence::dock.wait([&sent]
+		{
+			return vm::sequence::retired != sent;
+		});
+
+		sent = vm::sequence::retired;
+		publish(sent);
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+
+void
+ircd::m::replica::publish(const uint64_t &sequence)
+{
+	assert(listener);
+	const auto expires
+	{
+		now<system_point>() - milliseconds(interval) * 4
+	};
+
+	for(auto it(begin(subscribers)); it != end(subscribers); )
+	{
+		const auto &[remote, last] {*it};
+		if(last < expires)
+		{
+			char buf[64];
+			log::dwarning
+			{
+				log, "Replica %s expired",
+				net::string(buf, remote),
+			};
+
+			it = subscribers.erase(it);
+			continue;
+		}
+
+		net::listener_udp::datagram datagram
+		{
+			byte_view<string_view>(sequence), remote
+		};
+
+		try
+		{
+			(*listener)(datagram);
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			char buf[64];
+			log::derror
+			{
+				log, "Replica %s notify :%s",
+				net::string(buf, remote),
+				e.what(),
+			};
+		}
+
+		++it;
+	}
+}
+
+void
+ircd::m::replica::handle_subscribe()
+try
+{
+	char buf[16];
+	for(;;)
+	{
+		net::listener_udp::datagram datagram
+		{
+			mutable_buffer{buf}
+		};
+
+		// Only processes on this machine may subscribe.
+		(*listener)(datagram);
+		if(unlikely(!is_loop(datagram.remote)))
+			continue;
+
+		const auto it
+		{
+			subscribers.find(datagram.remote)
+		};
+
+		if(it == end(subscribers))
+		{
+			char buf[64];
+			log::info
+			{
+				log, "Replica %s subscribed",
+				net::string(buf, datagram.remote),
+			};
+		}
+
+		subscribers[datagram.remote] = now<system_point>();
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Subscription receiver :%s",
+		e.what(),
+	};
+}
@@ -71,6 +71,11 @@ ircd::m::resource::method::handle(client &client,
                                   ircd::resource::request &request_)
 try
 {
+	// A replica serves only the methods marked for it; everything else is
+	// forwarded to the primary before any local processing.
+	if(replica::is() && !replica::local(*this))
+		return replica::proxy(client, request_);
+
 	m::resource::request request
 	{
 		*this, client, request_
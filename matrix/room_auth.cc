@@ -16,6 +16,9 @@ namespace ircd::m
 	static void check_room_auth_rule_3(const m::event &, room::auth::hookdata &);
 	static void check_room_auth_rule_2(const m::event &, room::auth::hookdata &);
 
+	static void room_auth_chain_close(room::auth::chain::reach &, const event::closure_idx &);
+	static void room_auth_chain_range(const uint64_t &, const uint64_t &, const uint64_t &, const event::closure_idx &);
+
 	extern hook::site<room::auth::hookdata &> room_auth_hook;
 }
 
@@ -843,9 +846,332 @@ const
 	return ret;
 }
 
+size_t
+ircd::m::room::auth::chain::rebuild()
+{
+	static const event::fetch::opts fopts
+	{
+		event::keys::include {"type", "state_key", "auth_events"}
+	};
+
+	static const m::events::range range
+	{
+		0, -1UL, &fopts
+	};
+
+	db::txn txn
+	{
+		*m::dbs::events
+	};
+
+	dbs::write_opts wopts;
+	wopts.appendix.reset();
+	wopts.appendix.set(dbs::appendix::EVENT_AUTH_CHAIN);
+	wopts.interpose = &txn;
+
+	// Events whose auth events have greater indexes are only placed by a
+	// later pass; passes continue until nothing more can be placed. Events
+	// left after that have auth events missing from the cover.
+	size_t ret(0), added(0), left(0), pass(0); do
+	{
+		added = 0;
+		left = 0;
+		m::events::for_each(range, [&txn, &wopts, &added, &left]
+		(const event::idx &event_idx, const m::event &event)
+		{
+			if(!defined(json::get<"state_key"_>(event)))
+				return true;
+
+			dbs::event_auth_chain_pos pos;
+			if(dbs::find_event_auth_chain(pos, event_idx, wopts))
+				return true;
+
+			const size_t before(txn.size());
+			wopts.event_idx = event_idx;
+			dbs::write(txn, event, wopts);
+			added += txn.size() > before;
+			left += txn.size() == before;
+
+			if(txn.bytes() < size_t(64_MiB))
+				return true;
+
+			txn();
+			txn.clear();
+			return true;
+		});
+
+		txn();
+		txn.clear();
+		ret += added;
+
+		log::info
+		{
+			log, "Auth chain cover rebuild pass:%zu added:%zu total:%zu left:%zu",
+			pass++,
+			added,
+			ret,
+			left,
+		};
+	}
+	while(added);
+
+	if(left)
+		log::warning
+		{
+			log, "Auth chain cover rebuild left %zu state events unplaced after %zu passes.",
+			left,
+			pass,
+		};
+
+	return ret;
+}
+
+bool
+ircd::m::room::auth::chain::for_each_difference(const vector_view<const event::idx> &idxs,
+                                                const closure &closure)
+{
+	std::vector<reach> reaches(idxs.size());
+	for(size_t i(0); i < idxs.size(); ++i)
+	{
+		if(chain(idxs[i]).cover(reaches[i]))
+		{
+			room_auth_chain_close(reaches[i], {});
+			continue;
+		}
+
+		// Any chain outside of the cover; all of them are walked instead.
+		std::vector<std::set<event::idx>> sets(idxs.size());
+		for(size_t j(0); j < idxs.size(); ++j)
+			chain(idxs[j]).for_each_walk([&sets, &j]
+			(const event::idx &event_idx)
+			{
+				sets[j].emplace(event_idx);
+				return true;
+			});
+
+		std::map<event::idx, size_t> count;
+		for(const auto &set : sets)
+			for(const auto &event_idx : set)
+				++count[event_idx];
+
+		for(const auto &[event_idx, num] : count)
+			if(num < sets.size())
+				if(!closure(event_idx))
+					return false;
+
+		return true;
+	}
+
+	// Within each chain the auth chains differ by the range between the
+	// lowest and the highest seq reached.
+	std::vector<event::idx> ret;
+	std::set<uint64_t> chains;
+	for(const auto &reach : reaches)
+		for(const auto &[chain_id, seq] : reach)
+			chains.emplace(chain_id);
+
+	for(const auto &chain_id : chains)
+	{
+		uint64_t lo(-1UL), hi(0);
+		for(const auto &reach : reaches)
+		{
+			const auto it(reach.find(chain_id));
+			const uint64_t seq(it != end(reach)? it->second : 0UL);
+			lo = std::min(lo, seq);
+			hi = std::max(hi, seq);
+		}
+
+		room_auth_chain_range(chain_id, lo, hi, [&ret]
+		(const event::idx &event_idx)
+		{
+			ret.emplace_back(event_idx);
+		});
+	}
+
+	std::sort(begin(ret), end(ret));
+	for(const auto &event_idx : ret)
+		if(!closure(event_idx))
+			return false;
+
+	return true;
+}
+
 bool
 ircd::m::room::auth::chain::for_each(const closure &closure)
 const
+{
+	reach reach;
+	if(!cover(reach))
+		return for_each_walk(closure);
+
+	std::vector<event::idx> ret;
+	room_auth_chain_close(reach, [&ret]
+	(const event::idx &event_idx)
+	{
+		ret.emplace_back(event_idx);
+	});
+
+	std::sort(begin(ret), end(ret));
+	for(const auto &event_idx : ret)
+		if(!closure(event_idx))
+			return false;
+
+	return true;
+}
+
+/// Find the positions in the chain cover of the auth events of this event.
+/// False when any of them isn't in the cover.
+bool
+ircd::m::room::auth::chain::cover(reach &reach)
+const
+{
+	static const dbs::write_opts wopts;
+	const auto add{[&reach](const dbs::event_auth_chain_pos &pos)
+	{
+		auto &seq(reach[pos.first]);
+		seq = std::max(seq, pos.second);
+	}};
+
+	// The event is in the cover; its own value has the links.
+	dbs::event_auth_chain_pos pos;
+	if(dbs::find_event_auth_chain(pos, idx, wopts))
+	{
+		if(pos.second > 1)
+			add({pos.first, pos.second - 1});
+
+		char buf[dbs::EVENT_AUTH_COVER_KEY_SIZE];
+		return dbs::event_auth_cover(dbs::event_auth_cover_key(buf, pos.first, pos.second), std::nothrow, [&add]
+		(const string_view &val)
+		{
+			dbs::event_auth_chain_pos link[event::auth::MAX];
+			const auto &[event_idx, links]
+			{
+				dbs::event_auth_cover_val(link, val)
+			};
+
+			for(size_t i(0); i < links; ++i)
+				add(link[i]);
+		});
+	}
+
+	m::event::fetch e;
+	if(!seek(std::nothrow, e, idx))
+		return true;
+
+	const event::auth prev{e};
+	event::idx auth_idxs[prev.MAX];
+	const auto &auth_idx
+	{
+		prev.idxs(auth_idxs)
+	};
+
+	for(size_t i(0); i < auth_idx.size(); ++i)
+	{
+		if(!auth_idx[i])
+			return false;
+
+		if(!dbs::find_event_auth_chain(pos, auth_idx[i], wopts))
+			return false;
+
+		add(pos);
+	}
+
+	return true;
+}
+
+/// Extend the reach to everything reachable through the links of the events
+/// in the ranges. Each range is scanned once and its events are presented
+/// to the closure.
+void
+ircd::m::room_auth_chain_close(room::auth::chain::reach &reach,
+                               const event::closure_idx &closure)
+{
+	std::map<uint64_t, uint64_t> scanned;
+	std::deque<uint64_t> queue;
+	for(const auto &[chain, seq] : reach)
+		queue.emplace_back(chain);
+
+	while(!queue.empty())
+	{
+		const auto chain(queue.front());
+		queue.pop_front();
+
+		auto &lo(scanned[chain]);
+		const auto hi(reach.at(chain));
+		if(hi <= lo)
+			continue;
+
+		char buf[dbs::EVENT_AUTH_COVER_KEY_SIZE];
+		auto it
+		{
+			dbs::event_auth_cover.begin(dbs::event_auth_cover_key(buf, chain, lo + 1))
+		};
+
+		lo = hi;
+		for(; bool(it); ++it)
+		{
+			if(dbs::event_auth_cover_key(it->first) > hi)
+				break;
+
+			dbs::event_auth_chain_pos link[event::auth::MAX];
+			const auto &[event_idx, links]
+			{
+				dbs::event_auth_cover_val(link, it->second)
+			};
+
+			// Tombstone of a deleted event; its links still apply.
+			if(closure && event_idx)
+				closure(event_idx);
+
+			for(size_t i(0); i < links; ++i)
+			{
+				auto &seq(reach[link[i].first]);
+				if(link[i].second <= seq)
+					continue;
+
+				seq = link[i].second;
+				queue.emplace_back(link[i].first);
+			}
+		}
+	}
+}
+
+/// Presents the events of the chain with lo < seq <= hi.
+void
+ircd::m::room_auth_chain_range(const uint64_t &chain,
+                               const uint64_t &lo,
+                               const uint64_t &hi,
+                               const event::closure_idx &closure)
+{
+	if(hi <= lo)
+		return;
+
+	char buf[dbs::EVENT_AUTH_COVER_KEY_SIZE];
+	auto it
+	{
+		dbs::event_auth_cover.begin(dbs::event_auth_cover_key(buf, chain, lo + 1))
+	};
+
+	for(; bool(it); ++it)
+	{
+		if(dbs::event_auth_cover_key(it->first) > hi)
+			break;
+
+		dbs::event_auth_chain_pos link[event::auth::MAX];
+		const auto &[event_idx, links]
+		{
+			dbs::event_auth_cover_val(link, it->second)
+		};
+
+		// Tombstone of a deleted event.
+		if(event_idx)
+			closure(event_idx);
+	}
+}
+
+bool
+ircd::m::room::auth::chain::for_each_walk(const closure &closure)
+const
 {
 	m::event::fetch e, a;
 	std::set<event::idx> ae;
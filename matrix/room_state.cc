@@ -942,6 +942,21 @@ ircd::m::room::state::rebuild::rebuild(const room::id &room_id)
 		*m::dbs::events
 	};
 
+	// The co-membership index is resynced after the rebuild from the joined
+	// members before and after, rather than by each rewritten member event.
+	std::vector<std::string> joined[2];
+	const auto get_joined{[&room_id](auto &joined)
+	{
+		m::room::members(room_id).for_each("join", [&joined]
+		(const m::user::id &user_id)
+		{
+			joined.emplace_back(user_id);
+			return true;
+		});
+	}};
+
+	get_joined(joined[0]);
+
 	m::event::fetch event;
 	ssize_t added(0), deleted(0);
 	present_state.for_each([&opts, &txn, &deleted, &event]
@@ -1005,4 +1020,16 @@ ircd::m::room::state::rebuild::rebuild(const room::id &room_id)
 	};
 
 	txn();
+
+	get_joined(joined[1]);
+	db::txn mitsein_txn
+	{
+		*m::dbs::events
+	};
+
+	const std::vector<m::user::id> before(begin(joined[0]), end(joined[0]));
+	const std::vector<m::user::id> after(begin(joined[1]), end(joined[1]));
+	dbs::_index_user_mitsein(mitsein_txn, room_id, before, db::op::DELETE);
+	dbs::_index_user_mitsein(mitsein_txn, room_id, after, db::op::SET);
+	mitsein_txn();
 }
@@ -9,6 +9,11 @@
 // full license for this software is available in the LICENSE file.
 
 
+namespace ircd::m
+{
+	static int64_t find_point(const room::id &, const int64_t &bound, int64_t &base);
+}
+
 //
 // room::state::history
 //
@@ -174,6 +179,20 @@ ircd::m::room::state::history::for_each(const string_view &type,
                                         const closure &closure)
 const
 {
+	// Iterations over many (type, state_key) start from the nearest
+	// checkpoint rather than scanning all states of the room.
+	if(!defined(state_key) && bound > 0)
+	{
+		int64_t base;
+		const int64_t point
+		{
+			find_point(space.room.room_id, bound, base)
+		};
+
+		if(point > 0)
+			return for_each_point(type, point, base, closure);
+	}
+
 	char type_buf[m::event::TYPE_MAX_SIZE];
 	char state_key_buf[m::event::STATE_KEY_MAX_SIZE];
 
@@ -201,3 +220,188 @@ const
 		return true;
 	});
 }
+
+/// The state at the bound is composed from three sources in order of
+/// precedence: the room events between the checkpoint and the bound, the
+/// entries of the checkpoint, and the entries of its keyframe. The first two
+/// are collected into an ordered overlay which is merged with the keyframe
+/// as it is iterated.
+bool
+ircd::m::room::state::history::for_each_point(const string_view &type,
+                                              const int64_t &point,
+                                              const int64_t &base,
+                                              const closure &closure)
+const
+{
+	static const event::fetch::opts fopts
+	{
+		event::keys::include {"type", "state_key", "depth"}
+	};
+
+	using overlay_key = std::pair<std::string, std::string>;
+	using overlay_val = std::pair<int64_t, event::idx>;
+
+	const auto &room_id(space.room.room_id);
+	std::map<overlay_key, overlay_val> overlay;
+	const auto add{[&overlay, &type]
+	(const m::event &event, const event::idx &event_idx)
+	{
+		if(type && json::get<"type"_>(event) != type)
+			return;
+
+		overlay.emplace
+		(
+			std::piecewise_construct,
+			std::forward_as_tuple(json::get<"type"_>(event), json::get<"state_key"_>(event)),
+			std::forward_as_tuple(json::get<"depth"_>(event), event_idx)
+		);
+	}};
+
+	// The event at the bound is included even though its depth is not less
+	// than the bound, just as with the space iteration.
+	if(this->event_idx && state::is(std::nothrow, this->event_idx))
+	{
+		const m::event::fetch event
+		{
+			std::nothrow, this->event_idx, fopts
+		};
+
+		if(event.valid && json::get<"depth"_>(event) >= bound)
+			add(event, this->event_idx);
+	}
+
+	// Replay the state events from the bound back to the checkpoint; the
+	// most recent event for a (type, state_key) is found first. Events which
+	// are not in the state space did not pass auth and are ignored.
+	char buf[std::max(dbs::ROOM_STATE_SPACE_KEY_MAX_SIZE, dbs::ROOM_STATE_POINT_KEY_MAX_SIZE)];
+	m::room::events it
+	{
+		space.room, uint64_t(bound - 1), &fopts
+	};
+
+	for(; it && int64_t(it.depth()) >= point; --it)
+	{
+		const auto &event_idx
+		{
+			it.event_idx()
+		};
+
+		if(!state::is(std::nothrow, event_idx))
+			continue;
+
+		const m::event &event
+		{
+			it.fetch(std::nothrow)
+		};
+
+		if(!json::get<"type"_>(event))
+			continue;
+
+		const string_view &space_key
+		{
+			dbs::room_state_space_key(buf, room_id, at<"type"_>(event), at<"state_key"_>(event), at<"depth"_>(event), event_idx)
+		};
+
+		if(!db::has(dbs::room_state_space, space_key))
+			continue;
+
+		add(event, event_idx);
+	}
+
+	// The entries changed since the keyframe.
+	if(base != point)
+		for(auto it(dbs::room_state_point.begin(dbs::room_state_point_key(buf, room_id, point, type))); it; ++it)
+		{
+			const auto &[_point, _type, _state_key]
+			{
+				dbs::room_state_point_key(it->first)
+			};
+
+			if(_point != point || (type && _type != type))
+				break;
+
+			if(!_type)
+				continue;
+
+			const auto &[depth, event_idx]
+			{
+				dbs::room_state_point_val(it->second)
+			};
+
+			overlay.emplace
+			(
+				std::piecewise_construct,
+				std::forward_as_tuple(_type, _state_key),
+				std::forward_as_tuple(depth, event_idx)
+			);
+		}
+
+	// Merge the keyframe with the overlay.
+	auto ot(begin(overlay));
+	for(auto it(dbs::room_state_point.begin(dbs::room_state_point_key(buf, room_id, base, type))); it; ++it)
+	{
+		const auto &[_point, _type, _state_key]
+		{
+			dbs::room_state_point_key(it->first)
+		};
+
+		if(_point != base || (type && _type != type))
+			break;
+
+		if(!_type)
+			continue;
+
+		const auto key
+		{
+			std::make_pair(_type, _state_key)
+		};
+
+		for(; ot != end(overlay) && std::make_pair(string_view{ot->first.first}, string_view{ot->first.second}) < key; ++ot)
+			if(!closure(ot->first.first, ot->first.second, ot->second.first, ot->second.second))
+				return false;
+
+		if(ot != end(overlay) && ot->first.first == _type && ot->first.second == _state_key)
+			continue;
+
+		const auto &[depth, event_idx]
+		{
+			dbs::room_state_point_val(it->second)
+		};
+
+		if(!closure(_type, _state_key, depth, event_idx))
+			return false;
+	}
+
+	for(; ot != end(overlay); ++ot)
+		if(!closure(ot->first.first, ot->first.second, ot->second.first, ot->second.second))
+			return false;
+
+	return true;
+}
+
+/// Finds the nearest checkpoint at or below the bound. Returns the point or
+/// -1 when there is none; the point of its keyframe is set in base.
+int64_t
+ircd::m::find_point(const room::id &room_id,
+                    const int64_t &bound,
+                    int64_t &base)
+{
+	char buf[dbs::ROOM_STATE_POINT_KEY_MAX_SIZE];
+	const auto it
+	{
+		dbs::room_state_point.begin(dbs::room_state_point_key(buf, room_id, bound))
+	};
+
+	if(!it)
+		return -1;
+
+	const auto &[point, type, state_key]
+	{
+		dbs::room_state_point_key(it->first)
+	};
+
+	assert(!type && !state_key);
+	assert(point <= bound);
+	std::tie(base, std::ignore) = dbs::room_state_point_val(it->second);
+	return point;
+}
@@ -212,6 +212,78 @@ ircd::m::room::state::space::rebuild::rebuild(const room::id &room_id)
 		!m::internal(room_id)
 	};
 
+	// The checkpoints are remade from the state accumulated during the
+	// replay below; any existing checkpoints are discarded.
+	char point_buf[dbs::ROOM_STATE_POINT_KEY_MAX_SIZE];
+	char point_val[dbs::ROOM_STATE_POINT_VAL_SIZE];
+	for(auto pit(dbs::room_state_point.begin(room_id)); pit; ++pit)
+	{
+		const auto &[point, type, state_key]
+		{
+			dbs::room_state_point_key(pit->first)
+		};
+
+		db::txn::append
+		{
+			txn, dbs::room_state_point,
+			{
+				db::op::DELETE,
+				dbs::room_state_point_key(point_buf, room_id, point, type, state_key),
+			}
+		};
+	}
+
+	using state_key_pair = std::pair<std::string, std::string>;
+	using state_val_pair = std::pair<int64_t, event::idx>;
+	std::map<state_key_pair, state_val_pair> present;
+
+	const int64_t interval
+	{
+		int64_t(dbs::desc::room_state_point__interval)
+	};
+
+	int64_t next_point(-1), keyframe(-1);
+	size_t points_count(0);
+	const auto make_point{[&](const int64_t &point)
+	{
+		const int64_t base
+		{
+			dbs::room_state_point_base(point) != point &&
+			dbs::room_state_point_base(point) == keyframe?
+				keyframe:
+				point
+		};
+
+		keyframe = base == point? point : keyframe;
+		db::txn::append
+		{
+			txn, dbs::room_state_point,
+			{
+				db::op::SET,
+				dbs::room_state_point_key(point_buf, room_id, point),
+				dbs::room_state_point_val(point_val, base, 0UL),
+			}
+		};
+
+		for(const auto &[key, val] : present)
+		{
+			if(base != point && val.first < base)
+				continue;
+
+			db::txn::append
+			{
+				txn, dbs::room_state_point,
+				{
+					db::op::SET,
+					dbs::room_state_point_key(point_buf, room_id, point, key.first, key.second),
+					dbs::room_state_point_val(point_val, val.first, val.second),
+				}
+			};
+		}
+
+		++points_count;
+	}};
+
 	size_t state_count(0), messages_count(0), state_deleted(0);
 	for(; it; ++it, ++messages_count) try
 	{
@@ -220,6 +292,17 @@ ircd::m::room::state::space::rebuild::rebuild(const room::id &room_id)
 			it.event_idx()
 		};
 
+		const int64_t depth
+		{
+			int64_t(it.depth())
+		};
+
+		if(interval > 0 && next_point < 0)
+			next_point = (depth / interval + 1) * interval;
+
+		for(; interval > 0 && next_point <= depth; next_point += interval)
+			make_point(next_point);
+
 		if(!state::is(std::nothrow, event_idx))
 			continue;
 
@@ -269,6 +352,8 @@ ircd::m::room::state::space::rebuild::rebuild(const room::id &room_id)
 		state_deleted += opts.op == db::op::DELETE;
 
 		dbs::write(txn, event, opts);
+		if(opts.op == db::op::SET)
+			present[{at<"type"_>(event), at<"state_key"_>(event)}] = {depth, event_idx};
 	}
 	catch(const ctx::interrupted &e)
 	{
@@ -291,11 +376,12 @@ ircd::m::room::state::space::rebuild::rebuild(const room::id &room_id)
 
 	log::info
 	{
-		log, "room::state::space::rebuild %s complete msgs:%zu state:%zu del:%zu transaction elems:%zu size:%s",
+		log, "room::state::space::rebuild %s complete msgs:%zu state:%zu del:%zu points:%zu transaction elems:%zu size:%s",
 		string_view{room_id},
 		messages_count,
 		state_count,
 		state_deleted,
+		points_count,
 		txn.size(),
 		pretty(iec(txn.bytes()))
 	};
@@ -0,0 +1,583 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::rooms::directory
+{
+	struct rank;
+	using word_closure = std::function<void (const string_view &)>;
+
+	static size_t words(const string_view &text, const word_closure &);
+	static void link(entry &);
+	static void unlink(entry &);
+	static void set(const string_view &state_key, const event::idx &);
+	static void del(const event::idx &);
+	static std::vector<const entry *> search(const opts &);
+	static entry parse_token(const string_view &);
+	static void build();
+	static void handle_summary(const m::event &, vm::eval &);
+	static void handle_redaction(const m::event &, vm::eval &);
+
+	extern std::map<std::string, entry, std::less<>> entries;
+	extern std::set<const entry *, rank> ranked;
+	extern std::multimap<std::string, const entry *, std::less<>> terms;
+	extern std::map<event::idx, const entry *> indexed;
+	extern std::unique_ptr<context> builder;
+	extern bool built;
+	extern hookfn<vm::eval &> summary_hook;
+	extern hookfn<vm::eval &> redaction_hook;
+}
+
+/// Entries by descending joined members, then by room_id and origin for a
+/// total order which pagination tokens can resume from.
+struct ircd::m::rooms::directory::rank
+{
+	bool operator()(const entry *const &a, const entry *const &b) const noexcept
+	{
+		if(a->joined != b->joined)
+			return a->joined > b->joined;
+
+		if(a->room_id != b->room_id)
+			return a->room_id < b->room_id;
+
+		return a->origin < b->origin;
+	}
+};
+
+decltype(ircd::m::rooms::directory::enable)
+ircd::m::rooms::directory::enable
+{
+	{ "name",     "ircd.m.rooms.directory.enable" },
+	{ "default",  true                            },
+};
+
+decltype(ircd::m::rooms::directory::terms_max)
+ircd::m::rooms::directory::terms_max
+{
+	{ "name",     "ircd.m.rooms.directory.terms.max" },
+	{ "default",  64L                                },
+};
+
+decltype(ircd::m::rooms::directory::entries)
+ircd::m::rooms::directory::entries;
+
+decltype(ircd::m::rooms::directory::ranked)
+ircd::m::rooms::directory::ranked;
+
+decltype(ircd::m::rooms::directory::terms)
+ircd::m::rooms::directory::terms;
+
+decltype(ircd::m::rooms::directory::indexed)
+ircd::m::rooms::directory::indexed;
+
+decltype(ircd::m::rooms::directory::builder)
+ircd::m::rooms::directory::builder;
+
+decltype(ircd::m::rooms::directory::built)
+ircd::m::rooms::directory::built;
+
+decltype(ircd::m::rooms::directory::summary_hook)
+ircd::m::rooms::directory::summary_hook
+{
+	handle_summary,
+	{
+		{ "_site",    "vm.notify"           },
+		{ "room_id",  "!public"             },
+		{ "type",     "ircd.rooms.summary"  },
+	}
+};
+
+decltype(ircd::m::rooms::directory::redaction_hook)
+ircd::m::rooms::directory::redaction_hook
+{
+	handle_redaction,
+	{
+		{ "_site",    "vm.notify"         },
+		{ "room_id",  "!public"           },
+		{ "type",     "m.room.redaction"  },
+	}
+};
+
+void
+ircd::m::rooms::directory::init()
+{
+	if(!enable)
+		return;
+
+	builder = std::make_unique<context>
+	(
+		"m.rooms.directory",
+		256_KiB,
+		&build,
+		context::POST
+	);
+}
+
+void
+ircd::m::rooms::directory::fini()
+noexcept
+{
+	if(builder)
+		builder->interrupt();
+
+	builder.reset();
+	built = false;
+	indexed.clear();
+	terms.clear();
+	ranked.clear();
+	entries.clear();
+}
+
+bool
+ircd::m::rooms::directory::ready()
+noexcept
+{
+	return built && enable;
+}
+
+size_t
+ircd::m::rooms::directory::count(const opts &opts)
+{
+	if(opts.search_term)
+		return search(opts).size();
+
+	if(!opts.server)
+		return ranked.size();
+
+	return std::count_if(begin(ranked), end(ranked), [&opts]
+	(const entry *const &entry)
+	{
+		return entry->origin == opts.server;
+	});
+}
+
+bool
+ircd::m::rooms::directory::for_each(const opts &opts,
+                                    const closure &closure)
+{
+	// The closure may yield while the index changes, so the entries are
+	// copied out a chunk at a time and the next chunk is found again from the
+	// position of the last entry.
+	static const size_t chunk_max
+	{
+		64
+	};
+
+	std::vector<entry> chunk;
+	chunk.reserve(chunk_max);
+	entry last
+	{
+		parse_token(opts.since)
+	};
+
+	bool resume
+	{
+		!empty(last.room_id)
+	};
+
+	for(bool done(false); !done; resume = true)
+	{
+		chunk.clear();
+		if(opts.search_term)
+		{
+			const auto matches
+			{
+				search(opts)
+			};
+
+			auto it
+			{
+				resume?
+					std::upper_bound(begin(matches), end(matches), &last, rank{}):
+					begin(matches)
+			};
+
+			for(; it != end(matches) && chunk.size() < chunk_max; ++it)
+				chunk.emplace_back(entry{(*it)->room_id, (*it)->origin, (*it)->event_idx, (*it)->joined});
+
+			done = it == end(matches);
+		}
+		else
+		{
+			auto it
+			{
+				resume?
+					ranked.upper_bound(&last):
+					begin(ranked)
+			};
+
+			for(; it != end(ranked) && chunk.size() < chunk_max; ++it)
+				if(!opts.server || (*it)->origin == opts.server)
+					chunk.emplace_back(entry{(*it)->room_id, (*it)->origin, (*it)->event_idx, (*it)->joined});
+
+			done = it == end(ranked);
+		}
+
+		for(const auto &entry : chunk)
+			if(!closure(entry))
+				return false;
+
+		if(!chunk.empty())
+			last = std::move(chunk.back());
+	}
+
+	return true;
+}
+
+ircd::string_view
+ircd::m::rooms::directory::make_token(const mutable_buffer &buf,
+                                      const entry &entry)
+{
+	return fmt::sprintf
+	{
+		buf, "%zu,%s,%s",
+		entry.joined,
+		entry.room_id,
+		entry.origin,
+	};
+}
+
+bool
+ircd::m::rooms::directory::valid_token(const string_view &token)
+noexcept
+{
+	const auto &[joined, remain]
+	{
+		split(token, ',')
+	};
+
+	const auto &[room_id, origin]
+	{
+		rsplit(remain, ',')
+	};
+
+	return lex_castable<size_t>(joined)
+	&& valid(m::id::ROOM, room_id)
+	&& !empty(origin);
+}
+
+ircd::m::rooms::directory::entry
+ircd::m::rooms::directory::parse_token(const string_view &token)
+{
+	if(!valid_token(token))
+		return {};
+
+	const auto &[joined, remain]
+	{
+		split(token, ',')
+	};
+
+	const auto &[room_id, origin]
+	{
+		rsplit(remain, ',')
+	};
+
+	return entry
+	{
+		std::string(room_id),
+		std::string(origin),
+		0UL,
+		lex_cast<size_t>(joined),
+	};
+}
+
+/// Entries having a word prefixed by every word of the search term, in the
+/// order of their rank.
+std::vector<const ircd::m::rooms::directory::entry *>
+ircd::m::rooms::directory::search(const opts &opts)
+{
+	std::vector<std::string> want;
+	words(opts.search_term, [&want]
+	(const string_view &word)
+	{
+		want.emplace_back(word);
+	});
+
+	std::vector<const entry *> ret;
+	if(want.empty())
+		return ret;
+
+	// Candidates come from the longest word, which is likely the most
+	// selective; the remaining words are checked against each candidate.
+	std::sort(begin(want), end(want), []
+	(const auto &a, const auto &b)
+	{
+		return a.size() > b.size();
+	});
+
+	const auto &first
+	{
+		want.front()
+	};
+
+	std::set<const entry *> candidates;
+	for(auto it(terms.lower_bound(first)); it != end(terms) && startswith(it->first, first); ++it)
+		candidates.emplace(it->second);
+
+	const auto has_prefix{[](const entry &entry, const string_view &word)
+	{
+		return std::any_of(begin(entry.terms), end(entry.terms), [&word]
+		(const string_view &term)
+		{
+			return startswith(term, word);
+		});
+	}};
+
+	for(const auto &candidate : candidates)
+	{
+		if(opts.server && candidate->origin != opts.server)
+			continue;
+
+		const bool match
+		{
+			std::all_of(begin(want) + 1, end(want), [&has_prefix, &candidate]
+			(const string_view &word)
+			{
+				return has_prefix(*candidate, word);
+			})
+		};
+
+		if(match)
+			ret.emplace_back(candidate);
+	}
+
+	std::sort(begin(ret), end(ret), rank{});
+	return ret;
+}
+
+void
+ircd::m::rooms::directory::build()
+try
+{
+	const room::id::buf public_room_id
+	{
+		"!public", my_host()
+	};
+
+	const room::state state
+	{
+		public_room_id
+	};
+
+	size_t count(0);
+	state.for_each("ircd.rooms.summary", [&count]
+	(const string_view &type, const string_view &state_key, const event::idx &event_idx)
+	{
+		set(state_key, event_idx);
+		++count;
+		return true;
+	});
+
+	built = true;
+	log::info
+	{
+		log, "Public rooms directory indexed %zu of %zu summaries with %zu terms.",
+		entries.size(),
+		count,
+		terms.size(),
+	};
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Public rooms directory index :%s",
+		e.what(),
+	};
+}
+
+void
+ircd::m::rooms::directory::handle_summary(const m::event &event,
+                                          vm::eval &eval)
+{
+	if(!builder)
+		return;
+
+	set(at<"state_key"_>(event), eval.sequence);
+}
+
+void
+ircd::m::rooms::directory::handle_redaction(const m::event &event,
+                                            vm::eval &eval)
+{
+	if(!builder || !json::get<"redacts"_>(event))
+		return;
+
+	const auto event_idx
+	{
+		m::index(std::nothrow, event::id(json::get<"redacts"_>(event)))
+	};
+
+	if(event_idx)
+		del(event_idx);
+}
+
+void
+ircd::m::rooms::directory::set(const string_view &state_key,
+                               const event::idx &event_idx)
+{
+	const auto &[room_id, origin]
+	{
+		rooms::summary::unmake_state_key(state_key)
+	};
+
+	entry update
+	{
+		std::string(room_id),
+		std::string(origin),
+		event_idx,
+	};
+
+	m::get(std::nothrow, event_idx, "content", [&update]
+	(const json::object &content)
+	{
+		update.joined = content.get<size_t>("num_joined_members", 0UL);
+
+		const auto add{[&update](const string_view &word)
+		{
+			if(update.terms.size() >= size_t(terms_max))
+				return;
+
+			if(std::find(begin(update.terms), end(update.terms), word) != end(update.terms))
+				return;
+
+			update.terms.emplace_back(word);
+		}};
+
+		words(json::string(content["name"]), add);
+		words(json::string(content["canonical_alias"]), add);
+		for(const json::string alias : json::array(content["aliases"]))
+			words(alias, add);
+
+		words(json::string(content["topic"]), add);
+	});
+
+	auto it
+	{
+		entries.find(state_key)
+	};
+
+	// A newer summary was already indexed by the hook during the build.
+	if(it != end(entries) && it->second.event_idx > event_idx)
+		return;
+
+	if(it != end(entries))
+	{
+		unlink(it->second);
+		it->second = std::move(update);
+	}
+	else it = entries.emplace(std::string(state_key), std::move(update)).first;
+
+	link(it->second);
+}
+
+void
+ircd::m::rooms::directory::del(const event::idx &event_idx)
+{
+	const auto it
+	{
+		indexed.find(event_idx)
+	};
+
+	if(it == end(indexed))
+		return;
+
+	char state_key_buf[event::STATE_KEY_MAX_SIZE];
+	const auto state_key
+	{
+		rooms::summary::make_state_key(state_key_buf, room::id(it->second->room_id), it->second->origin)
+	};
+
+	const auto eit
+	{
+		entries.find(state_key)
+	};
+
+	assert(eit != end(entries));
+	unlink(eit->second);
+	entries.erase(eit);
+}
+
+void
+ircd::m::rooms::directory::link(entry &entry)
+{
+	ranked.emplace(&entry);
+	indexed.emplace(entry.event_idx, &entry);
+	for(const auto &term : entry.terms)
+		terms.emplace(term, &entry);
+}
+
+void
+ircd::m::rooms::directory::unlink(entry &entry)
+{
+	ranked.erase(&entry);
+	indexed.erase(entry.event_idx);
+	for(const auto &term : entry.terms)
+	{
+		auto pit
+		{
+			terms.equal_range(term)
+		};
+
+		for(auto it(pit.first); it != pit.second; ++it)
+			if(it->second == &entry)
+			{
+				terms.erase(it);
+				break;
+			}
+	}
+}
+
+/// Lower-cases the words of the text; anything but ASCII letters, digits and
+/// multibyte characters separates them.
+size_t
+ircd::m::rooms::directory::words(const string_view &text,
+                                 const word_closure &closure)
+{
+	static const size_t word_max
+	{
+		48
+	};
+
+	size_t ret(0);
+	char buf[word_max];
+	size_t len(0);
+	const auto flush{[&]
+	{
+		if(len)
+			closure(string_view{buf, len});
+
+		ret += len > 0;
+		len = 0;
+	}};
+
+	for(const char &c : text)
+	{
+		const bool wordc
+		{
+			std::isalnum(uint8_t(c)) || uint8_t(c) >= 0x80
+		};
+
+		if(!wordc)
+		{
+			flush();
+			continue;
+		}
+
+		if(len < word_max)
+			buf[len++] = std::tolower(uint8_t(c));
+	}
+
+	flush();
+	return ret;
+}
@@ -0,0 +1,337 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::search
+{
+	using terms_view = vector_view<const string_view>;
+	using tf_view = vector_view<const uint16_t>;
+	using intersect_closure = std::function<bool (const string_view &, const event::idx &, const tf_view &)>;
+
+	constexpr size_t TERMS_MAX {16};
+
+	static size_t tokenize(const vector_view<string_view> &, const mutable_buffer &, const json::string &);
+	static size_t count(const string_view &term, const string_view &room_id, const size_t &max);
+	static dbs::room_terms_mask keys_mask(const query &);
+	static bool intersect(const terms_view &, const string_view &room_id, const dbs::room_terms_mask &, const intersect_closure &);
+	static bool for_each_rank(const terms_view &, const string_view &room_id, const dbs::room_terms_mask &, const closure &);
+	static bool for_each_recent(const terms_view &, const string_view &room_id, const dbs::room_terms_mask &, const closure &);
+	static bool for_each(const query &, const string_view &room_id, const closure &);
+}
+
+/// The number of matching events considered when results are ordered by rank.
+/// Ranking requires the whole candidate set before the first result can be
+/// produced, so this bounds the cost of a ranked query.
+decltype(ircd::m::search::rank_max)
+ircd::m::search::rank_max
+{
+	{ "name",     "ircd.m.search.rank.max" },
+	{ "default",  1024L                    },
+};
+
+/// The number of postings counted for each term to compute its document
+/// frequency when ranking. Terms more common than this are weighted equally.
+decltype(ircd::m::search::rank_df_max)
+ircd::m::search::rank_df_max
+{
+	{ "name",     "ircd.m.search.rank.df.max" },
+	{ "default",  65536L                      },
+};
+
+bool
+ircd::m::search::for_each(const query &query,
+                          const closure &closure)
+{
+	return for_each(query, string_view{}, closure);
+}
+
+bool
+ircd::m::search::for_each(const query &query,
+                          const room::id &room_id,
+                          const closure &closure)
+{
+	assert(room_id);
+	return for_each(query, string_view{room_id}, closure);
+}
+
+bool
+ircd::m::search::for_each(const query &query,
+                          const string_view &room_id,
+                          const closure &closure)
+{
+	char buf[512];
+	string_view term[TERMS_MAX];
+	const vector_view<const string_view> terms
+	{
+		term, tokenize(term, buf, json::string{query.search_term})
+	};
+
+	if(terms.empty())
+		return true;
+
+	const auto keys
+	{
+		keys_mask(query)
+	};
+
+	if(!keys)
+		return true;
+
+	const bool rank
+	{
+		json::get<"order_by"_>(query.room_events) != "recent"
+	};
+
+	return rank?
+		for_each_rank(terms, room_id, keys, closure):
+		for_each_recent(terms, room_id, keys, closure);
+}
+
+/// The content keys given by the query; all of them when none are given.
+/// Keys which are not indexed match nothing.
+ircd::m::dbs::room_terms_mask
+ircd::m::search::keys_mask(const query &query)
+{
+	const json::array &keys
+	{
+		json::get<"keys"_>(query.room_events)
+	};
+
+	if(keys.empty())
+		return dbs::ROOM_TERMS_KEYS_ALL;
+
+	dbs::room_terms_mask ret(0);
+	for(const json::string key : keys)
+		ret |= dbs::room_terms_key_mask(key);
+
+	return ret;
+}
+
+/// Results are produced in the order of the index (most recent first) with
+/// the sum of the term frequencies as the rank.
+bool
+ircd::m::search::for_each_recent(const terms_view &terms,
+                                 const string_view &room_id,
+                                 const dbs::room_terms_mask &keys,
+                                 const closure &closure)
+{
+	return intersect(terms, room_id, keys, [&closure]
+	(const string_view &room_id, const event::idx &event_idx, const tf_view &tf)
+	{
+		const long rank
+		{
+			std::accumulate(begin(tf), end(tf), 0L)
+		};
+
+		return closure(event_idx, rank);
+	});
+}
+
+/// Results are scored by tf-idf where the document frequency of each term
+/// is counted within the room (or globally). Ties are broken by recency.
+bool
+ircd::m::search::for_each_rank(const terms_view &terms,
+                               const string_view &room_id,
+                               const dbs::room_terms_mask &keys,
+                               const closure &closure)
+{
+	const size_t df_max
+	{
+		std::max(size_t(rank_df_max), 1UL)
+	};
+
+	double idf[TERMS_MAX];
+	for(size_t i(0); i < terms.size(); ++i)
+	{
+		const size_t df
+		{
+			std::max(count(terms[i], room_id, df_max), 1UL)
+		};
+
+		idf[i] = std::log(1.0 + double(df_max) / df);
+	}
+
+	std::vector<std::pair<long, event::idx>> results;
+	results.reserve(std::min(size_t(rank_max), 1024UL));
+	intersect(terms, room_id, keys, [&results, &idf]
+	(const string_view &room_id, const event::idx &event_idx, const tf_view &tf)
+	{
+		double score(0.0);
+		for(size_t i(0); i < tf.size(); ++i)
+			score += tf[i] * idf[i];
+
+		results.emplace_back(long(score * 1000.0), event_idx);
+		return results.size() < size_t(rank_max);
+	});
+
+	std::sort(begin(results), end(results), []
+	(const auto &a, const auto &b)
+	{
+		return a > b;
+	});
+
+	for(const auto &[rank, event_idx] : results)
+		if(!closure(event_idx, rank))
+			return false;
+
+	return true;
+}
+
+/// Leapfrog intersection of the postings of each term. All cursors share the
+/// column's order of (room_id ascending, event_idx descending); the trailing
+/// cursors are sought to the leading cursor's position until all of them
+/// land on the same posting, which is then a match when every term was found
+/// in one of the keys.
+bool
+ircd::m::search::intersect(const terms_view &terms,
+                           const string_view &room_id,
+                           const dbs::room_terms_mask &keys,
+                           const intersect_closure &closure)
+{
+	const size_t num
+	{
+		std::min(terms.size(), TERMS_MAX)
+	};
+
+	char buf[dbs::ROOM_TERMS_KEY_MAX_SIZE];
+	db::domain::const_iterator it[TERMS_MAX];
+	for(size_t i(0); i < num; ++i)
+	{
+		const string_view &key
+		{
+			dbs::room_terms_key(buf, terms[i], room_id)
+		};
+
+		it[i] = dbs::room_terms.begin(key);
+		if(!it[i])
+			return true;
+	}
+
+	static const auto before{[]
+	(const dbs::room_terms_tuple &a, const dbs::room_terms_tuple &b)
+	{
+		return std::get<0>(a) < std::get<0>(b) ||
+		(std::get<0>(a) == std::get<0>(b) && std::get<1>(a) > std::get<1>(b));
+	}};
+
+	uint16_t tf[TERMS_MAX];
+	char lead_room_buf[id::MAX_SIZE];
+	for(;;)
+	{
+		size_t lead(0);
+		for(size_t i(1); i < num; ++i)
+			if(before(dbs::room_terms_key(it[lead]->first), dbs::room_terms_key(it[i]->first)))
+				lead = i;
+
+		// The position of the leading cursor is copied because the keys are
+		// invalidated when the cursors move.
+		const auto &[lead_room_, lead_idx]
+		{
+			dbs::room_terms_key(it[lead]->first)
+		};
+
+		if(room_id && lead_room_ != room_id)
+			return true;
+
+		const string_view lead_room
+		{
+			lead_room_buf, copy(lead_room_buf, lead_room_)
+		};
+
+		bool aligned(true), keyed(true);
+		for(size_t i(0); i < num; ++i)
+		{
+			const auto &[_room, _idx]
+			{
+				dbs::room_terms_key(it[i]->first)
+			};
+
+			if(_room == lead_room && _idx == lead_idx)
+			{
+				const auto &[_tf, _keys]
+				{
+					dbs::room_terms_val(it[i]->second)
+				};
+
+				tf[i] = _tf;
+				keyed &= bool(_keys & keys);
+				continue;
+			}
+
+			const string_view &key
+			{
+				dbs::room_terms_key(buf, terms[i], lead_room, lead_idx)
+			};
+
+			aligned = false;
+			if(!db::seek(it[i], key))
+				return true;
+		}
+
+		if(!aligned)
+			continue;
+
+		if(keyed && !closure(lead_room, lead_idx, tf_view(tf, num)))
+			return false;
+
+		if(!++it[0])
+			return true;
+	}
+}
+
+size_t
+ircd::m::search::count(const string_view &term,
+                       const string_view &room_id,
+                       const size_t &max)
+{
+	char buf[dbs::ROOM_TERMS_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		dbs::room_terms_key(buf, term, room_id)
+	};
+
+	size_t ret(0);
+	for(auto it(dbs::room_terms.begin(key)); it && ret < max; ++it, ++ret)
+	{
+		const auto &[_room_id, event_idx]
+		{
+			dbs::room_terms_key(it->first)
+		};
+
+		if(room_id && _room_id != room_id)
+			break;
+	}
+
+	return ret;
+}
+
+/// Tokenizes the search term the same way content is tokenized by the
+/// indexer. Duplicate terms are removed.
+size_t
+ircd::m::search::tokenize(const vector_view<string_view> &out,
+                          const mutable_buffer &buf,
+                          const json::string &search_term)
+{
+	size_t ret(0);
+	dbs::room_terms_tokenize(buf, search_term, [&out, &ret]
+	(const string_view &term)
+	{
+		const auto it
+		{
+			std::find(begin(out), begin(out) + ret, term)
+		};
+
+		if(it == begin(out) + ret)
+			out[ret++] = term;
+
+		return ret < out.size();
+	});
+
+	return ret;
+}
@@ -187,6 +187,27 @@ ircd::m::sync::stats::info
 	{ "default",  false                    },
 };
 
+/// Number of longpolling requests currently in the notifier index.
+decltype(ircd::m::sync::stats::longpoll_waiting)
+ircd::m::sync::stats::longpoll_waiting
+{
+	{ "name", "ircd.m.sync.longpoll.waiting" },
+};
+
+/// Number of events which the notifier routed to at least one longpoll.
+decltype(ircd::m::sync::stats::longpoll_events)
+ircd::m::sync::stats::longpoll_events
+{
+	{ "name", "ircd.m.sync.longpoll.events" },
+};
+
+/// Number of longpolls woken by the notifier in total.
+decltype(ircd::m::sync::stats::longpoll_notified)
+ircd::m::sync::stats::longpoll_notified
+{
+	{ "name", "ircd.m.sync.longpoll.notified" },
+};
+
 //
 // sync/item.h
 //
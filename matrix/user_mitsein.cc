@@ -8,11 +8,124 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+size_t
+ircd::m::user::mitsein::rebuild()
+{
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	m::users::opts opts;
+	opts.hostpart = my_host();
+
+	// Clear the index of all of our users and collect the rooms they're in.
+	size_t deleted(0);
+	std::set<std::string, std::less<>> rooms;
+	m::users::for_each(opts, [&txn, &deleted, &rooms]
+	(const m::user &user)
+	{
+		char buf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+		auto it
+		{
+			dbs::user_mitsein.begin(dbs::user_mitsein_key(buf, user))
+		};
+
+		for(; bool(it); ++it, ++deleted)
+		{
+			const auto &[other, room_id]
+			{
+				dbs::user_mitsein_key(it->first)
+			};
+
+			char keybuf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+			db::txn::append
+			{
+				txn, dbs::user_mitsein,
+				{
+					db::op::DELETE,
+					dbs::user_mitsein_key(keybuf, user, other, room_id),
+				}
+			};
+		}
+
+		const m::user::rooms user_rooms
+		{
+			user
+		};
+
+		user_rooms.for_each("join", [&rooms]
+		(const m::room &room, const string_view &)
+		{
+			rooms.emplace(room.room_id);
+		});
+
+		return true;
+	});
+
+	txn();
+	txn.clear();
+
+	size_t ret(0);
+	std::vector<std::string> members;
+	std::vector<m::user::id> ids;
+	for(const auto &room_id : rooms)
+	{
+		members.clear();
+		m::room::members(m::room::id(room_id)).for_each("join", [&members]
+		(const m::user::id &member)
+		{
+			members.emplace_back(member);
+			return true;
+		});
+
+		ids.assign(begin(members), end(members));
+		dbs::_index_user_mitsein(txn, m::room::id{room_id}, ids, db::op::SET);
+		++ret;
+
+		if(txn.size() < 65536UL)
+			continue;
+
+		txn();
+		txn.clear();
+	}
+
+	log::info
+	{
+		log, "User mitsein index rebuild rooms:%zu deleted:%zu txn:%zu %s commit...",
+		ret,
+		deleted,
+		txn.size(),
+		pretty(iec(txn.bytes())),
+	};
+
+	txn();
+	return ret;
+}
+
 bool
 ircd::m::user::mitsein::has(const m::user &other,
                             const string_view &membership)
 const
 {
+	if(indexed(other, membership))
+	{
+		const bool ours
+		{
+			my(user)
+		};
+
+		const m::user::id &a(ours? user.user_id : other.user_id);
+		const m::user::id &b(ours? other.user_id : user.user_id);
+		char buf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+		auto it
+		{
+			dbs::user_mitsein.begin(dbs::user_mitsein_key(buf, a, b))
+		};
+
+		return bool(it) && std::get<0>(dbs::user_mitsein_key(it->first)) == b;
+	}
+
 	// Return true if broken out of loop.
 	return !for_each(other, membership, []
 	(const m::room &, const string_view &)
@@ -68,9 +181,50 @@ const
 		user
 	};
 
-	// here we gooooooo :/
-	///TODO: ideal: db schema
-	///TODO: minimally: custom alloc?
+	if(indexed(membership))
+	{
+		// The user is among the members of their own rooms but not in the
+		// index, so they're visited first if they're in any room.
+		const bool any
+		{
+			!rooms.for_each(membership, rooms::closure_bool{[]
+			(const m::room &, const string_view &)
+			{
+				return false;
+			}})
+		};
+
+		if(any && !closure(user))
+			return false;
+
+		char buf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+		auto it
+		{
+			dbs::user_mitsein.begin(dbs::user_mitsein_key(buf, user))
+		};
+
+		// The pairs are contiguous; each other user is visited once for
+		// however many rooms they share.
+		char lastbuf[id::MAX_SIZE];
+		string_view last;
+		for(; bool(it); ++it)
+		{
+			const auto &[other, room_id]
+			{
+				dbs::user_mitsein_key(it->first)
+			};
+
+			if(other == last)
+				continue;
+
+			last = strlcpy(lastbuf, other);
+			if(!closure(m::user{m::user::id{last}}))
+				return false;
+		}
+
+		return true;
+	}
+
 	std::set<uint128_t, std::less<>> seen;
 	return rooms.for_each(membership, rooms::closure_bool{[&membership, &closure, &seen]
 	(const m::room &room, const string_view &_membership)
@@ -116,6 +270,38 @@ ircd::m::user::mitsein::for_each(const m::user &user,
                                  const rooms::closure_bool &closure)
 const
 {
+	if(indexed(user, membership))
+	{
+		const bool ours
+		{
+			my(this->user)
+		};
+
+		const m::user::id &a(ours? this->user.user_id : user.user_id);
+		const m::user::id &b(ours? user.user_id : this->user.user_id);
+		char buf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+		auto it
+		{
+			dbs::user_mitsein.begin(dbs::user_mitsein_key(buf, a, b))
+		};
+
+		for(; bool(it); ++it)
+		{
+			const auto &[other, room_id]
+			{
+				dbs::user_mitsein_key(it->first)
+			};
+
+			if(other != b)
+				break;
+
+			if(!closure(m::room{m::room::id{room_id}}, membership))
+				return false;
+		}
+
+		return true;
+	}
+
 	const m::user::rooms our_rooms{this->user};
 	const m::user::rooms their_rooms{user};
 	const bool use_our
@@ -142,3 +328,20 @@ const
 		return closure(room, membership);
 	}});
 }
+
+bool
+ircd::m::user::mitsein::indexed(const m::user &other,
+                                const string_view &membership)
+const
+{
+	return membership == "join"
+	&& user.user_id != other.user_id
+	&& (my(user) || my(other));
+}
+
+bool
+ircd::m::user::mitsein::indexed(const string_view &membership)
+const
+{
+	return membership == "join" && my(user);
+}
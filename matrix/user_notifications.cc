@@ -14,6 +14,101 @@ ircd::m::user::notifications::type_prefix
 	"ircd.push.note"
 };
 
+size_t
+ircd::m::user::notifications::rebuild()
+{
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	m::users::opts opts;
+	opts.hostpart = my_host();
+
+	size_t ret(0), deleted(0);
+	m::users::for_each(opts, [&txn, &ret, &deleted]
+	(const m::user &user)
+	{
+		char buf[dbs::USER_UNREAD_KEY_MAX_SIZE];
+		auto it
+		{
+			dbs::user_unread.begin(dbs::user_unread_key(buf, user))
+		};
+
+		for(; bool(it); ++it, ++deleted)
+		{
+			char keybuf[dbs::USER_UNREAD_KEY_MAX_SIZE];
+			db::txn::append
+			{
+				txn, dbs::user_unread,
+				{
+					db::op::DELETE,
+					dbs::user_unread_key(keybuf, user, dbs::user_unread_key(it->first)),
+				}
+			};
+		}
+
+		const notifications notifications
+		{
+			user
+		};
+
+		const m::user::rooms user_rooms
+		{
+			user
+		};
+
+		user_rooms.for_each("join", [&txn, &ret, &user, &notifications]
+		(const m::room &room, const string_view &)
+		{
+			m::event::id::buf last_read;
+			const auto read_idx
+			{
+				m::receipt::get(last_read, room.room_id, user)?
+					m::index(std::nothrow, last_read):
+					0UL
+			};
+
+			const auto &[notification, highlight]
+			{
+				notifications.tally(room.room_id, read_idx)
+			};
+
+			const dbs::user_unread_tuple counts
+			{
+				notification, highlight, read_idx
+			};
+
+			char keybuf[dbs::USER_UNREAD_KEY_MAX_SIZE];
+			char valbuf[dbs::USER_UNREAD_VAL_SIZE];
+			db::txn::append
+			{
+				txn, dbs::user_unread,
+				{
+					db::op::SET,
+					dbs::user_unread_key(keybuf, user, room.room_id),
+					dbs::user_unread_val(valbuf, counts),
+				}
+			};
+
+			++ret;
+		});
+
+		txn();
+		txn.clear();
+		return true;
+	});
+
+	log::info
+	{
+		log, "User unread notification counts rebuilt rooms:%zu deleted:%zu",
+		ret,
+		deleted,
+	};
+
+	return ret;
+}
+
 ircd::m::user::notifications::opts
 ircd::m::user::notifications::unmake_type(const string_view &type)
 {
@@ -53,6 +148,80 @@ ircd::m::user::notifications::make_type(const mutable_buffer &buf,
 	};
 }
 
+ircd::m::user::notifications::counts
+ircd::m::user::notifications::unread(const room::id &room_id)
+const
+{
+	char buf[dbs::USER_UNREAD_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		dbs::user_unread_key(buf, user, room_id)
+	};
+
+	counts ret {0, 0, 0};
+	db::column &column(dbs::user_unread);
+	column(key, std::nothrow, [&ret]
+	(const string_view &val)
+	{
+		const auto &[notification, highlight, event_idx]
+		{
+			dbs::user_unread_val(val)
+		};
+
+		ret = counts
+		{
+			notification, highlight, event_idx
+		};
+	});
+
+	return ret;
+}
+
+/// Counts the notifications for the room which refer to events after the
+/// event_idx. A notification is written after the event it refers to, so
+/// the scan can stop at the event_idx, but the notified event_idx in each
+/// notification's content decides whether it is counted. Plain notifications
+/// and highlights have distinct types; the notification count covers both.
+std::pair<size_t, size_t>
+ircd::m::user::notifications::tally(const room::id &room_id,
+                                    const event::idx &since)
+const
+{
+	const auto count_after{[this, &since]
+	(opts &opts)
+	{
+		size_t ret(0);
+		for_each(opts, closure{[&since, &ret]
+		(const event::idx &note_idx, const json::object &content)
+		{
+			ret += content.get<event::idx>("event_idx", 0UL) > since;
+			return true;
+		}});
+
+		return ret;
+	}};
+
+	opts opts;
+	opts.room_id = room_id;
+	opts.to = since;
+	opts.sorted = false;
+	const auto notes
+	{
+		count_after(opts)
+	};
+
+	opts.only = "highlight";
+	const auto highlights
+	{
+		count_after(opts)
+	};
+
+	return
+	{
+		notes + highlights, highlights
+	};
+}
+
 bool
 ircd::m::user::notifications::empty(const opts &opts)
 const
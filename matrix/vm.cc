@@ -8,6 +8,11 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m::vm
+{
+	extern const ctx::pool::opts pool_opts;
+}
+
 decltype(ircd::m::vm::log)
 ircd::m::vm::log
 {
@@ -17,6 +22,18 @@ ircd::m::vm::log
 decltype(ircd::m::vm::dock)
 ircd::m::vm::dock;
 
+decltype(ircd::m::vm::pool_opts)
+ircd::m::vm::pool_opts
+{
+	size_t(1_MiB), 0, -1, 0
+};
+
+decltype(ircd::m::vm::pool)
+ircd::m::vm::pool
+{
+	"m.vm", pool_opts
+};
+
 decltype(ircd::m::vm::ready)
 ircd::m::vm::ready;
 
@@ -26,6 +43,9 @@ ircd::m::vm::default_copts;
 decltype(ircd::m::vm::default_opts)
 ircd::m::vm::default_opts;
 
+decltype(ircd::m::vm::phase_duration)
+ircd::m::vm::phase_duration;
+
 //
 // init
 //
@@ -37,6 +57,24 @@ ircd::m::vm::init::init()
 	sequence::committed = sequence::retired;
 	sequence::uncommitted = sequence::committed;
 
+	for(uint i(phase::EXECUTE); i < phase::_NUM_; ++i)
+	{
+		char buf[64];
+		const string_view name
+		{
+			fmt::sprintf
+			{
+				buf, "ircd.m.vm.phase.%s.duration", reflect(phase(i))
+			}
+		};
+
+		phase_duration[i] = std::make_unique<stats::histogram>(json::members
+		{
+			{ "name", tolower(buf, name)                       },
+			{ "desc", "Microseconds evaluations spent in phase." },
+		});
+	}
+
 	vm::ready = true;
 	vm::dock.notify_all();
 
@@ -71,6 +109,8 @@ noexcept
 		return !eval::executing && !eval::injecting;
 	});
 
+	vm::pool.join();
+
 	if(sequence::pending)
 		log::warning
 		{
@@ -107,6 +147,8 @@ noexcept
 	};
 
 	assert(retired == sequence::retired || ircd::read_only);
+	for(auto &item : phase_duration)
+		item.reset();
 }
 
 ircd::http::code
@@ -37,6 +37,31 @@ ircd::m::vm::eval::executing;
 decltype(ircd::m::vm::eval::injecting)
 ircd::m::vm::eval::injecting;
 
+namespace ircd::m::vm
+{
+	extern conf::item<size_t> verify_batch_min;
+	extern conf::item<size_t> verify_concurrency;
+}
+
+/// The minimum number of pdus in an eval for their verification to be
+/// conducted as a batch on the offload threads.
+decltype(ircd::m::vm::verify_batch_min)
+ircd::m::vm::verify_batch_min
+{
+	{ "name",     "ircd.m.vm.verify.batch.min" },
+	{ "default",  4L                           },
+};
+
+/// The number of offload workers which divide the batch verification. Note
+/// the offload engine's thread count (ircd.ctx.ole.thread.max) bounds the
+/// actual parallelism; 0 disables the batch verification.
+decltype(ircd::m::vm::verify_concurrency)
+ircd::m::vm::verify_concurrency
+{
+	{ "name",     "ircd.m.vm.verify.concurrency" },
+	{ "default",  4L                             },
+};
+
 size_t
 ircd::m::vm::fetch_keys(const eval &eval)
 {
@@ -78,6 +103,141 @@ ircd::m::vm::fetch_keys(const eval &eval)
 	return fetched;
 }
 
+/// Verifies the content hashes and signatures of all pdus in the eval on the
+/// offload threads. The keys are resolved here first because that may involve
+/// IO; the workers only conduct the computation. Results are stored in
+/// eval.verified for the individual evals to consult.
+size_t
+ircd::m::vm::verify_pdus(eval &eval)
+{
+	struct job
+	{
+		ed25519::pk pk;
+		ed25519::sig sig;
+		bool keyed {false};
+	};
+
+	const auto &pdus
+	{
+		eval.pdus
+	};
+
+	eval.verified.clear();
+	if(!verify_concurrency || pdus.size() < size_t(verify_batch_min))
+		return 0;
+
+	std::vector<job> jobs(pdus.size());
+	for(size_t i(0); i < pdus.size(); ++i) try
+	{
+		const auto &event(pdus[i]);
+		const string_view &origin
+		{
+			json::get<"origin"_>(event)
+		};
+
+		if(!origin || m::fed::errant(origin))
+			continue;
+
+		const json::object &origin_sigs
+		{
+			json::get<"signatures"_>(event).get(origin)
+		};
+
+		for(const auto &[keyid, sig] : origin_sigs)
+		{
+			const m::node::keys node_keys
+			{
+				origin
+			};
+
+			node_keys.get(json::string(keyid), [&jobs, &i]
+			(const ed25519::pk &pk)
+			{
+				jobs[i].pk = pk;
+				jobs[i].keyed = true;
+			});
+
+			if(!jobs[i].keyed)
+				continue;
+
+			jobs[i].sig = ed25519::sig
+			{
+				[&sig](auto&& buf)
+				{
+					b64::decode(buf, json::string(sig));
+				}
+			};
+
+			break;
+		}
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		// The event will be verified serially during its eval, where any
+		// error is reported properly.
+		continue;
+	}
+
+	const ctx::ole::opts oopts
+	{
+		"vm.verify", std::max(size_t(verify_concurrency), 1UL)
+	};
+
+	eval.verified.assign(pdus.size(), 0);
+	std::atomic<size_t> next {0}, valid {0};
+	ctx::offload
+	{
+		oopts, [&pdus, &jobs, &eval, &next, &valid]
+		{
+			for(size_t i; (i = next.fetch_add(1)) < pdus.size(); ) try
+			{
+				const auto &event(pdus[i]);
+				uint8_t result(0);
+				if(!empty(json::get<"hashes"_>(event)))
+				{
+					result |= verified::HASH_CHECKED;
+					result |= m::verify_hash(event)? verified::HASH_VALID: 0;
+				}
+
+				if(jobs[i].keyed && m::verify(event, jobs[i].pk, jobs[i].sig))
+					result |= verified::SIGNATURE_VALID;
+
+				eval.verified[i] = result;
+				valid += bool(result & verified::SIGNATURE_VALID);
+			}
+			catch(...)
+			{
+				// This event is left for serial verification.
+				continue;
+			}
+		}
+	};
+
+	return valid;
+}
+
+/// Results of the batch verification for an event in the eval's pdus; zero
+/// when the event is not part of a batch.
+uint8_t
+ircd::m::vm::preverified(const eval &eval,
+                         const event &event)
+noexcept
+{
+	const auto *const begin(eval.pdus.data());
+	const auto *const end(begin + eval.pdus.size());
+	if(&event < begin || &event >= end)
+		return 0;
+
+	const size_t pos(std::distance(begin, &event));
+	return pos < eval.verified.size()?
+		eval.verified[pos]:
+		0;
+}
+
 size_t
 ircd::m::vm::prefetch_refs(const eval &eval)
 {
@@ -10,6 +10,8 @@
 
 namespace ircd::m::vm
 {
+	struct scope_phase;
+
 	template<class... args> static bool output(const vm::opts &, const vm::fault &, const string_view &event_id, const string_view &fmt, args&&...);
 	template<class... args> static fault handle_fault(const opts &, const fault &, const string_view &event_id, const string_view &fmt, args&&...);
 	template<class T> static void call_hook(hook::site<T> &, eval &, const event &, T&& data);
@@ -22,6 +24,7 @@ namespace ircd::m::vm
 	static fault execute_pdu(eval &, const event &);
 	static fault execute_du(eval &, const event &);
 	static fault execute(eval &, const event &);
+	static bool execute_rooms(eval &, const vector_view<const event> &);
 	static fault inject3(eval &, json::iov &, const json::iov &);
 	static fault inject1(eval &, json::iov &, const json::iov &);
 	static void fini();
@@ -43,6 +46,19 @@ namespace ircd::m::vm
 	extern conf::item<bool> log_accept_info;
 }
 
+/// Enters the eval into a phase for the scope and counts the time spent in
+/// the phase into its histogram on the way out.
+struct ircd::m::vm::scope_phase
+{
+	vm::phase phase;
+	ircd::timer timer;
+	scope_restore<vm::phase> restore;
+
+	scope_phase(eval &, const vm::phase &);
+	scope_phase(const scope_phase &) = delete;
+	~scope_phase() noexcept;
+};
+
 decltype(ircd::m::vm::log_commit_debug)
 ircd::m::vm::log_commit_debug
 {
@@ -128,6 +144,31 @@ ircd::m::vm::effect_hook
 	{ "interrupts",  false        },
 };
 
+//
+// scope_phase
+//
+
+ircd::m::vm::scope_phase::scope_phase(eval &eval,
+                                      const vm::phase &phase)
+:phase
+{
+	phase
+}
+,restore
+{
+	eval.phase, phase
+}
+{
+}
+
+ircd::m::vm::scope_phase::~scope_phase()
+noexcept
+{
+	assert(phase < phase::_NUM_);
+	if(likely(phase_duration[phase]))
+		*phase_duration[phase] += timer.at<microseconds>();
+}
+
 //
 // execute
 //
@@ -195,6 +236,15 @@ ircd::m::vm::execute(eval &eval,
 		*eval.opts
 	};
 
+	const bool concurrent
+	{
+		opts.concurrency > 1
+		&& events.size() > 1
+	};
+
+	if(concurrent && execute_rooms(eval, events))
+		return fault::ACCEPT;
+
 	const scope_restore eval_pdus
 	{
 		eval.pdus, events
@@ -205,9 +255,9 @@ ircd::m::vm::execute(eval &eval,
 		eval::executing
 	};
 
-	const scope_restore eval_phase
+	const scope_phase eval_phase
 	{
-		eval.phase, phase::EXECUTE
+		eval, phase::EXECUTE
 	};
 
 	const bool prefetch_keys
@@ -236,6 +286,25 @@ ircd::m::vm::execute(eval &eval,
 			vm::prefetch_refs(eval): 0UL
 	};
 
+	const bool verify_pdus
+	{
+		opts.phase[phase::VERIFY]
+		&& opts.mverify
+		&& events.size() > 1
+	};
+
+	// Results of the batch verification are only valid for these pdus.
+	const unwind clear_verified{[&eval]
+	{
+		eval.verified.clear();
+	}};
+
+	const size_t verified_pdus
+	{
+		verify_pdus?
+			vm::verify_pdus(eval): 0UL
+	};
+
 	size_t accepted(0), existed(0), i, j, k;
 	for(i = 0; i < events.size(); i += j)
 	{
@@ -299,6 +368,71 @@ ircd::m::vm::execute(eval &eval,
 	return fault::ACCEPT;
 }
 
+/// Partitions the events by room and evaluates the rooms concurrently on the
+/// vm::pool, each with its own eval. The order of the events within a room is
+/// preserved. Returns false without evaluating anything when all of the
+/// events are in the same room.
+bool
+ircd::m::vm::execute_rooms(eval &eval,
+                           const vector_view<const event> &events)
+{
+	assert(eval.opts);
+	const auto &opts
+	{
+		*eval.opts
+	};
+
+	std::vector<std::vector<m::event>> rooms;
+	for(const auto &event : events)
+	{
+		const auto it
+		{
+			std::find_if(begin(rooms), end(rooms), [&event]
+			(const auto &room)
+			{
+				return json::get<"room_id"_>(room.front()) == json::get<"room_id"_>(event);
+			})
+		};
+
+		if(it == end(rooms))
+			rooms.emplace_back(1, event);
+		else
+			it->emplace_back(event);
+	}
+
+	if(rooms.size() <= 1)
+		return false;
+
+	ctx::mutex out_mutex;
+	vm::opts room_opts{opts};
+	room_opts.concurrency = 1;
+	room_opts.out_mutex = opts.out_mutex?: &out_mutex;
+
+	pool.min(std::min(opts.concurrency, rooms.size()));
+	ctx::concurrent_for_each<std::vector<m::event>>
+	{
+		pool, rooms, [&eval, &room_opts]
+		(auto &events)
+		{
+			vm::eval room_eval
+			{
+				room_opts
+			};
+
+			const unwind account{[&eval, &room_eval]
+			{
+				eval.evaluated += room_eval.evaluated;
+				eval.accepted += room_eval.accepted;
+				eval.faulted += room_eval.faulted;
+			}};
+
+			execute(room_eval, vector_view<const m::event>(events));
+		}
+	};
+
+	return true;
+}
+
 ircd::m::vm::fault
 ircd::m::vm::execute(eval &eval,
                      const event &event)
@@ -356,13 +490,19 @@ try
 		eval.report, event::conforms{}
 	};
 
+	// Pick up any results for this event from the batch verification.
+	const scope_restore eval_preverified
+	{
+		eval.preverified, vm::preverified(eval, event)
+	};
+
 	// Conformity checks only require the event data itself; note that some
 	// local queries may still be made by the hook, such as m::redacted().
 	if(likely(opts.phase[phase::CONFORM]) && !opts.edu)
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::CONFORM
+			eval, phase::CONFORM
 		};
 
 		call_hook(conform_hook, eval, event, eval);
@@ -485,9 +625,9 @@ try
 	// rejected here, as the first eval might fail and the second might not.
 	if(likely(opts.phase[phase::DUPWAIT]) && eval.event_id)
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::DUPWAIT
+			eval, phase::DUPWAIT
 		};
 
 		// Prevent more than one event with the same event_id from
@@ -598,9 +738,9 @@ try
 	// created event.
 	if(opts.phase[phase::ISSUE] && eval.copts && eval.copts->issue)
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::ISSUE
+			eval, phase::ISSUE
 		};
 
 		call_hook(issue_hook, eval, event, eval);
@@ -629,9 +769,9 @@ try
 	// include notifying client `/sync` and the federation sender.
 	if(likely(opts.phase[phase::NOTIFY]))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::NOTIFY
+			eval, phase::NOTIFY
 		};
 
 		call_hook(notify_hook, eval, event, eval);
@@ -643,9 +783,9 @@ try
 	// notify for the event at issue here has already been made.
 	if(likely(opts.phase[phase::EFFECTS]))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::EFFECTS
+			eval, phase::EFFECTS
 		};
 
 		call_hook(effect_hook, eval, event, eval);
@@ -736,9 +876,9 @@ ircd::m::vm::execute_edu(eval &eval,
 {
 	if(likely(eval.opts->phase[phase::EVALUATE]))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::EVALUATE
+			eval, phase::EVALUATE
 		};
 
 		call_hook(eval_hook, eval, event, eval);
@@ -746,9 +886,9 @@ ircd::m::vm::execute_edu(eval &eval,
 
 	if(likely(eval.opts->phase[phase::POST]))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::POST
+			eval, phase::POST
 		};
 
 		call_hook(post_hook, eval, event, eval);
@@ -809,9 +949,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Check if an event with the same ID was already accepted.
 	if(likely(opts.phase[phase::DUPCHK]))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::DUPCHK
+			eval, phase::DUPCHK
 		};
 
 		// Prevent the same event from being accepted twice.
@@ -833,9 +973,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Check if event's proprietor is denied by the room ACL.
 	if(likely(opts.phase[phase::ACCESS]))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::ACCESS
+			eval, phase::ACCESS
 		};
 
 		call_hook(access_hook, eval, event, eval);
@@ -844,9 +984,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Check if this event is relevant to this server.
 	if(likely(opts.phase[phase::EMPTION]) && !eval.room_internal)
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::EMPTION
+			eval, phase::EMPTION
 		};
 
 		emption_check(eval, event);
@@ -854,12 +994,17 @@ ircd::m::vm::execute_pdu(eval &eval,
 
 	if(likely(opts.phase[phase::VERIFY]))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::VERIFY
+			eval, phase::VERIFY
 		};
 
-		if(!verify(event))
+		const bool preverified
+		{
+			bool(eval.preverified & verified::SIGNATURE_VALID)
+		};
+
+		if(!preverified && !verify(event))
 			throw m::BAD_SIGNATURE
 			{
 				"Signature verification failed."
@@ -868,9 +1013,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 
 	if(likely(opts.phase[phase::FETCH_AUTH] && opts.fetch))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::FETCH_AUTH
+			eval, phase::FETCH_AUTH
 		};
 
 		call_hook(fetch_auth_hook, eval, event, eval);
@@ -879,9 +1024,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Evaluation by auth system; throws
 	if(likely(opts.phase[phase::AUTH_STATIC]) && authenticate)
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::AUTH_STATIC
+			eval, phase::AUTH_STATIC
 		};
 
 		const auto &[pass, fail]
@@ -899,9 +1044,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 
 	if(likely(opts.phase[phase::FETCH_PREV] && opts.fetch))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::FETCH_PREV
+			eval, phase::FETCH_PREV
 		};
 
 		call_hook(fetch_prev_hook, eval, event, eval);
@@ -909,9 +1054,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 
 	if(likely(opts.phase[phase::FETCH_STATE] && opts.fetch))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::FETCH_STATE
+			eval, phase::FETCH_STATE
 		};
 
 		call_hook(fetch_state_hook, eval, event, eval);
@@ -950,9 +1095,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Allocate transaction; prefetch dependencies.
 	if(likely(opts.phase[phase::PREINDEX]) && !opts.mprefetch_refs)
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::PREINDEX
+			eval, phase::PREINDEX
 		};
 
 		dbs::write_opts wopts(opts.wopts);
@@ -963,9 +1108,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 		};
 	}
 
-	const scope_restore eval_phase_precommit
+	const scope_phase eval_phase_precommit
 	{
-		eval.phase, phase::PRECOMMIT
+		eval, phase::PRECOMMIT
 	};
 
 	// Wait until this is the lowest sequence number
@@ -980,9 +1125,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 
 	if(likely(opts.phase[phase::AUTH_RELA] && authenticate))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::AUTH_RELA
+			eval, phase::AUTH_RELA
 		};
 
 		const auto &[pass, fail]
@@ -1005,9 +1150,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	assert(sequence::retired < sequence::get(eval));
 	sequence::uncommitted = std::max(sequence::get(eval), sequence::uncommitted);
 
-	const scope_restore eval_phase_commit
+	const scope_phase eval_phase_commit
 	{
-		eval.phase, phase::COMMIT
+		eval, phase::COMMIT
 	};
 
 	// Wait until this is the lowest sequence number
@@ -1022,9 +1167,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Reevaluation of auth against the present state of the room.
 	if(likely(opts.phase[phase::AUTH_PRES] && authenticate))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::AUTH_PRES
+			eval, phase::AUTH_PRES
 		};
 
 		room::auth::check_present(event);
@@ -1033,9 +1178,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Evaluation by module hooks
 	if(likely(opts.phase[phase::EVALUATE]))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::EVALUATE
+			eval, phase::EVALUATE
 		};
 
 		call_hook(eval_hook, eval, event, eval);
@@ -1044,9 +1189,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Allocate transaction; discover shared-sequenced evals.
 	if(likely(opts.phase[phase::INDEX]))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::INDEX
+			eval, phase::INDEX
 		};
 
 		// Transaction composition.
@@ -1057,9 +1202,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// an entire eval of several more events recursively before returning.
 	if(likely(opts.phase[phase::POST]))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::POST
+			eval, phase::POST
 		};
 
 		call_hook(post_hook, eval, event, eval);
@@ -1074,9 +1219,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Commit the transaction to database iff this eval is at the stack base.
 	if(likely(opts.phase[phase::WRITE] && !parent_post))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::WRITE
+			eval, phase::WRITE
 		};
 
 		write_commit(eval);
@@ -1086,9 +1231,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// never return back to that stack base.
 	if(likely(!parent_post))
 	{
-		const scope_restore eval_phase
+		const scope_phase eval_phase
 		{
-			eval.phase, phase::RETIRE
+			eval, phase::RETIRE
 		};
 
 		retire(eval, event);
@@ -1333,6 +1478,12 @@ ircd::m::vm::write_append(eval &eval,
 		wopts.appendix[dbs::appendix::ROOM_JOINED] && state_present && pass
 	);
 
+	wopts.appendix.set
+	(
+		dbs::appendix::USER_MITSEIN,
+		wopts.appendix[dbs::appendix::USER_MITSEIN] && state_present && pass
+	);
+
 	const size_t wrote
 	{
 		dbs::write(txn, event, wopts)
@@ -1526,6 +1677,10 @@ ircd::m::vm::output(const vm::opts &opts,
 	if(unlikely(!event_id))
 		return false;
 
+	std::unique_lock<ctx::mutex> lock;
+	if(opts.out_mutex)
+		lock = std::unique_lock<ctx::mutex>{*opts.out_mutex};
+
 	json::stack::object object
 	{
 		*opts.out, event_id
@@ -245,7 +245,7 @@ put__presence_status(client &client,
 			client, http::OK
 		};
 
-	const auto eid
+	const auto version
 	{
 		m::presence::set(user, presence, status_msg)
 	};
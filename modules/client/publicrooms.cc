@@ -60,7 +60,7 @@ get__publicrooms(client &client,
 			url::decode(since_buf, request.query["since"])
 	};
 
-	if(since && !valid(m::id::ROOM, since))
+	if(since && !valid(m::id::ROOM, since) && !m::rooms::directory::valid_token(since))
 		throw m::BAD_REQUEST
 		{
 			"Invalid since token for this server."
@@ -162,9 +162,22 @@ get__publicrooms(client &client,
 		since,
 	};
 
+	// The directory index answers listings and term searches; searches for
+	// a user's rooms or by alias prefix are conducted by the rooms iteration.
+	const bool directory
+	{
+		m::rooms::directory::ready() && !opts.user_id && !opts.room_alias
+	};
+
+	m::rooms::directory::opts dopts;
+	dopts.since = since;
+	dopts.server = opts.server;
+	dopts.search_term = search_term;
+
 	size_t count{0};
 	m::room::id::buf prev_batch_buf; //TODO: XXX
-	m::room::id::buf next_batch_buf;
+	char next_batch_buf[m::rooms::directory::TOKEN_MAX_SIZE];
+	string_view next_batch;
 	json::stack::object top{out};
 	{
 		json::stack::array chunk
@@ -172,31 +185,53 @@ get__publicrooms(client &client,
 			top, "chunk"
 		};
 
-		m::rooms::for_each(opts, [&]
-		(const m::room::id &room_id)
-		{
-			if(++count > limit)
+		if(directory)
+			m::rooms::directory::for_each(dopts, [&]
+			(const m::rooms::directory::entry &entry)
 			{
-				next_batch_buf = room_id;
-				return false;
-			}
-
-			json::stack::object obj
+				if(++count > limit)
+				{
+					next_batch = m::rooms::directory::make_token(next_batch_buf, entry);
+					return false;
+				}
+
+				json::stack::object obj
+				{
+					chunk
+				};
+
+				m::rooms::summary::get(obj, m::room::id(entry.room_id));
+				return true;
+			});
+		else
+			m::rooms::for_each(opts, [&]
+			(const m::room::id &room_id)
 			{
-				chunk
-			};
-
-			m::rooms::summary::get(obj, room_id);
-			return true;
-		});
+				if(++count > limit)
+				{
+					next_batch = strlcpy(next_batch_buf, room_id);
+					return false;
+				}
+
+				json::stack::object obj
+				{
+					chunk
+				};
+
+				m::rooms::summary::get(obj, room_id);
+				return true;
+			});
 	}
 
 	// To count the total we clear the since token, otherwise the count
 	// will be the remainder.
 	opts.room_id = {};
+	dopts.since = {};
 	const size_t total_rooms_count_estimate
 	{
-		m::rooms::count(opts)
+		directory?
+			m::rooms::directory::count(dopts):
+			m::rooms::count(opts)
 	};
 
 	json::stack::member
@@ -213,10 +248,10 @@ get__publicrooms(client &client,
 			top, "prev_batch", prev_batch_buf
 		};
 
-	if(next_batch_buf)
+	if(next_batch)
 		json::stack::member
 		{
-			top, "next_batch", next_batch_buf
+			top, "next_batch", next_batch
 		};
 
 	return std::move(response);
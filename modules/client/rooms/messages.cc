@@ -22,6 +22,15 @@ struct pagination_tokens
 	pagination_tokens(const m::resource::request &);
 };
 
+using type_cursor = std::pair<int64_t, m::event::idx>;
+
+static size_t
+_fetch_types(m::event::idx *const &out,
+             const size_t &max,
+             const m::room &room,
+             const json::array &types,
+             type_cursor &cursor);
+
 static bool
 _append(json::stack::array &chunk,
         const m::event &,
@@ -43,6 +52,13 @@ postfetch_multiplier
 	{ "default",   2.0                                               },
 };
 
+/// Number of events fetched from the database together.
+static const size_t
+fetch_batch_max
+{
+	64
+};
+
 log::log
 messages_log
 {
@@ -132,44 +148,136 @@ get__messages(client &client,
 		top, "chunk"
 	};
 
+	const json::array &types
+	{
+		json::get<"types"_>(filter)
+	};
+
+	const json::array &not_types
+	{
+		json::get<"not_types"_>(filter)
+	};
+
+	// Scrollback filtered to certain types is found from the room's type
+	// index, jumping over all of the other events rather than fetching them.
+	const m::event::idx from_idx
+	{
+		page.from?
+			m::index(std::nothrow, page.from):
+			0UL
+	};
+
+	const bool by_type
+	{
+		!empty(types) && page.dir == 'b' && (!page.from || from_idx)
+	};
+
+	type_cursor cursor
+	{
+		from_idx?
+			m::get(std::nothrow, from_idx, "depth", -1L):
+			std::numeric_limits<int64_t>::max(),
+
+		from_idx?
+			from_idx + 1:
+			0UL,
+	};
+
 	size_t hit{0}, miss{0};
 	m::room::events it
 	{
 		room
 	};
 
-	for(; it; page.dir == 'b'? --it : ++it)
+	// Events of a type excluded by the filter are skipped by the type alone
+	// so they are not fetched.
+	const auto excluded{[&not_types](const m::event::idx &event_idx)
+	{
+		return !empty(not_types) && m::query(std::nothrow, event_idx, "type", [&not_types]
+		(const string_view &type)
+		{
+			for(const json::string not_type : not_types)
+				if(type == not_type)
+					return true;
+
+			return false;
+		});
+	}};
+
+	// The events are fetched in batches sized for the remaining results
+	// (and the event after them, which provides the end token) so their
+	// queries are submitted to the database together.
+	bool more{false}, exhausted{false};
+	while((by_type? !exhausted : bool(it)) && !more)
 	{
-		const m::event &event
+		m::event::idx batch[fetch_batch_max];
+		size_t num(0);
+		const size_t want
 		{
-			*it
+			std::min(page.limit - hit + 1, fetch_batch_max)
 		};
 
-		end = event.event_id;
-		if(hit >= page.limit || miss >= size_t(max_filter_miss))
+		if(by_type)
+		{
+			num = _fetch_types(batch, want, room, types, cursor);
+			exhausted = num < want;
+		}
+		else for(; it && num < want && miss < size_t(max_filter_miss); page.dir == 'b'? --it : ++it)
+		{
+			if(excluded(it.event_idx()))
+			{
+				++miss;
+				continue;
+			}
+
+			batch[num++] = it.event_idx();
+		}
+
+		// Everything was skipped up to the limit of misses; the next page
+		// continues after them.
+		if(!num && it && !by_type)
+		{
+			end = m::event_id(std::nothrow, it.event_idx());
+			more = true;
 			break;
+		}
 
-		const bool ok
+		m::event::fetch::for_each({batch, num}, [&](const auto &event_idx, const auto &event)
 		{
-			(empty(filter_json) || match(filter, event))
-
-			&& visible(event, request.user_id)
-
-			&& _append(chunk, event, it.event_idx(), user_room, room_depth)
-		};
-
-		hit += ok;
-		miss += !ok;
+			end = event.event_id;
+			if(hit >= page.limit || miss >= size_t(max_filter_miss))
+			{
+				more = true;
+				return false;
+			}
+
+			const bool ok
+			{
+				(empty(filter_json) || match(filter, event))
+
+				&& visible(event, request.user_id)
+
+				&& _append(chunk, event, event_idx, user_room, room_depth)
+			};
+
+			hit += ok;
+			miss += !ok;
+			return true;
+		},
+		room.fopts?
+			*room.fopts:
+			m::event::fetch::default_opts);
 	}
 	chunk.~array();
 
-	if(it || page.dir == 'b')
+	more |= by_type? !exhausted : bool(it);
+	if(more || page.dir == 'b')
 		json::stack::member
 		{
 			top, "start", json::value{start}
 		};
 
-	if(it || page.dir != 'b')
+	if(more || page.dir != 'b')
 		json::stack::member
 		{
 			top, "end", json::value{end}
@@ -189,7 +297,20 @@ get__messages(client &client,
 	// this loop does not yet account for visibility and filters etc.
 	size_t postfetched(0);
 	const size_t postfetch_max(page.limit * float(postfetch_multiplier));
-	for(size_t i(0); i <= postfetch_max && it; ++i, page.dir == 'b'? --it : ++it)
+	if(by_type)
+	{
+		m::event::idx batch[fetch_batch_max];
+		const size_t num
+		{
+			!exhausted?
+				_fetch_types(batch, std::min(postfetch_max, fetch_batch_max), room, types, cursor):
+				0UL
+		};
+
+		for(size_t i(0); i < num; ++i)
+			postfetched += m::prefetch(batch[i]);
+	}
+	else for(size_t i(0); i <= postfetch_max && it; ++i, page.dir == 'b'? --it : ++it)
 	{
 		const auto &event_idx(it.event_idx());
 		postfetched += m::prefetch(event_idx);
@@ -214,6 +335,59 @@ get__messages(client &client,
 	return {};
 }
 
+/// Collects the next events of any of the types below the cursor, in order
+/// of descending depth, from the room's type index; the cursor is advanced
+/// past the events returned.
+size_t
+_fetch_types(m::event::idx *const &out,
+             const size_t &max,
+             const m::room &room,
+             const json::array &types,
+             type_cursor &cursor)
+{
+	// Each type's events in the index are ordered; the first max of each
+	// contain the first max of them all.
+	std::vector<type_cursor> found;
+	found.reserve(max * 2);
+	for(const json::string type : types)
+	{
+		size_t count(0);
+		const m::room::type events
+		{
+			room, type, { uint64_t(cursor.first), -1L }
+		};
+
+		events.for_each([&found, &count, &max, &cursor]
+		(const string_view &, const uint64_t &depth, const m::event::idx &event_idx)
+		{
+			const type_cursor pos
+			{
+				int64_t(depth), event_idx
+			};
+
+			if(pos >= cursor)
+				return true;
+
+			found.emplace_back(pos);
+			return ++count < max;
+		});
+	}
+
+	std::sort(begin(found), end(found), std::greater<type_cursor>{});
+	const size_t num
+	{
+		std::min(found.size(), max)
+	};
+
+	for(size_t i(0); i < num; ++i)
+		out[i] = found[i].second;
+
+	if(num)
+		cursor = found[num - 1];
+
+	return num;
+}
+
 bool
 _append(json::stack::array &chunk,
         const m::event &event,
@@ -94,13 +94,19 @@ get_rooms(client &client,
 m::resource::method
 method_get
 {
-	rooms_resource, "GET", get_rooms
+	rooms_resource, "GET", get_rooms,
+	{
+		method_get.READ_ONLY
+	}
 };
 
 m::resource::method
 method_get_unstable
 {
-	rooms_resource_unstable, "GET", get_rooms
+	rooms_resource_unstable, "GET", get_rooms,
+	{
+		method_get_unstable.READ_ONLY
+	}
 };
 
 m::resource::response
@@ -11,7 +11,7 @@
 namespace ircd::m::search
 {
 	static bool handle_result(result &, const query &);
-	static bool handle_content(result &, const query &, const json::object &);
+	static bool handle_match(result &, const query &, const event::idx &, const long &rank);
 	static bool query_all_rooms(result &, const query &);
 	static bool query_room(result &, const query &, const room::id &);
 	static bool query_rooms(result &, const query &);
@@ -87,6 +87,20 @@ ircd::m::search::search_post_handle(client &client,
 		request["search_categories"]
 	};
 
+	// Rejected here, before the response is started.
+	const json::array &keys
+	{
+		json::object{search_categories["room_events"]}["keys"]
+	};
+
+	for(const json::string key : keys)
+		if(!dbs::room_terms_key_mask(key))
+			throw m::UNSUPPORTED
+			{
+				"Searching the key '%s' is not supported.",
+				string_view{key},
+			};
+
 	resource::response::chunked response
 	{
 		client, http::OK
@@ -204,12 +218,19 @@ try
 		}
 	};
 
-	//TODO: XXX
-	json::stack::array
+	json::stack::array highlights
 	{
 		room_events_result, "highlights"
 	};
 
+	char highlight_buf[512];
+	dbs::room_terms_tokenize(highlight_buf, json::string{query.search_term}, [&highlights]
+	(const string_view &term)
+	{
+		highlights.append(json::value{term, json::STRING});
+		return true;
+	});
+
 	//TODO: XXX
 	json::stack::object
 	{
@@ -296,16 +317,10 @@ ircd::m::search::query_room(result &result,
 			string_view{room_id},
 		};
 
-	const m::room::content content
+	return m::search::for_each(query, room_id, [&result, &query]
+	(const event::idx &event_idx, const long &rank)
 	{
-		room
-	};
-
-	return content.for_each([&result, &query]
-	(const json::object &content, const auto &depth, const auto &event_idx)
-	{
-		result.event_idx = event_idx;
-		return handle_content(result, query, content);
+		return handle_match(result, query, event_idx, rank);
 	});
 }
 
@@ -319,18 +334,18 @@ ircd::m::search::query_all_rooms(result &result,
 			"You are not an operator."
 		};
 
-	return m::events::content::for_each([&result, &query]
-	(const auto &event_idx, const json::object &content)
+	return m::search::for_each(query, [&result, &query]
+	(const event::idx &event_idx, const long &rank)
 	{
-		result.event_idx = event_idx;
-		return handle_content(result, query, content);
+		return handle_match(result, query, event_idx, rank);
 	});
 }
 
 bool
-ircd::m::search::handle_content(result &result,
-                                const query &query,
-                                const json::object &content)
+ircd::m::search::handle_match(result &result,
+                              const query &query,
+                              const event::idx &event_idx,
+                              const long &rank)
 try
 {
 	if(result.skipped < query.batch)
@@ -339,23 +354,15 @@ try
 		return true;
 	}
 
-	const json::string body
-	{
-		content["body"]
-	};
-
-	const bool match
-	{
-		has(body, query.search_term)
-	};
-
+	result.event_idx = event_idx;
+	result.rank = rank;
 	const bool handled
 	{
-		match && handle_result(result, query)
+		handle_result(result, query)
 	};
 
 	result.checked += 1;
-	result.matched += match;
+	result.matched += 1;
 	result.count += handled;
 	return result.count < query.limit;
 }
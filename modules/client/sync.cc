@@ -9,11 +9,17 @@
 // full license for this software is available in the LICENSE file.
 
 
+namespace ircd::m::sync::cache
+{
+	struct entry;
+	using entry_ptr = std::shared_ptr<entry>;
+}
+
 namespace ircd::m::sync
 {
 	struct response;
 
-	static const_buffer flush(data &, resource::response::chunked &, const const_buffer &);
+	static const_buffer flush(data &, resource::response::chunked &, cache::entry *, const const_buffer &);
 	static bool empty_response(data &, const uint64_t &next_batch);
 	static bool linear_handle(data &);
 	static bool polylog_handle(data &);
@@ -40,11 +46,50 @@ namespace ircd::m::sync::longpoll
 	static void fini() noexcept;
 }
 
+namespace ircd::m::sync::cache
+{
+	static string_view make_key(const mutable_buffer &, const data &);
+	static entry_ptr acquire(const string_view &key, const system_point &timesout);
+	static void append(entry &, const const_buffer &);
+	static bool commit(entry &);
+	static void release(const entry_ptr &) noexcept;
+	static void expire();
+	static void handle_notify(const m::event &, m::vm::eval &);
+	static void fini() noexcept;
+
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> entries_max;
+	extern conf::item<size_t> entry_size_max;
+	extern conf::item<size_t> filter_size_max;
+	extern conf::item<seconds> ttl;
+	extern conf::item<size_t> lag_max;
+	extern m::hookfn<m::vm::eval &> notified;
+	extern std::map<std::string, entry_ptr, std::less<>> map;
+	extern ctx::dock dock;
+}
+
+/// A /sync response held for requests with an identical key. The entry is
+/// pending while its first request composes the response; the body is the
+/// serialized output flushed from that request's json::stack.
+struct ircd::m::sync::cache::entry
+{
+	std::string key;
+	std::string body;
+	event::idx next_batch {0};
+	event::idx retired {0};
+	system_point created;
+	size_t hits {0};
+	bool pending {true};
+	bool overflow {false};
+	bool released {false};
+};
+
 ircd::mapi::header
 IRCD_MODULE
 {
 	"Client 6.2.1 :Sync", nullptr, []
 	{
+		ircd::m::sync::cache::fini();
 		ircd::m::sync::longpoll::fini();
 	}
 };
@@ -175,7 +220,8 @@ ircd::m::sync::method_get
 {
 	resource, "GET", handle_get,
 	{
-		method_get.REQUIRES_AUTH,
+		method_get.REQUIRES_AUTH |
+		method_get.READ_ONLY,
 		-1s,
 	}
 };
@@ -287,6 +333,43 @@ ircd::m::sync::handle_get(client &client,
 		{ "Cache-Control", "no-cache" },
 	};
 
+	// Identical requests are satisfied from the response cache. This covers
+	// a client retrying a /sync whose response it never received and the
+	// concurrent connections of a device syncing the same token; the latter
+	// wait here for the first to finish composing.
+	char cache_key_buf[1_KiB];
+	const string_view cache_key
+	{
+		cache::enable && !paused && !invalid_since && !args.semaphore?
+			cache::make_key(cache_key_buf, data):
+			string_view{}
+	};
+
+	const cache::entry_ptr cached
+	{
+		cache_key?
+			cache::acquire(cache_key, args.timesout):
+			cache::entry_ptr{}
+	};
+
+	if(cached && !cached->pending)
+		return resource::response
+		{
+			client,
+			cached->body,
+			"application/json; charset=utf-8",
+			http::OK,
+			response_headers,
+		};
+
+	// When this request is composing the entry it is dropped from the cache
+	// unless a response is committed to it below.
+	const unwind release{[&cached]
+	{
+		if(cached && cached->pending)
+			cache::release(cached);
+	}};
+
 	// Start the chunked encoded response.
 	resource::response::chunked response
 	{
@@ -302,7 +385,7 @@ ircd::m::sync::handle_get(client &client,
 	json::stack out
 	{
 		response.buf,
-		std::bind(sync::flush, std::ref(data), std::ref(response), ph::_1),
+		std::bind(sync::flush, std::ref(data), std::ref(response), cached.get(), ph::_1),
 		size_t(flush_hiwat)
 	};
 	data.out = &out;
@@ -395,6 +478,13 @@ ircd::m::sync::handle_get(client &client,
 	if(!complete)
 		complete = longpoll_handle(data);
 
+	// Only a response carrying content is worth caching; an empty response
+	// is cheaper to recompose than to hold.
+	const bool composed
+	{
+		complete && !invalid_since && !paused
+	};
+
 	if(!complete || invalid_since || paused)
 		complete = empty_response(data, uint64_t
 		{
@@ -411,6 +501,12 @@ ircd::m::sync::handle_get(client &client,
 		});
 
 	assert(complete);
+	if(cached && composed)
+	{
+		out.flush(true);
+		cache::commit(*cached);
+	}
+
 	return std::move(response);
 }
 
@@ -472,6 +568,7 @@ ircd::m::sync::empty_response(data &data,
 ircd::const_buffer
 ircd::m::sync::flush(data &data,
                      resource::response::chunked &response,
+                     cache::entry *const cached,
                      const const_buffer &buffer)
 {
 	assert(size(buffer) <= size(response.buf));
@@ -481,6 +578,9 @@ ircd::m::sync::flush(data &data,
 	};
 
 	assert(size(wrote) <= size(buffer));
+	if(cached)
+		cache::append(*cached, wrote);
+
 	if(data.stats)
 	{
 		data.stats->flush_bytes += size(wrote);
@@ -490,6 +590,315 @@ ircd::m::sync::flush(data &data,
 	return wrote;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// cache
+//
+
+// Responses are cached by the request parameters which determine their
+// content: the user, device, filter and since token. A response holds the
+// events in [since, next_batch) and remains a valid answer for the same
+// request after more events arrive; those are delivered by the next /sync
+// starting at the response's next_batch. The vm notify hook limits how far
+// behind the server an entry may fall before it is recomposed.
+
+decltype(ircd::m::sync::cache::enable)
+ircd::m::sync::cache::enable
+{
+	{ "name",     "ircd.client.sync.cache.enable" },
+	{ "default",  true                            },
+};
+
+decltype(ircd::m::sync::cache::entries_max)
+ircd::m::sync::cache::entries_max
+{
+	{ "name",     "ircd.client.sync.cache.entries.max" },
+	{ "default",  256L                                 },
+};
+
+decltype(ircd::m::sync::cache::entry_size_max)
+ircd::m::sync::cache::entry_size_max
+{
+	{ "name",     "ircd.client.sync.cache.entry.size.max" },
+	{ "default",  long(1_MiB)                             },
+	{ "help",     "Responses larger than this are not cached" },
+};
+
+decltype(ircd::m::sync::cache::filter_size_max)
+ircd::m::sync::cache::filter_size_max
+{
+	{ "name",     "ircd.client.sync.cache.filter.size.max" },
+	{ "default",  256L                                     },
+	{ "help",     "Requests with a larger inline filter are not cached" },
+};
+
+decltype(ircd::m::sync::cache::ttl)
+ircd::m::sync::cache::ttl
+{
+	{ "name",     "ircd.client.sync.cache.ttl" },
+	{ "default",  30L                          },
+};
+
+decltype(ircd::m::sync::cache::lag_max)
+ircd::m::sync::cache::lag_max
+{
+	{ "name",     "ircd.client.sync.cache.lag.max" },
+	{ "default",  512L                             },
+	{ "help",     "Number of events retired past an entry before it expires" },
+};
+
+decltype(ircd::m::sync::cache::map)
+ircd::m::sync::cache::map;
+
+decltype(ircd::m::sync::cache::dock)
+ircd::m::sync::cache::dock;
+
+decltype(ircd::m::sync::cache::notified)
+ircd::m::sync::cache::notified
+{
+	handle_notify,
+	{
+		{ "_site",  "vm.notify" },
+	}
+};
+
+void
+ircd::m::sync::cache::fini()
+noexcept
+{
+	for(const auto &[key, entry] : map)
+		entry->released = true;
+
+	map.clear();
+	interrupt(dock);
+}
+
+void
+ircd::m::sync::cache::handle_notify(const m::event &event,
+                                    m::vm::eval &eval)
+{
+	assert(eval.opts);
+	if(!eval.opts->notify_clients)
+		return;
+
+	if(!map.empty())
+		expire();
+}
+
+/// Drops the composed entries which are older than the ttl or which were
+/// composed more than lag_max events behind the current sequence. Entries
+/// still being composed are left to their request.
+void
+ircd::m::sync::cache::expire()
+{
+	const auto now
+	{
+		ircd::now<system_point>()
+	};
+
+	const auto &retired
+	{
+		vm::sequence::retired
+	};
+
+	for(auto it(begin(map)); it != end(map); )
+	{
+		const auto &entry(*it->second);
+		const bool expired
+		{
+			!entry.pending &&
+			(
+				entry.created + seconds(ttl) < now ||
+				entry.retired + size_t(lag_max) < retired
+			)
+		};
+
+		it = expired?
+			map.erase(it):
+			std::next(it);
+	}
+}
+
+/// Finds the entry for the key. A composed entry is returned for the caller
+/// to respond with. If another request is composing the entry this waits for
+/// it until the timeout. Otherwise a pending entry is created for the caller
+/// to compose. Returns null when the response should not be cached at all.
+ircd::m::sync::cache::entry_ptr
+ircd::m::sync::cache::acquire(const string_view &key,
+                              const system_point &timesout)
+{
+	expire();
+	for(auto it(map.find(key)); it != end(map); it = map.find(key))
+	{
+		const entry_ptr entry
+		{
+			it->second
+		};
+
+		if(!entry->pending)
+		{
+			entry->hits++;
+			log::debug
+			{
+				log, "cache hit `%s' next_batch:%lu bytes:%zu hits:%zu",
+				key,
+				entry->next_batch,
+				size(entry->body),
+				entry->hits,
+			};
+
+			return entry;
+		}
+
+		// Released entries are removed from the map so the next iteration
+		// either finds a successor or creates one.
+		const bool ready
+		{
+			dock.wait_until(timesout, [&entry]
+			{
+				return !entry->pending || entry->released;
+			})
+		};
+
+		if(!ready)
+			return {};
+	}
+
+	if(map.size() >= size_t(entries_max))
+	{
+		const auto oldest
+		{
+			std::min_element(begin(map), end(map), []
+			(const auto &a, const auto &b)
+			{
+				return std::tie(a.second->pending, a.second->created)
+				< std::tie(b.second->pending, b.second->created);
+			})
+		};
+
+		if(oldest == end(map) || oldest->second->pending)
+			return {};
+
+		map.erase(oldest);
+	}
+
+	auto entry
+	{
+		std::make_shared<cache::entry>()
+	};
+
+	entry->key = std::string(key);
+	entry->retired = vm::sequence::retired;
+	entry->created = ircd::now<system_point>();
+	map.emplace(entry->key, entry);
+	return entry;
+}
+
+/// Called with the portion of the response flushed to the client. Once the
+/// body exceeds the size limit it is discarded and the entry won't commit.
+void
+ircd::m::sync::cache::append(entry &entry,
+                             const const_buffer &buf)
+{
+	if(entry.overflow)
+		return;
+
+	if(size(entry.body) + size(buf) > size_t(entry_size_max))
+	{
+		entry.overflow = true;
+		entry.body = {};
+		return;
+	}
+
+	entry.body.append(buffer::data(buf), size(buf));
+}
+
+/// Completes a pending entry with the response composed into its body and
+/// wakes any identical requests waiting on it.
+bool
+ircd::m::sync::cache::commit(entry &entry)
+{
+	assert(entry.pending);
+	if(entry.overflow || entry.released || entry.body.empty())
+		return false;
+
+	const json::object object
+	{
+		entry.body
+	};
+
+	const json::string next_batch
+	{
+		object.get("next_batch")
+	};
+
+	entry.next_batch = sequence(make_since(next_batch));
+	entry.pending = false;
+	dock.notify_all();
+	return true;
+}
+
+/// Removes an entry which won't be committed; waiting requests will then
+/// compose the response themselves.
+void
+ircd::m::sync::cache::release(const entry_ptr &entry)
+noexcept
+{
+	const auto it
+	{
+		map.find(entry->key)
+	};
+
+	if(it != end(map) && it->second == entry)
+		map.erase(it);
+
+	entry->released = true;
+	dock.notify_all();
+}
+
+ircd::string_view
+ircd::m::sync::cache::make_key(const mutable_buffer &buf,
+                               const data &data)
+{
+	assert(data.args);
+	const auto &args
+	{
+		*data.args
+	};
+
+	if(size(args.filter_id) > size_t(filter_size_max))
+		return {};
+
+	const auto &[token, snapshot, flags]
+	{
+		args.since
+	};
+
+	const string_view ret
+	{
+		fmt::sprintf
+		{
+			buf, "%s %s %s %ld_%lu_%s %lu %b%b%b",
+			string_view{data.user.user_id},
+			string_view{data.device_id},
+			args.filter_id,
+			int64_t(token),
+			snapshot,
+			flags,
+			args.next_batch,
+			args.full_state,
+			args.set_presence,
+			args.phased,
+		}
+	};
+
+	// A truncated key cannot be trusted to be unique.
+	if(size(ret) + 1 >= size(buf))
+		return {};
+
+	return ret;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // longpoll
@@ -503,17 +912,62 @@ namespace ircd::m::sync
 
 namespace ircd::m::sync::longpoll
 {
+	struct waiter;
+
 	static bool polled(data &, const args &);
-	static int poll(data &);
+	static bool polled_presence(data &, waiter &);
+	static int poll(data &, waiter &);
+	static size_t notify(const string_view &key, const event::idx &);
+	static size_t notify_presence(const string_view &key, const m::user::id &);
 	static void handle_notify(const m::event &, m::vm::eval &);
+	static void handle_presence(const m::event &);
 	static void fini() noexcept;
 
+	extern std::multimap<string_view, waiter *> index;
+	extern std::set<waiter *> waiters;
+	extern std::set<waiter *> deferred;
 	extern m::hookfn<m::vm::eval &> notified;
-	extern ctx::dock dock;
+	extern m::hookfn<> presence_notified;
 }
 
-decltype(ircd::m::sync::longpoll::dock)
-ircd::m::sync::longpoll::dock;
+/// A longpolling /sync. The waiter is indexed by the mxid of its user and the
+/// rooms where the user is joined or invited, including the user's own room.
+/// The notify hook records the index of each event concerning those keys and
+/// wakes only the waiters found under them.
+struct ircd::m::sync::longpoll::waiter
+{
+	sync::data &data;
+
+	/// Events with an index up to and including this value were retired
+	/// before the waiter entered the index; they are scanned in sequence.
+	event::idx horizon {0};
+
+	/// Indexes of events routed to this waiter which have yet to be polled.
+	std::set<event::idx> hits;
+
+	/// Users whose presence changed since entering the index. Presence
+	/// changes are not events; they are sent when no event is ready.
+	std::set<std::string, std::less<>> presence;
+
+	/// Owns the keys referenced by this waiter's entries in the index.
+	std::vector<std::string> keys;
+
+	ctx::dock dock;
+
+	waiter(sync::data &);
+	waiter(waiter &&) = delete;
+	waiter(const waiter &) = delete;
+	~waiter() noexcept;
+};
+
+decltype(ircd::m::sync::longpoll::index)
+ircd::m::sync::longpoll::index;
+
+decltype(ircd::m::sync::longpoll::waiters)
+ircd::m::sync::longpoll::waiters;
+
+decltype(ircd::m::sync::longpoll::deferred)
+ircd::m::sync::longpoll::deferred;
 
 decltype(ircd::m::sync::longpoll::notified)
 ircd::m::sync::longpoll::notified
@@ -524,18 +978,28 @@ ircd::m::sync::longpoll::notified
 	}
 };
 
+decltype(ircd::m::sync::longpoll::presence_notified)
+ircd::m::sync::longpoll::presence_notified
+{
+	handle_presence,
+	{
+		{ "_site",  "presence.changed" },
+	}
+};
+
 void
 ircd::m::sync::longpoll::fini()
 noexcept
 {
-	if(!dock.empty())
+	if(!waiters.empty())
 		log::warning
 		{
 			log, "Interrupting %zu longpolling clients...",
-			dock.size(),
+			waiters.size(),
 		};
 
-	interrupt(dock);
+	for(auto *const waiter : waiters)
+		interrupt(waiter->dock);
 }
 
 void
@@ -547,7 +1011,83 @@ try
 	if(!eval.opts->notify_clients)
 		return;
 
-	dock.notify_all();
+	const auto &event_idx
+	{
+		eval.sequence
+	};
+
+	if(unlikely(!event_idx))
+		return;
+
+	const auto &type
+	{
+		json::get<"type"_>(event)
+	};
+
+	size_t ret(0);
+	ret += notify(json::get<"room_id"_>(event), event_idx);
+
+	// Membership concerning a user in a room they're not yet indexed under.
+	if(type == "m.room.member")
+		ret += notify(json::get<"state_key"_>(event), event_idx);
+
+	// Ephemeral events are found in the user room of their sender but are
+	// synchronized to the members of the room they concern.
+	else if(type == "ircd.typing")
+		ret += notify(json::string(json::get<"content"_>(event).get("room_id")), event_idx);
+
+	else if(type == "ircd.read")
+		ret += notify(json::get<"state_key"_>(event), event_idx);
+
+	// Presence and device updates are synchronized to everyone sharing a
+	// joined room with the sender.
+	else if(type == "ircd.presence" || startswith(type, "ircd.device"))
+	{
+		const m::user::rooms rooms
+		{
+			m::user::id(json::get<"sender"_>(event))
+		};
+
+		rooms.for_each("join", [&ret, &event_idx]
+		(const m::room &room, const string_view &)
+		{
+			ret += notify(room.room_id, event_idx);
+		});
+	}
+
+	// A presence snapshot concerns everyone sharing a joined room with any of
+	// the users in it.
+	else if(type == "ircd.presence.snapshot")
+	{
+		const json::object &users
+		{
+			json::get<"content"_>(event).get("users")
+		};
+
+		for(const auto &[user_id, object] : users)
+		{
+			if(!valid(m::id::USER, user_id))
+				continue;
+
+			const m::user::rooms rooms
+			{
+				m::user::id(user_id)
+			};
+
+			rooms.for_each("join", [&ret, &event_idx]
+			(const m::room &room, const string_view &)
+			{
+				ret += notify(room.room_id, event_idx);
+			});
+		}
+	}
+
+	// Waiters holding hits which were not yet retired re-evaluate.
+	for(auto *const waiter : deferred)
+		waiter->dock.notify_all();
+
+	stats::longpoll_events += bool(ret);
+	stats::longpoll_notified += ret;
 }
 catch(const ctx::interrupted &)
 {
@@ -563,14 +1103,156 @@ catch(const std::exception &e)
 	};
 }
 
+/// A change of presence concerns everyone sharing a joined room with the
+/// user, and the user.
+void
+ircd::m::sync::longpoll::handle_presence(const m::event &event)
+try
+{
+	const m::user::id &user_id
+	{
+		at<"sender"_>(event)
+	};
+
+	size_t ret(0);
+	ret += notify_presence(user_id, user_id);
+
+	const m::user::rooms rooms
+	{
+		user_id
+	};
+
+	rooms.for_each("join", [&ret, &user_id]
+	(const m::room &room, const string_view &)
+	{
+		ret += notify_presence(room.room_id, user_id);
+	});
+
+	stats::longpoll_notified += ret;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "longpoll presence notify for %s :%s",
+		json::get<"sender"_>(event),
+		e.what(),
+	};
+}
+
+size_t
+ircd::m::sync::longpoll::notify_presence(const string_view &key,
+                                         const m::user::id &user_id)
+{
+	size_t ret(0);
+	const auto range
+	{
+		index.equal_range(key)
+	};
+
+	for(auto it(range.first); it != range.second; ++it)
+	{
+		auto &waiter(*it->second);
+		if(!waiter.presence.emplace(user_id).second)
+			continue;
+
+		waiter.dock.notify_all();
+		++ret;
+	}
+
+	return ret;
+}
+
+/// Records the event for every waiter under the key and wakes them. Returns
+/// the number of waiters which were notified.
+size_t
+ircd::m::sync::longpoll::notify(const string_view &key,
+                                const event::idx &event_idx)
+{
+	if(!key)
+		return 0;
+
+	size_t ret(0);
+	const auto range
+	{
+		index.equal_range(key)
+	};
+
+	for(auto it(range.first); it != range.second; ++it)
+	{
+		auto &waiter(*it->second);
+		if(!waiter.hits.emplace(event_idx).second)
+			continue;
+
+		waiter.dock.notify_all();
+		++ret;
+	}
+
+	return ret;
+}
+
+//
+// waiter::waiter
+//
+
+ircd::m::sync::longpoll::waiter::waiter(sync::data &data)
+:data{data}
+{
+	keys.emplace_back(data.user.user_id);
+	keys.emplace_back(data.user_room.room_id);
+	for(const auto &membership : {"join"_sv, "invite"_sv})
+		data.user_rooms.for_each(membership, [this]
+		(const m::room &room, const string_view &)
+		{
+			keys.emplace_back(room.room_id);
+		});
+
+	// Nothing here yields; no event is notified between sampling the
+	// horizon and entering the index.
+	horizon = vm::sequence::retired;
+	for(const auto &key : keys)
+		index.emplace(key, this);
+
+	waiters.emplace(this);
+	++stats::longpoll_waiting;
+	if(data.stats)
+		data.stats->longpoll_keys = keys.size();
+}
+
+ircd::m::sync::longpoll::waiter::~waiter()
+noexcept
+{
+	for(const auto &key : keys)
+	{
+		auto it(index.lower_bound(key));
+		while(it != end(index) && it->first == key)
+			it = it->second == this?
+				index.erase(it):
+				std::next(it);
+	}
+
+	deferred.erase(this);
+	waiters.erase(this);
+	--stats::longpoll_waiting;
+}
+
 /// Longpolling blocks the client's request until a relevant event is processed
 /// by the m::vm. If no event is processed by a timeout this returns false.
 bool
 ircd::m::sync::longpoll_handle(data &data)
 try
 {
+	longpoll::waiter waiter
+	{
+		data
+	};
+
 	int ret;
-	while((ret = longpoll::poll(data)) == -1)
+	while((ret = longpoll::poll(data, waiter)) == -1)
 	{
 		// When the client explicitly gives a next_batch token we have to
 		// adhere to it and return an empty response before going past their
@@ -610,10 +1292,12 @@ catch(const std::exception &e)
 	throw;
 }
 
-/// When the vm's sequence number is incremented our dock is notified and the
-/// event at that next sequence number is fetched. That event gets proffered
-/// around the linear sync handlers for whether it's relevant to the user
-/// making the request on this stack.
+/// The waiter is woken by the notify hook when an event concerning the user
+/// is processed by the vm. Events which were retired before the waiter was
+/// indexed are considered one at a time; after that the range skips directly
+/// to each event routed to the waiter. The event at that next sequence number
+/// is fetched and proffered around the linear sync handlers for whether it's
+/// relevant to the user making the request on this stack.
 ///
 /// If relevant, we respond immediately with that one event and finish the
 /// request right there, providing them the next since token of one-past the
@@ -621,8 +1305,8 @@ catch(const std::exception &e)
 ///
 /// If not relevant, we send nothing and continue checking events that come
 /// through until the timeout. This will be an empty response providing the
-/// client with the next since token of one past where we left off (vm's
-/// current sequence number) to start the next /sync.
+/// client with the next since token of one past where we left off to start
+/// the next /sync.
 ///
 /// @returns
 /// - true if a relevant event was hit and output to the client. If so, this
@@ -633,18 +1317,54 @@ catch(const std::exception &e)
 /// has been sent to the client yet here either.
 ///
 int
-ircd::m::sync::longpoll::poll(data &data)
+ircd::m::sync::longpoll::poll(data &data,
+                              waiter &waiter)
 {
-	const auto ready{[&data]
+	auto &hits
+	{
+		waiter.hits
+	};
+
+	// Discard hits already passed by the range.
+	hits.erase(begin(hits), hits.lower_bound(data.range.second));
+
+	const auto ready_events{[&data, &waiter, &hits]
 	{
 		assert(data.range.second <= m::vm::sequence::retired + 1);
-		return data.range.second <= m::vm::sequence::retired;
+		if(data.range.second <= waiter.horizon)
+			return true;
+
+		return !hits.empty() && *begin(hits) <= m::vm::sequence::retired;
+	}};
+
+	const auto ready{[&waiter, &ready_events]
+	{
+		return ready_events() || !waiter.presence.empty();
+	}};
+
+	// A hit for an event which is not yet retired is re-evaluated as other
+	// events are notified.
+	const bool defer
+	{
+		!hits.empty()
+	};
+
+	if(defer)
+		deferred.emplace(&waiter);
+
+	const unwind undefer{[&waiter, &defer]
+	{
+		if(defer)
+			deferred.erase(&waiter);
 	}};
 
 	assert(data.args);
-	if(!dock.wait_until(data.args->timesout, ready))
+	if(!waiter.dock.wait_until(data.args->timesout, ready))
 		return false;
 
+	if(data.stats)
+		data.stats->longpoll_wakes++;
+
 	// Check if client went away while we were sleeping,
 	// if so, just returning true is the easiest way out w/o throwing
 	assert(data.client && data.client->sock);
@@ -656,15 +1376,129 @@ ircd::m::sync::longpoll::poll(data &data)
 	const auto &client(*data.client);
 	net::check(*client.sock);
 
+	// Changes of presence are sent on their own when no event is ready.
+	if(!ready_events())
+	{
+		if(polled_presence(data, waiter))
+			return true;
+
+		return -1;
+	}
+
+	// Skip past the events which weren't routed to this waiter.
+	if(data.range.second > waiter.horizon)
+	{
+		assert(!hits.empty());
+		if(int64_t(data.args->next_batch) > 0 && *begin(hits) >= data.args->next_batch)
+			return false;
+
+		data.range.second = *begin(hits);
+		hits.erase(begin(hits));
+	}
+
 	// Keep in mind if the handler returns true that means
 	// it made a hit and we can return true to exit longpoll
 	// and end the request cleanly.
 	if(polled(data, *data.args))
 		return true;
 
+	if(data.stats)
+		data.stats->longpoll_misses++;
+
 	return -1;
 }
 
+/// Respond with the presence of the users which changed while waiting. The
+/// range is not advanced; the changes are not events in the sequence.
+bool
+ircd::m::sync::longpoll::polled_presence(data &data,
+                                         waiter &waiter)
+{
+	const auto users
+	{
+		std::move(waiter.presence)
+	};
+
+	waiter.presence.clear();
+
+	// In semaphore-mode the client wants an empty response for events.
+	assert(data.args);
+	if(data.args->semaphore)
+		return false;
+
+	json::stack::object top
+	{
+		*data.out
+	};
+
+	{
+		json::stack::object presence
+		{
+			top, "presence"
+		};
+
+		json::stack::array events
+		{
+			presence, "events"
+		};
+
+		for(const auto &user_id : users)
+			m::presence::get(std::nothrow, m::user::id(user_id), m::presence::closure_state{[&]
+			(const m::presence::state &state)
+			{
+				char buf[1_KiB];
+				const json::object content
+				{
+					m::presence::compose(buf, m::user::id(user_id), state)
+				};
+
+				json::stack::object object
+				{
+					events
+				};
+
+				json::stack::member
+				{
+					object, "sender", user_id
+				};
+
+				json::stack::member
+				{
+					object, "type", json::value{"m.presence"}
+				};
+
+				json::stack::member
+				{
+					object, "content", content
+				};
+			}});
+	}
+
+	const auto next
+	{
+		std::min(data.range.second, vm::sequence::retired + 1)
+	};
+
+	char since_buf[64];
+	json::stack::member
+	{
+		top, "next_batch", json::value
+		{
+			make_since(since_buf, next), json::STRING
+		}
+	};
+
+	log::debug
+	{
+		log, "request %s longpoll presence users:%zu complete @%lu",
+		loghead(data),
+		users.size(),
+		next
+	};
+
+	return true;
+}
+
 /// Evaluate the event indexed by data.range.second (the upper-bound). The
 /// sync system sees a data.range window of [since, U] where U is a counter
 /// that starts at the `vm::sequence::retired` event_idx
@@ -762,10 +1596,12 @@ ircd::m::sync::longpoll::polled(data &data,
 
 	log::debug
 	{
-		log, "request %s longpoll hit:%lu consumed:%zu complete @%lu",
+		log, "request %s longpoll hit:%lu consumed:%zu wakes:%zu misses:%zu complete @%lu",
 		loghead(data),
 		event.event_idx,
 		consumed,
+		data.stats? data.stats->longpoll_wakes: 0UL,
+		data.stats? data.stats->longpoll_misses: 0UL,
 		next
 	};
 
@@ -38,65 +38,76 @@ ircd::m::sync::presence_linear(data &data)
 
 	assert(data.event);
 	const m::event &event{*data.event};
-	if(json::get<"type"_>(event) != "ircd.presence")
+	const auto &type
+	{
+		json::get<"type"_>(event)
+	};
+
+	if(type != "ircd.presence.snapshot" && type != "ircd.presence")
 		return false;
 
 	if(!my_host(json::get<"origin"_>(event)))
 		return false;
 
-	const json::object &content
+	const m::user::mitsein mitsein
 	{
-		at<"content"_>(event)
+		data.user
 	};
 
-	const json::string &sender
+	std::optional<json::stack::object> presence;
+	std::optional<json::stack::array> array;
+	const auto append{[&data, &mitsein, &presence, &array]
+	(const string_view &sender, const json::object &content)
 	{
-		content["user_id"]
-	};
+		if(!valid(m::id::USER, sender))
+			return;
 
-	const m::user::mitsein mitsein
-	{
-		data.user
-	};
+		if(!mitsein.has(m::user::id(sender), "join"))
+			return;
 
-	assert(sender);
-	if(!mitsein.has(m::user::id(sender), "join"))
-		return false;
+		if(!presence)
+		{
+			presence.emplace(*data.out, "presence");
+			array.emplace(*data.out, "events");
+		}
 
-	json::stack::object presence
-	{
-		*data.out, "presence"
-	};
+		json::stack::object object
+		{
+			*data.out
+		};
 
-	json::stack::array array
-	{
-		*data.out, "events"
-	};
+		// sender
+		json::stack::member
+		{
+			*data.out, "sender", sender
+		};
 
-	json::stack::object object
-	{
-		*data.out
-	};
+		// type
+		json::stack::member
+		{
+			*data.out, "type", json::value{"m.presence"}
+		};
 
-	// sender
-	json::stack::member
-	{
-		*data.out, "sender", sender
-	};
+		// content
+		json::stack::member
+		{
+			*data.out, "content", content
+		};
+	}};
 
-	// type
-	json::stack::member
+	const json::object &content
 	{
-		*data.out, "type", json::value{"m.presence"}
+		at<"content"_>(event)
 	};
 
-	// content
-	json::stack::member
-	{
-		*data.out, "content", at<"content"_>(event)
-	};
+	// A snapshot carries the presence of several users.
+	if(type == "ircd.presence.snapshot")
+		for(const auto &[user_id, object] : json::object(content["users"]))
+			append(user_id, object);
+	else
+		append(json::string(content["user_id"]), content);
 
-	return true;
+	return bool(presence);
 }
 
 bool
@@ -108,36 +119,28 @@ ircd::m::sync::presence_polylog(data &data)
 	};
 
 	bool ret{false};
-	ctx::mutex mutex;
-	const auto append_event{[&data, &array, &mutex, &ret]
-	(const json::object &event)
+	const auto append_event{[&data, &array, &ret]
+	(const m::user::id &user_id, const m::presence::state &state)
 	{
 		// Conditions to not send; we don't send for offline users
 		// on initial sync, unless they have a message set.
 		const bool skip
 		{
 			data.range.first == 0
-			&& unquote(event.get("presence")) == "offline"
-			&& !event.has("status_msg")
+			&& state.presence == "offline"
+			&& state.status_msg.empty()
 		};
 
 		if(skip)
 			return;
 
-		const json::string &user_id
+		char buf[1_KiB];
+		const json::object content
 		{
-			event.get("user_id")
+			m::presence::compose(buf, user_id, state)
 		};
 
-		if(!valid(m::id::USER, user_id))
-			return;
-
-		// Lock the json::stack for the append operations. This mutex will only be
-		// contended during a json::stack flush to the client; not during database
-		// queries leading to this.
-		const std::lock_guard l{mutex};
 		ret = true;
-
 		json::stack::object object
 		{
 			array
@@ -158,39 +161,30 @@ ircd::m::sync::presence_polylog(data &data)
 		// content
 		json::stack::member
 		{
-			object, "content", event
+			object, "content", content
 		};
 	}};
 
-	// Setup for concurrentization.
-	static const size_t fibers(64);
-	sync::pool.min(fibers);
-	ctx::concurrent<std::string> concurrent
+	// Iterate all of the users visible to our user in joined rooms. Their
+	// presence is held in memory; the state is copied out before the append
+	// might yield to a flush.
+	const m::user::mitsein mitsein{data.user};
+	mitsein.for_each("join", [&data, &append_event]
+	(const m::user &user)
 	{
-		sync::pool, [&data, &append_event](std::string user_id)
+		m::presence::get(std::nothrow, user, m::presence::closure_state{[&data, &user, &append_event]
+		(const m::presence::state &state)
 		{
-			const event::idx event_idx
-			{
-				m::presence::get(std::nothrow, m::user::id{user_id})
-			};
-
-			if(!apropos(data, event_idx))
+			// The state is synchronized at the version; a state which is
+			// older than the since token was already sent.
+			if(!data.phased && state.version < data.range.first)
 				return;
 
-			m::get(std::nothrow, event_idx, "content", append_event);
-		}
-	};
+			append_event(user.user_id, state);
+		}});
 
-	// Iterate all of the users visible to our user in joined rooms.
-	const m::user::mitsein mitsein{data.user};
-	mitsein.for_each("join", [&concurrent]
-	(const m::user &user)
-	{
-		concurrent(std::string(user.user_id));
 		return true;
 	});
 
-	const ctx::uninterruptible ui;
-	concurrent.wait();
 	return ret;
 }
@@ -10,8 +10,6 @@
 
 namespace ircd::m::sync
 {
-	static long _notification_count(const room &, const event::idx &a, const event::idx &b);
-	static long _highlight_count(const room &, const user &u, const event::idx &a, const event::idx &b);
 	static bool room_unread_notifications_polylog(data &);
 	static bool room_unread_notifications_linear(data &);
 
@@ -102,18 +100,14 @@ ircd::m::sync::room_unread_notifications_linear(data &data)
 			if(json::get<"depth"_>(*data.event) + room::events::viewport_size < data.room_depth)
 				return false;
 
-	m::event::id::buf last_read;
-	if(likely(!is_self_read))
-		if(!m::receipt::get(last_read, room.room_id, data.user))
-			return false;
+	const m::user::notifications notifications
+	{
+		data.user
+	};
 
-	const auto start_idx
+	const auto counts
 	{
-		last_read?
-			index(last_read):
-		!is_self_read?
-			index(room):
-			0UL
+		notifications.unread(room.room_id)
 	};
 
 	json::stack::object rooms
@@ -136,23 +130,11 @@ ircd::m::sync::room_unread_notifications_linear(data &data)
 		*data.out, "unread_notifications"
 	};
 
-	const event::idx upper_bound
-	{
-		std::max(data.range.second, data.event_idx + 1)
-	};
-
-	const auto notification_count
-	{
-		start_idx && !is_self_read?
-			_notification_count(room, start_idx, upper_bound):
-			0L
-	};
-
 	json::stack::member
 	{
 		*data.out, "notification_count", json::value
 		{
-			notification_count
+			long(std::get<0>(counts))
 		}
 	};
 
@@ -160,9 +142,7 @@ ircd::m::sync::room_unread_notifications_linear(data &data)
 	{
 		*data.out, "highlight_count", json::value
 		{
-			notification_count?
-				_highlight_count(room, data.user, start_idx, upper_bound):
-				0L
+			long(std::get<1>(counts))
 		}
 	};
 
@@ -181,34 +161,26 @@ ircd::m::sync::room_unread_notifications_polylog(data &data)
 		*data.room
 	};
 
-	m::event::id::buf last_read_buf;
-	const auto last_read
+	const m::user::notifications notifications
 	{
-		m::receipt::get(last_read_buf, room.room_id, data.user)
+		data.user
 	};
 
-	const auto start_idx
+	// The counts are maintained as notifications and receipts are written;
+	// they are only sent when they changed within the range of this sync.
+	const auto &[notification_count, highlight_count, event_idx]
 	{
-		last_read?
-			index(last_read):
-		data.membership == "join"?
-			room::index(room):
-			0UL
+		notifications.unread(room.room_id)
 	};
 
-	if(!apropos(data, start_idx))
+	if(!apropos(data, event_idx))
 		return false;
 
-	const auto notification_count
-	{
-		_notification_count(room, start_idx, data.range.second)
-	};
-
 	json::stack::member
 	{
 		*data.out, "notification_count", json::value
 		{
-			notification_count
+			long(notification_count)
 		}
 	};
 
@@ -216,53 +188,9 @@ ircd::m::sync::room_unread_notifications_polylog(data &data)
 	{
 		*data.out, "highlight_count", json::value
 		{
-			notification_count?
-				_highlight_count(room, data.user, start_idx, data.range.second):
-				0L
+			long(highlight_count)
 		}
 	};
 
 	return true;
 }
-
-long
-ircd::m::sync::_notification_count(const room &room,
-                                   const event::idx &a,
-                                   const event::idx &b)
-{
-	const event::idx_range range
-	{
-		std::minmax(a, b)
-	};
-
-	return room::events::count(room, range);
-}
-
-long
-ircd::m::sync::_highlight_count(const room &room,
-                                const user &user,
-                                const event::idx &a,
-                                const event::idx &b)
-{
-	const event::idx_range range
-	{
-		std::minmax(a, b)
-	};
-
-	const user::notifications notifications
-	{
-		user
-	};
-
-	user::notifications::opts opts;
-	opts.room_id = room.room_id;
-	opts.only = "highlight";
-	opts.from = range.second;
-	opts.to = range.first;
-	const auto ret
-	{
-		notifications.count(opts)
-	};
-
-	return ret;
-}
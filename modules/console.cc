@@ -7892,6 +7892,22 @@ console_cmd__events__rebuild(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__events__auth__rebuild(opt &out, const string_view &line)
+{
+	const size_t added
+	{
+		m::room::auth::chain::rebuild()
+	};
+
+	out
+	<< "Placed "
+	<< added
+	<< " state events in the auth chain cover."
+	<< std::endl;
+	return true;
+}
+
 //
 // event
 //
@@ -12501,12 +12517,12 @@ console_cmd__user__presence__set(opt &out, const string_view &line)
 		param["status"]
 	};
 
-	const auto eid
+	const auto version
 	{
 		m::presence::set(user, state, status)
 	};
 
-	out << eid << std::endl;
+	out << version << std::endl;
 	return true;
 }
 
@@ -13188,6 +13204,22 @@ console_cmd__user__mitsein__count(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__user__mitsein__rebuild(opt &out, const string_view &line)
+{
+	const size_t rooms
+	{
+		m::user::mitsein::rebuild()
+	};
+
+	out
+	<< "Indexed the joined members of "
+	<< rooms
+	<< " rooms."
+	<< std::endl;
+	return true;
+}
+
 bool
 console_cmd__user__tokens(opt &out, const string_view &line)
 {
@@ -13970,6 +14002,59 @@ console_cmd__user__notifications(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__user__notifications__unread(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"user_id", "room_id"
+	}};
+
+	const m::user::id &user_id
+	{
+		param.at("user_id")
+	};
+
+	const m::room::id::buf room_id
+	{
+		m::room_id(param.at("room_id"))
+	};
+
+	const m::user::notifications notifications
+	{
+		user_id
+	};
+
+	const auto &[notification, highlight, event_idx]
+	{
+		notifications.unread(room_id)
+	};
+
+	out
+	<< "notification_count: " << notification << std::endl
+	<< "highlight_count:    " << highlight << std::endl
+	<< "event_idx:          " << event_idx << std::endl
+	;
+
+	return true;
+}
+
+bool
+console_cmd__user__notifications__rebuild(opt &out, const string_view &line)
+{
+	const size_t rooms
+	{
+		m::user::notifications::rebuild()
+	};
+
+	out
+	<< "Counted the unread notifications in "
+	<< rooms
+	<< " rooms."
+	<< std::endl;
+	return true;
+}
+
 //
 // users
 //
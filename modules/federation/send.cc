@@ -40,6 +40,13 @@ eval_max_per_node
 	{ "default",  4L                                       },
 };
 
+conf::item<size_t>
+eval_concurrency
+{
+	{ "name",     "ircd.federation.send.eval.concurrency" },
+	{ "default",  4L                                      },
+};
+
 conf::item<bool>
 fetch_state
 {
@@ -102,6 +109,7 @@ handle_pdus(client &client,
 	vmopts.phase.set(m::vm::phase::FETCH_PREV, bool(fetch_prev));
 	vmopts.phase.set(m::vm::phase::FETCH_STATE, bool(fetch_state));
 	vmopts.fetch_prev_wait_count = -1;
+	vmopts.concurrency = size_t(eval_concurrency);
 	m::vm::eval eval
 	{
 		pdus, vmopts
@@ -221,9 +229,12 @@ handle_put(client &client,
 			txn_id
 		};
 
+	// Transactions are counted rather than evals, because the pdus of one
+	// transaction may be evaluated by several evals concurrently.
 	size_t evals{0};
 	bool txn_in_progress{false};
-	m::vm::eval::for_each([&txn_id, &request, &evals, &txn_in_progress]
+	string_view txns[16];
+	m::vm::eval::for_each([&txn_id, &request, &evals, &txn_in_progress, &txns]
 	(const auto &eval)
 	{
 		assert(eval.opts);
@@ -238,8 +249,24 @@ handle_put(client &client,
 			eval.opts->txn_id == txn_id
 		};
 
-		evals += match_node;
+		const auto txns_end
+		{
+			txns + std::min(evals, std::size(txns))
+		};
+
+		const bool counted
+		{
+			std::find(txns, txns_end, eval.opts->txn_id) != txns_end
+		};
+
 		txn_in_progress |= match_txn;
+		if(!match_node || counted)
+			return true;
+
+		if(evals < std::size(txns))
+			txns[evals] = eval.opts->txn_id;
+
+		++evals;
 		return evals < size_t(eval_max_per_node);
 	});
 
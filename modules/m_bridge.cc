@@ -10,21 +10,85 @@
 
 namespace ircd::m::bridge
 {
-	static size_t make_txn(const config &, json::stack &, events::range &);
-	static event::idx worker_handle(const config &, const net::hostport &, const events::range &, window_buffer);
-	static void worker_loop(const config &, const rfc3986::uri &, const mutable_buffer &);
-	static void worker(std::string event, std::string event_id);
+	struct route;
+	struct matcher;
+	using mask = uint64_t;
+	using queue = std::deque<event::idx>;
+
+	static bool append(const route &, json::stack::array &, const event::idx &, const event &);
+	static size_t make_txn(const route &, const queue &, json::stack &, size_t &);
+	static size_t worker_handle(const route &, const queue &, const net::hostport &, window_buffer);
+	static void rescan(route &);
+	static void worker_loop(route &, const mutable_buffer &);
+	static void worker(route &);
+
+	static mask pick_alias(const room &);
+	static mask pick(const event &);
+	static mask pick(const event::idx &, const event &);
+	static void interest_member(const event::idx &, const event &);
+	static void interest_init();
+	static void router_handle(const events::range &);
+	static void router();
+
 	static void handle_event(const event &, vm::eval &);
 	static void fini();
 	static void init();
 
 	extern conf::item<bool> enable;
 	extern conf::item<seconds> timeout;
-	extern ctx::dock worker_dock;
-	extern std::vector<context> worker_context;
+	extern conf::item<size_t> queue_max;
+	extern const event::fetch::opts pick_fopts;
+	extern ctx::dock router_dock;
+	extern std::vector<std::unique_ptr<route>> routes;
+	extern std::map<std::string, mask, std::less<>> room_users;
+	extern std::map<std::string, mask, std::less<>> room_aliases;
+	extern matcher users, rooms, aliases;
+	extern context router_context;
 	extern hookfn<vm::eval &> notify_hook;
 }
 
+/// A configured bridge. The router appends the index of each event of
+/// interest to the queue; the worker takes everything queued at once into
+/// pending and sends it in transactions, so the router never sees a queue
+/// being sent.
+///
+/// When the queues are full the router stops queueing for the bridge and
+/// leaves the index of the first event it passed over in resume. The worker
+/// scans the sequence again from there once it has room, and hands back to
+/// the router at horizon when it catches up; no event is dropped.
+struct ircd::m::bridge::route
+{
+	std::string event_id;
+	std::string source;
+	bridge::config config;
+	rfc3986::uri uri;
+	size_t pos;
+	bridge::queue queue;
+	bridge::queue pending;
+	event::idx resume {0};
+	event::idx horizon {0};
+	ctx::dock dock;
+	context worker;
+
+	route(const event &, const bridge::config &);
+	route(route &&) = delete;
+	route(const route &) = delete;
+};
+
+/// The namespace expressions of every bridge together. These are globs with
+/// no compiled form; they are matched directly against each subject. Only
+/// duplicates are removed: an expression shared by several bridges is tested
+/// once per subject and carries the mask of the bridges it belongs to.
+struct ircd::m::bridge::matcher
+{
+	std::vector<std::pair<std::string, mask>> exprs;
+
+	mask operator()(const string_view &) const;
+
+	void add(const string_view &expr, const size_t &pos);
+	void add(const json::array &namespaces, const size_t &pos);
+};
+
 ircd::mapi::header
 IRCD_MODULE
 {
@@ -47,11 +111,48 @@ ircd::m::bridge::timeout
 	{ "default",   10L                          },
 };
 
-decltype(ircd::m::bridge::worker_dock)
-ircd::m::bridge::worker_dock;
+/// Events waiting for a bridge beyond this number are not queued, as when
+/// the bridge has been down for a long time; the bridge's worker finds them
+/// again by scanning the sequence once it has room.
+decltype(ircd::m::bridge::queue_max)
+ircd::m::bridge::queue_max
+{
+	{ "name",      "ircd.m.bridge.queue.max"  },
+	{ "default",   65536L                     },
+};
+
+decltype(ircd::m::bridge::pick_fopts)
+ircd::m::bridge::pick_fopts
+{
+	event::keys::include {"event_id", "room_id", "sender", "type", "state_key"}
+};
+
+decltype(ircd::m::bridge::router_dock)
+ircd::m::bridge::router_dock;
+
+decltype(ircd::m::bridge::routes)
+ircd::m::bridge::routes;
+
+/// Rooms with one of our joined members in the users namespace of a bridge.
+decltype(ircd::m::bridge::room_users)
+ircd::m::bridge::room_users;
+
+/// Rooms with one of our aliases in the aliases namespace of a bridge. This
+/// is filled as rooms are seen and invalidated by their alias events.
+decltype(ircd::m::bridge::room_aliases)
+ircd::m::bridge::room_aliases;
+
+decltype(ircd::m::bridge::users)
+ircd::m::bridge::users;
+
+decltype(ircd::m::bridge::rooms)
+ircd::m::bridge::rooms;
 
-decltype(ircd::m::bridge::worker_context)
-ircd::m::bridge::worker_context;
+decltype(ircd::m::bridge::aliases)
+ircd::m::bridge::aliases;
+
+decltype(ircd::m::bridge::router_context)
+ircd::m::bridge::router_context;
 
 decltype(ircd::m::bridge::notify_hook)
 ircd::m::bridge::notify_hook
@@ -73,7 +174,10 @@ try
 	if(!event.event_id)
 		return;
 
-	worker_dock.notify_all();
+	if(!router_context)
+		return;
+
+	router_dock.notify_all();
 }
 catch(const ctx::interrupted &)
 {
@@ -95,9 +199,27 @@ ircd::m::bridge::init()
 	if(!enable)
 		return;
 
+	// The primary sends the transactions; a replica replaying the same
+	// events would only send them again.
+	if(m::replica::is())
+		return;
+
 	config::for_each([]
 	(const event::idx &event_idx, const event &event, const config &config)
 	{
+		if(routes.size() >= sizeof(mask) * 8)
+		{
+			log::error
+			{
+				log, "Too many bridges; ignoring configuration for '%s' in %s by %s",
+				json::get<"id"_>(config),
+				json::get<"room_id"_>(event),
+				string_view{event.event_id},
+			};
+
+			return true;
+		}
+
 		log::debug
 		{
 			log, "Found configuration for '%s' in %s by %s",
@@ -106,55 +228,454 @@ ircd::m::bridge::init()
 			string_view{event.event_id},
 		};
 
-		worker_context.emplace_back(context
-		{
-			"m.bridge",
-			512_KiB,
-			context::POST,
-			std::bind(&bridge::worker, std::string(event.source), std::string(event.event_id)),
-		});
-
+		routes.emplace_back(std::make_unique<route>(event, config));
 		return true;
 	});
+
+	if(routes.empty())
+		return;
+
+	router_context = context
+	{
+		"m.bridge.router",
+		512_KiB,
+		context::POST,
+		router,
+	};
 }
 
 void
 ircd::m::bridge::fini()
 {
-	for(auto &worker : worker_context)
-		worker.terminate();
+	if(router_context)
+		router_context.terminate();
+
+	for(auto &route : routes)
+		route->worker.terminate();
 
-	if(!worker_context.empty())
+	if(!routes.empty())
 		log::debug
 		{
 			log, "Waiting for %zu bridge workers...",
-			worker_context.size(),
+			routes.size(),
+		};
+
+	if(router_context)
+		router_context.join();
+
+	for(auto &route : routes)
+		route->worker.join();
+
+	routes.clear();
+}
+
+//
+// route
+//
+
+ircd::m::bridge::route::route(const m::event &event,
+                              const bridge::config &config)
+:event_id
+{
+	event.event_id
+}
+,source
+{
+	json::get<"content"_>(event)
+}
+,config
+{
+	json::object{source}
+}
+,uri
+{
+	at<"url"_>(this->config)
+}
+,pos
+{
+	routes.size()
+}
+,worker
+{
+	"m.bridge",
+	512_KiB,
+	context::POST,
+	std::bind(&bridge::worker, std::ref(*this)),
+}
+{
+	const bridge::namespaces &namespaces
+	{
+		json::get<"namespaces"_>(this->config)
+	};
+
+	users.add(json::get<"users"_>(namespaces), pos);
+	rooms.add(json::get<"rooms"_>(namespaces), pos);
+	aliases.add(json::get<"aliases"_>(namespaces), pos);
+}
+
+//
+// matcher
+//
+
+void
+ircd::m::bridge::matcher::add(const json::array &namespaces,
+                              const size_t &pos)
+{
+	for(const json::object object : namespaces)
+	{
+		const bridge::namespace_ ns
+		{
+			object
+		};
+
+		add(json::get<"regex"_>(ns), pos);
+	}
+}
+
+void
+ircd::m::bridge::matcher::add(const string_view &expr,
+                              const size_t &pos)
+{
+	assert(pos < sizeof(mask) * 8);
+	auto it
+	{
+		std::find_if(begin(exprs), end(exprs), [&expr]
+		(const auto &pair)
+		{
+			return pair.first == expr;
+		})
+	};
+
+	if(it == end(exprs))
+		it = exprs.emplace(end(exprs), std::string{expr}, 0UL);
+
+	it->second |= (1UL << pos);
+}
+
+ircd::m::bridge::mask
+ircd::m::bridge::matcher::operator()(const string_view &subject)
+const
+{
+	mask ret(0);
+	for(const auto &[expr, bridges] : exprs)
+	{
+		// Skip the expression when all of its bridges already matched.
+		if((bridges & ret) == bridges)
+			continue;
+
+		const globular_imatch match
+		{
+			expr
 		};
 
-	for(auto &worker : worker_context)
-		worker.join();
+		if(match(subject))
+			ret |= bridges;
+	}
+
+	return ret;
 }
 
+//
+// router
+//
+
 void
-ircd::m::bridge::worker(const std::string event_,
-                        const std::string event_id)
+ircd::m::bridge::router()
 try
 {
-	const m::event event
+	interest_init();
+
+	auto since {vm::sequence::retired}; do
+	{
+		router_dock.wait([&since]
+		{
+			return since < vm::sequence::retired;
+		});
+
+		const events::range range
+		{
+			since + 1, vm::sequence::retired + 1
+		};
+
+		router_handle(range);
+		since = range.second - 1;
+	}
+	while(run::level == run::level::RUN);
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Router unhandled :%s",
+		e.what(),
+	};
+}
+
+void
+ircd::m::bridge::router_handle(const events::range &range_)
+{
+	const events::range range
+	{
+		range_.first, range_.second, &pick_fopts
+	};
+
+	m::events::for_each(range, [](const event::idx &event_idx, const event &event)
+	{
+		const mask picked
+		{
+			pick(event_idx, event)
+		};
+
+		for(size_t i(0); i < routes.size(); ++i)
+		{
+			if(!(picked & (1UL << i)))
+				continue;
+
+			auto &route(*routes[i]);
+
+			// The worker already scanned this event for the bridge.
+			if(event_idx < route.horizon)
+				continue;
+
+			// The worker will find this event when it scans from resume.
+			if(route.resume)
+				continue;
+
+			if(unlikely(route.queue.size() + route.pending.size() >= size_t(queue_max)))
+			{
+				log::dwarning
+				{
+					log, "[%s] queue full; events from idx:%lu are scanned again later",
+					json::get<"id"_>(route.config),
+					event_idx,
+				};
+
+				route.resume = event_idx;
+				route.dock.notify_all();
+				continue;
+			}
+
+			route.queue.emplace_back(event_idx);
+			route.dock.notify_all();
+		}
+
+		return true;
+	});
+}
+
+ircd::m::bridge::mask
+ircd::m::bridge::pick(const event::idx &event_idx,
+                      const event &event)
+{
+	const room::id &room_id
 	{
-		json::object{event_}, event_id
+		json::get<"room_id"_>(event)
+	};
+
+	if(!room_id || internal(room_id))
+		return 0;
+
+	// Membership changes of our users update the interest before the event
+	// itself is considered.
+	if(json::get<"type"_>(event) == "m.room.member")
+		interest_member(event_idx, event);
+
+	// Alias changes invalidate the cached alias interest of the room.
+	const bool aliasing
+	{
+		json::get<"type"_>(event) == "m.room.aliases" ||
+		json::get<"type"_>(event) == "m.room.canonical_alias"
+	};
+
+	const auto ait
+	{
+		aliasing?
+			room_aliases.find(string_view{room_id}):
+			end(room_aliases)
+	};
+
+	if(ait != end(room_aliases))
+		room_aliases.erase(ait);
+
+	return pick(event);
+}
+
+/// The bridges interested in the event by the interest as it is now; this
+/// has no effect on the interest and is safe for events seen before.
+ircd::m::bridge::mask
+ircd::m::bridge::pick(const event &event)
+{
+	const room::id &room_id
+	{
+		json::get<"room_id"_>(event)
+	};
+
+	if(!room_id || internal(room_id))
+		return 0;
+
+	const mask all
+	{
+		routes.size() < sizeof(mask) * 8?
+			(1UL << routes.size()) - 1:
+			~0UL
+	};
+
+	mask ret(0);
+
+	// Bridged user is the sender
+	ret |= users(json::get<"sender"_>(event));
+
+	// Bridged user is target of a membership state transition
+	if(json::get<"type"_>(event) == "m.room.member")
+		ret |= users(json::get<"state_key"_>(event));
+
+	// Bridged user is in the room.
+	const auto it(room_users.find(string_view{room_id}));
+	if(it != end(room_users))
+		ret |= it->second;
+
+	if(ret != all)
+		ret |= rooms(room_id);
+
+	if(ret != all && !aliases.exprs.empty())
+		ret |= pick_alias(room_id);
+
+	return ret;
+}
+
+ircd::m::bridge::mask
+ircd::m::bridge::pick_alias(const room &room)
+{
+	const string_view &room_id
+	{
+		room.room_id
+	};
+
+	auto it
+	{
+		room_aliases.lower_bound(room_id)
 	};
 
-	const bridge::config config
+	if(it != end(room_aliases) && it->first == room_id)
+		return it->second;
+
+	mask ret(0);
+	const m::room::aliases room_aliases_
 	{
-		json::get<"content"_>(event)
+		room
 	};
 
-	const rfc3986::uri uri
+	room_aliases_.for_each(my_host(), [&ret](const room::alias &alias)
 	{
-		at<"url"_>(config)
+		ret |= aliases(alias);
+		return true;
+	});
+
+	room_aliases.emplace_hint(it, std::string(room_id), ret);
+	return ret;
+}
+
+void
+ircd::m::bridge::interest_member(const event::idx &event_idx,
+                                 const event &event)
+{
+	const m::user::id &user_id
+	{
+		json::get<"state_key"_>(event)
 	};
 
+	if(!my(user_id) || !users(user_id))
+		return;
+
+	const room::id &room_id
+	{
+		json::get<"room_id"_>(event)
+	};
+
+	char buf[32];
+	if(m::membership(buf, event_idx) == "join")
+	{
+		room_users[std::string(room_id)] |= users(user_id);
+		return;
+	}
+
+	// Recompute the room from its remaining members.
+	mask ret(0);
+	const room::members members
+	{
+		room_id
+	};
+
+	members.for_each("join", my_host(), [&ret](const id::user &member)
+	{
+		ret |= users(member);
+		return true;
+	});
+
+	const auto it
+	{
+		room_users.find(string_view{room_id})
+	};
+
+	if(ret)
+		room_users[std::string(room_id)] = ret;
+	else if(it != end(room_users))
+		room_users.erase(it);
+}
+
+void
+ircd::m::bridge::interest_init()
+{
+	if(users.exprs.empty())
+		return;
+
+	m::users::opts opts;
+	opts.hostpart = my_host();
+	m::users::for_each(opts, [](const m::user &user)
+	{
+		const mask picked
+		{
+			users(user.user_id)
+		};
+
+		if(!picked)
+			return true;
+
+		const m::user::rooms user_rooms
+		{
+			user
+		};
+
+		user_rooms.for_each("join", [&picked]
+		(const m::room &room, const string_view &)
+		{
+			room_users[std::string(room.room_id)] |= picked;
+		});
+
+		return true;
+	});
+
+	log::debug
+	{
+		log, "Bridged users are joined to %zu rooms.",
+		room_users.size(),
+	};
+}
+
+//
+// worker
+//
+
+void
+ircd::m::bridge::worker(route &route)
+try
+{
+	const auto &config(route.config);
+	const auto &uri(route.uri);
 	const unique_mutable_buffer buf
 	{
 		event::MAX_SIZE * 8
@@ -165,7 +686,7 @@ try
 		log, "Bridging to '%s' via %s by %s",
 		json::get<"id"_>(config),
 		uri.remote,
-		event_id,
+		route.event_id,
 	};
 
 	run::barrier<ctx::interrupted> {};
@@ -183,7 +704,7 @@ try
 			server::errmsg(uri.remote),
 		};
 
-	worker_loop(config, uri, buf);
+	worker_loop(route, buf);
 }
 catch(const ctx::interrupted &)
 {
@@ -199,23 +720,36 @@ catch(const std::exception &e)
 }
 
 void
-ircd::m::bridge::worker_loop(const config &config,
-                             const rfc3986::uri &uri,
+ircd::m::bridge::worker_loop(route &route,
                              const mutable_buffer &buf)
 try
 {
+	const auto &config(route.config);
+	const auto &uri(route.uri);
 	const net::hostport target
 	{
 		uri.remote
 	};
 
-	auto since {vm::sequence::retired}; do
-    {
-		worker_dock.wait([&since]
+	auto &pending(route.pending); do
+	{
+		route.dock.wait([&route, &pending]
 		{
-			return since < vm::sequence::retired;
+			return !route.queue.empty() || !pending.empty() || route.resume;
 		});
 
+		// Take everything the router queued so far behind what remains from
+		// any prior attempt.
+		std::move(begin(route.queue), end(route.queue), std::back_inserter(pending));
+		route.queue.clear();
+
+		// Find the events the router passed over while the queue was full.
+		if(route.resume)
+			rescan(route);
+
+		if(pending.empty())
+			continue;
+
 		// Wait here if the bridge is down.
 		while(unlikely(server::errant(target)))
 		{
@@ -231,21 +765,20 @@ try
 			continue;
 		}
 
-		const events::range range
+		const size_t handled
 		{
-			since, vm::sequence::retired + 1
+			worker_handle(route, pending, target, buf)
 		};
 
-		since = worker_handle(config, target, range, buf);
-		assert(since >= range.first);
-		assert(since <= range.second);
-
-		// Prevent spin for retrying the same range on handled exception.
-		if(unlikely(since == range.first))
+		// Prevent spin for retrying the same events on handled exception.
+		if(unlikely(!handled))
 		{
 			sleep(15s);
 			continue;
 		}
+
+		assert(handled <= pending.size());
+		pending.erase(begin(pending), begin(pending) + handled);
 	}
 	while(run::level == run::level::RUN);
 }
@@ -262,16 +795,75 @@ catch(const std::exception &e)
 	};
 }
 
-ircd::m::event::idx
-ircd::m::bridge::worker_handle(const config &config,
+/// Appends the events of interest from the resume point to pending until it
+/// is full. Once the scan reaches the end of the sequence the router takes
+/// over again from the horizon.
+void
+ircd::m::bridge::rescan(route &route)
+{
+	auto &pending(route.pending);
+	while(route.resume && pending.size() < size_t(queue_max))
+	{
+		const event::idx upper
+		{
+			vm::sequence::retired + 1
+		};
+
+		// Nothing yields from this check until the router sees the reset.
+		if(route.resume >= upper)
+		{
+			log::debug
+			{
+				log, "[%s] rescan caught up at idx:%lu pending:%zu",
+				json::get<"id"_>(route.config),
+				upper,
+				pending.size(),
+			};
+
+			route.horizon = upper;
+			route.resume = 0;
+			break;
+		}
+
+		const events::range range
+		{
+			route.resume, upper, &pick_fopts
+		};
+
+		bool full(false);
+		m::events::for_each(range, [&route, &pending, &full]
+		(const event::idx &event_idx, const event &event)
+		{
+			if(pick(event) & (1UL << route.pos))
+				pending.emplace_back(event_idx);
+
+			route.resume = event_idx + 1;
+			full = pending.size() >= size_t(queue_max);
+			return !full;
+		});
+
+		if(!full)
+			route.resume = std::max(route.resume, upper);
+	}
+}
+
+/// Sends a transaction of the events at the front of the pending queue.
+/// Returns the number of pending events it covered, or zero on failure.
+size_t
+ircd::m::bridge::worker_handle(const route &route,
+                               const queue &pending,
                                const net::hostport &target,
-                               const events::range &range_,
                                window_buffer buf)
 try
 {
-	size_t count {0};
-	auto range {range_};
-	buf([&config, &count, &range]
+	const auto &config(route.config);
+	const event::idx first
+	{
+		pending.front()
+	};
+
+	size_t count {0}, handled {0};
+	buf([&route, &pending, &count, &handled]
 	(const mutable_buffer &buf)
 	{
 		json::stack out
@@ -279,12 +871,12 @@ try
 			buf
 		};
 
-		count += make_txn(config, out, range);
+		count += make_txn(route, pending, out, handled);
 		return out.completed();
 	});
 
 	if(!count)
-		return range.second;
+		return handled;
 
 	const json::object content
 	{
@@ -302,18 +894,16 @@ try
 	{
 		make_uri(uribuf, config, fmt::sprintf
 		{
-			txnidbuf, "transactions/%lu", range.first,
+			txnidbuf, "transactions/%lu", first,
 		})
 	};
 
 	log::debug
 	{
-		log, "[%s] PUT txn:%lu:%lu (%lu:%lu) events:%zu",
+		log, "[%s] PUT txn:%lu pending:%zu events:%zu",
 		json::get<"id"_>(config),
-		range.first,
-		range.second,
-		range_.first,
-		range_.second,
+		first,
+		pending.size(),
 		count,
 	};
 
@@ -354,18 +944,15 @@ try
 	log::logf
 	{
 		log, log::level::DEBUG,
-		"[%s] %u txn:%lu:%lu (%lu:%lu) events:%zu :%s",
+		"[%s] %u txn:%lu events:%zu :%s",
 		json::get<"id"_>(config),
 		uint(code),
-		range.first,
-		range.second,
-		range_.first,
-		range_.second,
+		first,
 		count,
 		http::status(code),
 	};
 
-	return range.second + 1;
+	return handled;
 }
 catch(const ctx::interrupted &)
 {
@@ -375,30 +962,20 @@ catch(const std::exception &e)
 {
 	log::error
 	{
-		log, "worker handle range:%lu:%lu :%s",
-		range_.first,
-		range_.second,
+		log, "[%s] worker handle txn:%lu :%s",
+		json::get<"id"_>(route.config),
+		pending.front(),
 		e.what(),
 	};
 
-	return range_.first;
-}
-
-namespace ircd::m::bridge
-{
-	static bool pick_alias(const config &, const event::idx &, const event &, const json::array &, const m::room::alias &);
-	static bool pick_alias(const config &, const event::idx &, const event &, const room &, const json::array &);
-	static bool pick_room(const config &, const event::idx &, const event &, const room &, const json::array &);
-	static bool pick_user(const config &, const event::idx &, const event &, const json::array &, const m::user::id &);
-	static bool pick_user(const config &, const event::idx &, const event &, const room &, const json::array &);
-	static bool pick(const config &, const event::idx &, const event &);
-	static bool append(const config &, json::stack::array &, events::range &, size_t &, const event::idx &, const event &);
+	return 0;
 }
 
 size_t
-ircd::m::bridge::make_txn(const config &config,
+ircd::m::bridge::make_txn(const route &route,
+                          const queue &pending,
                           json::stack &out,
-                          events::range &range)
+                          size_t &handled)
 {
 	json::stack::object top
 	{
@@ -411,26 +988,24 @@ ircd::m::bridge::make_txn(const config &config,
 	};
 
 	size_t count {0};
-	m::events::for_each(m::events::range{range}, [&]
-	(const event::idx &event_idx, const event &event)
+	m::event::fetch event;
+	for(const auto &event_idx : pending)
 	{
-		if(!pick(config, event_idx, event))
-			return true;
-
-		if(!append(config, events, range, count, event_idx, event))
-			return false;
+		++handled;
+		if(!seek(std::nothrow, event, event_idx))
+			continue;
 
-		return true;
-	});
+		++count;
+		if(!append(route, events, event_idx, event))
+			break;
+	}
 
 	return count;
 }
 
 bool
-ircd::m::bridge::append(const config &config,
+ircd::m::bridge::append(const route &route,
                         json::stack::array &events,
-                        events::range &range,
-                        size_t &count,
                         const event::idx &event_idx,
                         const event &event)
 {
@@ -446,19 +1021,14 @@ ircd::m::bridge::append(const config &config,
 
 	log::debug
 	{
-		log, "[%s] ADD %s in %s idx:%lu txn:%lu:%lu events:%zu buffer:%zu",
-		json::get<"id"_>(config),
+		log, "[%s] ADD %s in %s idx:%lu buffer:%zu",
+		json::get<"id"_>(route.config),
 		string_view{event.event_id},
 		json::get<"room_id"_>(event),
 		event_idx,
-		range.first,
-		range.second,
-		count,
 		events.s->remaining(),
 	};
 
-	++count;
-	range.second = event_idx;
 	const bool sufficient_buffer
 	{
 		events.s->remaining() > event::MAX_SIZE + 16_KiB
@@ -466,169 +1036,3 @@ ircd::m::bridge::append(const config &config,
 
 	return sufficient_buffer;
 }
-
-bool
-ircd::m::bridge::pick(const config &config,
-                      const event::idx &event_idx,
-                      const event &event)
-{
-	const room room
-	{
-		json::get<"room_id"_>(event)
-	};
-
-	if(internal(room))
-		return false;
-
-	const bridge::namespaces &namespaces
-	{
-		json::get<"namespaces"_>(config)
-	};
-
-	return false
-	|| pick_user(config, event_idx, event, room, json::get<"users"_>(namespaces))
-	|| pick_room(config, event_idx, event, room, json::get<"rooms"_>(namespaces))
-	|| pick_alias(config, event_idx, event, room, json::get<"aliases"_>(namespaces))
-	;
-}
-
-bool
-ircd::m::bridge::pick_user(const config &config,
-                           const event::idx &event_idx,
-                           const event &event,
-                           const room &room,
-                           const json::array &namespaces)
-{
-	const m::user::id &sender
-	{
-		json::get<"sender"_>(event)
-	};
-
-	// Bridged user is the sender
-	if(pick_user(config, event_idx, event, namespaces, sender))
-		return true;
-
-	// Bridged user is target of a membership state transition
-	if(json::get<"type"_>(event) == "m.room.member")
-	{
-		// event::conforms ensures this is always a valid user_id
-		const user::id &state_key
-		{
-			json::get<"state_key"_>(event)
-		};
-
-		if(pick_user(config, event_idx, event, namespaces, state_key))
-			return true;
-	}
-
-	const room::members members
-	{
-		room
-	};
-
-	// Bridged user is in the room.
-	return true
-	&& !namespaces.empty() // avoid this query io if there's nothing to match.
-	&& !members.for_each("join", my_host(), [&](const id::user &user_id)
-	{
-		return !pick_user(config, event_idx, event, namespaces, user_id);
-	});
-}
-
-bool
-ircd::m::bridge::pick_user(const config &config,
-                           const event::idx &event_idx,
-                           const event &event,
-                           const json::array &namespaces,
-                           const user::id &user_id)
-{
-	for(const json::object object : namespaces)
-	{
-		const bridge::namespace_ ns
-		{
-			object
-		};
-
-		const globular_imatch match
-		{
-			json::get<"regex"_>(ns)
-		};
-
-		if(match(user_id))
-			return true;
-	}
-
-	return false;
-}
-
-bool
-ircd::m::bridge::pick_room(const config &config,
-                           const event::idx &event_idx,
-                           const event &event,
-                           const room &room,
-                           const json::array &namespaces)
-{
-	for(const json::object object : namespaces)
-	{
-		const bridge::namespace_ ns
-		{
-			object
-		};
-
-		const globular_imatch match
-		{
-			json::get<"regex"_>(ns)
-		};
-
-		if(match(room.room_id))
-			return true;
-	}
-
-	return false;
-}
-
-bool
-ircd::m::bridge::pick_alias(const config &config,
-                            const event::idx &event_idx,
-                            const event &event,
-                            const room &room,
-                            const json::array &namespaces)
-{
-	const m::room::aliases aliases
-	{
-		room
-	};
-
-	return true
-	&& !namespaces.empty()
-	&& !aliases.for_each(my_host(), [&](const room::alias &alias)
-	{
-		return !pick_alias(config, event_idx, event, namespaces, alias);
-	});
-}
-
-bool
-ircd::m::bridge::pick_alias(const config &config,
-                            const event::idx &event_idx,
-                            const event &event,
-                            const json::array &namespaces,
-                            const m::room::alias &room_alias)
-{
-	for(const json::object object : namespaces)
-	{
-		const bridge::namespace_ ns
-		{
-			object
-		};
-
-		const globular_imatch match
-		{
-			json::get<"regex"_>(ns)
-		};
-
-		if(match(room_alias))
-			return true;
-	}
-
-	return false;
-}
@@ -333,6 +333,19 @@ try
 			"A listener with the name '%s' is already loaded", name
 		};
 
+	// A replica only shares the listeners marked for it; the others belong
+	// to the primary (e.g. the one replicas forward requests to).
+	if(m::replica::is() && !opts.get<bool>("replica", false))
+	{
+		log::dwarning
+		{
+			"Listener '%s' is not for replicas; skipped.",
+			name,
+		};
+
+		return false;
+	}
+
 	listeners.emplace_back(name, opts, client::create, _listener_proffer);
 
 	if(ircd::run::level == ircd::run::level::RUN)
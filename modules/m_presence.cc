@@ -10,7 +10,7 @@
 
 using namespace ircd;
 
-static void handle_ircd_presence(const m::event &, m::vm::eval &);
+static void handle_presence_changed(const m::event &);
 static void handle_edu_m_presence_object(const m::event &, const m::presence &edu);
 static void handle_edu_m_presence(const m::event &, m::vm::eval &);
 
@@ -56,7 +56,7 @@ presence_log
 };
 
 /// This hook processes incoming m.presence events from the federation and
-/// turns them into ircd.presence events in the user's room.
+/// sets them in the presence table.
 const m::hookfn<m::vm::eval &>
 _m_presence_eval
 {
@@ -129,27 +129,11 @@ try
 
 	bool useful{true};
 	const auto closure{[&event, &object, &useful]
-	(const m::event &existing_event)
+	(const m::presence::state &existing)
 	{
-		const json::object &existing_object
-		{
-			json::get<"content"_>(existing_event)
-		};
-
-		// This check shouldn't have to exist. I think this was a result of corrupting
-		// my DB during development and it fails on only one user. Nevertheless, it's
-		// a valid assertion so might as well keep it.
-		if(unlikely(json::get<"user_id"_>(object) != unquote(existing_object.get("user_id"))))
-		{
-			//log::critical("%s != %s", json::get<"user_id"_>(object), unquote(existing_object.get("user_id")));
-			return;
-		}
-
-		assert(json::get<"user_id"_>(object) == unquote(existing_object.get("user_id")));
-
-		const auto &prev_active_ago
+		const time_t &prev_active_absolute
 		{
-			existing_object.get<time_t>("last_active_ago")
+			existing.last_active
 		};
 
 		const time_t &now_active_ago
@@ -157,11 +141,6 @@ try
 			json::get<"last_active_ago"_>(object)
 		};
 
-		const time_t &prev_active_absolute
-		{
-			json::get<"origin_server_ts"_>(existing_event) - prev_active_ago
-		};
-
 		const time_t &now_active_absolute
 		{
 			json::get<"origin_server_ts"_>(event) - now_active_ago
@@ -169,7 +148,7 @@ try
 
 		const time_t ts_diff
 		{
-			ircd::time<milliseconds>() - json::get<"origin_server_ts"_>(existing_event)
+			ircd::time<milliseconds>() - existing.updated
 		};
 
 		// Ignore any spam on a per-user basis here.
@@ -181,10 +160,10 @@ try
 		else if(now_active_absolute < prev_active_absolute)
 			useful = false;
 
-		else if(json::get<"presence"_>(object) != unquote(existing_object.get("presence")))
+		else if(json::get<"presence"_>(object) != existing.presence)
 			useful = true;
 
-		else if(json::get<"currently_active"_>(object) != existing_object.get<bool>("currently_active"))
+		else if(json::get<"currently_active"_>(object) != existing.currently_active)
 			useful = true;
 
 		else if(json::get<"currently_active"_>(object))
@@ -194,12 +173,7 @@ try
 			useful = false;
 	}};
 
-	static const m::event::fetch::opts fopts
-	{
-		m::event::keys::include {"content", "origin_server_ts"}
-	};
-
-	m::presence::get(std::nothrow, user_id, closure, &fopts);
+	m::presence::get(std::nothrow, user_id, m::presence::closure_state{closure});
 
 	if(!useful)
 	{
@@ -216,10 +190,7 @@ try
 		return;
 	}
 
-	const auto evid
-	{
-		m::presence::set(object)
-	};
+	m::presence::set(object);
 
 	log::info
 	{
@@ -242,43 +213,46 @@ catch(const m::error &e)
 	};
 }
 
-/// This hook processes ircd.presence events generated internally from local
-/// users and converts them to m.presence over the federation.
-const m::hookfn<m::vm::eval &>
-_ircd_presence_eval
+/// This hook receives each change to the presence table and converts the
+/// presence of our users to m.presence over the federation.
+const m::hookfn<>
+_presence_changed
 {
-	handle_ircd_presence,
+	handle_presence_changed,
 	{
-		{ "_site",   "vm.effect"      },
-		{ "type",    "ircd.presence"  },
+		{ "_site",    "presence.changed"  },
+		{ "type",     "m.presence"        },
 	}
 };
 
 void
-handle_ircd_presence(const m::event &event,
-                     m::vm::eval &eval)
+handle_presence_changed(const m::event &event)
 try
 {
 	if(!federation_send)
 		return;
 
+	// The primary sends the presence of our users; not a replica.
+	if(m::replica::is())
+		return;
+
 	const m::user::id &user_id
 	{
-		json::get<"sender"_>(event)
+		at<"sender"_>(event)
 	};
 
 	if(!my(user_id))
 		return;
 
-	// The event has to be an ircd.presence in the user's room, not just a
-	// random ircd.presence typed event in some other room...
-	if(!m::user::room::is(json::get<"room_id"_>(event), user_id))
-		return;
+	const json::object &object
+	{
+		json::get<"content"_>(event)
+	};
 
-	// Get the spec EDU data from our PDU's content
+	// Get the spec EDU data from the change
 	const m::edu::m_presence edu
 	{
-		json::get<"content"_>(event)
+		object
 	};
 
 	// Check if the user_id in the content is legitimate. This should have
@@ -289,7 +263,7 @@ try
 
 	// The matrix EDU format requires us to wrap this data in an array
 	// called "push" so we copy content into this stack buffer :/
-	char buf[512];
+	char buf[1_KiB];
 	json::stack out{buf};
 	{
 		json::stack::array push{out};
@@ -311,7 +285,7 @@ try
 	opts.edu = true;
 	opts.prop_mask.reset();            // Clear all PDU properties
 	opts.prop_mask.set("origin");
-	opts.notify_clients = false;       // Client /sync already saw the ircd.presence
+	opts.notify_clients = false;       // Client /sync is told by its own hook
 
 	// Execute
 	m::vm::eval
@@ -333,7 +307,7 @@ catch(const std::exception &e)
 	log::error
 	{
 		presence_log, "Presence from our %s to federation :%s",
-		string_view{json::get<"sender"_>(event)},
+		string_view{user_id},
 		e.what(),
 	};
 }
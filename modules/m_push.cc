@@ -10,20 +10,126 @@
 
 namespace ircd::m::push
 {
-	static void execute(const event &, vm::eval &, const user::id &, const path &, const rule &, const event::idx &);
-	static bool matching(const event &, vm::eval &, const user::id &, const path &, const rule &);
-	static bool handle_kind(const event &, vm::eval &, const user::id &, const path &);
-	static void handle_rules(const event &, vm::eval &, const user::id &, const string_view &scope);
+	struct program;
+	struct user_rules;
+	struct memo;
+
+	using memo_key = std::tuple<size_t, string_view, string_view, string_view>;
+
+	static void execute(const event &, vm::eval &, const user::id &, const program &, const size_t &, const event::idx &);
+	static bool evaluate(const event &, const program &, const size_t &, const size_t &, const match::opts &, memo &);
+	static bool matching(const event &, const user::id &, const program &, const size_t &, memo &);
+	static void handle_rules(const event &, vm::eval &, const user::id &, memo &);
 	static void handle_event(const m::event &, vm::eval &);
+	static std::shared_ptr<const program> intern(std::string &&);
+	static std::shared_ptr<const user_rules> compile(const user::id &);
+	static std::shared_ptr<const user_rules> get_rules(const user::id &);
+	static void handle_pushrules(const m::event &, vm::eval &);
+
+	extern conf::item<size_t> cache_max;
+	extern std::map<string_view, std::weak_ptr<const program>> programs;
+	extern std::map<std::string, std::pair<std::shared_ptr<const user_rules>, std::list<string_view>::iterator>, std::less<>> cache;
+	extern std::list<string_view> cache_lru;
+	extern uint64_t cache_version;
 	extern hookfn<vm::eval &> hook_event;
+	extern hookfn<vm::eval &> hook_pushrules;
 }
 
+/// The push rules of a user flattened into the order they are evaluated,
+/// with the rule objects parsed and the action summary precomputed. The
+/// program is identified by its source, which is the concatenation of all
+/// rules; users with identical rules (i.e. everyone on the server defaults)
+/// share one instance.
+struct ircd::m::push::program
+{
+	struct cond;
+	struct rule;
+
+	std::string source;
+	std::vector<rule> rules;
+
+	program(std::string &&source);
+	program(const program &) = delete;
+	~program() noexcept;
+};
+
+struct ircd::m::push::program::cond
+{
+	/// Index into match::cond_kind for the condition's kind.
+	size_t kind;
+
+	/// The result of the condition does not depend on the user it is being
+	/// evaluated for, so it is computed once per event for all users.
+	bool shared;
+
+	push::cond object;
+
+	cond(const push::cond &);
+};
+
+struct ircd::m::push::program::rule
+{
+	string_view kind;
+	string_view rule_id;
+	string_view actions;
+	bool enabled {false};
+	bool notify {false};
+	bool highlight {false};
+	std::vector<cond> conds;
+
+	rule(const string_view &kind, const string_view &rule_id, const json::object &);
+};
+
+/// A user's compiled rules. The program may be shared; the index of the
+/// event which set each rule is specific to the user and aligned with the
+/// program's rules (zero for a server-default).
+struct ircd::m::push::user_rules
+{
+	std::shared_ptr<const program> prog;
+	std::vector<event::idx> rule_idx;
+};
+
+/// State for the evaluation of one event for all members of the room. The
+/// results of conditions which are independent of the user are remembered
+/// by the condition's parameters; the programs are held so those keys
+/// remain valid for the duration of the evaluation.
+struct ircd::m::push::memo
+{
+	const json::object::index &content;
+	std::map<memo_key, bool> result;
+	std::set<std::shared_ptr<const program>> held;
+};
+
 ircd::mapi::header
 IRCD_MODULE
 {
 	"Matrix 13.13 :Push Notifications",
 };
 
+/// The number of users whose compiled rules are cached. Zero disables the
+/// cache and compiles the rules for every event.
+decltype(ircd::m::push::cache_max)
+ircd::m::push::cache_max
+{
+	{ "name",     "ircd.m.push.cache.max" },
+	{ "default",  16384L                  },
+};
+
+// programs must be constructed before (and destroyed after) the cache
+// because each program erases itself from here on destruction.
+decltype(ircd::m::push::programs)
+ircd::m::push::programs;
+
+decltype(ircd::m::push::cache)
+ircd::m::push::cache;
+
+/// Keys of the cache from the most to the least recently used.
+decltype(ircd::m::push::cache_lru)
+ircd::m::push::cache_lru;
+
+decltype(ircd::m::push::cache_version)
+ircd::m::push::cache_version;
+
 decltype(ircd::m::push::hook_event)
 ircd::m::push::hook_event
 {
@@ -33,6 +139,15 @@ ircd::m::push::hook_event
 	}
 };
 
+decltype(ircd::m::push::hook_pushrules)
+ircd::m::push::hook_pushrules
+{
+	handle_pushrules,
+	{
+		{ "_site", "vm.effect" },
+	}
+};
+
 void
 ircd::m::push::handle_event(const m::event &event,
                             vm::eval &eval)
@@ -56,7 +171,19 @@ try
 		room_id
 	};
 
-	members.for_each("join", my_host(), [&event, &eval]
+	// The content is indexed once here and shared by the evaluation of all
+	// rules for all members.
+	const json::object::index content
+	{
+		json::get<"content"_>(event)
+	};
+
+	memo memo
+	{
+		content
+	};
+
+	members.for_each("join", my_host(), [&event, &eval, &memo]
 	(const user::id &user_id, const event::idx &membership_event_idx)
 	{
 		// r0.6.0-13.13.15 Homeservers MUST NOT notify the Push Gateway for
@@ -64,7 +191,7 @@ try
 		if(user_id == at<"sender"_>(event))
 			return true;
 
-		handle_rules(event, eval, user_id, "global");
+		handle_rules(event, eval, user_id, memo);
 		return true;
 	});
 }
@@ -86,82 +213,69 @@ void
 ircd::m::push::handle_rules(const event &event,
                             vm::eval &eval,
                             const user::id &user_id,
-                            const string_view &scope)
+                            memo &memo)
 {
-	const push::path path[]
+	const auto rules
 	{
-		{ scope, "override",   string_view{}         },
-		{ scope, "content",    string_view{}         },
-		{ scope, "room",       at<"room_id"_>(event) },
-		{ scope, "sender",     at<"sender"_>(event)  },
-		{ scope, "underride",  string_view{}         },
+		get_rules(user_id)
 	};
 
-	for(const auto &p : path)
-		if(!handle_kind(event, eval, user_id, p))
-			break;
-}
-
-bool
-ircd::m::push::handle_kind(const event &event,
-                           vm::eval &eval,
-                           const user::id &user_id,
-                           const path &path)
-{
-	const user::pushrules pushrules
+	const auto &program
 	{
-		user_id
+		*rules->prog
 	};
 
-	return pushrules.for_each(path, [&event, &eval, &user_id]
-	(const auto &event_idx, const auto &path, const auto &rule)
-	{
-		if(matching(event, eval, user_id, path, rule))
+	memo.held.emplace(rules->prog);
+	for(size_t i(0); i < program.rules.size(); ++i)
+		if(matching(event, user_id, program, i, memo))
 		{
-			execute(event, eval, user_id, path, rule, event_idx);
-			return false; // false to break due to match
+			execute(event, eval, user_id, program, i, rules->rule_idx.at(i));
+			break;
 		}
-		else return true;
-	});
 }
 
 bool
 ircd::m::push::matching(const event &event,
-                        vm::eval &eval,
                         const user::id &user_id,
-                        const path &path,
-                        const rule &rule)
+                        const program &program,
+                        const size_t &pos,
+                        memo &memo)
 try
 {
-	const auto &[scope, kind, ruleid]
+	const auto &rule
 	{
-		path
+		program.rules.at(pos)
 	};
 
-	if(!json::get<"enabled"_>(rule))
+	if(!rule.enabled)
+		return false;
+
+	// The rule_id of room and sender rules is the room or sender they apply to.
+	if(rule.kind == "room" && rule.rule_id != json::get<"room_id"_>(event))
+		return false;
+
+	if(rule.kind == "sender" && rule.rule_id != json::get<"sender"_>(event))
 		return false;
 
 	push::match::opts opts;
 	opts.user_id = user_id;
-	const push::match match
-	{
-		event, rule, opts
-	};
+	opts.content = &memo.content;
+	for(size_t i(0); i < rule.conds.size(); ++i)
+		if(!evaluate(event, program, pos, i, opts, memo))
+			return false;
 
 	#if 0
 	log::debug
 	{
-		log, "event %s rule { %s, %s, %s } for %s %s",
+		log, "event %s rule { global, %s, %s } for %s MATCH",
 		string_view{event.event_id},
-		scope,
-		kind,
-		ruleid,
+		rule.kind,
+		rule.rule_id,
 		string_view{user_id},
-		bool(match)? "MATCH"_sv : string_view{}
 	};
 	#endif
 
-	return bool(match);
+	return true;
 }
 catch(const ctx::interrupted &)
 {
@@ -169,63 +283,104 @@ catch(const ctx::interrupted &)
 }
 catch(const std::exception &e)
 {
-	const auto &[scope, kind, ruleid]
+	const auto &rule
 	{
-		path
+		program.rules.at(pos)
 	};
 
 	log::error
 	{
-		log, "Push rule matching in %s for %s at { %s, %s, %s } :%s",
+		log, "Push rule matching in %s for %s at { global, %s, %s } :%s",
 		string_view{event.event_id},
 		string_view{user_id},
-		scope,
-		kind,
-		ruleid,
+		rule.kind,
+		rule.rule_id,
 		e.what(),
 	};
 
 	return false;
 }
 
+bool
+ircd::m::push::evaluate(const event &event,
+                        const program &program,
+                        const size_t &pos,
+                        const size_t &i,
+                        const match::opts &opts,
+                        memo &memo)
+{
+	const auto &cond
+	{
+		program.rules.at(pos).conds.at(i)
+	};
+
+	const auto &func
+	{
+		match::cond_kind[cond.kind]
+	};
+
+	if(!cond.shared)
+		return func(event, cond.object, opts);
+
+	const memo_key key
+	{
+		cond.kind,
+		json::get<"key"_>(cond.object),
+		json::get<"pattern"_>(cond.object),
+		json::get<"is"_>(cond.object),
+	};
+
+	const auto it
+	{
+		memo.result.find(key)
+	};
+
+	if(it != end(memo.result))
+		return it->second;
+
+	// The condition may yield (e.g. room_member_count) so the iterator
+	// above is not reused for the insertion.
+	const bool result
+	{
+		func(event, cond.object, opts)
+	};
+
+	memo.result.emplace(key, result);
+	return result;
+}
+
 void
 ircd::m::push::execute(const event &event,
                        vm::eval &eval,
                        const user::id &user_id,
-                       const path &path,
-                       const rule &rule,
+                       const program &program,
+                       const size_t &pos,
                        const event::idx &rule_idx)
 try
 {
-	const auto &[scope, kind, ruleid]
-	{
-		path
-	};
-
-	const json::array &actions
+	const auto &rule
 	{
-		json::get<"actions"_>(rule)
+		program.rules.at(pos)
 	};
 
 	log::debug
 	{
-		log, "event %s action { %s, %s, %s } for %s :%s",
+		log, "event %s action { global, %s, %s } for %s :%s",
 		string_view{event.event_id},
-		scope,
-		kind,
-		ruleid,
+		rule.kind,
+		rule.rule_id,
 		string_view{user_id},
-		string_view{json::get<"actions"_>(rule)},
+		rule.actions,
 	};
 
 	// action is dont_notify or undefined etc
-	if(!notifying(rule))
+	if(!rule.notify)
 		return;
 
 	user::notifications::opts opts;
 	opts.room_id = eval.room_id;
 	opts.only =
-		highlighting(rule)?
+		rule.highlight?
 			"highlight"_sv:
 			string_view{};
 
@@ -240,6 +395,8 @@ try
 		user_id
 	};
 
+	// Writing the notification also counts it into the user's unread counts
+	// for the room (see dbs::user_unread); the next receipt resets them.
 	send(user_room, at<"sender"_>(event), type, json::members
 	{
 		{ "event_idx",  long(eval.sequence)  },
@@ -253,19 +410,268 @@ catch(const ctx::interrupted &)
 }
 catch(const std::exception &e)
 {
-	const auto &[scope, kind, ruleid]
+	const auto &rule
 	{
-		path
+		program.rules.at(pos)
 	};
 
 	log::error
 	{
-		log, "Push rule action in %s for %s at { %s, %s, %s } :%s",
+		log, "Push rule action in %s for %s at { global, %s, %s } :%s",
 		string_view{event.event_id},
 		string_view{user_id},
-		scope,
-		kind,
-		ruleid,
+		rule.kind,
+		rule.rule_id,
 		e.what(),
 	};
 }
+
+//
+// cache
+//
+
+void
+ircd::m::push::handle_pushrules(const m::event &event,
+                                vm::eval &eval)
+{
+	// Rules are deleted by redacting them in the user's room.
+	const bool changing
+	{
+		startswith(json::get<"type"_>(event), rule::type_prefix) ||
+		json::get<"type"_>(event) == "m.room.redaction"
+	};
+
+	if(!changing)
+		return;
+
+	const m::user::id &sender
+	{
+		at<"sender"_>(event)
+	};
+
+	if(!my(sender) || !m::user::room::is(at<"room_id"_>(event), sender))
+		return;
+
+	// Any compilation which is yielding now is discarded when it resumes.
+	++cache_version;
+
+	const auto it
+	{
+		cache.find(sender)
+	};
+
+	if(it == end(cache))
+		return;
+
+	cache_lru.erase(it->second.second);
+	cache.erase(it);
+}
+
+std::shared_ptr<const ircd::m::push::user_rules>
+ircd::m::push::get_rules(const user::id &user_id)
+{
+	const auto it
+	{
+		cache.find(user_id)
+	};
+
+	if(it != end(cache))
+	{
+		auto &[rules, lru]
+		{
+			it->second
+		};
+
+		cache_lru.splice(begin(cache_lru), cache_lru, lru);
+		return rules;
+	}
+
+	const auto version
+	{
+		cache_version
+	};
+
+	auto ret
+	{
+		compile(user_id)
+	};
+
+	if(version != cache_version || !size_t(cache_max))
+		return ret;
+
+	// Evict the least recently used.
+	while(cache.size() >= size_t(cache_max))
+	{
+		const auto lit
+		{
+			cache.find(cache_lru.back())
+		};
+
+		assert(lit != end(cache));
+		cache_lru.pop_back();
+		cache.erase(lit);
+	}
+
+	const auto iit
+	{
+		cache.emplace(std::string{user_id}, std::make_pair(ret, end(cache_lru))).first
+	};
+
+	iit->second.second = cache_lru.emplace(begin(cache_lru), iit->first);
+	return ret;
+}
+
+/// Collects all of the user's rules in the order of evaluation. The source
+/// of the program is each rule as kind, rule_id and object separated by
+/// null characters, which cannot appear in any of them.
+std::shared_ptr<const ircd::m::push::user_rules>
+ircd::m::push::compile(const user::id &user_id)
+{
+	static const string_view kinds[]
+	{
+		"override", "content", "room", "sender", "underride"
+	};
+
+	const user::pushrules pushrules
+	{
+		user_id
+	};
+
+	std::string source;
+	std::vector<event::idx> rule_idx;
+	for(const auto &kind : kinds)
+		pushrules.for_each(push::path{"global", kind, string_view{}}, [&source, &rule_idx]
+		(const auto &event_idx, const auto &path, const json::object &rule)
+		{
+			const auto &[scope, kind, ruleid]
+			{
+				path
+			};
+
+			source.append(kind);
+			source.push_back('\0');
+			source.append(ruleid);
+			source.push_back('\0');
+			source.append(string_view{rule});
+			source.push_back('\0');
+			rule_idx.emplace_back(event_idx);
+			return true;
+		});
+
+	auto ret
+	{
+		std::make_shared<user_rules>()
+	};
+
+	ret->prog = intern(std::move(source));
+	ret->rule_idx = std::move(rule_idx);
+	assert(ret->prog->rules.size() == ret->rule_idx.size());
+	return ret;
+}
+
+std::shared_ptr<const ircd::m::push::program>
+ircd::m::push::intern(std::string &&source)
+{
+	const auto it
+	{
+		programs.find(source)
+	};
+
+	if(it != end(programs))
+		if(auto ret{it->second.lock()})
+			return ret;
+
+	const auto ret
+	{
+		std::make_shared<const program>(std::move(source))
+	};
+
+	// The key is a view of the program's own source.
+	programs.erase(string_view{ret->source});
+	programs.emplace(string_view{ret->source}, ret);
+	return ret;
+}
+
+//
+// program
+//
+
+ircd::m::push::program::program(std::string &&source_)
+:source
+{
+	std::move(source_)
+}
+{
+	string_view in
+	{
+		source
+	};
+
+	while(!empty(in))
+	{
+		const auto &[kind, post0] {split(in, '\0')};
+		const auto &[rule_id, post1] {split(post0, '\0')};
+		const auto &[object, post2] {split(post1, '\0')};
+		rules.emplace_back(kind, rule_id, json::object{object});
+		in = post2;
+	}
+}
+
+ircd::m::push::program::~program()
+noexcept
+{
+	const auto it
+	{
+		programs.find(string_view{source})
+	};
+
+	if(it != end(programs) && data(it->first) == data(source))
+		programs.erase(it);
+}
+
+ircd::m::push::program::rule::rule(const string_view &kind,
+                                   const string_view &rule_id,
+                                   const json::object &object)
+:kind{kind}
+,rule_id{rule_id}
+{
+	const push::rule rule
+	{
+		object
+	};
+
+	actions = json::get<"actions"_>(rule);
+	enabled = json::get<"enabled"_>(rule);
+	notify = notifying(rule);
+	highlight = highlighting(rule);
+
+	// Content rules are an event_match on the body with the rule's pattern.
+	if(json::get<"pattern"_>(rule))
+		conds.emplace_back(push::cond
+		{
+			{ "kind",     "event_match"               },
+			{ "key",      "content.body"              },
+			{ "pattern",  json::get<"pattern"_>(rule) },
+		});
+
+	for(const json::object cond : json::get<"conditions"_>(rule))
+		conds.emplace_back(push::cond{cond});
+}
+
+ircd::m::push::program::cond::cond(const push::cond &object)
+:kind
+{
+	indexof(json::get<"kind"_>(object), string_views(match::cond_kind_name))
+}
+,shared
+{
+	json::get<"kind"_>(object) == "event_match" ||
+	json::get<"kind"_>(object) == "room_member_count" ||
+	json::get<"kind"_>(object) == "sender_notification_permission"
+}
+,object
+{
+	object
+}
+{
+}
@@ -72,7 +72,7 @@ _changed_rules_notify_hookfn
 {
 	_changed_rules_notify,
 	{
-		{ "_site",    "vm.notify"          },
+		{ "_site",    "vm.effect"          },
 		{ "type",     "m.room.join_rules"  },
 	}
 };
@@ -25,7 +25,7 @@ ircd::m::room_message_notify_hook
 {
 	room_message_notify,
 	{
-		{ "_site",  "vm.notify"       },
+		{ "_site",  "vm.effect"       },
 		{ "type",   "m.room.message"  },
 	}
 };
@@ -28,7 +28,7 @@ ircd::m::changed_room_power_levels_hookfn
 {
 	changed_room_power_levels,
 	{
-		{ "_site",    "vm.notify"            },
+		{ "_site",    "vm.effect"            },
 		{ "type",     "m.room.power_levels"  },
 	}
 };
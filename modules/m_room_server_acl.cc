@@ -57,7 +57,7 @@ ircd::m::changed_room_server_acl
 {
 	on_changed_room_server_acl,
 	{
-		{ "_site",    "vm.notify"          },
+		{ "_site",    "vm.effect"          },
 		{ "type",     "m.room.server_acl"  },
 	}
 };
@@ -39,6 +39,11 @@ get__download_local(client &client,
                     const string_view &file,
                     const m::room &room);
 
+static std::pair<size_t, size_t>
+download_range(const m::resource::request &request,
+               const string_view &etag,
+               const size_t &file_size);
+
 static m::resource::response
 get__download(client &client,
               const m::resource::request &request)
@@ -73,6 +78,11 @@ get__download(client &client,
 		request.query.get<bool>("allow_remote", true)
 	};
 
+	// A replica only serves media the primary already has; anything which
+	// still has to be downloaded is left for the primary.
+	if(m::replica::is() && !m::exists(m::media::file::room_id({server, file})))
+		return m::replica::proxy(client, request);
+
 	const m::room::id::buf room_id
 	{
 		m::media::file::download({server, file}, user_id)
@@ -127,48 +137,199 @@ get__download_local(client &client,
 		};
 	});
 
-	static const auto &addl_headers
+	// The content of an mxc never changes so its path serves as the
+	// validator for If-Range.
+	char etag_buf[512];
+	const string_view etag
+	{
+		fmt::sprintf
+		{
+			etag_buf, "\"%s/%s\"", server, file
+		}
+	};
+
+	const auto range
 	{
-		"Cache-Control: public, max-age=31536000, immutable\r\n"_sv
+		download_range(request, etag, file_size)
+	};
+
+	const bool partial
+	{
+		range.first != 0 || range.second != file_size
+	};
+
+	char addl_headers_buf[768];
+	const string_view addl_headers
+	{
+		fmt::sprintf
+		{
+			addl_headers_buf,
+			"Cache-Control: public, max-age=31536000, immutable\r\n"
+			"Accept-Ranges: bytes\r\n"
+			"ETag: %s\r\n",
+			etag,
+		}
+	};
+
+	// The range starts past the end of the file.
+	if(file_size && range.first >= range.second)
+	{
+		char content_range_buf[64];
+		m::resource::response
+		{
+			client,
+			http::RANGE_NOT_SATISFIABLE,
+			content_type,
+			0UL,
+			fmt::sprintf
+			{
+				content_range_buf, "Content-Range: bytes */%zu\r\n",
+				file_size,
+			}
+		};
+
+		return {};
+	}
+
+	char content_range_buf[64];
+	const string_view content_range
+	{
+		partial?
+			fmt::sprintf
+			{
+				content_range_buf, "Content-Range: bytes %zu-%zu/%zu\r\n",
+				range.first,
+				range.second - 1,
+				file_size,
+			}:
+			string_view{}
+	};
+
+	char headers_buf[1024];
+	const string_view headers
+	{
+		fmt::sprintf
+		{
+			headers_buf, "%s%s",
+			addl_headers,
+			content_range,
+		}
 	};
 
 	// Send HTTP head to client
 	m::resource::response
 	{
 		client,
-		http::OK,
+		partial? http::PARTIAL_CONTENT: http::OK,
 		content_type,
-		file_size,
-		addl_headers,
+		range.second - range.first,
+		headers,
 	};
 
+	// Each call is several blocks gathered for one write to the socket.
 	size_t sent{0}, read
 	{
-		m::media::file::read(room, [&client, &sent]
-		(const string_view &block)
+		m::media::file::read(room, range, [&client, &sent]
+		(const const_buffer &blocks)
 		{
-			sent += write_all(*client.sock, block);
+			sent += client.write_all(blocks);
 		})
 	};
 
-	if(unlikely(read != file_size))
+	if(unlikely(read != range.second - range.first))
 		log::error
 		{
 			m::media::log, "File %s/%s [%s] size mismatch: expected %zu got %zu",
 			server,
 			file,
 			string_view{room.room_id},
-			file_size,
+			range.second - range.first,
 			read
 		};
 
 	// Have to kill client here after failing content length expectation.
-	if(unlikely(read != file_size))
+	if(unlikely(read != range.second - range.first))
 		client.close(net::dc::RST, net::close_ignore);
 
 	return {};
 }
 
+/// Returns the byte range [first, second) requested by a single range in the
+/// Range header, or the whole file when there is no usable Range header or the
+/// If-Range validator does not match. A range starting past the end of the
+/// file is returned as is for the caller to reject.
+static std::pair<size_t, size_t>
+download_range(const m::resource::request &request,
+               const string_view &etag,
+               const size_t &file_size)
+{
+	const std::pair<size_t, size_t> whole
+	{
+		0UL, file_size
+	};
+
+	const string_view range
+	{
+		strip(request.head.range)
+	};
+
+	// Multiple ranges are permitted to be answered with the whole file.
+	if(!startswith(range, "bytes=") || has(range, ','))
+		return whole;
+
+	if(request.head.if_range && strip(request.head.if_range) != etag)
+		return whole;
+
+	const auto &[first, last]
+	{
+		split(strip(lstrip(range, "bytes=")), '-')
+	};
+
+	// Suffix range of the last bytes.
+	if(!first)
+	{
+		if(!lex_castable<size_t>(last))
+			return whole;
+
+		const size_t suffix
+		{
+			std::min(lex_cast<size_t>(last), file_size)
+		};
+
+		// bytes=-0 is unsatisfiable.
+		if(!suffix)
+			return { file_size, file_size };
+
+		return { file_size - suffix, file_size };
+	}
+
+	if(!lex_castable<size_t>(first))
+		return whole;
+
+	if(last && !lex_castable<size_t>(last))
+		return whole;
+
+	const size_t begin
+	{
+		lex_cast<size_t>(first)
+	};
+
+	const size_t end
+	{
+		last && lex_cast<size_t>(last) < file_size?
+			lex_cast<size_t>(last) + 1:
+			file_size
+	};
+
+	if(last && lex_cast<size_t>(last) < begin)
+		return whole;
+
+	if(begin >= file_size)
+		return { begin, begin };
+
+	return { begin, end };
+}
+
 static m::resource::method
 method_get
 {
@@ -176,8 +337,8 @@ method_get
 	"GET",
 	get__download,
 	{
-		m::resource::method::flag(0),  // flags
-		45s,                           // timeout
+		m::resource::method::READ_ONLY,     // flags
+		45s,                                // timeout
 	}
 };
 
@@ -188,7 +349,7 @@ method_get__legacy
 	"GET",
 	get__download,
 	{
-		m::resource::method::flag(0),  // flags
-		45s,                           // timeout
+		m::resource::method::READ_ONLY,     // flags
+		45s,                                // timeout
 	}
 };
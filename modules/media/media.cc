@@ -100,12 +100,109 @@ ircd::m::media::blocks_descriptor
 	60s * 60 * 24 * 42,
 };
 
+// Thumbnails column
+decltype(ircd::m::media::thumbnails_descriptor)
+ircd::m::media::thumbnails_descriptor
+{
+	// name
+	"thumbnails",
+
+	// explain
+	R"(
+	Key-value store of generated thumbnails. The key is the room_id of the
+	source file followed by the width, height and method; the dimensions are
+	one of a few fixed sizes. The value is the time the thumbnail was made
+	followed by the binary thumbnail as it was sent to the client. Entries
+	older than the configured TTL or whose source file is gone are removed
+	by compaction.
+	)",
+
+	// typing
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	{},      // options
+	{},      // comparaor
+	{},      // prefix transform
+	false,   // drop column
+
+	bool(blocks_cache_enable)? -1 : 0,
+
+	bool(blocks_cache_comp_enable)? -1 : 0,
+
+	// bloom_bits
+	10,
+
+	// expect hit
+	false,
+
+	// block_size
+	32_KiB,
+
+	// meta block size
+	512,
+
+	// compression
+	{}, // no compression
+
+	// compactor
+	{
+		thumbnails_compact,
+	},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target file size
+	{},
+
+	// max bytes for each level
+	{},
+
+	// compaction_period
+	60s * 60 * 24 * 7,
+};
+
+/// Expired thumbnails and the thumbnails of files which no longer exist are
+/// dropped when compacted.
+ircd::db::op
+ircd::m::media::thumbnails_compact(const db::compactor::args &args)
+{
+	if(size(args.val) < sizeof(time_t))
+		return db::op::DELETE;
+
+	const time_t created
+	{
+		byte_view<time_t>(args.val.substr(0, sizeof(time_t)))
+	};
+
+	const seconds age
+	{
+		ircd::time() - created
+	};
+
+	if(age > seconds(thumbnail::cache_ttl))
+		return db::op::DELETE;
+
+	const string_view &room_id
+	{
+		split(args.key, ' ').first
+	};
+
+	if(!valid(m::id::ROOM, room_id) || !exists(m::room::id(room_id)))
+		return db::op::DELETE;
+
+	return db::op::GET;
+}
+
 decltype(ircd::m::media::description)
 ircd::m::media::description
 {
 	{ "default" }, // requirement of RocksDB
 
 	blocks_descriptor,
+	thumbnails_descriptor,
 };
 
 decltype(ircd::m::media::blocks_cache_size)
@@ -140,6 +237,22 @@ ircd::m::media::blocks_cache_comp_size
 	}
 };
 
+decltype(ircd::m::media::thumbnails_cache_size)
+ircd::m::media::thumbnails_cache_size
+{
+	{
+		{ "name",     "ircd.media.thumbnails.cache.size" },
+		{ "default",  long(32_MiB)                       },
+	}, []
+	{
+		if(!thumbnails)
+			return;
+
+		const size_t &value{thumbnails_cache_size};
+		db::capacity(db::cache(thumbnails), value);
+	}
+};
+
 decltype(ircd::m::media::blocks_prefetch)
 ircd::m::media::blocks_prefetch
 {
@@ -154,12 +267,22 @@ ircd::m::media::events_prefetch
 	{ "default",  16L                               },
 };
 
+decltype(ircd::m::media::read_gather)
+ircd::m::media::read_gather
+{
+	{ "name",     "ircd.media.file.read.gather" },
+	{ "default",  8L                            },
+};
+
 decltype(ircd::m::media::database)
 ircd::m::media::database;
 
 decltype(ircd::m::media::blocks)
 ircd::m::media::blocks;
 
+decltype(ircd::m::media::thumbnails)
+ircd::m::media::thumbnails;
+
 decltype(ircd::m::media::downloading)
 ircd::m::media::downloading;
 
@@ -176,11 +299,13 @@ ircd::m::media::init()
 	static const std::string dbopts;
 	database = std::make_shared<db::database>("media", dbopts, description);
 	blocks = db::column{*database, "blocks"};
+	thumbnails = db::column{*database, "thumbnails"};
 
 	// The conf setter callbacks must be manually executed after
 	// the database was just loaded to set the cache size.
 	conf::reset("ircd.media.blocks.cache.size");
 	conf::reset("ircd.media.blocks.cache_comp.size");
+	conf::reset("ircd.media.thumbnails.cache.size");
 }
 
 void
@@ -432,125 +557,169 @@ size_t
 IRCD_MODULE_EXPORT
 ircd::m::media::file::read(const m::room &room,
                            const closure &closure)
+{
+	return read(room, {0UL, -1UL}, closure);
+}
+
+size_t
+IRCD_MODULE_EXPORT
+ircd::m::media::file::read(const m::room &room,
+                           const std::pair<size_t, size_t> &range,
+                           const closure &closure)
 {
 	static const event::fetch::opts fopts
 	{
-		event::keys::include { "content", "type" }
+		event::keys::include { "content" }
 	};
 
-	size_t ret{0};
-	room::events it
+	// The block events in the order they were written; the type index
+	// iterates from the highest depth.
+	std::vector<event::idx> idx;
+	const m::room::type blocks_type
 	{
-		room, 1, &fopts
+		room, "ircd.file.block"
 	};
 
-	if(!it)
-		return ret;
+	blocks_type.for_each([&idx]
+	(const string_view &, const uint64_t &, const event::idx &event_idx)
+	{
+		idx.emplace_back(event_idx);
+		return true;
+	});
+
+	std::reverse(begin(idx), end(idx));
+	if(idx.empty() || range.first >= range.second)
+		return 0;
 
-	size_t events_fetched(0), events_prefetched(0);
-	room::events epf
+	// All blocks but the last have the size of the first, which lets the
+	// range be mapped onto the block list without reading the skipped blocks.
+	const std::string front
 	{
-		room, 1, &fopts
+		m::get(idx.front(), "content")
 	};
 
-	size_t blocks_fetched(0), blocks_prefetched(0);
-	room::events bpf
+	const size_t block_size
 	{
-		room, 1, &fopts
+		json::object(front).at<size_t>("size")
 	};
 
-	for(; it; ++it)
-	{
-		for(; bpf && blocks_prefetched < blocks_fetched + blocks_prefetch; ++bpf)
-		{
-			for(; epf && events_prefetched < events_fetched + events_prefetch; ++epf)
-				events_prefetched += epf.prefetch();
+	if(unlikely(!block_size))
+		return 0;
 
-			++events_fetched;
-			const m::event &event
-			{
-				*bpf
-			};
+	size_t i
+	{
+		range.first / block_size
+	};
 
-			if(at<"type"_>(event) != "ircd.file.block")
-				continue;
+	size_t skip
+	{
+		range.first % block_size
+	};
 
-			const json::string &hash
-			{
-				at<"content"_>(event).at("hash")
-			};
+	if(i >= idx.size())
+		return 0;
 
-			blocks_prefetched += block::prefetch(hash);
-		}
+	// Blocks are gathered into one buffer to be passed to the closure
+	// several at a time, which is the size of each write to the client.
+	const size_t gather
+	{
+		std::max(size_t(read_gather), 1UL)
+	};
 
-		if(!blocks_fetched)
-			ctx::yield();
+	const unique_buffer<mutable_buffer> buf
+	{
+		gather * block_size
+	};
 
-		++blocks_fetched;
-		const m::event &event
-		{
-			*it
-		};
+	size_t ret(0), pos(0), epf(i), bpf(i);
+	for(; i < idx.size() && range.first + ret < range.second; ++i)
+	{
+		for(; epf < idx.size() && epf < bpf + events_prefetch; ++epf)
+			m::prefetch(idx[epf], fopts);
 
-		if(at<"type"_>(event) != "ircd.file.block")
-			continue;
+		for(; bpf < idx.size() && bpf < i + blocks_prefetch; ++bpf)
+			m::get(std::nothrow, idx[bpf], "content", []
+			(const json::object &content)
+			{
+				block::prefetch(json::string(content["hash"]));
+			});
 
-		const json::string &hash
+		const std::string content
 		{
-			at<"content"_>(event).at("hash")
+			m::get(idx[i], "content")
 		};
 
-		const auto &block_size
+		const json::string hash
 		{
-			at<"content"_>(event).get<size_t>("size")
+			json::object(content).at("hash")
 		};
 
-		const auto handle{[&](const const_buffer &block)
+		const size_t blk_size
 		{
-			if(unlikely(size(block) != block_size))
-				throw m::NOT_FOUND
-				{
-					"File [%s] block [%s] event %s idx:%lu block size %zu != %zu",
-					string_view{room.room_id},
-					hash,
-					string_view{event.event_id},
-					it.event_idx(),
-					block_size,
-					size(block)
-				};
-
-			assert(size(block) == block_size);
-			ret += size(block);
+			json::object(content).at<size_t>("size")
+		};
 
-			#if 0
-			log::debug
+		if(unlikely(blk_size > block_size || (blk_size != block_size && i + 1 < idx.size())))
+			throw m::NOT_FOUND
 			{
-				log, "File %s read %s block[fetched:%zu prefetched:%zu] events[fetched:%zu prefetched:%zu] size:%zu total:%zu",
+				"File [%s] block %s idx:%lu size %zu irregular to the block size %zu",
 				string_view{room.room_id},
 				hash,
-				blocks_fetched,
-				blocks_prefetched,
-				events_fetched,
-				events_prefetched,
+				idx[i],
+				blk_size,
 				block_size,
-				ret,
 			};
-			#endif
 
-			closure(block);
-		}};
+		const bool found
+		{
+			block::get(hash, [&](const const_buffer &block)
+			{
+				if(unlikely(size(block) != blk_size))
+					throw m::NOT_FOUND
+					{
+						"File [%s] block %s idx:%lu block size %zu != %zu",
+						string_view{room.room_id},
+						hash,
+						idx[i],
+						blk_size,
+						size(block),
+					};
+
+				const size_t remain
+				{
+					range.second - range.first - ret
+				};
 
-		if(unlikely(!block::get(hash, handle)))
+				const const_buffer part
+				{
+					data(block) + skip, std::min(size(block) - skip, remain)
+				};
+
+				pos += copy(buf + pos, part);
+				ret += size(part);
+				skip = 0;
+			})
+		};
+
+		if(unlikely(!found))
 			throw m::NOT_FOUND
 			{
-				"File [%s] block %s missing in event %s idx:%lu",
+				"File [%s] block %s missing in event idx:%lu",
 				string_view{room.room_id},
 				hash,
-				string_view{event.event_id},
-				it.event_idx(),
+				idx[i],
 			};
+
+		if(pos + block_size <= size(buf))
+			continue;
+
+		closure(const_buffer{data(buf), pos});
+		pos = 0;
 	}
 
+	if(pos)
+		closure(const_buffer{data(buf), pos});
+
 	return ret;
 }
 
@@ -14,18 +14,23 @@ namespace ircd::m::media
 
 	static void init();
 	static void fini();
+	static db::op thumbnails_compact(const db::compactor::args &);
 
 	extern log::log log;
 	extern conf::item<bool> blocks_cache_enable;
 	extern conf::item<bool> blocks_cache_comp_enable;
 	extern conf::item<size_t> blocks_cache_size;
 	extern conf::item<size_t> blocks_cache_comp_size;
+	extern conf::item<size_t> thumbnails_cache_size;
 	extern conf::item<size_t> blocks_prefetch;
 	extern conf::item<size_t> events_prefetch;
+	extern conf::item<size_t> read_gather;
 	extern const db::descriptor blocks_descriptor;
+	extern const db::descriptor thumbnails_descriptor;
 	extern const db::description description;
 	extern std::shared_ptr<db::database> database;
 	extern db::column blocks;
+	extern db::column thumbnails;
 
 	extern conf::item<seconds> download_timeout;
 	extern std::set<m::room::id> downloading;
@@ -43,4 +48,8 @@ namespace ircd::m::media::thumbnail
 	extern conf::item<size_t> height_max;
 	extern conf::item<std::string> mime_whitelist;
 	extern conf::item<std::string> mime_blacklist;
+	extern conf::item<bool> cache_enable;
+	extern conf::item<seconds> cache_ttl;
+	extern std::set<std::string, std::less<>> generating;
+	extern ctx::dock generating_dock;
 }
@@ -76,6 +76,33 @@ ircd::m::media::thumbnail::mime_blacklist
 	{ "default",  ""                                      },
 };
 
+decltype(ircd::m::media::thumbnail::cache_enable)
+ircd::m::media::thumbnail::cache_enable
+{
+	{ "name",     "ircd.m.media.thumbnail.cache.enable" },
+	{ "default",  true                                  },
+};
+
+/// Stored thumbnails are removed by compaction after this time; they are
+/// generated again when next requested.
+decltype(ircd::m::media::thumbnail::cache_ttl)
+ircd::m::media::thumbnail::cache_ttl
+{
+	{ "name",     "ircd.m.media.thumbnail.cache.ttl" },
+	{ "default",  60L * 60 * 24 * 30                 },
+};
+
+decltype(ircd::m::media::thumbnail::generating)
+ircd::m::media::thumbnail::generating;
+
+decltype(ircd::m::media::thumbnail::generating_dock)
+ircd::m::media::thumbnail::generating_dock;
+
+static const auto &addl_headers
+{
+	"Cache-Control: public, max-age=31536000, immutable\r\n"_sv
+};
+
 m::resource
 thumbnail_resource__legacy
 {
@@ -102,6 +129,15 @@ get__thumbnail_local(client &client,
                      const m::media::mxc &,
                      const m::room &room);
 
+static bool
+get__thumbnail_cached(client &client,
+                      const string_view &key,
+                      const string_view &content_type);
+
+static pair<size_t>
+thumbnail_size(const string_view &method,
+               const pair<size_t> &requested);
+
 m::resource::response
 get__thumbnail(client &client,
                const m::resource::request &request)
@@ -195,7 +231,7 @@ get__thumbnail_local(client &client,
 		request.query.get<size_t>("height", 0),
 	};
 
-	const pair<size_t> dimension
+	const pair<size_t> requested
 	{
 		_dimension[0]?
 			std::clamp(_dimension[0], size_t(width_min), size_t(width_max)):
@@ -206,6 +242,15 @@ get__thumbnail_local(client &client,
 			_dimension[1]
 	};
 
+	// The thumbnail is made in one of a few sizes so clients can't store an
+	// arbitrary number of thumbnails of the same file.
+	const pair<size_t> dimension
+	{
+		requested.first && requested.second?
+			thumbnail_size(method, requested):
+			requested
+	};
+
 	static const m::event::fetch::opts fopts
 	{
 		m::event::keys::include {"content"}
@@ -245,6 +290,98 @@ get__thumbnail_local(client &client,
 		};
 	});
 
+	const auto mime_type
+	{
+		split(content_type, ';').first
+	};
+
+	const bool supported
+	{
+		// Available in build
+		#ifdef IRCD_USE_MAGICK
+			(true)
+		#else
+			(false)
+		#endif
+
+		// Enabled by configuration
+		&& enable
+	};
+
+	const bool permitted
+	{
+		// If there's a blacklist, mime type must not in the blacklist.
+		(!mime_blacklist || !has(mime_blacklist, mime_type))
+
+		// If there's a whitelist, mime type must be in the whitelist.
+		&& (!mime_whitelist || has(mime_whitelist, mime_type))
+	};
+
+	const bool valid_args
+	{
+		// Both dimension parameters given in query string
+		(dimension.first && dimension.second)
+
+		// Known thumbnailing method in query string
+		&& (method == "scale" || method == "crop")
+	};
+
+	// Thumbnails are generated once and stored by the source file, the
+	// dimensions and the method. A thumbnail is only ever stored after it
+	// was generated, so nothing is found here for a fallback.
+	char cache_key_buf[m::id::MAX_SIZE + 64];
+	const string_view cache_key
+	{
+		cache_enable && supported && permitted && valid_args?
+			fmt::sprintf
+			{
+				cache_key_buf, "%s %zu %zu %s",
+				string_view{room.room_id},
+				dimension.first,
+				dimension.second,
+				method,
+			}:
+			string_view{}
+	};
+
+	// Concurrent requests for the same thumbnail wait for the first one to
+	// generate it and are then served from the cache.
+	auto generating_it
+	{
+		end(generating)
+	};
+
+	while(cache_key)
+	{
+		if(get__thumbnail_cached(client, cache_key, content_type))
+			return {}; // responded from cache.
+
+		const auto iit
+		{
+			generating.emplace(cache_key)
+		};
+
+		if(iit.second)
+		{
+			generating_it = iit.first;
+			break;
+		}
+
+		generating_dock.wait([&cache_key]
+		{
+			return !generating.count(cache_key);
+		});
+	}
+
+	const unwind generated{[&generating_it]
+	{
+		if(generating_it == end(generating))
+			return;
+
+		generating.erase(generating_it);
+		generating_dock.notify_all();
+	}};
+
 	const unique_buffer<mutable_buffer> buf
 	{
 		file_size
@@ -274,33 +411,6 @@ get__thumbnail_local(client &client,
 			copied
 		};
 
-	const auto mime_type
-	{
-		split(content_type, ';').first
-	};
-
-	const bool supported
-	{
-		// Available in build
-		#ifdef IRCD_USE_MAGICK
-			(true)
-		#else
-			(false)
-		#endif
-
-		// Enabled by configuration
-		&& enable
-	};
-
-	const bool permitted
-	{
-		// If there's a blacklist, mime type must not in the blacklist.
-		(!mime_blacklist || !has(mime_blacklist, mime_type))
-
-		// If there's a whitelist, mime type must be in the whitelist.
-		&& (!mime_whitelist || has(mime_whitelist, mime_type))
-	};
-
 	const bool animated
 	{
 		// Administrator's fuse to disable animation detection.
@@ -316,15 +426,6 @@ get__thumbnail_local(client &client,
 		&& (has(mime_type, "image/png") && png::is_animated(buf))
 	};
 
-	const bool valid_args
-	{
-		// Both dimension parameters given in query string
-		(dimension.first && dimension.second)
-
-		// Known thumbnailing method in query string
-		&& (method == "scale" || method == "crop")
-	};
-
 	const bool fallback // Reasons to just send the original image
 	{
 		// Thumbnailer support not enabled or available
@@ -356,20 +457,30 @@ get__thumbnail_local(client &client,
 				"Unknown reason",
 		};
 
-	static const auto &addl_headers
-	{
-		"Cache-Control: public, max-age=31536000, immutable\r\n"_sv
-	};
-
 	if(fallback)
 		return m::resource::response
 		{
 			client, buf, content_type, http::OK, addl_headers
 		};
 
-	const auto closure{[&client, &content_type]
+	const auto closure{[&client, &content_type, &cache_key]
 	(const const_buffer &buf)
 	{
+		// The value is prefixed by the time for the TTL of the compactor.
+		if(cache_key)
+		{
+			const time_t now(ircd::time());
+			const unique_buffer<mutable_buffer> val
+			{
+				sizeof(now) + size(buf)
+			};
+
+			mutable_buffer out(val);
+			consume(out, copy(out, byte_view<string_view>(now)));
+			consume(out, copy(out, buf));
+			db::write(m::media::thumbnails, cache_key, const_buffer(val));
+		}
+
 		m::resource::response
 		{
 			client, buf, content_type, http::OK, addl_headers
@@ -389,3 +500,60 @@ get__thumbnail_local(client &client,
 
 	return {}; // responded from closure.
 }
+
+static bool
+get__thumbnail_cached(client &client,
+                      const string_view &key,
+                      const string_view &content_type)
+{
+	// The value is copied out rather than responding while it is pinned in
+	// the database because the response may yield for some time.
+	std::string thumbnail;
+	m::media::thumbnails(key, std::nothrow, [&thumbnail]
+	(const string_view &value)
+	{
+		if(size(value) > sizeof(time_t))
+			thumbnail = value.substr(sizeof(time_t));
+	});
+
+	if(empty(thumbnail))
+		return false;
+
+	m::resource::response
+	{
+		client, const_buffer{thumbnail}, content_type, http::OK, addl_headers
+	};
+
+	return true;
+}
+
+/// The smallest of the fixed sizes for the method which covers the requested
+/// dimensions, or the largest one. A larger thumbnail than requested is
+/// permitted by the specification.
+static pair<size_t>
+thumbnail_size(const string_view &method,
+               const pair<size_t> &requested)
+{
+	static const pair<size_t> crop[]
+	{
+		{ 32, 32 }, { 96, 96 }, { 320, 320 }, { 640, 640 },
+	};
+
+	static const pair<size_t> scale[]
+	{
+		{ 320, 240 }, { 640, 480 }, { 800, 600 }, { 1536, 1536 },
+	};
+
+	const vector_view<const pair<size_t>> sizes
+	{
+		method == "crop"?
+			vector_view<const pair<size_t>>(crop):
+			vector_view<const pair<size_t>>(scale)
+	};
+
+	for(const auto &fixed : sizes)
+		if(fixed.first >= requested.first && fixed.second >= requested.second)
+			return fixed;
+
+	return sizes.back();
+}
@@ -10,6 +10,8 @@
 
 namespace ircd::stats
 {
+	static string_view metric_name(const mutable_buffer &, const string_view &);
+	static void write_histogram(resource::response::chunked &, const string_view &, const histogram &, const time_t &);
 	static resource::response get_stats(client &, const resource::request &);
 
 	extern resource::method method_get;
@@ -53,19 +55,32 @@ ircd::stats::get_stats(client &client,
 
 	for(const auto &item : items)
 	{
-		char buf[256], name[2][128], val[64];
+		char buf[256], name[128], val[64];
 		const string_view _name
 		{
-			replace(name[0], item->name, '.', '_')
+			metric_name(name, item->name)
 		};
 
+		if(item->type == typeid(histogram))
+		{
+			const auto &hist
+			{
+				dynamic_cast<const histogram &>(*item)
+			};
+
+			if(!!hist)
+				write_histogram(response, _name, hist, ts);
+
+			continue;
+		}
+
 		const string_view line
 		{
 			buf,
 			::snprintf
 			(
 				buf, sizeof(buf), "%s %s %lu\n",
-				data(strlcpy(name[1], _name)),
+				data(_name),
 				data(string(val, *item)),
 				ts
 			)
@@ -76,3 +91,72 @@ ircd::stats::get_stats(client &client,
 
 	return std::move(response);
 }
+
+/// Histograms are exported as the cumulative buckets in the format of a
+/// Prometheus histogram. The samples are microseconds while the bounds are
+/// given in seconds. Buckets past the last occupied bucket are left out
+/// because they all repeat the total.
+void
+ircd::stats::write_histogram(resource::response::chunked &response,
+                             const string_view &name,
+                             const histogram &hist,
+                             const time_t &ts)
+{
+	size_t last(0);
+	for(size_t i(0); i < hist.BUCKETS - 1; ++i)
+		if(hist.bucket[i])
+			last = i;
+
+	char buf[512];
+	uint64_t cumulative(0);
+	for(size_t i(0); i <= last; ++i)
+	{
+		cumulative += hist.bucket[i];
+		response.write(string_view
+		{
+			buf,
+			::snprintf
+			(
+				buf, sizeof(buf), "%s_bucket{le=\"%.6f\"} %lu %lu\n",
+				data(name),
+				histogram::bound(i) / 1000000.0,
+				cumulative,
+				ts
+			)
+		});
+	}
+
+	response.write(string_view
+	{
+		buf,
+		::snprintf
+		(
+			buf, sizeof(buf), "%s_bucket{le=\"+Inf\"} %lu %lu\n"
+			"%s_sum %.6f %lu\n"
+			"%s_count %lu %lu\n",
+			data(name), hist.count, ts,
+			data(name), hist.sum / 1000000.0, ts,
+			data(name), hist.count, ts
+		)
+	});
+}
+
+/// Prometheus metric names are limited to [a-zA-Z0-9_]; everything else in
+/// the item name (e.g. the '.' separators, or the '/' of a resource path) is
+/// replaced. The result is null terminated.
+ircd::string_view
+ircd::stats::metric_name(const mutable_buffer &buf,
+                         const string_view &name)
+{
+	const string_view ret
+	{
+		data(strlcpy(buf, name))
+	};
+
+	std::replace_if(data(buf), data(buf) + size(ret), [](const char &c)
+	{
+		return !std::isalnum(uint8_t(c)) && c != '_';
+	}, '_');
+
+	return ret;
+}